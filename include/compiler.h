@@ -7,6 +7,9 @@
 #include "type.h"
 #include "value.h"
 
+// localRegisters entry of a variable that lives in a global
+#define NO_LOCAL_REGISTER UINT8_MAX
+
 typedef struct {
     int loopStart;         // Start position of the current loop
     int loopEnd;           // End position of the current loop (for breaks)
@@ -46,9 +49,14 @@ typedef struct {
     // Register VM compilation mode - Phase 1.1 enhancement
     bool isRegisterMode;           // True when compiling directly to register VM
     struct RegisterChunk* rchunk;  // Target register chunk when in register mode
-    uint8_t nextRegister;          // Next available register for allocation
-    uint8_t registerStack[256];    // Stack of allocated registers for expression evaluation
-    int registerStackTop;          // Top of register stack
+    uint8_t nextRegister;          // Next free virtual register; released per statement and scope
+    uint8_t nextWindowSlot;        // Next free argument window slot
+    uint8_t nextLane;              // Next free i64/f64 lane register
+    bool promoteLocals;            // Keep the current function's locals in registers
+    uint8_t promoteLimit;          // Locals stay in globals once this many registers are in use
+    uint8_t localRegisters[UINT8_COUNT]; // Virtual register of each promoted variable
+    uint8_t builderRegisters[UINT8_COUNT]; // String builder standing in for a variable in a loop
+    int tryDepth;                  // Enclosing try blocks in register mode
 } Compiler;
 
 void initCompiler(Compiler* compiler, Chunk* chunk,
@@ -63,6 +71,10 @@ bool compileToRegisterDirect(ASTNode* ast, struct RegisterChunk* rchunk,
 bool compileToRegister(ASTNode* ast, struct RegisterChunk* rchunk,
                        const char* filePath, const char* sourceCode,
                        bool requireMain);
+// Type-check a module without generating code, recording its declarations
+// in the global tables as compileToRegisterDirect would. For modules whose
+// code comes from the module cache.
+bool typeCheckModule(ASTNode* ast, const char* filePath, const char* sourceCode);
 uint8_t resolveVariable(Compiler* compiler, Token name);       // Added
 uint8_t addLocal(Compiler* compiler, Token name, Type* type, bool isMutable, bool isConst);  // Added
 uint8_t defineVariable(Compiler* compiler, Token name, Type* type);  // Added
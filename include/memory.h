@@ -5,6 +5,14 @@
 #include "value.h"
 #include "error.h"
 
+struct RegisterVM;
+
+// Phase of a VM heap's old-space collection cycle
+typedef enum {
+    GC_PHASE_IDLE,   // No cycle in progress
+    GC_PHASE_MARK,   // Tracing gray objects
+    GC_PHASE_SWEEP,  // Freeing the objects left white
+} GCPhase;
 
 // This macro is used to grow the capacity of the dynamic array that stores the
 // bytecode instructions. It ensures that the capacity is at least 8, and doubles it otherwise
@@ -80,33 +88,163 @@
 // Allocates memory for a new object of a given type. It takes the type of the
 void* reallocate(void* pointer, size_t oldSize, size_t newSize);
 
-
-// Allocate a new string object copying the given characters
+// Size-class slab allocator behind reallocate and object allocation. Blocks
+// up to SLAB_MAX_SIZE come from per-class free lists; larger ones from malloc.
+#define SLAB_CLASS_COUNT 8
+#define SLAB_MAX_SIZE 256
+
+typedef struct {
+    size_t blockSize;     // Class size in bytes, 0 for the malloc fallback
+    size_t liveBlocks;    // Blocks currently handed out
+    size_t freeBlocks;    // Blocks waiting on the free list
+    size_t slabs;         // Slabs carved for this class
+    uint64_t allocations; // Total allocations served
+} SlabStats;
+
+void* slabAllocate(size_t size);
+// Free a block; `size` must be the size it was allocated with
+void slabFree(void* pointer, size_t size);
+// One entry per size class followed by the malloc fallback
+void getSlabStats(SlabStats stats[SLAB_CLASS_COUNT + 1]);
+// orusc prints these after the program runs when ORUS_SLAB_STATS is set
+void printSlabStats();
+
+// Allocate a new string object copying the given characters. Outside
+// execution this returns the interned string.
 ObjString* allocateString(const char* str, int length);
 
+// Short strings are shared: while a heap is running, allocating one of up
+// to SMALL_STRING_MAX bytes returns its interned copy, interning it first
+// if there is none. The copy lives in the old space and is collected like
+// any other string once nothing refers to it. initSmallStrings interns the empty string, every one-byte string and the
+// runtime type names permanently, so producing those never allocates.
+#define SMALL_STRING_MAX 15
+void initSmallStrings();
+
+// Allocate a new string holding `a` followed by `b`
+ObjString* concatenateStrings(ObjString* a, ObjString* b);
+
+// String interning: one canonical ObjString per content, so two interned
+// strings are equal exactly when they are the same object. The table is
+// weak; collected strings drop out of it. `str` must not point into a
+// collectable string, since interning may allocate.
+uint32_t hashString(const char* str, int length);
+ObjString* internString(const char* str, int length);
+// The interned string with these contents, or NULL
+ObjString* findInternedString(const char* str, int length);
+
 // Allocate a new array object with the given length
 ObjArray* allocateArray(int length);
+// Allocate an array storing `length` zeroed elements of `kind`. Use
+// ARRAY_PACKED for an empty array whose element type is a primitive.
+ObjArray* allocateArrayOfKind(ArrayKind kind, int length);
+// Bytes per element of an array of `kind`
+size_t arrayElementSize(ArrayKind kind);
+// Packed kind that holds `value` unconverted, or ARRAY_VALUES
+ArrayKind arrayKindOf(Value value);
+
+// Element access for arrays of every kind. Stores of a value the packed
+// kind cannot hold convert the array to Values first; like reserveArray,
+// that fails for a nursery array when the nursery has no room left.
+Value arrayGet(ObjArray* array, int index);
+bool arraySet(ObjArray* array, int index, Value value);
+bool arrayPush(ObjArray* array, Value value);
+Value arrayPop(ObjArray* array);
 // Allocate a new 64-bit integer array with the given length
 ObjIntArray* allocateIntArray(int length);
+// String builders: appends grow the buffer by doubling; finishing copies
+// the contents into a new string and leaves the builder usable
+ObjStringBuilder* allocateStringBuilder(ObjString* seed);
+bool appendStringBuilder(ObjStringBuilder* builder, const char* chars, int length);
+ObjString* finishStringBuilder(ObjStringBuilder* builder);
 ObjRangeIterator* allocateRangeIterator(int64_t start, int64_t end);
 struct ObjError* allocateError(ErrorType type, const char* message, SrcLocation location);
 
-// Allocate AST and Type objects
+// Allocate AST and Type objects; from the compile arena while one is open
 struct ASTNode* allocateASTNode();
 struct Type* allocateType();
+// Allocate a type that outlives the compile arena
+struct Type* allocatePromotedType();
+
+// Compile arena: a region for AST nodes, types and other compiler data that
+// is released in one go when the outermost endCompileArena runs. Nested
+// begin/end pairs (module imports) share the outer region. Types reachable
+// from the type registries are promoted out of it on release; anything else
+// the caller keeps must be promoted with promoteType before then.
+void beginCompileArena();
+void endCompileArena();
+bool compileArenaActive();
+// Bump-allocate from the open arena; NULL when none is open
+void* arenaAllocate(size_t size);
+bool inCompileArena(const void* pointer);
 
 // Allocate enum value object
 ObjEnum* allocateEnum(int variantIndex, Value* data, int dataCount, ObjString* typeName);
 
+// Grow an array's capacity; false if it could not be grown
+bool reserveArray(ObjArray* array, int capacity);
+
 // Mark helpers for GC
 void markObject(Obj* object);
 void markValue(Value value);
 
+// Write barrier for stores into heap objects. It records old objects that
+// are made to point into the nursery, so the next minor collection treats
+// them as roots, and shades the stored object while marking is in progress.
+void writeBarrier(Obj* owner, Value value);
+#define WRITE_BARRIER(owner, value)                         \
+    do {                                                    \
+        if (!(owner)->remembered || (owner)->marked) {      \
+            writeBarrier((owner), (value));                 \
+        }                                                   \
+    } while (0)
+
+// Minor collection: forward each root with forwardValue, then collectNursery
+void forwardValue(Value* slot);
+void collectNursery();
+
 // Garbage collector interface
+// Objects allocated while the attached VM is running go on its heap and are
+// collected; everything else (compiler output, types, AST) is permanent.
+void setGCHeap(struct RegisterVM* vm);
 void collectGarbage();
+
+// Incremental collection: after beginMarking and marking the roots, call
+// traceGray until it returns true, then beginSweep and sweepHeap until it
+// returns true. `budget` is the number of objects processed per call.
+void beginMarking();
+bool traceGray(size_t budget);
+void beginSweep();
+bool sweepHeap(size_t budget);
 void freeObjects();
+
+// Bytes an object holds, including the buffers it owns
+size_t objectSize(Obj* object);
+
+// Heap snapshots: between beginHeapSnapshot and endHeapSnapshot every
+// object marked is recorded along with the entry whose tracing marked it.
+// Each object thus hangs off one parent in a spanning tree of the heap;
+// endHeapSnapshot sums the tree into retained sizes.
+typedef struct {
+    Obj* object;
+    size_t size;      // objectSize of the object
+    size_t retained;  // Its size plus that of every entry hanging off it
+    int32_t parent;   // Entry that marked it, -1 for roots
+} HeapSnapshotEntry;
+
+typedef struct {
+    HeapSnapshotEntry* entries;  // In marking order; parents come first
+    int count;
+    int capacity;
+} HeapSnapshot;
+
+void beginHeapSnapshot(HeapSnapshot* snapshot);
+void endHeapSnapshot();
+void freeHeapSnapshot(HeapSnapshot* snapshot);
+
 void pauseGC();
 void resumeGC();
+bool isGCPaused();
 
 // Utility to copy a raw C string onto the heap
 char* copyString(const char* str, int length);
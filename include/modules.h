@@ -4,6 +4,7 @@
 #include "chunk.h"
 #include "register_chunk.h"
 #include "ast.h"
+#include "symtable.h"
 #include "value.h"
 #include "register_vm.h"
 #include <stdbool.h>
@@ -15,18 +16,38 @@ typedef struct {
     uint8_t index; // Global variable index
 } Export;
 
+// Open-addressing hash table from a string to a pointer, probed linearly.
+// Keys are borrowed. A removed entry keeps its key with a NULL value so
+// probes continue past it.
 typedef struct {
+    const char* key;  // NULL for an empty slot
+    uint32_t hash;
+    void* value;
+} NameEntry;
+
+typedef struct {
+    NameEntry* entries;
+    int count;     // Live and removed entries
+    int capacity;  // Zero or a power of two
+} NameTable;
+
+// Module is declared in symtable.h, where import aliases refer to it.
+// Neither the registry nor a module's exports have a fixed size; what bounds
+// them is the MAX_GLOBALS slots that every module's declarations share.
+struct Module {
     char* module_name; // full path
     char* name;        // base module name
     Chunk* bytecode;            // Stack VM bytecode
     RegisterChunk* regBytecode; // Register VM bytecode
-    Export exports[UINT8_COUNT];
-    uint8_t export_count;
+    Export* exports;
+    int export_count;
+    NameTable export_table; // Export name -> entry of exports
     bool executed;
     char* disk_path;   // path on disk if loaded from file
     long mtime;        // modification time
     bool from_embedded; // true if loaded from embedded table
-} Module;
+    bool unfinished;   // regBytecode is still being built, see finish_module_builds
+};
 
 Export* get_export(Module* module, const char* name);
 
@@ -38,9 +59,23 @@ Chunk* compile_module_ast(ASTNode* ast, const char* module_name);
 RegisterChunk* compile_module_ast_to_register(ASTNode* ast, const char* module_name);
 bool register_module(Module* module);
 Module* get_module(const char* name);
+// Loaded modules in load order; each comes after the modules it imports
+int get_module_count(void);
+Module* get_module_at(int index);
 InterpretResult compile_module_only(const char* path);
 
 extern bool traceImports;
+// Level modules are optimized at; part of their cache key
+extern uint32_t moduleOptimizationLevel;
+
+// Processes compiling modules at once. Above 1, each module missing from
+// the cache is compiled in a child process while the compiler carries on
+// with the program, and finish_module_builds collects the results.
+extern int moduleBuildJobs;
+
+// Wait for the modules compiled since the last call. Returns false if one
+// of them failed to compile; the error has been reported.
+bool finish_module_builds(void);
 
 // Holds the last module loading error message if any
 extern const char* moduleError;
@@ -0,0 +1,95 @@
+/**
+ * @file register_allocator.h
+ * @brief Orus Register Allocator
+ *
+ * The register code generator emits instructions over virtual registers and
+ * leaves the mapping onto the VM's register file to this pass. Each function
+ * body (and the top-level code around them) is allocated on its own:
+ *
+ * - Virtual registers v0..v(VIRTUAL_REGISTER_COUNT-1) are ordinary values.
+ *   Their live ranges come from a backward liveness analysis over the
+ *   function's control flow and they are assigned registers in order of
+ *   their first appearance, linear-scan style. A register is reused as soon
+ *   as every value in it is dead, and MOVE operands share a register when
+ *   their live ranges allow it, which turns the move into a NOP.
+ * - Window registers WINDOW_REGISTER(0).. name the argument window used by
+ *   calls and by instructions that read a run of consecutive registers.
+ *   They are placed right after the function's ordinary registers, so
+ *   WINDOW_REGISTER(k) becomes R(frame + k).
+ *
+ * In a function, v0..v(n-1) hold the n parameters on entry and stay pinned
+ * to R0..R(n-1).
+ *
+ * @author Orus Development Team
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifndef ORUS_REGISTER_ALLOCATOR_H
+#define ORUS_REGISTER_ALLOCATOR_H
+
+#include "common.h"
+#include "register_chunk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// VIRTUAL REGISTERS
+// =============================================================================
+
+/** Number of ordinary virtual registers per function */
+#define VIRTUAL_REGISTER_COUNT 224
+
+/** First virtual register that names an argument window slot */
+#define WINDOW_REGISTER_BASE VIRTUAL_REGISTER_COUNT
+
+/** Number of argument window slots */
+#define WINDOW_SLOT_COUNT (256 - WINDOW_REGISTER_BASE)
+
+/** Virtual register of argument window slot `slot` */
+#define WINDOW_REGISTER(slot) ((uint8_t)(WINDOW_REGISTER_BASE + (slot)))
+
+/** Whether a virtual register names an argument window slot */
+#define IS_WINDOW_REGISTER(reg) ((reg) >= WINDOW_REGISTER_BASE)
+
+// =============================================================================
+// ALLOCATION
+// =============================================================================
+
+/**
+ * @brief Map every virtual register in the chunk onto the register file
+ *
+ * Rewrites all register operands, turns coalesced moves into NOPs and strips
+ * them, and records each function's register_count and the chunk's
+ * max_registers. Must run before calls are linked: CALL and MODULE_CALL
+ * immediates are left alone.
+ *
+ * @param chunk Chunk produced by the register code generator
+ * @param failed_function Set to the index of the function that did not fit
+ *        (function_count for top-level code), or UINT16_MAX when memory
+ *        ran out, whenever false is returned
+ * @return false if some function needs more than REGISTER_COUNT registers
+ *         or memory ran out
+ */
+bool register_allocate_chunk(RegisterChunk* chunk, uint16_t* failed_function);
+
+/**
+ * @brief Check whether one function's virtual registers fit the register file
+ *
+ * Runs the same analysis as register_allocate_chunk on the function alone
+ * and leaves the chunk unchanged.
+ *
+ * @param chunk Chunk produced by the register code generator
+ * @param function Index of the function to check
+ * @return false if the function needs more than REGISTER_COUNT registers
+ *         or memory ran out
+ */
+bool register_function_fits(RegisterChunk* chunk, uint16_t function);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ORUS_REGISTER_ALLOCATOR_H
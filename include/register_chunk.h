@@ -57,6 +57,7 @@ typedef struct SourceLocation {
 struct DebugInfo {
     SourceLocation* locations;    /**< Source locations for each instruction */
     uint32_t location_count;      /**< Number of source locations */
+    uint32_t location_capacity;   /**< Capacity of source locations array */
     
     char** source_files;          /**< Array of source file paths */
     uint16_t source_file_count;   /**< Number of source files */
@@ -89,6 +90,7 @@ struct FunctionInfo {
     bool is_generic;              /**< Whether function is generic */
     bool is_exported;             /**< Whether function is exported */
     uint16_t generic_param_count; /**< Number of generic parameters */
+    uint16_t global_index;        /**< Global slot holding the function (UINT16_MAX if none) */
 };
 
 // =============================================================================
@@ -136,6 +138,42 @@ struct ModuleInfo {
     uint16_t dependency_count;    /**< Number of dependencies */
 };
 
+// =============================================================================
+// STRUCT SHAPES
+// =============================================================================
+
+/** Field name operands and NEW_STRUCT shape operands are one byte wide */
+#define MAX_FIELD_NAMES 256
+#define MAX_STRUCT_SHAPES 256
+
+/**
+ * @brief Field layout shared by every instance of a struct type
+ *
+ * Struct instances are arrays whose `shape` is the shape's index plus one.
+ * Generic instantiations share the shape of their struct.
+ */
+typedef struct {
+    char* name;                   /**< Struct type name */
+    uint8_t* field_names;         /**< Field name index stored in each slot */
+    uint8_t field_count;          /**< Number of fields */
+} StructShape;
+
+/** Shapes remembered per field access before it goes megamorphic */
+#define INLINE_CACHE_WAYS 4
+
+/**
+ * @brief Inline cache of one GET_FIELD/SET_FIELD instruction
+ *
+ * Maps the shapes seen at the instruction to the slot holding the field.
+ * One entry is monomorphic, up to INLINE_CACHE_WAYS polymorphic; shapes
+ * beyond that are looked up on every access.
+ */
+typedef struct {
+    uint16_t shapes[INLINE_CACHE_WAYS]; /**< Cached shape ids */
+    uint8_t slots[INLINE_CACHE_WAYS];   /**< Field slot for each cached shape */
+    uint8_t count;                      /**< Entries in use */
+} InlineCache;
+
 // =============================================================================
 // BYTECODE CHUNK
 // =============================================================================
@@ -167,6 +205,18 @@ struct RegisterChunk {
     // Module information
     ModuleInfo* module;           /**< Module metadata */
     
+    // Struct layouts for GET_FIELD/SET_FIELD/NEW_STRUCT
+    char** field_names;           /**< Field names, indexed by field operands */
+    uint16_t field_name_count;    /**< Number of field names */
+    uint16_t field_name_capacity; /**< Field name array capacity */
+    StructShape* shapes;          /**< Struct shapes, indexed by shape id - 1 */
+    uint16_t shape_count;         /**< Number of shapes */
+    uint16_t shape_capacity;      /**< Shape array capacity */
+    
+    // Inline caches, parallel to code (runtime state, reset at load)
+    InlineCache* inline_caches;   /**< Per-instruction field caches (NULL if unused) */
+    uint32_t inline_cache_count;  /**< Number of cache entries */
+    
     // Debug information
     DebugInfo* debug;             /**< Debug information (NULL if not available) */
     
@@ -182,8 +232,17 @@ struct RegisterChunk {
     bool is_optimized;            /**< Whether chunk has been optimized */
     uint32_t optimization_level;  /**< Optimization level used */
     
+    // Verification state
+    bool is_verified;             /**< Operands proven valid by register_chunk_verify */
+    
     // Checksum for integrity
     uint32_t checksum;            /**< CRC32 checksum of chunk data */
+    
+    // Backing .orbc image of a loaded chunk
+    uint8_t* image;               /**< Image the chunk borrows from (NULL if none) */
+    size_t image_size;            /**< Image size in bytes */
+    bool image_mapped;            /**< Image is mmap'ed rather than malloc'ed */
+    bool strings_pending;         /**< String constants not materialized yet */
 };
 
 // =============================================================================
@@ -265,6 +324,17 @@ uint32_t register_chunk_get_instruction(const RegisterChunk* chunk, uint32_t add
 bool register_chunk_set_instruction(RegisterChunk* chunk, uint32_t address,
                                    uint32_t instruction);
 
+/**
+ * @brief Drop the instructions from `count` on
+ * 
+ * Functions that start in the dropped code and its source locations go
+ * with it, so the code can be generated again.
+ * 
+ * @param chunk Pointer to chunk
+ * @param count Number of instructions to keep
+ */
+void register_chunk_truncate(RegisterChunk* chunk, uint32_t count);
+
 /**
  * @brief Get current instruction count
  * 
@@ -382,6 +452,52 @@ Value register_chunk_get_global(const RegisterChunk* chunk, uint16_t index);
  */
 bool register_chunk_set_global(RegisterChunk* chunk, uint16_t index, Value value);
 
+// =============================================================================
+// STRUCT SHAPE MANAGEMENT
+// =============================================================================
+
+/**
+ * @brief Add a field name, reusing an existing entry with the same name
+ * 
+ * @param chunk Pointer to chunk
+ * @param name Field name (copied)
+ * @return Field name index, or UINT16_MAX if the table is full
+ */
+uint16_t register_chunk_add_field_name(RegisterChunk* chunk, const char* name);
+
+/**
+ * @brief Add the shape of a struct type, reusing an existing shape of that name
+ * 
+ * @param chunk Pointer to chunk
+ * @param name Struct type name (copied)
+ * @param field_names Field names in slot order
+ * @param field_count Number of fields
+ * @return Shape id (index + 1), or 0 if the shape or field tables are full
+ */
+uint16_t register_chunk_add_shape(RegisterChunk* chunk, const char* name,
+                                  const char* const* field_names, uint8_t field_count);
+
+/**
+ * @brief Find the slot of a field in a shape
+ * 
+ * @param chunk Pointer to chunk
+ * @param shape Shape id
+ * @param field Field name index
+ * @return Slot index, or -1 if the shape has no such field
+ */
+int register_chunk_shape_slot(const RegisterChunk* chunk, uint16_t shape, uint8_t field);
+
+/**
+ * @brief Allocate empty inline caches for every instruction
+ *
+ * Caches are only allocated when the chunk uses field names. Called when a
+ * chunk is loaded into the VM, after all code rewriting.
+ * 
+ * @param chunk Pointer to chunk
+ * @return true on success, false on allocation failure
+ */
+bool register_chunk_reset_inline_caches(RegisterChunk* chunk);
+
 // =============================================================================
 // DEBUG INFORMATION
 // =============================================================================
@@ -465,9 +581,33 @@ bool register_chunk_add_import(RegisterChunk* chunk, const char* module_name,
 // SERIALIZATION
 // =============================================================================
 
+/**
+ * Register bytecode images (.orbc version 3) are laid out so that a chunk
+ * can run straight out of a mapped file. All fields are little-endian:
+ *
+ * - A 48-byte header: magic, version, header size, section count, image
+ *   size, CRC32 of the code, optimization level, register count and flags.
+ * - A section table of {id, count, offset, size} entries, 16 bytes each.
+ * - The sections, each aligned to ORBC_SECTION_ALIGN. Code is the raw
+ *   instruction stream and debug locations are SourceLocation records;
+ *   the other tables are fixed-size records whose names are offsets into
+ *   one NUL-terminated string section.
+ *
+ * Nothing in the image is an address, so loading it only builds the small
+ * metadata tables. On little-endian hosts the code, locations and every
+ * name are used in place; only string constants are turned into ObjStrings,
+ * by register_chunk_materialize_strings.
+ */
+#define ORBC_IMAGE_MAGIC 0x4F524243  /* "ORBC", shared with version 1 files */
+#define ORBC_IMAGE_VERSION 3
+#define ORBC_SECTION_ALIGN 16
+
 /**
  * @brief Serialize chunk to binary format
  * 
+ * Fails if a constant or global holds a value other than a primitive or
+ * a string.
+ * 
  * @param chunk Pointer to chunk
  * @param buffer Output buffer (allocated by function)
  * @param size Output buffer size
@@ -478,6 +618,8 @@ bool register_chunk_serialize(const RegisterChunk* chunk, uint8_t** buffer, size
 /**
  * @brief Deserialize chunk from binary format
  * 
+ * The buffer is copied; the chunk borrows from its own copy.
+ * 
  * @param buffer Input buffer
  * @param size Buffer size
  * @param chunk Output chunk (must be uninitialized)
@@ -485,6 +627,49 @@ bool register_chunk_serialize(const RegisterChunk* chunk, uint8_t** buffer, size
  */
 bool register_chunk_deserialize(const uint8_t* buffer, size_t size, RegisterChunk* chunk);
 
+/**
+ * @brief Write a chunk's image to a file
+ * 
+ * @param chunk Pointer to chunk
+ * @param path Output file path
+ * @return true on success, false on failure
+ */
+bool register_chunk_write_file(const RegisterChunk* chunk, const char* path);
+
+/**
+ * @brief Map an image file and load the chunk in place
+ * 
+ * The mapping is private, so patching the code (optimizer, allocator)
+ * copies the touched pages instead of writing the file. It is released
+ * by register_chunk_free.
+ * 
+ * @param path Image file path
+ * @param chunk Output chunk (must be uninitialized)
+ * @return true on success, false on failure
+ */
+bool register_chunk_map_file(const char* path, RegisterChunk* chunk);
+
+/**
+ * @brief Create the string constants and globals of a loaded image
+ * 
+ * Until then they read as nil. Run before the chunk is verified or
+ * executed; registervm_init does so.
+ * 
+ * @param chunk Pointer to chunk
+ * @return true on success, false on failure
+ */
+bool register_chunk_materialize_strings(RegisterChunk* chunk);
+
+/**
+ * @brief Free a buffer the chunk holds unless it lies in the chunk's image
+ * 
+ * For code that replaces chunk arrays wholesale.
+ * 
+ * @param chunk Pointer to chunk
+ * @param pointer Buffer to release
+ */
+void register_chunk_release(RegisterChunk* chunk, void* pointer);
+
 /**
  * @brief Calculate chunk checksum
  * 
@@ -496,21 +681,43 @@ uint32_t register_chunk_checksum(const RegisterChunk* chunk);
 /**
  * @brief Verify chunk integrity
  * 
+ * Checks the stored checksum (if any) and proves statically that every
+ * register, constant, global and jump operand is in range and that the
+ * operands of the inline arithmetic opcodes always carry the expected
+ * type tag.
+ * 
  * @param chunk Pointer to chunk
  * @return true if chunk is valid, false otherwise
  */
 bool register_chunk_verify(const RegisterChunk* chunk);
 
+/**
+ * @brief Verify chunk and record the result
+ * 
+ * Sets is_verified so the VM can execute the chunk without per-instruction
+ * operand checks. Adding or replacing instructions clears the flag.
+ * 
+ * @param chunk Pointer to chunk
+ * @return true if chunk passed verification
+ */
+bool register_chunk_mark_verified(RegisterChunk* chunk);
+
 // =============================================================================
 // OPTIMIZATION
 // =============================================================================
 
 /**
- * @brief Apply basic optimizations to chunk
+ * @brief Optimize the chunk in place
+ * 
+ * Level 1 removes redundant moves, threads jumps, strips NOPs and fuses
+ * superinstructions; level 2 adds constant folding/propagation and dead
+ * code elimination across basic blocks; level 3 adds loop-invariant code
+ * motion. Jump targets, function ranges and debug locations are remapped
+ * when code moves. The chunk must be re-verified afterwards.
  * 
  * @param chunk Pointer to chunk
  * @param level Optimization level (0-3)
- * @return true on success, false on failure
+ * @return true on success, false on invalid level or allocation failure
  */
 bool register_chunk_optimize(RegisterChunk* chunk, uint32_t level);
 
@@ -522,6 +729,32 @@ bool register_chunk_optimize(RegisterChunk* chunk, uint32_t level);
  */
 bool register_chunk_is_optimized(const RegisterChunk* chunk);
 
+// =============================================================================
+// LINKING
+// =============================================================================
+
+/**
+ * @brief Link a program and its modules into a single chunk
+ *
+ * Units are given in the order their top levels run: every module after
+ * the modules it imports, the program last. Each unit's HALT except the
+ * last falls through to the next unit. Module calls are resolved to the
+ * function owning the called global slot (FunctionInfo.global_index),
+ * functions unreachable from top-level code are dropped, and constants,
+ * field names, struct shapes and source files are merged without
+ * duplicates. The output must be verified before it runs.
+ *
+ * @param units Chunks to link; their strings are materialized
+ * @param unit_count Number of chunks
+ * @param output Chunk to initialize with the result (freed on failure)
+ * @param message Buffer receiving an error message
+ * @param size Size of the message buffer
+ * @return true on success, false if a call cannot be resolved, a limit is
+ *         exceeded or memory runs out
+ */
+bool register_chunk_link(RegisterChunk* const* units, uint16_t unit_count,
+                         RegisterChunk* output, char* message, size_t size);
+
 // =============================================================================
 // UTILITY FUNCTIONS
 // =============================================================================
@@ -126,6 +126,14 @@ typedef enum {
     ROP_CEIL_F64    = 0x38,  /**< Ceiling 64-bit float */
     ROP_ROUND_F64   = 0x39,  /**< Round 64-bit float */
     
+    // Unsigned arithmetic, continued from 0x2C-0x2F
+    ROP_SUB_U32     = 0x3A,  /**< Subtract 32-bit unsigned */
+    ROP_SUB_U64     = 0x3B,  /**< Subtract 64-bit unsigned */
+    ROP_DIV_U32     = 0x3C,  /**< Divide 32-bit unsigned */
+    ROP_DIV_U64     = 0x3D,  /**< Divide 64-bit unsigned */
+    ROP_MOD_U32     = 0x3E,  /**< Modulo 32-bit unsigned */
+    ROP_MOD_U64     = 0x3F,  /**< Modulo 64-bit unsigned */
+    
     // ==========================================================================
     // LOGICAL OPERATIONS (0x40 - 0x4F)
     // ==========================================================================
@@ -182,6 +190,14 @@ typedef enum {
     ROP_IS_TYPE     = 0x68,  /**< Check if value is specific type */
     ROP_TYPE_CHECK  = 0x69,  /**< Runtime type check */
     
+    // Arithmetic dispatched on the operands' tags, for generic code
+    ROP_ADD_ANY     = 0x6A,  /**< Add two numbers of the same type */
+    ROP_SUB_ANY     = 0x6B,  /**< Subtract two numbers of the same type */
+    ROP_MUL_ANY     = 0x6C,  /**< Multiply two numbers of the same type */
+    ROP_DIV_ANY     = 0x6D,  /**< Divide two numbers of the same type */
+    ROP_MOD_ANY     = 0x6E,  /**< Modulo two integers of the same type */
+    ROP_NEG_ANY     = 0x6F,  /**< Negate a signed number */
+    
     // ==========================================================================
     // OBJECT OPERATIONS (0x70 - 0x7F)
     // ==========================================================================
@@ -204,6 +220,9 @@ typedef enum {
     ROP_CALL_METHOD = 0x7A,  /**< Call object method */
     ROP_CALL_STATIC = 0x7B,  /**< Call static method */
     
+    // Array literal whose elements share a primitive type
+    ROP_NEW_PACKED_ARRAY = 0x7C,  /**< Create new packed array */
+    
     // ==========================================================================
     // STRING OPERATIONS (0x80 - 0x8F)
     // ==========================================================================
@@ -216,6 +235,9 @@ typedef enum {
     ROP_STR_COMPARE = 0x85,  /**< Compare strings */
     ROP_STR_TO_UPPER= 0x86,  /**< Convert to uppercase */
     ROP_STR_TO_LOWER= 0x87,  /**< Convert to lowercase */
+    ROP_STR_BUILDER_NEW    = 0x88,  /**< Start a builder from a string */
+    ROP_STR_BUILDER_APPEND = 0x89,  /**< Append a string to a builder */
+    ROP_STR_BUILDER_FINISH = 0x8A,  /**< Copy a builder's contents into a string */
     
     // ==========================================================================
     // ARRAY OPERATIONS (0x90 - 0x9F)
@@ -229,9 +251,10 @@ typedef enum {
     ROP_ARRAY_CONCAT= 0x95,  /**< Concatenate arrays */
     ROP_ARRAY_REVERSE=0x96,  /**< Reverse array in place */
     ROP_ARRAY_SORT  = 0x97,  /**< Sort array */
+    ROP_ARRAY_RESERVE=0x98,  /**< Grow array capacity */
     
     // ==========================================================================
-    // GENERIC OPERATIONS (0xA0 - 0xAF)
+    // GENERIC OPERATIONS (0xA0 - 0xA3)
     // ==========================================================================
     
     ROP_GENERIC_CALL= 0xA0,  /**< Call generic function */
@@ -239,6 +262,25 @@ typedef enum {
     ROP_GENERIC_CHECK=0xA2,  /**< Check generic constraints */
     ROP_GENERIC_CAST= 0xA3,  /**< Generic type cast */
     
+    // ==========================================================================
+    // TYPED REGISTER LANES (0xA4 - 0xAF)
+    // ==========================================================================
+    // Operands name untagged lane registers (I0-I31, F0-F31) unless noted.
+    // Tags are only materialized by BOX at boundaries (calls, stores, print).
+    
+    ROP_UNBOX_I64   = 0xA4,  /**< Unbox i32/i64 register into I lane */
+    ROP_UNBOX_F64   = 0xA5,  /**< Unbox f64/i32 register into F lane */
+    ROP_BOX_I64     = 0xA6,  /**< Box I lane into register as i64 */
+    ROP_BOX_F64     = 0xA7,  /**< Box F lane into register as f64 */
+    ROP_LANE_ADD_I64= 0xA8,  /**< Add I lanes */
+    ROP_LANE_SUB_I64= 0xA9,  /**< Subtract I lanes */
+    ROP_LANE_MUL_I64= 0xAA,  /**< Multiply I lanes */
+    ROP_LANE_ADD_F64= 0xAB,  /**< Add F lanes */
+    ROP_LANE_SUB_F64= 0xAC,  /**< Subtract F lanes */
+    ROP_LANE_MUL_F64= 0xAD,  /**< Multiply F lanes */
+    ROP_LANE_DIV_F64= 0xAE,  /**< Divide F lanes */
+    ROP_LANE_LT_I64 = 0xAF,  /**< Less than on I lanes, bool into register */
+    
     // ==========================================================================
     // PATTERN MATCHING (0xB0 - 0xBF)
     // ==========================================================================
@@ -287,7 +329,7 @@ typedef enum {
     ROP_TIMESTAMP   = 0xE9,  /**< Get timestamp */
     
     // ==========================================================================
-    // DEBUG AND PROFILING (0xF0 - 0xFF)
+    // DEBUG AND PROFILING (0xF0 - 0xF5)
     // ==========================================================================
     
     ROP_DEBUG_BREAK = 0xF0,  /**< Debug breakpoint */
@@ -297,6 +339,24 @@ typedef enum {
     ROP_PROFILE_END = 0xF4,  /**< End profiling */
     ROP_PROFILE_MARK= 0xF5,  /**< Profile marker */
     
+    // ==========================================================================
+    // SUPERINSTRUCTIONS (0xF6 - 0xFE)
+    // ==========================================================================
+    // A superinstruction replaces only the opcode of the first word of a hot
+    // sequence. The following words are left in place, so jumps into the
+    // middle of the sequence and the generic handler (which executes just the
+    // base opcode) stay correct. See get_superinstruction_info().
+    
+    ROP_LT_I32_JZ   = 0xF6,  /**< LT_I32 + JZ */
+    ROP_LT_I32_JNZ  = 0xF7,  /**< LT_I32 + JNZ */
+    ROP_EQ_I32_JZ   = 0xF8,  /**< EQ_I32 + JZ */
+    ROP_EQ_I32_JNZ  = 0xF9,  /**< EQ_I32 + JNZ */
+    ROP_ADD_I32_JMP = 0xFA,  /**< ADD_I32 + JMP (loop back edge) */
+    ROP_INC_LT_I32_JNZ=0xFB, /**< ADD_I32 + LT_I32 + JNZ (range loop) */
+    ROP_LOAD_CONST_ADD_I32=0xFC, /**< LOAD_CONST + ADD_I32 */
+    ROP_LOAD_CONST_ADD_F64=0xFD, /**< LOAD_CONST + ADD_F64 */
+    ROP_LOAD_CONST_MUL_F64=0xFE, /**< LOAD_CONST + MUL_F64 */
+    
     // Reserved for future expansion
     ROP_RESERVED    = 0xFF,  /**< Reserved opcode */
     
@@ -361,11 +421,13 @@ typedef enum {
     INST_CAT_STRING,       /**< String operations */
     INST_CAT_ARRAY,        /**< Array operations */
     INST_CAT_GENERIC,      /**< Generic operations */
+    INST_CAT_LANE,         /**< Typed register lane operations */
     INST_CAT_PATTERN,      /**< Pattern matching */
     INST_CAT_EXCEPTION,    /**< Exception handling */
     INST_CAT_MODULE,       /**< Module operations */
     INST_CAT_BUILTIN,      /**< Built-in functions */
     INST_CAT_DEBUG,        /**< Debug and profiling */
+    INST_CAT_SUPER,        /**< Fused superinstructions */
 } InstructionCategory;
 
 // =============================================================================
@@ -386,6 +448,21 @@ typedef struct {
     bool modifies_flags;          /**< Whether instruction modifies status flags */
 } InstructionMetadata;
 
+/** Maximum number of instruction words covered by a superinstruction */
+#define MAX_SUPERINSTRUCTION_LENGTH 3
+
+/**
+ * @brief Superinstruction description
+ * 
+ * Describes which opcode sequence a fused opcode stands for. The fused
+ * opcode's own operands are those of pattern[0].
+ */
+typedef struct {
+    RegisterOpcode opcode;        /**< Fused opcode */
+    uint8_t length;               /**< Number of instruction words covered */
+    RegisterOpcode pattern[MAX_SUPERINSTRUCTION_LENGTH]; /**< Covered opcodes */
+} SuperinstructionInfo;
+
 // =============================================================================
 // FUNCTION DECLARATIONS
 // =============================================================================
@@ -430,6 +507,31 @@ bool instruction_has_side_effects(RegisterOpcode opcode);
  */
 bool instruction_can_throw(RegisterOpcode opcode);
 
+/**
+ * @brief Get superinstruction description
+ * 
+ * @param opcode Instruction opcode
+ * @return Description, or NULL if opcode is not a superinstruction
+ */
+const SuperinstructionInfo* get_superinstruction_info(RegisterOpcode opcode);
+
+/**
+ * @brief Get the opcode a superinstruction starts with
+ * 
+ * @param opcode Instruction opcode
+ * @return pattern[0] for superinstructions, opcode itself otherwise
+ */
+RegisterOpcode get_base_opcode(RegisterOpcode opcode);
+
+/**
+ * @brief Find the longest superinstruction matching a code sequence
+ * 
+ * @param code First instruction of the candidate sequence
+ * @param remaining Number of instructions available from code
+ * @return Matching description, or NULL if none applies
+ */
+const SuperinstructionInfo* match_superinstruction(const uint32_t* code, uint32_t remaining);
+
 /**
  * @brief Validate instruction format
  * 
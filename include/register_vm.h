@@ -7,8 +7,10 @@
  * with efficient instruction dispatch and integrated memory management.
  * 
  * Key Features:
- * - 32 general-purpose registers (R0-R31)
+ * - 32 general-purpose registers (R0-R31) per call frame
  * - Special-purpose registers (SP, FP, FLAGS)
+ * - Sliding register windows over one growable register stack
+ * - Untagged i64/f64 register lanes for type-proven numeric code
  * - Direct bytecode execution without stack translation
  * - Integrated garbage collection support
  * - Comprehensive debugging and profiling support
@@ -21,6 +23,8 @@
 #ifndef ORUS_REGISTER_VM_H
 #define ORUS_REGISTER_VM_H
 
+#include <stdio.h>
+
 #include "common.h"
 #include "value.h"
 #include "memory.h"
@@ -48,8 +52,11 @@ extern "C" {
 /** Total number of registers including special registers */
 #define TOTAL_REGISTER_COUNT 35
 
-/** Maximum call stack depth */
-#define MAX_CALL_STACK_DEPTH 256
+/** Number of untagged registers in each typed lane (I0-I31, F0-F31) */
+#define LANE_REGISTER_COUNT 32
+
+/** Maximum call stack depth; the call stack grows on demand up to it */
+#define MAX_CALL_STACK_DEPTH 65536
 
 /** Maximum exception handler nesting */
 #define MAX_EXCEPTION_HANDLERS 64
@@ -122,10 +129,16 @@ typedef enum {
  * 
  * Represents a single function call on the call stack.
  * Tracks return address, register state, and local variable scope.
+ *
+ * Every frame addresses a window of TOTAL_REGISTER_COUNT slots of the VM's
+ * register stack starting at register_base. `CALL Rn, f` starts the callee's
+ * window at the caller's Rn, so the arguments the caller placed in Rn, Rn+1..
+ * are the callee's R0, R1.. without copying, and the callee's return value
+ * (left in its R0) is the caller's Rn.
  */
 typedef struct CallFrame {
     uint32_t return_address;     /**< Return instruction pointer */
-    uint8_t register_base;       /**< Base register for local variables */
+    size_t register_base;        /**< Register stack index of this frame's R0 */
     uint8_t register_count;      /**< Number of registers used by this frame */
     Value* locals;               /**< Local variable storage */
     uint16_t local_count;        /**< Number of local variables */
@@ -145,7 +158,8 @@ typedef struct ExceptionHandler {
     uint32_t try_start;          /**< Start of try block */
     uint32_t try_end;            /**< End of try block */
     uint32_t catch_address;      /**< Address of catch handler */
-    uint8_t catch_register;      /**< Register to store exception in */
+    uint8_t catch_register;      /**< Global slot to store the error message in */
+    uint32_t call_depth;         /**< Call depth of the frame that installed it */
     struct ExceptionHandler* previous; /**< Previous handler in stack */
 } ExceptionHandler;
 
@@ -159,6 +173,23 @@ typedef struct ExceptionHandler {
 // PERFORMANCE COUNTERS
 // =============================================================================
 
+/** Number of buckets in the GC pause histogram */
+#define GC_PAUSE_BUCKETS 16
+
+/**
+ * @brief Collector pause times
+ *
+ * Every minor collection, full collection and incremental step is one
+ * pause. Bucket 0 counts pauses under 1us, bucket i > 0 counts pauses of
+ * [2^(i-1), 2^i) us, and the last bucket everything longer.
+ */
+typedef struct {
+    uint64_t total;                      /**< Total pause time (ns) */
+    uint64_t max;                        /**< Longest pause (ns) */
+    uint64_t pauses;                     /**< Number of pauses */
+    uint64_t buckets[GC_PAUSE_BUCKETS];  /**< Pause counts by duration */
+} GCPauseHistogram;
+
 /**
  * @brief Performance monitoring counters
  * 
@@ -169,15 +200,73 @@ typedef struct {
     uint64_t function_calls;         /**< Number of function calls */
     uint64_t memory_allocations;     /**< Number of memory allocations */
     uint64_t gc_collections;         /**< Garbage collection cycles */
+    uint64_t gc_minor_collections;   /**< Nursery (minor) collections */
     uint64_t cache_hits;             /**< Cache hits (if caching enabled) */
     uint64_t cache_misses;           /**< Cache misses */
     
     // Timing information (in nanoseconds)
     uint64_t execution_time;         /**< Total execution time */
-    uint64_t gc_time;                /**< Time spent in garbage collection */
+    GCPauseHistogram gc_time;        /**< Garbage collection pauses */
     uint64_t compilation_time;       /**< Time spent compiling */
 } PerformanceCounters;
 
+/** Number of hash slots for opcode-triple counts */
+#define OPCODE_TRIPLE_SLOTS 4096
+
+/**
+ * @brief Dynamic opcode sequence profile
+ * 
+ * Counts executed opcodes, adjacent opcode pairs and triples. Used to pick
+ * superinstruction candidates. Superinstructions are counted as the opcodes
+ * they stand for, since the instrumented loop executes them unfused.
+ */
+typedef struct {
+    uint64_t singles[256];           /**< Per-opcode counts */
+    uint64_t pairs[256][256];        /**< pairs[a][b]: a immediately followed by b */
+    struct {
+        uint32_t key;                /**< (a << 16 | b << 8 | c) + 1, 0 if empty */
+        uint64_t count;              /**< Executions of the triple */
+    } triples[OPCODE_TRIPLE_SLOTS];  /**< Open-addressed triple counts */
+    uint64_t dropped_triples;        /**< Triples not recorded (table full) */
+    int16_t previous[2];             /**< Last two opcodes, -1 if none */
+} OpcodeProfile;
+
+/** Most allocation sites tracked; later sites are counted as site 0 */
+#define ALLOCATION_SITE_LIMIT 4096
+
+/**
+ * @brief Objects allocated by one instruction
+ * 
+ * Live and retained figures describe the heap as of the last snapshot.
+ * The retained size of a site is the memory that would become garbage if
+ * its objects did. It is estimated from the tree in which each object hangs
+ * off the object that marked it, rather than a full dominator tree, by
+ * summing the subtrees of the site's objects whose parent is not its own.
+ */
+typedef struct {
+    uint32_t address;                /**< Allocating instruction, UINT32_MAX for site 0 */
+    uint64_t allocations;            /**< Objects allocated */
+    uint64_t bytes;                  /**< Bytes allocated, including buffer growth */
+    uint64_t live_objects;           /**< Objects alive at the last snapshot */
+    uint64_t live_bytes;             /**< Bytes alive at the last snapshot */
+    uint64_t retained_bytes;         /**< Bytes retained at the last snapshot */
+} AllocationSite;
+
+/**
+ * @brief Allocation-site profile
+ * 
+ * Every object allocated while the VM runs is tagged (Obj.site) with the
+ * site of the instruction that allocated it. Site 0 collects allocations
+ * made outside any instruction, such as by the host.
+ */
+typedef struct {
+    AllocationSite* sites;           /**< Sites, indexed by Obj.site */
+    uint32_t count;                  /**< Sites in use, including site 0 */
+    uint32_t capacity;               /**< Allocated sites */
+    uint16_t* site_of;               /**< Site of each instruction address, 0 if none yet */
+    uint32_t address_count;          /**< Entries in site_of */
+} AllocationProfile;
+
 // =============================================================================
 // REGISTER VM STATE
 // =============================================================================
@@ -190,7 +279,14 @@ typedef struct {
  */
 typedef struct RegisterVM {
     // Register file
-    Value registers[TOTAL_REGISTER_COUNT]; /**< All VM registers */
+    Value* registers;                /**< Current frame's window (R0) */
+    Value* register_stack;           /**< Register stack shared by all frames */
+    size_t register_stack_capacity;  /**< Allocated register stack slots */
+    size_t register_base;            /**< Stack index of the current window */
+    
+    // Typed register lanes (untagged, only valid where the compiler proved the type)
+    int64_t int_lanes[LANE_REGISTER_COUNT];  /**< i64 lane registers I0-I31 */
+    double float_lanes[LANE_REGISTER_COUNT]; /**< f64 lane registers F0-F31 */
     
     // Execution state
     uint32_t ip;                     /**< Instruction pointer */
@@ -203,8 +299,9 @@ typedef struct RegisterVM {
     
     // Call stack
     CallFrame* current_frame;        /**< Current function call frame */
-    CallFrame call_stack[MAX_CALL_STACK_DEPTH]; /**< Call stack storage */
-    uint16_t call_depth;             /**< Current call stack depth */
+    CallFrame* call_stack;           /**< Call stack storage */
+    uint32_t call_stack_capacity;    /**< Allocated call frames */
+    uint32_t call_depth;             /**< Current call stack depth */
     
     // Exception handling
     ExceptionHandler* current_handler; /**< Current exception handler */
@@ -216,9 +313,27 @@ typedef struct RegisterVM {
     size_t bytes_allocated;          /**< Total bytes allocated */
     size_t next_gc;                  /**< Threshold for next GC */
     bool gc_running;                 /**< GC execution state */
+    bool gc_stress;                  /**< Collect before every allocation */
+    
+    // Young generation
+    uint8_t* nursery;                /**< Bump-allocated space for new objects */
+    uint8_t* nursery_top;            /**< Next free nursery byte */
+    uint8_t* nursery_end;            /**< End of the nursery */
+    Obj** remembered_set;            /**< Old objects that may point into the nursery */
+    size_t remembered_count;         /**< Entries in the remembered set */
+    size_t remembered_capacity;      /**< Remembered set capacity */
+    
+    // Incremental old-space collection
+    bool gc_incremental;             /**< Collect in steps between instructions */
+    size_t gc_step_work;             /**< Objects traced or swept per step */
+    uint8_t gc_phase;                /**< GCPhase of the current cycle */
+    Obj* gc_sweep;                   /**< Objects the current sweep has yet to visit */
+    Obj* gc_sweep_permanent;         /**< Permanent objects whose marks are yet to be cleared */
     
     // Performance monitoring
     PerformanceCounters* perf;       /**< Performance counters (NULL if disabled) */
+    OpcodeProfile* opcode_profile;   /**< Opcode sequence profile (NULL if disabled) */
+    AllocationProfile* alloc_profile; /**< Allocation-site profile (NULL if disabled) */
     
     // Debug support
     bool debug_mode;                 /**< Debug mode enabled */
@@ -358,13 +473,53 @@ static inline void registervm_set_flags(RegisterVM* vm, uint8_t flags) {
 // MEMORY MANAGEMENT INTEGRATION
 // =============================================================================
 
+/** Objects traced or swept per incremental step unless configured */
+#define GC_DEFAULT_STEP_WORK 1000
+
 /**
  * @brief Trigger garbage collection
  * 
+ * Runs a full collection, completing any incremental cycle in progress.
+ * 
  * @param vm Pointer to VM instance
  */
 void registervm_gc_collect(RegisterVM* vm);
 
+/**
+ * @brief Do the collection work that allocation pacing calls for
+ *
+ * A full collection, or in incremental mode one bounded step of the
+ * current cycle (starting one if none is in progress).
+ *
+ * @param vm Pointer to VM instance
+ */
+void registervm_gc_step(RegisterVM* vm);
+
+/**
+ * @brief Interleave old-space collection with execution
+ *
+ * In incremental mode each step traces or sweeps at most `step_work`
+ * objects, which bounds the pause; marking ends with one short pause that
+ * rescans the roots and empties the nursery. Also enabled at init time by
+ * setting ORUS_GC_INCREMENTAL, whose value, if a number, is `step_work`.
+ *
+ * @param vm Pointer to VM instance
+ * @param enabled Whether to collect incrementally
+ * @param step_work Objects per step, 0 for GC_DEFAULT_STEP_WORK
+ */
+void registervm_set_gc_incremental(RegisterVM* vm, bool enabled, size_t step_work);
+
+/**
+ * @brief Empty the nursery
+ *
+ * Promotes the nursery objects reachable from the roots and the remembered
+ * set to the old space and resets the bump pointer. registervm_gc_collect
+ * runs one first, so full collections only ever see old objects.
+ *
+ * @param vm Pointer to VM instance
+ */
+void registervm_gc_minor(RegisterVM* vm);
+
 /**
  * @brief Mark VM roots for garbage collection
  * 
@@ -372,6 +527,17 @@ void registervm_gc_collect(RegisterVM* vm);
  */
 void registervm_gc_mark_roots(RegisterVM* vm);
 
+/**
+ * @brief Collect before every heap allocation while the VM runs
+ *
+ * Shakes out objects that are live but unreachable from the roots. Also
+ * enabled at init time by setting the ORUS_GC_STRESS environment variable.
+ *
+ * @param vm Pointer to VM instance
+ * @param enabled Whether stress collection is on
+ */
+void registervm_set_gc_stress(RegisterVM* vm, bool enabled);
+
 // =============================================================================
 // DEBUG AND PROFILING
 // =============================================================================
@@ -399,6 +565,121 @@ void registervm_disable_profiling(RegisterVM* vm);
  */
 const PerformanceCounters* registervm_get_performance(const RegisterVM* vm);
 
+/**
+ * @brief Enable opcode pair/triple profiling
+ * 
+ * Execution switches to the instrumented loop while enabled. Setting
+ * ORUS_OPCODE_PROFILE enables it at init time, and orusc then prints the
+ * profile after the program runs.
+ * 
+ * @param vm Pointer to VM instance
+ * @return true on success, false on failure
+ */
+bool registervm_enable_opcode_profiling(RegisterVM* vm);
+
+/**
+ * @brief Disable opcode pair/triple profiling and free its counters
+ * 
+ * @param vm Pointer to VM instance
+ */
+void registervm_disable_opcode_profiling(RegisterVM* vm);
+
+/**
+ * @brief Get opcode sequence profile
+ * 
+ * @param vm Pointer to VM instance
+ * @return Pointer to profile (NULL if disabled)
+ */
+const OpcodeProfile* registervm_get_opcode_profile(const RegisterVM* vm);
+
+/**
+ * @brief Print the most frequent opcode pairs and triples
+ * 
+ * @param vm Pointer to VM instance
+ * @param top_n Number of entries to print for each table
+ */
+void registervm_print_opcode_profile(const RegisterVM* vm, int top_n);
+
+/**
+ * @brief Print the GC pause histogram (times in microseconds)
+ *
+ * Pauses are only timed while profiling is enabled. Setting ORUS_GC_PAUSES
+ * enables it at init time, and orusc then prints the histogram after the
+ * program runs.
+ * 
+ * @param vm Pointer to VM instance
+ */
+void registervm_print_gc_pauses(const RegisterVM* vm);
+
+/**
+ * @brief Enable allocation-site profiling
+ * 
+ * Objects allocated from now on are attributed to their allocating
+ * instruction. Enable it before execution starts.
+ * 
+ * @param vm Pointer to VM instance
+ * @return true on success, false on failure
+ */
+bool registervm_enable_allocation_profiling(RegisterVM* vm);
+
+/**
+ * @brief Disable allocation-site profiling and free its counters
+ * 
+ * @param vm Pointer to VM instance
+ */
+void registervm_disable_allocation_profiling(RegisterVM* vm);
+
+/**
+ * @brief Get allocation-site profile
+ * 
+ * @param vm Pointer to VM instance
+ * @return Pointer to profile (NULL if disabled)
+ */
+const AllocationProfile* registervm_get_allocation_profile(const RegisterVM* vm);
+
+/**
+ * @brief Attribute a new object to the instruction being executed
+ * 
+ * Called by the allocator while allocation profiling is enabled.
+ * 
+ * @param vm Pointer to VM instance
+ * @param object Newly allocated object
+ * @param size Bytes allocated for it
+ */
+void registervm_record_allocation(RegisterVM* vm, Obj* object, size_t size);
+
+/**
+ * @brief Print the allocation sites that allocated the most bytes
+ * 
+ * Sites are printed as file:line when the chunk has debug information.
+ * Live and retained columns are those of the last heap snapshot.
+ * 
+ * @param vm Pointer to VM instance
+ * @param top_n Number of sites to print
+ */
+void registervm_print_allocation_profile(const RegisterVM* vm, int top_n);
+
+/**
+ * @brief Write a heap snapshot
+ * 
+ * Runs a full collection and, while the heap is marked, writes every
+ * reachable object with its size, retained size, allocation site and the
+ * object it was reached from, followed by per-site totals. Updates the
+ * live and retained figures of the allocation profile if enabled.
+ * 
+ * Format (one record per line, fields separated by spaces):
+ *   orus-heap-snapshot 1
+ *   objects <count>
+ *   <id> <type> <site> <size> <retained> <parent id, -1 for roots>
+ *   sites <count>
+ *   <site> <allocations> <bytes> <live objects> <live bytes> <retained> <location>
+ * 
+ * @param vm Pointer to VM instance
+ * @param out Stream to write to
+ * @return true on success, false if a collection is not possible now
+ */
+bool registervm_heap_snapshot(RegisterVM* vm, FILE* out);
+
 /**
  * @brief Print VM state for debugging
  * 
@@ -73,12 +73,8 @@ typedef struct {
     TokenType type;
 } KeywordEntry;
 
-void init_scanner(const char* source);
-Token scan_token();
-
-// Expose the global scanner instance so other modules (like the parser)
-// can access the raw source when producing error messages.
-extern Scanner scanner;
+void init_scanner(Scanner* scanner, const char* source);
+Token scan_token(Scanner* scanner);
 
 
 #endif
\ No newline at end of file
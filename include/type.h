@@ -87,6 +87,8 @@ void initTypeSystem(void);
 void freeTypeSystem(void);  // Add this
 Type* getPrimitiveType(TypeKind kind);
 void markTypeRoots();
+Type* promoteType(Type* type);
+void promoteTypeRoots();
 Type* substituteGenerics(Type* type, ObjString** names, Type** subs, int count);
 Type* instantiateStructType(Type* base, Type** args, int argCount);
 
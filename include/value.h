@@ -12,7 +12,15 @@ typedef struct ObjIntArray ObjIntArray;
 typedef struct ObjError ObjError;
 typedef struct ObjRangeIterator ObjRangeIterator;
 typedef struct ObjEnum ObjEnum;
+typedef struct ObjBoxedInt ObjBoxedInt;
+
+// Build with -DNAN_BOXING to pack every Value into 8 bytes. Doubles are
+// stored as-is; everything else lives in the payload of a quiet NaN.
+#ifdef NAN_BOXING
+typedef uint64_t Value;
+#else
 typedef struct Value Value;
+#endif
 
 // Base object type for the garbage collector
 typedef enum {
@@ -24,11 +32,15 @@ typedef enum {
     OBJ_ERROR,
     OBJ_RANGE_ITERATOR,
     OBJ_ENUM,
+    OBJ_BOXED_INT,
+    OBJ_STRING_BUILDER,
 } ObjType;
 
 struct Obj {
     ObjType type;
     bool marked;
+    bool remembered;     // Recorded in the remembered set since the last minor GC
+    uint16_t site;       // Allocation site in the VM's AllocationProfile, 0 if untracked
     Obj* next;
 };
 
@@ -45,25 +57,58 @@ typedef enum {
     VAL_ERROR,
     VAL_RANGE_ITERATOR,
     VAL_ENUM,
+    VAL_STRING_BUILDER,
 } ValueType;
 
 typedef struct ObjString {
     Obj obj;
     int length;
-    char* chars;
+    uint32_t hash;       // FNV-1a of chars, computed at allocation
+    bool interned;       // Canonical copy held by the intern table
+    char chars[];        // NUL-terminated, allocated with the header
 } ObjString;
 
+// Mutable string under construction. The compiler keeps one in a register
+// while a loop appends to a string local, so each append is amortized O(1)
+// instead of copying the whole prefix; it never escapes to user code.
+typedef struct ObjStringBuilder {
+    Obj obj;
+    int length;
+    int capacity;        // Bytes allocated for chars, including the NUL
+    char* chars;         // NUL-terminated, grown by doubling
+} ObjStringBuilder;
+
+// Storage of an array's elements. Arrays whose static element type is a
+// primitive keep the raw elements packed; a store of anything else converts
+// them to ARRAY_VALUES, which is what every other array uses.
+typedef enum {
+    ARRAY_VALUES,        // Value
+    ARRAY_I32,           // int32_t
+    ARRAY_I64,           // int64_t
+    ARRAY_U32,           // uint32_t
+    ARRAY_U64,           // uint64_t
+    ARRAY_F64,           // double
+    ARRAY_BOOL,          // uint8_t
+    ARRAY_PACKED,        // Packed but still empty; the first push picks the kind
+} ArrayKind;
+
 typedef struct ObjArray {
     Obj obj;
     int length;
-    int capacity;
-    Value* elements;
+    int capacity;        // In elements of the current kind
+    uint16_t shape;      // Struct shape id (1-based, see StructShape), 0 for plain arrays
+    uint8_t kind;        // ArrayKind of the elements
+    int inlineSize;      // Bytes allocated with the header; elements moves out when it grows
+    Value* elements;     // Values, or the packed elements for other kinds (ARRAY_DATA)
 } ObjArray;
 
+// Packed elements of an array of a primitive kind
+#define ARRAY_DATA(array, type) ((type*)(void*)(array)->elements)
+
 typedef struct ObjIntArray {
     Obj obj;
     int length;
-    int64_t* elements;
+    int64_t* elements;   // Allocated with the header
 } ObjIntArray;
 
 typedef struct ObjRangeIterator {
@@ -75,14 +120,181 @@ typedef struct ObjRangeIterator {
 typedef struct ObjEnum {
     Obj obj;
     int variantIndex;    // Which variant this enum value represents
-    Value* data;         // Data carried by this variant (NULL for unit variants)
+    Value* data;         // Data carried by this variant, allocated with the header (NULL for unit variants)
     int dataCount;       // Number of data fields
     ObjString* typeName; // Name of the enum type
 } ObjEnum;
 
+// Out-of-line storage for i64/u64 values too wide for a NaN-boxed payload
+typedef struct ObjBoxedInt {
+    Obj obj;
+    ValueType type;      // VAL_I64 or VAL_U64
+    union {
+        int64_t i64;
+        uint64_t u64;
+    } as;
+} ObjBoxedInt;
+
 typedef ObjString String;
 typedef ObjArray Array;
 
+#ifdef NAN_BOXING
+
+// Bit layout: a Value is a double unless all QNAN bits are set. Boxed values
+// use the sign bit and bits 48-49 as a tag and the low 48 bits as payload.
+#define SIGN_BIT         ((uint64_t)0x8000000000000000)
+#define QNAN             ((uint64_t)0x7ffc000000000000)
+#define NANBOX_TAG_MASK  (SIGN_BIT | QNAN | ((uint64_t)3 << 48))
+#define NANBOX_PAYLOAD   ((uint64_t)0x0000ffffffffffff)
+#define NANBOX_TAG(sign, tag) ((sign) | QNAN | ((uint64_t)(tag) << 48))
+
+#define NANBOX_U32       NANBOX_TAG(0, 0)
+#define NANBOX_NIL       NANBOX_TAG(0, 1)
+#define NANBOX_BOOL      NANBOX_TAG(0, 2)
+#define NANBOX_I32       NANBOX_TAG(0, 3)
+#define NANBOX_OBJ       NANBOX_TAG(SIGN_BIT, 0)
+#define NANBOX_I64       NANBOX_TAG(SIGN_BIT, 1) // 48-bit signed payload
+#define NANBOX_U64       NANBOX_TAG(SIGN_BIT, 2) // 48-bit unsigned payload
+
+// Range of 64-bit integers that fit in the payload without boxing
+#define NANBOX_I64_MIN   (-((int64_t)1 << 47))
+#define NANBOX_I64_MAX   (((int64_t)1 << 47) - 1)
+#define NANBOX_U64_MAX   ((uint64_t)NANBOX_PAYLOAD)
+
+// Allocate an out-of-line 64-bit integer (defined in memory.c)
+ObjBoxedInt* allocateBoxedInt(ValueType type, uint64_t bits);
+
+#define NANBOX_IS_TAG(value, tag) (((value) & NANBOX_TAG_MASK) == (tag))
+#define NANBOX_AS_OBJ(value) ((Obj*)(uintptr_t)((value) & NANBOX_PAYLOAD))
+#define NANBOX_OBJ_VAL(obj)  (NANBOX_OBJ | (uint64_t)(uintptr_t)(obj))
+
+static inline bool nanboxIsObjType(Value value, ObjType type) {
+    return NANBOX_IS_TAG(value, NANBOX_OBJ) && NANBOX_AS_OBJ(value) &&
+           NANBOX_AS_OBJ(value)->type == type;
+}
+
+static inline Value nanboxFromF64(double number) {
+    Value value;
+    if (number != number) {
+        return (Value)0x7ff8000000000000; // Canonical NaN never aliases a tag
+    }
+    memcpy(&value, &number, sizeof(double));
+    return value;
+}
+
+static inline double nanboxToF64(Value value) {
+    double number;
+    memcpy(&number, &value, sizeof(double));
+    return number;
+}
+
+static inline Value nanboxFromI64(int64_t number) {
+    if (number >= NANBOX_I64_MIN && number <= NANBOX_I64_MAX) {
+        return NANBOX_I64 | ((uint64_t)number & NANBOX_PAYLOAD);
+    }
+    return NANBOX_OBJ_VAL(allocateBoxedInt(VAL_I64, (uint64_t)number));
+}
+
+static inline Value nanboxFromU64(uint64_t number) {
+    if (number <= NANBOX_U64_MAX) {
+        return NANBOX_U64 | number;
+    }
+    return NANBOX_OBJ_VAL(allocateBoxedInt(VAL_U64, number));
+}
+
+static inline int64_t nanboxToI64(Value value) {
+    if (NANBOX_IS_TAG(value, NANBOX_I64)) {
+        // Sign-extend the 48-bit payload
+        return (int64_t)((value & NANBOX_PAYLOAD) ^ ((uint64_t)1 << 47)) -
+               ((int64_t)1 << 47);
+    }
+    return ((ObjBoxedInt*)NANBOX_AS_OBJ(value))->as.i64;
+}
+
+static inline uint64_t nanboxToU64(Value value) {
+    if (NANBOX_IS_TAG(value, NANBOX_U64)) {
+        return value & NANBOX_PAYLOAD;
+    }
+    return ((ObjBoxedInt*)NANBOX_AS_OBJ(value))->as.u64;
+}
+
+static inline bool nanboxIsBoxedInt(Value value, ValueType type) {
+    return nanboxIsObjType(value, OBJ_BOXED_INT) &&
+           ((ObjBoxedInt*)NANBOX_AS_OBJ(value))->type == type;
+}
+
+// Value creation macros
+#define I32_VAL(value)   (NANBOX_I32 | (uint64_t)(uint32_t)(int32_t)(value))
+#define I64_VAL(value)   nanboxFromI64((int64_t)(value))
+#define U32_VAL(value)   (NANBOX_U32 | (uint64_t)(uint32_t)(value))
+#define U64_VAL(value)   nanboxFromU64((uint64_t)(value))
+#define F64_VAL(value)   nanboxFromF64((double)(value))
+#define BOOL_VAL(value)  (NANBOX_BOOL | ((value) ? 1 : 0))
+#define NIL_VAL          ((Value)NANBOX_NIL)
+#define STRING_VAL(obj)  NANBOX_OBJ_VAL(obj)
+#define ARRAY_VAL(obj)   NANBOX_OBJ_VAL(obj)
+#define ERROR_VAL(obj)   NANBOX_OBJ_VAL(obj)
+#define RANGE_ITERATOR_VAL(obj) NANBOX_OBJ_VAL(obj)
+#define ENUM_VAL(obj)    NANBOX_OBJ_VAL(obj)
+#define STRING_BUILDER_VAL(obj) NANBOX_OBJ_VAL(obj)
+
+// Value checking macros
+#define IS_I32(value)    NANBOX_IS_TAG(value, NANBOX_I32)
+#define IS_I64(value)    (NANBOX_IS_TAG(value, NANBOX_I64) || nanboxIsBoxedInt(value, VAL_I64))
+#define IS_U32(value)    NANBOX_IS_TAG(value, NANBOX_U32)
+#define IS_U64(value)    (NANBOX_IS_TAG(value, NANBOX_U64) || nanboxIsBoxedInt(value, VAL_U64))
+#define IS_F64(value)    (((value) & QNAN) != QNAN)
+#define IS_BOOL(value)   NANBOX_IS_TAG(value, NANBOX_BOOL)
+#define IS_NIL(value)    ((value) == NANBOX_NIL)
+#define IS_STRING(value) nanboxIsObjType(value, OBJ_STRING)
+#define IS_ARRAY(value)  nanboxIsObjType(value, OBJ_ARRAY)
+#define IS_ERROR(value)  nanboxIsObjType(value, OBJ_ERROR)
+#define IS_RANGE_ITERATOR(value) nanboxIsObjType(value, OBJ_RANGE_ITERATOR)
+#define IS_ENUM(value)   nanboxIsObjType(value, OBJ_ENUM)
+#define IS_STRING_BUILDER(value) nanboxIsObjType(value, OBJ_STRING_BUILDER)
+
+// Value extraction macros
+#define AS_I32(value)    ((int32_t)(uint32_t)(value))
+#define AS_I64(value)    nanboxToI64(value)
+#define AS_U32(value)    ((uint32_t)(value))
+#define AS_U64(value)    nanboxToU64(value)
+#define AS_F64(value)    nanboxToF64(value)
+#define AS_BOOL(value)   (((value) & 1) != 0)
+#define AS_STRING(value) ((ObjString*)NANBOX_AS_OBJ(value))
+#define AS_ARRAY(value)  ((ObjArray*)NANBOX_AS_OBJ(value))
+#define AS_ERROR(value)  ((ObjError*)NANBOX_AS_OBJ(value))
+#define AS_RANGE_ITERATOR(value) ((ObjRangeIterator*)NANBOX_AS_OBJ(value))
+#define AS_ENUM(value)   ((ObjEnum*)NANBOX_AS_OBJ(value))
+#define AS_STRING_BUILDER(value) ((ObjStringBuilder*)NANBOX_AS_OBJ(value))
+
+static inline ValueType nanboxValueType(Value value) {
+    if (IS_F64(value)) return VAL_F64;
+    switch (value & NANBOX_TAG_MASK) {
+        case NANBOX_I32: return VAL_I32;
+        case NANBOX_U32: return VAL_U32;
+        case NANBOX_BOOL: return VAL_BOOL;
+        case NANBOX_NIL: return VAL_NIL;
+        case NANBOX_I64: return VAL_I64;
+        case NANBOX_U64: return VAL_U64;
+        default: break;
+    }
+    switch (NANBOX_AS_OBJ(value)->type) {
+        case OBJ_STRING: return VAL_STRING;
+        case OBJ_ARRAY: return VAL_ARRAY;
+        case OBJ_ERROR: return VAL_ERROR;
+        case OBJ_RANGE_ITERATOR: return VAL_RANGE_ITERATOR;
+        case OBJ_ENUM: return VAL_ENUM;
+        case OBJ_STRING_BUILDER: return VAL_STRING_BUILDER;
+        case OBJ_BOXED_INT: return ((ObjBoxedInt*)NANBOX_AS_OBJ(value))->type;
+        default: return VAL_NIL;
+    }
+}
+
+// Runtime type tag of a value
+#define VALUE_TYPE(value) nanboxValueType(value)
+
+#else
+
 typedef struct Value {
     ValueType type;
     union {
@@ -97,6 +309,7 @@ typedef struct Value {
         ObjError* error;
         ObjRangeIterator* rangeIter;
         ObjEnum* enumValue;
+        ObjStringBuilder* builder;
     } as;
 } Value;
 
@@ -113,6 +326,7 @@ typedef struct Value {
 #define ERROR_VAL(obj)   ((Value){VAL_ERROR, {.error = obj}})
 #define RANGE_ITERATOR_VAL(obj) ((Value){VAL_RANGE_ITERATOR, {.rangeIter = obj}})
 #define ENUM_VAL(obj)    ((Value){VAL_ENUM, {.enumValue = obj}})
+#define STRING_BUILDER_VAL(obj) ((Value){VAL_STRING_BUILDER, {.builder = obj}})
 
 // Value checking macros
 #define IS_I32(value)    ((value).type == VAL_I32)
@@ -127,6 +341,7 @@ typedef struct Value {
 #define IS_ERROR(value)  ((value).type == VAL_ERROR)
 #define IS_RANGE_ITERATOR(value) ((value).type == VAL_RANGE_ITERATOR)
 #define IS_ENUM(value)   ((value).type == VAL_ENUM)
+#define IS_STRING_BUILDER(value) ((value).type == VAL_STRING_BUILDER)
 
 // Value extraction macros
 #define AS_I32(value)    ((value).as.i32)
@@ -140,6 +355,12 @@ typedef struct Value {
 #define AS_ERROR(value)  ((value).as.error)
 #define AS_RANGE_ITERATOR(value) ((value).as.rangeIter)
 #define AS_ENUM(value)   ((value).as.enumValue)
+#define AS_STRING_BUILDER(value) ((value).as.builder)
+
+// Runtime type tag of a value
+#define VALUE_TYPE(value) ((value).type)
+
+#endif // NAN_BOXING
 
 // Generic dynamic array implementation used for storing Values.
 #include "generic_array.h"
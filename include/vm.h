@@ -0,0 +1,87 @@
+#ifndef clox_vm_h
+#define clox_vm_h
+
+#include "common.h"
+#include "chunk.h"
+#include "value.h"
+#include "type.h"
+#include "ast.h"
+
+// Signature of a native function: receives its arguments, returns its result
+typedef Value (*NativeFn)(int argCount, Value* args);
+
+// Name of a global slot
+typedef struct {
+    ObjString* name;
+    int length;
+} VariableInfo;
+
+// Function compiled into a stack Chunk by the legacy back end
+typedef struct {
+    int start;
+    uint8_t arity;
+    Chunk* chunk;
+    uint8_t paramIndices[UINT8_COUNT];
+} Function;
+
+typedef struct {
+    ObjString* name;
+    int arity;            // -1 for variadic
+    NativeFn function;
+    Type* returnType;     // NULL when the result type depends on the arguments
+} NativeFunction;
+
+// Global slots a program and all of its modules may declare between them.
+// The compiler addresses globals with a uint8_t and uses UINT8_MAX for an
+// unresolved name, so the last entry of the tables below is never handed out.
+#define MAX_GLOBALS UINT8_MAX
+
+// Process-wide compiler and driver state. Globals are absolute slots shared
+// by the program and every module it imports; the tables below describe
+// each slot. Execution state lives in RegisterVM.
+typedef struct {
+    Value globals[UINT8_COUNT];
+    Type* globalTypes[UINT8_COUNT];
+    bool publicGlobals[UINT8_COUNT];
+    VariableInfo variableNames[UINT8_COUNT];
+    ASTNode* functionDecls[UINT8_COUNT];
+    int variableCount;
+
+    Function functions[UINT8_COUNT];
+    int functionCount;
+
+    NativeFunction nativeFunctions[UINT8_COUNT];
+    int nativeFunctionCount;
+
+    ASTNode* astRoot;       // Program being compiled
+    const char* filePath;   // Script being compiled or run
+    const char* stdPath;    // Standard library directory
+    const char* cachePath;  // Module cache directory, NULL to disable
+    bool devMode;
+    bool trace;
+} VM;
+
+extern VM vm;
+
+// Type of each global slot as seen by the type checker
+extern Type* variableTypes[UINT8_COUNT];
+
+void initVM(void);
+void freeVM(void);
+
+// Register a native function; its index is what CALL_STATIC names
+void defineNative(const char* name, NativeFn function, int arity, Type* returnType);
+// Index of a native function, or -1 if there is none with that name
+int findNative(ObjString* name);
+
+// Report an error from a native function. The call it was raised in fails
+// with this message once the native returns.
+void vmRuntimeError(const char* format, ...);
+// Error raised by the last native call, or NIL_VAL; clears it
+Value takeNativeError(void);
+
+// Run native `index` on `argCount` arguments. Returns false with the error
+// value in `result` if the call fails.
+bool callNative(int index, int argCount, Value* args, Value* result);
+
+#endif
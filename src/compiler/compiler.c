@@ -8,7 +8,10 @@
 
 #include "../../include/memory.h"
 #include "../../include/chunk.h"
-#include "../../include/reg_ir.h"
+#include "../../include/register_allocator.h"
+#include "../../include/register_chunk.h"
+#include "../../include/register_opcodes.h"
+#include "../../include/register_vm.h"
 #include "../../include/value.h"
 #include "../../include/ast.h"
 #include "../../include/vm.h"
@@ -80,6 +83,7 @@ static void patchContinueJumps(Compiler* compiler);
 static void emitForLoop(Compiler* compiler, ASTNode* node);
 void disassembleChunk(Chunk* chunk, const char* name);
 static void predeclareFunction(Compiler* compiler, ASTNode* node);
+static void recordModuleImport(Compiler* compiler, Module* module, Export* ex);
 
 static void deduceGenerics(Type* expected, Type* actual,
                            ObjString** names, Type** subs, int count) {
@@ -403,7 +407,7 @@ static bool convertLiteralForDecl(ASTNode* init, Type* src, Type* dst) {
 static Value convertLiteralToString(Value value) {
     char buffer[64];
     int length = 0;
-    switch (value.type) {
+    switch (VALUE_TYPE(value)) {
         case VAL_I32:
             length = snprintf(buffer, sizeof(buffer), "%d", AS_I32(value));
             break;
@@ -443,12 +447,6 @@ static void writeByte(Compiler* compiler, uint8_t byte) {
     writeChunk(compiler->chunk, byte, compiler->currentLine, compiler->currentColumn);
 }
 
-// Forward declarations for register mode functions - Phase 1.1 enhancement
-static uint8_t allocateRegister(Compiler* compiler);
-static void pushRegister(Compiler* compiler, uint8_t reg);
-static uint8_t popRegister(Compiler* compiler);
-static void writeRegisterOp(Compiler* compiler, RegisterOp op, uint8_t dst, uint8_t src1, uint8_t src2);
-
 static int makeConstant(Compiler* compiler, ObjString* string) {
     Value value = STRING_VAL(string);
     int constant = addConstant(compiler->chunk, value);
@@ -460,9 +458,9 @@ static void emitConstant(Compiler* compiler, Value value) {
     if (IS_I32(value) || IS_I64(value) || IS_U32(value) || IS_U64(value) ||
         IS_F64(value) || IS_BOOL(value) || IS_NIL(value) || IS_STRING(value)) {
         if (IS_STRING(value)) {
-            ObjString* copy = allocateString(value.as.string->chars,
-                                            value.as.string->length);
-            value.as.string = copy;
+            ObjString* copy = allocateString(AS_STRING(value)->chars,
+                                            AS_STRING(value)->length);
+            value = STRING_VAL(copy);
         }
 
         if (IS_I64(value)) {
@@ -484,7 +482,7 @@ static void emitConstant(Compiler* compiler, Value value) {
     } else {
         // fprintf(stderr, "ERROR: Invalid constant type\n");
         // Debug log to trace invalid constants
-        // fprintf(stderr, "DEBUG: Invalid constant encountered. Value type: %d\n", value.type);
+        // fprintf(stderr, "DEBUG: Invalid constant encountered. Value type: %d\n", VALUE_TYPE(value));
         // fprintf(stderr, "DEBUG: Value details: ");
         // printValue(value);
         // fprintf(stderr, "\n");
@@ -542,7 +540,8 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
                     } else if ((typesEqual(leftType, rightType) && leftType->kind == TYPE_GENERIC) ||
                                (typesEqual(leftType, rightType) &&
                                 (leftType->kind == TYPE_I32 || leftType->kind == TYPE_I64 ||
-                                 leftType->kind == TYPE_U32 || leftType->kind == TYPE_F64))) {
+                                 leftType->kind == TYPE_U32 || leftType->kind == TYPE_U64 ||
+                                 leftType->kind == TYPE_F64))) {
                         node->valueType = leftType;
                         node->data.operation.convertLeft = false;
                         node->data.operation.convertRight = false;
@@ -570,7 +569,8 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
                     if ((typesEqual(leftType, rightType) && leftType->kind == TYPE_GENERIC) ||
                         (typesEqual(leftType, rightType) &&
                          (leftType->kind == TYPE_I32 || leftType->kind == TYPE_I64 ||
-                          leftType->kind == TYPE_U32 || leftType->kind == TYPE_F64))) {
+                          leftType->kind == TYPE_U32 || leftType->kind == TYPE_U64 ||
+                          leftType->kind == TYPE_F64))) {
                         node->valueType = leftType;
                         node->data.operation.convertLeft = false;
                         node->data.operation.convertRight = false;
@@ -594,7 +594,8 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
                     }
                     if ((typesEqual(leftType, rightType) && leftType->kind == TYPE_GENERIC) ||
                         (typesEqual(leftType, rightType) &&
-                         (leftType->kind == TYPE_I32 || leftType->kind == TYPE_I64 || leftType->kind == TYPE_U32))) {
+                         (leftType->kind == TYPE_I32 || leftType->kind == TYPE_I64 ||
+                          leftType->kind == TYPE_U32 || leftType->kind == TYPE_U64))) {
                         node->valueType = leftType;
                         node->data.operation.convertLeft = false;
                         node->data.operation.convertRight = false;
@@ -1398,6 +1399,12 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
                 return;
             }
 
+            // The parser types the implicit step before casts in the range
+            // are resolved; a literal step takes the iterator's type
+            if (stepType && stepType->kind != startType->kind) {
+                convertLiteralForDecl(node->data.forStmt.stepExpr, stepType, startType);
+            }
+
             beginScope(compiler);
             // Define the iterator variable
             uint8_t index = defineVariable(compiler, node->data.forStmt.iteratorName, startType);
@@ -1794,6 +1801,7 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
                             fname, mod->module_name);
                     return;
                 }
+                recordModuleImport(compiler, mod, ex);
                 index = ex->index;
             } else {
                 index = resolveVariable(compiler, node->data.call.name);
@@ -2121,6 +2129,7 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
                                 fieldName, sym->module->module_name);
                         return;
                     }
+                    recordModuleImport(compiler, sym->module, ex);
                     node->type = AST_VARIABLE;
                     node->data.variable.name = node->data.field.fieldName;
                     node->data.variable.index = ex->index;
@@ -2404,6 +2413,35 @@ static void typeCheckNode(Compiler* compiler, ASTNode* node) {
  * @param compiler Active compiler instance.
  * @param node     AST node to translate.
  */
+// Find the `<Struct>_to_string` function used when printing struct values,
+// looking first at local symbols and then at imported module exports.
+static uint8_t resolveToStringFunction(Compiler* compiler, Type* structType) {
+    const char* structName = structType->info.structure.name->chars;
+    size_t len = strlen(structName);
+    const char* suffix = "_to_string";
+    char* temp = (char*)malloc(len + strlen(suffix) + 1);
+    memcpy(temp, structName, len);
+    memcpy(temp + len, suffix, strlen(suffix) + 1);
+    Symbol* sym = findSymbol(&compiler->symbols, temp);
+    uint8_t callIndex = UINT8_MAX;
+    if (sym) {
+        callIndex = sym->index;
+    } else {
+        for (int si = 0; si < compiler->symbols.count; si++) {
+            Symbol* modSym = &compiler->symbols.symbols[si];
+            if (!modSym->active || !modSym->isModule || !modSym->module) continue;
+            Export* ex = get_export(modSym->module, temp);
+            if (ex) {
+                recordModuleImport(compiler, modSym->module, ex);
+                callIndex = ex->index;
+                break;
+            }
+        }
+    }
+    free(temp);
+    return callIndex;
+}
+
 static void generateCode(Compiler* compiler, ASTNode* node) {
     if (!node || compiler->hadError) {
         return;
@@ -2421,17 +2459,8 @@ static void generateCode(Compiler* compiler, ASTNode* node) {
                 // printValue(node->data.literal);
                 // fprintf(stderr, "\n");
             }
-            
-            if (compiler->isRegisterMode) {
-                // Direct register VM compilation - Phase 1.1 enhancement
-                uint8_t dstReg = allocateRegister(compiler);
-                int constIndex = addRegisterConstant(compiler->rchunk, node->data.literal);
-                writeRegisterOp(compiler, ROP_LOAD_CONST, dstReg, (uint8_t)constIndex, 0);
-                pushRegister(compiler, dstReg);
-            } else {
-                // Legacy stack VM compilation
-                emitConstant(compiler, node->data.literal);
-            }
+
+            emitConstant(compiler, node->data.literal);
             break;
         }
 
@@ -3178,31 +3207,13 @@ static void generateCode(Compiler* compiler, ASTNode* node) {
                 // Automatically call `to_string` for struct values if available
                 if (node->data.print.format->valueType &&
                     node->data.print.format->valueType->kind == TYPE_STRUCT) {
-                    const char* structName =
-                        node->data.print.format->valueType->info.structure.name->chars;
-                    size_t len = strlen(structName);
-                    const char* suffix = "_to_string";
-                    char* temp = (char*)malloc(len + strlen(suffix) + 1);
-                    memcpy(temp, structName, len);
-                    memcpy(temp + len, suffix, strlen(suffix) + 1);
-                    Symbol* sym = findSymbol(&compiler->symbols, temp);
-                    uint8_t callIndex = UINT8_MAX;
-                    if (sym) {
-                        callIndex = sym->index;
-                    } else {
-                        for (int si = 0; si < compiler->symbols.count; si++) {
-                            Symbol* modSym = &compiler->symbols.symbols[si];
-                            if (!modSym->active || !modSym->isModule || !modSym->module) continue;
-                            Export* ex = get_export(modSym->module, temp);
-                            if (ex) { callIndex = ex->index; break; }
-                        }
-                    }
+                    uint8_t callIndex = resolveToStringFunction(
+                        compiler, node->data.print.format->valueType);
                     if (callIndex != UINT8_MAX) {
                         writeOp(compiler, OP_CALL);
                         writeOp(compiler, callIndex);
                         writeOp(compiler, 1);
                     }
-                    free(temp);
                 }
 
                 Type* t = node->data.print.format->valueType;
@@ -3294,37 +3305,12 @@ static void generateCode(Compiler* compiler, ASTNode* node) {
 
         case AST_FIELD_SET: {
             compiler->currentColumn = tokenColumn(compiler, &node->data.fieldSet.fieldName);
-            
-            if (compiler->isRegisterMode) {
-                // Direct register VM compilation - Phase 1.1 enhancement
-                generateCode(compiler, node->right); // Generate struct object
-                if (compiler->hadError) return;
-                
-                generateCode(compiler, node->left); // Generate new value
-                if (compiler->hadError) return;
-                
-                uint8_t valueReg = popRegister(compiler);  // Get value register
-                uint8_t structReg = popRegister(compiler); // Get struct register
-                uint8_t indexReg = allocateRegister(compiler); // Allocate index register
-                
-                // Load field index as constant
-                int constIndex = addRegisterConstant(compiler->rchunk, I32_VAL(node->data.fieldSet.index));
-                writeRegisterOp(compiler, ROP_LOAD_CONST, indexReg, (uint8_t)constIndex, 0);
-                
-                // Emit ROP_ARRAY_SET: dst=struct, src1=index, src2=value (structs use same implementation as arrays)
-                writeRegisterOp(compiler, ROP_ARRAY_SET, structReg, indexReg, valueReg);
-                
-                // Field assignment typically doesn't push a result, but we could push the struct back
-                pushRegister(compiler, structReg);
-            } else {
-                // Legacy stack VM compilation
-                generateCode(compiler, node->right); // object
-                if (compiler->hadError) return;
-                emitConstant(compiler, I32_VAL(node->data.fieldSet.index));
-                generateCode(compiler, node->left); // value
-                if (compiler->hadError) return;
-                writeOp(compiler, OP_ARRAY_SET);
-            }
+            generateCode(compiler, node->right); // object
+            if (compiler->hadError) return;
+            emitConstant(compiler, I32_VAL(node->data.fieldSet.index));
+            generateCode(compiler, node->left); // value
+            if (compiler->hadError) return;
+            writeOp(compiler, OP_ARRAY_SET);
             break;
         }
 
@@ -3344,68 +3330,25 @@ static void generateCode(Compiler* compiler, ASTNode* node) {
 
         case AST_STRUCT_LITERAL: {
             compiler->currentColumn = tokenColumn(compiler, &node->data.structLiteral.name);
-            
-            if (compiler->isRegisterMode) {
-                // Direct register VM compilation - Phase 1.1 enhancement
-                uint8_t dstReg = allocateRegister(compiler);
-                int count = 0;
-                
-                // Generate code for each field value, storing in consecutive registers
-                ASTNode* val = node->data.structLiteral.values;
-                uint8_t firstFieldReg = compiler->nextRegister;
-                
-                while (val) {
-                    generateCode(compiler, val);
-                    if (compiler->hadError) return;
-                    count++;
-                    val = val->next;
-                }
-                
-                // Emit ROP_MAKE_ARRAY: dst=result, src1=field_count, src2=first_field_reg (structs use same implementation as arrays)
-                writeRegisterOp(compiler, ROP_MAKE_ARRAY, dstReg, (uint8_t)count, firstFieldReg);
-                pushRegister(compiler, dstReg);
-            } else {
-                // Legacy stack VM compilation
-                int count = 0;
-                ASTNode* val = node->data.structLiteral.values;
-                while (val) {
-                    generateCode(compiler, val);
-                    if (compiler->hadError) return;
-                    count++;
-                    val = val->next;
-                }
-                writeOp(compiler, OP_MAKE_ARRAY);
-                writeOp(compiler, count);
+            int count = 0;
+            ASTNode* val = node->data.structLiteral.values;
+            while (val) {
+                generateCode(compiler, val);
+                if (compiler->hadError) return;
+                count++;
+                val = val->next;
             }
+            writeOp(compiler, OP_MAKE_ARRAY);
+            writeOp(compiler, count);
             break;
         }
 
         case AST_FIELD: {
             compiler->currentColumn = tokenColumn(compiler, &node->data.field.fieldName);
-            
-            if (compiler->isRegisterMode) {
-                // Direct register VM compilation - Phase 1.1 enhancement
-                generateCode(compiler, node->left);  // Generate struct object
-                if (compiler->hadError) return;
-                
-                uint8_t structReg = popRegister(compiler);  // Get struct register
-                uint8_t dstReg = allocateRegister(compiler);  // Allocate result register
-                uint8_t indexReg = allocateRegister(compiler);  // Allocate index register
-                
-                // Load field index as constant
-                int constIndex = addRegisterConstant(compiler->rchunk, I32_VAL(node->data.field.index));
-                writeRegisterOp(compiler, ROP_LOAD_CONST, indexReg, (uint8_t)constIndex, 0);
-                
-                // Emit ROP_ARRAY_GET: dst=result, src1=struct, src2=index (structs use same implementation as arrays)
-                writeRegisterOp(compiler, ROP_ARRAY_GET, dstReg, structReg, indexReg);
-                pushRegister(compiler, dstReg);
-            } else {
-                // Legacy stack VM compilation
-                generateCode(compiler, node->left);
-                if (compiler->hadError) return;
-                emitConstant(compiler, I32_VAL(node->data.field.index));
-                writeOp(compiler, OP_ARRAY_GET);
-            }
+            generateCode(compiler, node->left);
+            if (compiler->hadError) return;
+            emitConstant(compiler, I32_VAL(node->data.field.index));
+            writeOp(compiler, OP_ARRAY_GET);
             break;
         }
 
@@ -4132,9 +4075,10 @@ uint8_t addLocal(Compiler* compiler, Token name, Type* type, bool isMutable, boo
         }
     }
 
-    if (vm.variableCount >= UINT8_COUNT) {
-        error(compiler, "Too many variables.");
-        return 0;
+    if (vm.variableCount >= MAX_GLOBALS) {
+        errorFmt(compiler, "Too many variables: the program and the modules it imports "
+                 "share %d global slots.", MAX_GLOBALS);
+        return UINT8_MAX;
     }
     uint8_t index = vm.variableCount++;
     ObjString* nameObj = allocateString(name.start, name.length);
@@ -4335,11 +4279,13 @@ void initCompiler(Compiler* compiler, Chunk* chunk,
     compiler->isRegisterMode = false;  // Default to stack VM mode
     compiler->rchunk = NULL;
     compiler->nextRegister = 0;
-    compiler->registerStackTop = 0;
-    // Initialize register stack
-    for (int i = 0; i < 256; i++) {
-        compiler->registerStack[i] = 0;
-    }
+    compiler->nextWindowSlot = 0;
+    compiler->nextLane = 0;
+    compiler->promoteLocals = false;
+    compiler->promoteLimit = UINT8_MAX;
+    memset(compiler->localRegisters, NO_LOCAL_REGISTER, sizeof(compiler->localRegisters));
+    memset(compiler->builderRegisters, NO_LOCAL_REGISTER, sizeof(compiler->builderRegisters));
+    compiler->tryDepth = 0;
 
     // Count lines in sourceCode and record start pointers for each line
     if (sourceCode) {
@@ -4364,8 +4310,20 @@ void initCompiler(Compiler* compiler, Chunk* chunk,
     }
 }
 
+// Global types are looked up again by later modules and REPL lines, so they
+// must not stay in the compile arena. Declarations in vm.functionDecls are
+// only consulted while compiling and may stay.
+static void promoteGlobalTypes() {
+    for (int i = 0; i < vm.variableCount; i++) {
+        variableTypes[i] = promoteType(variableTypes[i]);
+        vm.globalTypes[i] = promoteType(vm.globalTypes[i]);
+    }
+}
+
 // Free resources used by the compiler
 static void freeCompiler(Compiler* compiler) {
+    promoteGlobalTypes();
+
     // Allow GC to reclaim jump arrays
     compiler->breakJumps = NULL;
     compiler->breakJumpCount = 0;
@@ -4436,111 +4394,1810 @@ bool compile(ASTNode* ast, Compiler* compiler, bool requireMain) {
 
 // Compile AST to register bytecode
 bool compileToRegister(ASTNode* ast, RegisterChunk* rchunk, const char* filePath, const char* sourceCode, bool requireMain) {
-    // Current implementation: Compile to stack VM, then translate to register VM
-    // TODO: Future enhancement - use compileToRegisterDirect for complete direct compilation
-    // The direct register compilation infrastructure is implemented and ready for future use
-    
-    Chunk chunk;
-    initChunk(&chunk);
-    Compiler compiler;
-    initCompiler(&compiler, &chunk, filePath, sourceCode);
-    bool ok = compile(ast, &compiler, requireMain);
-    if (ok) {
-        chunkToRegisterIR(&chunk, rchunk);
-    }
-    freeChunk(&chunk);
-    return ok;
+    return compileToRegisterDirect(ast, rchunk, filePath, sourceCode, requireMain);
 }
 
 // Register VM Direct Compilation - Phase 1.1 Enhancement
 // Initialize compiler for direct register VM compilation
 void initRegisterCompiler(Compiler* compiler, RegisterChunk* rchunk,
                          const char* filePath, const char* sourceCode) {
-    // Initialize basic compiler structure
-    initSymbolTable(&compiler->symbols);
-    compiler->scopeDepth = 0;
-    compiler->chunk = NULL;  // No stack VM chunk in register mode
-    compiler->hadError = false;
-    compiler->panicMode = false;
-    
-    // File and source information
-    compiler->filePath = filePath;
-    compiler->sourceCode = sourceCode;
-    compiler->lineStarts = NULL;
-    compiler->lineCount = 0;
-    
-    // AST compilation state
-    compiler->currentLine = 0;
-    compiler->currentColumn = 0;
-    compiler->currentReturnType = NULL;
-    compiler->currentFunctionHasGenerics = false;
-    compiler->genericNames = NULL;
-    compiler->genericConstraints = NULL;
-    compiler->genericCount = 0;
-    
-    // Loop control state
-    compiler->loopStart = -1;
-    compiler->loopEnd = -1;
-    compiler->loopContinue = -1;
-    compiler->loopDepth = 0;
-    compiler->breakJumps = NULL;
-    compiler->breakJumpCount = 0;
-    compiler->breakJumpCapacity = 0;
-    compiler->continueJumps = NULL;
-    compiler->continueJumpCount = 0;
-    compiler->continueJumpCapacity = 0;
-    
-    // Register VM mode
+    initCompiler(compiler, NULL, filePath, sourceCode);  // No stack VM chunk in register mode
+
     compiler->isRegisterMode = true;
     compiler->rchunk = rchunk;
-    compiler->nextRegister = 0;
-    compiler->registerStackTop = 0;
-    
-    // Initialize register stack
-    for (int i = 0; i < 256; i++) {
-        compiler->registerStack[i] = 0;
-    }
 }
 
-// Helper functions for register allocation
+// =============================================================================
+// DIRECT REGISTER CODE GENERATION
+// =============================================================================
+//
+// Code is generated straight from the type-checked AST into a RegisterChunk.
+// Expressions are compiled into a destination register chosen by the caller,
+// so results land where they are needed and no ROP_MOVE is required to shuffle
+// them. Registers are virtual (see register_allocator.h): temporaries are
+// allocated stack-wise and released after every statement, and
+// register_allocate_chunk maps them onto the register file by liveness once
+// the whole chunk is generated. Runs of consecutive registers (call
+// arguments, array elements) live in argument window slots.
+//
+// Top-level variables stay in chunk globals at the same indices the stack
+// compiler uses. Inside a function without nested functions, `let` locals,
+// parameters and loop iterators get a virtual register of their own instead.
+//
+// Operand conventions for instructions whose layout is not fixed by the ISA:
+//   JZ/JNZ/STORE_GLOBAL/RET_VAL   register in the dst byte
+//   CALL base, target             arguments in window slots base.., result
+//                                 in base; the callee sees its arguments as
+//                                 R0..Rn-1
+//   CALL_STATIC base, native, n   native call, same register window
+//   NEW_ARRAY dst, first, n       elements in window slots first..first+n-1
+//   NEW_PACKED_ARRAY dst, first, n  same, for arrays of primitives
+//   NEW_STRUCT dst, first, shape  fields in window slots first.., shape id - 1
+//   GET_FIELD dst, object, field  field name index, resolved per struct shape
+//   SET_FIELD object, field, value
+//   NEW_ENUM dst, first, n        type name, variant index, then n payloads
+//   ARRAY_SLICE dst, array, s     start in window slot s, end in s+1 (nil
+//                                 when omitted)
+//   SET_INDEX array, index, value
+//   ARRAY_PUSH array, value       ARRAY_RESERVE array, capacity
+//   ARRAY_POP dst, array
+//   GENERIC_CAST dst, src, kind   conversion to TypeKind `kind`
+//   TRY_BEGIN error, handler      error global index in the dst byte
+//   PRINT -, src, noNewline
+
+static uint32_t emitRegisterInstruction(Compiler* compiler, uint32_t instruction) {
+    return register_chunk_add_instruction(compiler->rchunk, instruction,
+                                          (uint32_t)compiler->currentLine,
+                                          (uint16_t)compiler->currentColumn);
+}
+
+static void emitRegisterOp(Compiler* compiler, RegisterOpcode op,
+                           uint8_t dst, uint8_t src1, uint8_t src2) {
+    emitRegisterInstruction(compiler, MAKE_INSTRUCTION(op, dst, src1, src2));
+}
+
 static uint8_t allocateRegister(Compiler* compiler) {
-    if (compiler->nextRegister >= 255) {
-        // Handle register exhaustion - this should rarely happen
-        compiler->hadError = true;
-        return 255;  // Return maximum register as fallback
+    if (compiler->nextRegister >= VIRTUAL_REGISTER_COUNT) {
+        errorFmt(compiler, "Function needs more than %d virtual registers.",
+                 VIRTUAL_REGISTER_COUNT);
+        return VIRTUAL_REGISTER_COUNT - 1;
     }
     return compiler->nextRegister++;
 }
 
-static void pushRegister(Compiler* compiler, uint8_t reg) {
-    if (compiler->registerStackTop < 256) {
-        compiler->registerStack[compiler->registerStackTop++] = reg;
+static void releaseRegisters(Compiler* compiler, uint8_t mark) {
+    compiler->nextRegister = mark;
+}
+
+static uint8_t allocateWindowSlot(Compiler* compiler) {
+    if (compiler->nextWindowSlot >= WINDOW_SLOT_COUNT) {
+        errorFmt(compiler, "Expression needs more than %d argument registers.",
+                 WINDOW_SLOT_COUNT);
+        return WINDOW_REGISTER(WINDOW_SLOT_COUNT - 1);
     }
+    return WINDOW_REGISTER(compiler->nextWindowSlot++);
 }
 
-static uint8_t popRegister(Compiler* compiler) {
-    if (compiler->registerStackTop > 0) {
-        return compiler->registerStack[--compiler->registerStackTop];
+static uint8_t allocateLane(Compiler* compiler) {
+    if (compiler->nextLane >= LANE_REGISTER_COUNT) {
+        errorFmt(compiler, "Expression needs more than %d lane registers.",
+                 LANE_REGISTER_COUNT);
+        return LANE_REGISTER_COUNT - 1;
     }
-    return 0;  // Fallback to register 0
+    return compiler->nextLane++;
 }
 
-// Helper function to emit register instructions
-static void writeRegisterOp(Compiler* compiler, RegisterOp op, uint8_t dst, uint8_t src1, uint8_t src2) {
-    RegisterInstr instr = {op, dst, src1, src2};
-    writeRegisterInstr(compiler->rchunk, instr);
+static uint32_t currentRegisterAddress(Compiler* compiler) {
+    return compiler->rchunk->code_count;
 }
 
-// Direct register VM compilation entry point
-bool compileToRegisterDirect(ASTNode* ast, RegisterChunk* rchunk, 
-                            const char* filePath, const char* sourceCode, bool requireMain) {
-    Compiler compiler;
-    initRegisterCompiler(&compiler, rchunk, filePath, sourceCode);
-    
-    // Use the existing compile function but in register mode
-    bool ok = compile(ast, &compiler, requireMain);
-    
-    freeCompiler(&compiler);
-    return ok;
+// Emit a jump whose target is patched later
+static uint32_t emitRegisterJump(Compiler* compiler, RegisterOpcode op, uint8_t reg) {
+    return emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(op, reg, 0xFFFF));
+}
+
+static void patchRegisterJumpTo(Compiler* compiler, uint32_t jump, uint32_t target) {
+    if (target > UINT16_MAX) {
+        error(compiler, "Too much code in one chunk for a jump target.");
+        return;
+    }
+    uint32_t instruction = compiler->rchunk->code[jump];
+    register_chunk_set_instruction(compiler->rchunk, jump,
+                                   (instruction & 0xFFFF) | (target << 16));
+}
+
+static void patchRegisterJump(Compiler* compiler, uint32_t jump) {
+    patchRegisterJumpTo(compiler, jump, currentRegisterAddress(compiler));
+}
+
+// Make sure a chunk global exists for `index`. New slots start with the value
+// the type checker recorded (constants and imported symbols). Function slots
+// start as nil: they are filled with this chunk's function index when the
+// body is compiled, so anything still nil at link time lives in a module.
+static void reserveRegisterGlobal(Compiler* compiler, uint8_t index) {
+    RegisterChunk* rchunk = compiler->rchunk;
+    while (rchunk->global_count <= index) {
+        uint16_t slot = rchunk->global_count;
+        Value initial = vm.functionDecls[slot] ? NIL_VAL : vm.globals[slot];
+        if (register_chunk_add_global(rchunk, initial) == UINT16_MAX) {
+            error(compiler, "Out of memory for register chunk globals.");
+            return;
+        }
+    }
+}
+
+static void emitLoadGlobal(Compiler* compiler, uint8_t dst, uint8_t index) {
+    reserveRegisterGlobal(compiler, index);
+    emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_LOAD_GLOBAL, dst, index));
+}
+
+static void emitStoreGlobal(Compiler* compiler, uint8_t src, uint8_t index) {
+    reserveRegisterGlobal(compiler, index);
+    emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, src, index));
+}
+
+// Whether the next local declared gets a register of its own
+static bool canPromoteLocal(Compiler* compiler) {
+    return compiler->promoteLocals && compiler->nextRegister < compiler->promoteLimit;
+}
+
+// Register of a promoted variable, or NO_LOCAL_REGISTER for a global
+static uint8_t localRegister(Compiler* compiler, uint8_t index) {
+    return compiler->localRegisters[index];
+}
+
+static void emitLoadVariable(Compiler* compiler, uint8_t dst, uint8_t index) {
+    uint8_t local = localRegister(compiler, index);
+    if (local == NO_LOCAL_REGISTER) {
+        emitLoadGlobal(compiler, dst, index);
+    } else if (local != dst) {
+        emitRegisterOp(compiler, ROP_MOVE, dst, local, 0);
+    }
+}
+
+static void emitStoreVariable(Compiler* compiler, uint8_t src, uint8_t index) {
+    uint8_t local = localRegister(compiler, index);
+    if (local == NO_LOCAL_REGISTER) {
+        emitStoreGlobal(compiler, src, index);
+    } else if (local != src) {
+        emitRegisterOp(compiler, ROP_MOVE, local, src, 0);
+    }
+}
+
+static void emitLoadValue(Compiler* compiler, uint8_t dst, Value value) {
+    if (IS_I32(value) && AS_I32(value) >= 0 && AS_I32(value) <= INT16_MAX) {
+        emitRegisterInstruction(compiler,
+            MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, dst, (uint16_t)AS_I32(value)));
+        return;
+    }
+    uint32_t constant = register_chunk_add_constant(compiler->rchunk, value);
+    if (constant > UINT16_MAX) {
+        error(compiler, "Too many constants in one chunk.");
+        return;
+    }
+    emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, dst, constant));
+}
+
+// Shape id of a struct type in the register chunk, or 0 when the chunk's
+// shape tables are full and the struct falls back to plain indexed arrays.
+// Generic instantiations keep their struct's name and so share its shape.
+static uint16_t structShape(Compiler* compiler, Type* structType) {
+    if (!structType || structType->kind != TYPE_STRUCT ||
+        structType->info.structure.fieldCount > UINT8_MAX) {
+        return 0;
+    }
+    int fieldCount = structType->info.structure.fieldCount;
+    const char* names[UINT8_MAX];
+    for (int i = 0; i < fieldCount; i++) {
+        names[i] = structType->info.structure.fields[i].name->chars;
+    }
+    return register_chunk_add_shape(compiler->rchunk,
+                                    structType->info.structure.name->chars,
+                                    names, (uint8_t)fieldCount);
+}
+
+// Field name operand of a field of a struct that has a shape
+static uint8_t structFieldName(Compiler* compiler, Type* structType, int index) {
+    return (uint8_t)register_chunk_add_field_name(compiler->rchunk,
+        structType->info.structure.fields[index].name->chars);
+}
+
+static ValueType valueTypeForKind(Type* type) {
+    if (!type) return VAL_NIL;
+    switch (type->kind) {
+        case TYPE_I32: return VAL_I32;
+        case TYPE_I64: return VAL_I64;
+        case TYPE_U32: return VAL_U32;
+        case TYPE_U64: return VAL_U64;
+        case TYPE_F64: return VAL_F64;
+        case TYPE_BOOL: return VAL_BOOL;
+        case TYPE_STRING: return VAL_STRING;
+        case TYPE_ARRAY:
+        case TYPE_STRUCT: return VAL_ARRAY;
+        case TYPE_ENUM: return VAL_ENUM;
+        default: return VAL_NIL;
+    }
+}
+
+// Note a module symbol the register chunk being compiled refers to
+static void recordModuleImport(Compiler* compiler, Module* module, Export* ex) {
+    if (!compiler->rchunk) return;
+    if (!register_chunk_add_import(compiler->rchunk, module->module_name, ex->name,
+                                   ex->index, valueTypeForKind(variableTypes[ex->index]))) {
+        error(compiler, "Out of memory for register chunk imports.");
+    }
+}
+
+static void unsupportedRegisterOperation(Compiler* compiler, const char* operation,
+                                         TypeKind kind) {
+    errorFmt(compiler,
+             "%s on '%s' values has no register instruction yet.",
+             operation, getTypeName(kind));
+}
+
+// Convert `reg` in place from one primitive type to another
+static void emitRegisterConversion(Compiler* compiler, uint8_t reg,
+                                   TypeKind from, TypeKind to) {
+    if (from == to) return;
+
+    RegisterOpcode op;
+    if (from == TYPE_I32 && to == TYPE_I64) {
+        op = ROP_CAST_I32_I64;
+    } else if (from == TYPE_I32 && to == TYPE_U32) {
+        op = ROP_CAST_I32_U32;
+    } else if (from == TYPE_I32 && to == TYPE_F64) {
+        op = ROP_CAST_I32_F64;
+    } else if (from == TYPE_I64 && to == TYPE_I32) {
+        op = ROP_CAST_I64_I32;
+    } else if (from == TYPE_F64 && to == TYPE_I32) {
+        op = ROP_CAST_F64_I32;
+    } else if (to == TYPE_STRING) {
+        op = ROP_CAST_TO_STR;
+    } else if (to == TYPE_BOOL) {
+        op = ROP_CAST_TO_BOOL;
+    } else {
+        emitRegisterOp(compiler, ROP_GENERIC_CAST, reg, reg, (uint8_t)to);
+        return;
+    }
+    emitRegisterOp(compiler, op, reg, reg, 0);
+}
+
+static void compileRegisterExpression(Compiler* compiler, ASTNode* node, uint8_t dst);
+static void compileRegisterStatement(Compiler* compiler, ASTNode* node);
+
+// Compile `node` into a fresh temporary and return its register
+static uint8_t compileRegisterTemporary(Compiler* compiler, ASTNode* node) {
+    uint8_t reg = allocateRegister(compiler);
+    compileRegisterExpression(compiler, node, reg);
+    return reg;
+}
+
+// Whether evaluating `node` (or the list it starts) may assign a variable
+static bool containsAssignment(ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                return true;
+            case AST_CALL:
+                if (containsAssignment(node->data.call.arguments)) return true;
+                break;
+            case AST_TERNARY:
+                if (containsAssignment(node->data.ternary.condition) ||
+                    containsAssignment(node->data.ternary.thenExpr) ||
+                    containsAssignment(node->data.ternary.elseExpr)) return true;
+                break;
+            case AST_ARRAY:
+                if (containsAssignment(node->data.array.elements)) return true;
+                break;
+            case AST_STRUCT_LITERAL:
+                if (containsAssignment(node->data.structLiteral.values)) return true;
+                break;
+            case AST_ARRAY_SET:
+                if (containsAssignment(node->data.arraySet.index)) return true;
+                break;
+            case AST_SLICE:
+                if (containsAssignment(node->data.slice.start) ||
+                    containsAssignment(node->data.slice.end)) return true;
+                break;
+            default:
+                break;
+        }
+        if (containsAssignment(node->left) || containsAssignment(node->right)) return true;
+    }
+    return false;
+}
+
+// Evaluate `node` and return the register holding its value. A promoted
+// variable is read in place unless `later`, evaluated before the value is
+// consumed, might assign it; anything else is compiled into `dst`.
+static uint8_t compileRegisterOperand(Compiler* compiler, ASTNode* node, uint8_t dst,
+                                      ASTNode* later) {
+    if (node && node->type == AST_VARIABLE && !containsAssignment(later)) {
+        uint8_t local = localRegister(compiler, node->data.variable.index);
+        if (local != NO_LOCAL_REGISTER) return local;
+    }
+    compileRegisterExpression(compiler, node, dst);
+    return dst;
+}
+
+// Pick the first window slot of a call producing `dst`. When `dst` is the
+// top window slot (the call is itself an argument) the window starts there
+// and the result needs no move.
+static uint8_t beginRegisterWindow(Compiler* compiler, uint8_t dst) {
+    if (compiler->nextWindowSlot > 0 &&
+        dst == WINDOW_REGISTER(compiler->nextWindowSlot - 1)) {
+        compiler->nextWindowSlot--;
+        return dst;
+    }
+    if (compiler->nextWindowSlot >= WINDOW_SLOT_COUNT) {
+        errorFmt(compiler, "Expression needs more than %d argument registers.",
+                 WINDOW_SLOT_COUNT);
+    }
+    return WINDOW_REGISTER(compiler->nextWindowSlot);
+}
+
+static void endRegisterWindow(Compiler* compiler, uint8_t dst, uint8_t base,
+                              uint8_t mark) {
+    if (base != dst) {
+        emitRegisterOp(compiler, ROP_MOVE, dst, base, 0);
+    }
+    compiler->nextWindowSlot = mark;
+}
+
+// -----------------------------------------------------------------------------
+// Typed lanes
+// -----------------------------------------------------------------------------
+
+// Longer chains are compiled with boxed arithmetic: every operand of a chain
+// is held in a temporary register until the chain is unboxed
+#define MAX_LANE_LEAVES 32
+
+static bool isLaneOperation(ASTNode* node, TypeKind kind) {
+    if (!node || node->type != AST_BINARY || !node->valueType ||
+        node->valueType->kind != kind ||
+        node->data.operation.convertLeft || node->data.operation.convertRight) {
+        return false;
+    }
+    switch (node->data.operation.operator.type) {
+        case TOKEN_PLUS:
+        case TOKEN_MINUS:
+        case TOKEN_STAR:
+            return true;
+        case TOKEN_SLASH:
+            return kind == TYPE_F64;
+        default:
+            return false;
+    }
+}
+
+static int countLaneOperations(ASTNode* node, TypeKind kind) {
+    if (!isLaneOperation(node, kind)) return 0;
+    return 1 + countLaneOperations(node->left, kind) +
+           countLaneOperations(node->right, kind);
+}
+
+// Evaluate the operands of a lane chain into temporaries, left to right.
+// This runs before the first UNBOX: an operand may call a function, and
+// lane registers are not preserved across calls.
+static void compileLaneLeaves(Compiler* compiler, ASTNode* node, TypeKind kind,
+                              uint8_t* leaves, int* count) {
+    if (!isLaneOperation(node, kind)) {
+        leaves[(*count)++] = compileRegisterTemporary(compiler, node);
+        return;
+    }
+    compileLaneLeaves(compiler, node->left, kind, leaves, count);
+    compileLaneLeaves(compiler, node->right, kind, leaves, count);
+}
+
+static uint8_t compileLaneOperand(Compiler* compiler, ASTNode* node, TypeKind kind,
+                                  const uint8_t* leaves, int* next) {
+    if (!isLaneOperation(node, kind)) {
+        uint8_t lane = allocateLane(compiler);
+        emitRegisterOp(compiler, kind == TYPE_I64 ? ROP_UNBOX_I64 : ROP_UNBOX_F64,
+                       lane, leaves[(*next)++], 0);
+        return lane;
+    }
+
+    uint8_t left = compileLaneOperand(compiler, node->left, kind, leaves, next);
+    uint8_t right = compileLaneOperand(compiler, node->right, kind, leaves, next);
+    RegisterOpcode op;
+    switch (node->data.operation.operator.type) {
+        case TOKEN_PLUS:  op = kind == TYPE_I64 ? ROP_LANE_ADD_I64 : ROP_LANE_ADD_F64; break;
+        case TOKEN_MINUS: op = kind == TYPE_I64 ? ROP_LANE_SUB_I64 : ROP_LANE_SUB_F64; break;
+        case TOKEN_STAR:  op = kind == TYPE_I64 ? ROP_LANE_MUL_I64 : ROP_LANE_MUL_F64; break;
+        default:          op = ROP_LANE_DIV_F64; break;
+    }
+    emitRegisterOp(compiler, op, left, left, right);
+    compiler->nextLane = left + 1;
+    return left;
+}
+
+// -----------------------------------------------------------------------------
+// Expressions
+// -----------------------------------------------------------------------------
+
+// Operands of generic type use the *_ANY opcodes, which dispatch on the
+// runtime tags
+static int registerArithmeticOpcode(TokenType operator, TypeKind kind) {
+    switch (operator) {
+        case TOKEN_PLUS:
+            switch (kind) {
+                case TYPE_STRING: return ROP_STR_CONCAT;
+                case TYPE_I32: return ROP_ADD_I32;
+                case TYPE_I64: return ROP_ADD_I64;
+                case TYPE_U32: return ROP_ADD_U32;
+                case TYPE_U64: return ROP_ADD_U64;
+                case TYPE_F64: return ROP_ADD_F64;
+                case TYPE_GENERIC: return ROP_ADD_ANY;
+                default: return -1;
+            }
+        case TOKEN_MINUS:
+            switch (kind) {
+                case TYPE_I32: return ROP_SUB_I32;
+                case TYPE_I64: return ROP_SUB_I64;
+                case TYPE_U32: return ROP_SUB_U32;
+                case TYPE_U64: return ROP_SUB_U64;
+                case TYPE_F64: return ROP_SUB_F64;
+                case TYPE_GENERIC: return ROP_SUB_ANY;
+                default: return -1;
+            }
+        case TOKEN_STAR:
+            switch (kind) {
+                case TYPE_I32: return ROP_MUL_I32;
+                case TYPE_I64: return ROP_MUL_I64;
+                case TYPE_U32: return ROP_MUL_U32;
+                case TYPE_U64: return ROP_MUL_U64;
+                case TYPE_F64: return ROP_MUL_F64;
+                case TYPE_GENERIC: return ROP_MUL_ANY;
+                default: return -1;
+            }
+        case TOKEN_SLASH:
+            switch (kind) {
+                case TYPE_I32: return ROP_DIV_I32;
+                case TYPE_I64: return ROP_DIV_I64;
+                case TYPE_U32: return ROP_DIV_U32;
+                case TYPE_U64: return ROP_DIV_U64;
+                case TYPE_F64: return ROP_DIV_F64;
+                case TYPE_GENERIC: return ROP_DIV_ANY;
+                default: return -1;
+            }
+        case TOKEN_MODULO:
+            switch (kind) {
+                case TYPE_I32: return ROP_MOD_I32;
+                case TYPE_I64: return ROP_MOD_I64;
+                case TYPE_U32: return ROP_MOD_U32;
+                case TYPE_U64: return ROP_MOD_U64;
+                case TYPE_GENERIC: return ROP_MOD_ANY;
+                default: return -1;
+            }
+        case TOKEN_BIT_AND:
+            return kind == TYPE_I32 || kind == TYPE_I64 || kind == TYPE_U32 ? ROP_AND : -1;
+        case TOKEN_BIT_OR:
+            return kind == TYPE_I32 || kind == TYPE_I64 || kind == TYPE_U32 ? ROP_OR : -1;
+        case TOKEN_BIT_XOR:
+            return kind == TYPE_I32 || kind == TYPE_I64 || kind == TYPE_U32 ? ROP_XOR : -1;
+        case TOKEN_SHIFT_LEFT:
+            return kind == TYPE_I32 || kind == TYPE_I64 || kind == TYPE_U32 ? ROP_SHL : -1;
+        case TOKEN_SHIFT_RIGHT:
+            if (kind == TYPE_U32) return ROP_SHR;
+            return kind == TYPE_I32 || kind == TYPE_I64 ? ROP_SAR : -1;
+        case TOKEN_LEFT_BRACKET:
+            return ROP_GET_INDEX;
+        case TOKEN_AND:
+            return ROP_BOOL_AND;
+        case TOKEN_OR:
+            return ROP_BOOL_OR;
+        default:
+            return -1;
+    }
+}
+
+static bool isComparisonOperator(TokenType operator) {
+    return operator == TOKEN_LESS || operator == TOKEN_LESS_EQUAL ||
+           operator == TOKEN_GREATER || operator == TOKEN_GREATER_EQUAL ||
+           operator == TOKEN_EQUAL_EQUAL || operator == TOKEN_BANG_EQUAL;
+}
+
+// Ordering comparisons other than i32 go through CMP_* and the flag jumps
+static bool usesFlagComparison(ASTNode* node) {
+    if (node->type != AST_BINARY) return false;
+    TokenType operator = node->data.operation.operator.type;
+    if (operator == TOKEN_EQUAL_EQUAL || operator == TOKEN_BANG_EQUAL ||
+        !isComparisonOperator(operator)) {
+        return false;
+    }
+    TypeKind kind = node->left->valueType ? node->left->valueType->kind : TYPE_I32;
+    return kind != TYPE_I32;
+}
+
+static RegisterOpcode flagCompareOpcode(Compiler* compiler, TypeKind kind) {
+    switch (kind) {
+        case TYPE_I64: return ROP_CMP_I64;
+        case TYPE_U32: return ROP_CMP_U32;
+        case TYPE_U64: return ROP_CMP_U64;
+        case TYPE_F64:
+        case TYPE_GENERIC: return ROP_CMP_F64;
+        default:
+            unsupportedRegisterOperation(compiler, "Ordering comparison", kind);
+            return ROP_CMP_F64;
+    }
+}
+
+static RegisterOpcode flagJumpOpcode(TokenType operator, bool negate) {
+    switch (operator) {
+        case TOKEN_LESS:          return negate ? ROP_JGE : ROP_JLT;
+        case TOKEN_LESS_EQUAL:    return negate ? ROP_JGT : ROP_JLE;
+        case TOKEN_GREATER:       return negate ? ROP_JLE : ROP_JGT;
+        default:                  return negate ? ROP_JLT : ROP_JGE;
+    }
+}
+
+static void compileRegisterComparison(Compiler* compiler, ASTNode* node, uint8_t dst) {
+    TokenType operator = node->data.operation.operator.type;
+    TypeKind leftKind = node->left->valueType ? node->left->valueType->kind : TYPE_I32;
+    TypeKind rightKind = node->right->valueType ? node->right->valueType->kind : TYPE_I32;
+    uint8_t mark = compiler->nextRegister;
+
+    if (usesFlagComparison(node)) {
+        uint8_t left = compileRegisterOperand(compiler, node->left,
+                                              allocateRegister(compiler), node->right);
+        uint8_t right = compileRegisterOperand(compiler, node->right,
+                                               allocateRegister(compiler), NULL);
+        emitRegisterOp(compiler, flagCompareOpcode(compiler, leftKind), 0, left, right);
+        releaseRegisters(compiler, mark);
+        // Loads leave the flags untouched
+        emitLoadValue(compiler, dst, BOOL_VAL(true));
+        uint32_t done = emitRegisterJump(compiler, flagJumpOpcode(operator, false), 0);
+        emitLoadValue(compiler, dst, BOOL_VAL(false));
+        patchRegisterJump(compiler, done);
+        return;
+    }
+
+    uint8_t left = compileRegisterOperand(compiler, node->left, dst, node->right);
+    uint8_t right = compileRegisterOperand(compiler, node->right, allocateRegister(compiler),
+                                           NULL);
+
+    RegisterOpcode op;
+    switch (operator) {
+        case TOKEN_LESS:          op = ROP_LT_I32; break;
+        case TOKEN_LESS_EQUAL:    op = ROP_LE_I32; break;
+        case TOKEN_GREATER:       op = ROP_GT_I32; break;
+        case TOKEN_GREATER_EQUAL: op = ROP_GE_I32; break;
+        default:
+            if (leftKind == TYPE_STRING || rightKind == TYPE_STRING) {
+                op = ROP_EQ_STR;
+            } else if (leftKind == TYPE_ARRAY || leftKind == TYPE_STRUCT ||
+                       leftKind == TYPE_ENUM) {
+                op = ROP_EQ_OBJ;
+            } else {
+                // EQ_I32 compares any two primitive values
+                op = ROP_EQ_I32;
+            }
+            if (operator == TOKEN_BANG_EQUAL && op == ROP_EQ_I32 &&
+                leftKind == TYPE_I32 && rightKind == TYPE_I32) {
+                op = ROP_NE_I32;
+            }
+            break;
+    }
+    emitRegisterOp(compiler, op, dst, left, right);
+    if (operator == TOKEN_BANG_EQUAL && op != ROP_NE_I32) {
+        emitRegisterOp(compiler, ROP_BOOL_NOT, dst, dst, 0);
+    }
+    releaseRegisters(compiler, mark);
+}
+
+static void compileRegisterBinary(Compiler* compiler, ASTNode* node, uint8_t dst) {
+    TokenType operator = node->data.operation.operator.type;
+    if (isComparisonOperator(operator)) {
+        compileRegisterComparison(compiler, node, dst);
+        return;
+    }
+
+    TypeKind resultKind = node->valueType->kind;
+    int laneOperations = resultKind == TYPE_I64 || resultKind == TYPE_F64
+                             ? countLaneOperations(node, resultKind) : 0;
+    if (laneOperations >= 2 && laneOperations < MAX_LANE_LEAVES) {
+        // Chains of i64/f64 arithmetic stay unboxed until the final result
+        uint8_t mark = compiler->nextRegister;
+        uint8_t leaves[MAX_LANE_LEAVES];
+        int leafCount = 0;
+        compileLaneLeaves(compiler, node, resultKind, leaves, &leafCount);
+
+        uint8_t laneMark = compiler->nextLane;
+        int next = 0;
+        uint8_t lane = compileLaneOperand(compiler, node, resultKind, leaves, &next);
+        emitRegisterOp(compiler, resultKind == TYPE_I64 ? ROP_BOX_I64 : ROP_BOX_F64,
+                       dst, lane, 0);
+        compiler->nextLane = laneMark;
+        releaseRegisters(compiler, mark);
+        return;
+    }
+
+    int op = registerArithmeticOpcode(operator, resultKind);
+    if (op < 0) {
+        unsupportedRegisterOperation(compiler, "Binary operator", resultKind);
+        return;
+    }
+
+    uint8_t mark = compiler->nextRegister;
+    uint8_t left = dst;
+    if (node->data.operation.convertLeft) {
+        // Converted in place, so never straight from a variable's register
+        compileRegisterExpression(compiler, node->left, dst);
+        emitRegisterConversion(compiler, dst, node->left->valueType->kind, resultKind);
+    } else {
+        left = compileRegisterOperand(compiler, node->left, dst, node->right);
+    }
+    uint8_t right;
+    if (node->data.operation.convertRight) {
+        right = compileRegisterTemporary(compiler, node->right);
+        emitRegisterConversion(compiler, right, node->right->valueType->kind, resultKind);
+    } else {
+        right = compileRegisterOperand(compiler, node->right, allocateRegister(compiler), NULL);
+    }
+    emitRegisterOp(compiler, (RegisterOpcode)op, dst, left, right);
+    releaseRegisters(compiler, mark);
 }
 
+static void compileRegisterUnary(Compiler* compiler, ASTNode* node, uint8_t dst) {
+    compileRegisterExpression(compiler, node->left, dst);
+    TypeKind kind = node->valueType->kind;
+    switch (node->data.operation.operator.type) {
+        case TOKEN_MINUS:
+            switch (kind) {
+                case TYPE_I32: emitRegisterOp(compiler, ROP_NEG_I32, dst, dst, 0); break;
+                case TYPE_I64: emitRegisterOp(compiler, ROP_NEG_I64, dst, dst, 0); break;
+                case TYPE_F64: emitRegisterOp(compiler, ROP_NEG_F64, dst, dst, 0); break;
+                case TYPE_GENERIC: emitRegisterOp(compiler, ROP_NEG_ANY, dst, dst, 0); break;
+                default: unsupportedRegisterOperation(compiler, "Negation", kind); break;
+            }
+            break;
+        case TOKEN_NOT:
+            emitRegisterOp(compiler, ROP_BOOL_NOT, dst, dst, 0);
+            break;
+        case TOKEN_BIT_NOT:
+            emitRegisterOp(compiler, ROP_NOT, dst, dst, 0);
+            break;
+        default:
+            error(compiler, "Unsupported unary operator.");
+            break;
+    }
+}
+
+// Compile a list of expressions into consecutive window slots starting at
+// the next free slot and return the first one
+static uint8_t compileRegisterList(Compiler* compiler, ASTNode* first, int* count) {
+    uint8_t base = WINDOW_REGISTER(compiler->nextWindowSlot);
+    int n = 0;
+    for (ASTNode* item = first; item && !compiler->hadError; item = item->next) {
+        compileRegisterExpression(compiler, item, allocateWindowSlot(compiler));
+        n++;
+    }
+    *count = n;
+    return base;
+}
+
+// Arrays of primitives get packed storage. An empty literal has element
+// type nil until its first push, so it is packed too.
+static bool packedElementType(Type* arrayType) {
+    if (!arrayType || arrayType->kind != TYPE_ARRAY || !arrayType->info.array.elementType) {
+        return false;
+    }
+    switch (arrayType->info.array.elementType->kind) {
+        case TYPE_I32:
+        case TYPE_I64:
+        case TYPE_U32:
+        case TYPE_U64:
+        case TYPE_F64:
+        case TYPE_BOOL:
+        case TYPE_NIL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// push(array, value) and reserve(array, capacity) update the array in
+// place and yield it; pop(array) yields the removed element
+static void compileRegisterArrayCall(Compiler* compiler, ASTNode* node, uint8_t dst) {
+    uint8_t mark = compiler->nextRegister;
+    ASTNode* array = node->data.call.arguments;
+    if (node->data.call.builtinOp == OP_ARRAY_POP) {
+        uint8_t source = compileRegisterOperand(compiler, array, allocateRegister(compiler),
+                                                NULL);
+        emitRegisterOp(compiler, ROP_ARRAY_POP, dst, source, 0);
+    } else {
+        compileRegisterExpression(compiler, array, dst);
+        uint8_t operand = compileRegisterOperand(compiler, array->next,
+                                                 allocateRegister(compiler), NULL);
+        emitRegisterOp(compiler, node->data.call.builtinOp == OP_ARRAY_PUSH ?
+                                     ROP_ARRAY_PUSH : ROP_ARRAY_RESERVE,
+                       dst, operand, 0);
+    }
+    releaseRegisters(compiler, mark);
+}
+
+static void compileRegisterCall(Compiler* compiler, ASTNode* node, uint8_t dst) {
+    compiler->currentColumn = tokenColumn(compiler, &node->data.call.name);
+
+    if (node->data.call.builtinOp == OP_ARRAY_PUSH ||
+        node->data.call.builtinOp == OP_ARRAY_POP ||
+        node->data.call.builtinOp == OP_ARRAY_RESERVE) {
+        compileRegisterArrayCall(compiler, node, dst);
+        return;
+    }
+
+    if (node->data.call.builtinOp != -1) {
+        uint8_t mark = compiler->nextRegister;
+        uint8_t arg = compileRegisterOperand(compiler, node->data.call.arguments,
+                                             allocateRegister(compiler), NULL);
+        bool isLen = node->data.call.builtinOp == OP_LEN_ARRAY ||
+                     node->data.call.builtinOp == OP_LEN_STRING;
+        emitRegisterOp(compiler, isLen ? ROP_LEN : ROP_TYPE_OF, dst, arg, 0);
+        releaseRegisters(compiler, mark);
+        return;
+    }
+
+    uint8_t mark = compiler->nextWindowSlot;
+    uint8_t base = beginRegisterWindow(compiler, dst);
+    int argCount = 0;
+    compileRegisterList(compiler, node->data.call.arguments, &argCount);
+    if (compiler->hadError) return;
+
+    if (node->data.call.nativeIndex != -1) {
+        emitRegisterOp(compiler, ROP_CALL_STATIC, base,
+                       (uint8_t)node->data.call.nativeIndex, (uint8_t)argCount);
+        endRegisterWindow(compiler, dst, base, mark);
+        return;
+    }
+
+    // Missing arguments take the parameter defaults
+    ASTNode* fnNode = vm.functionDecls[node->data.call.index];
+    if (fnNode) {
+        ASTNode* param = fnNode->data.function.parameters;
+        for (int i = 0; param; i++, param = param->next) {
+            if (i < argCount) continue;
+            if (!param->data.let.initializer) {
+                error(compiler, "Internal error: missing default value for parameter");
+                return;
+            }
+            compileRegisterExpression(compiler, param->data.let.initializer,
+                                      allocateWindowSlot(compiler));
+        }
+    }
+
+    // The target holds the function's global index until the call is linked
+    emitRegisterInstruction(compiler,
+        MAKE_IMM_INSTRUCTION(ROP_CALL, base, node->data.call.index));
+    endRegisterWindow(compiler, dst, base, mark);
+}
+
+static void compileRegisterExpression(Compiler* compiler, ASTNode* node, uint8_t dst) {
+    if (!node || compiler->hadError) return;
+    compiler->currentLine = node->line;
+
+    switch (node->type) {
+        case AST_LITERAL:
+            emitLoadValue(compiler, dst, node->data.literal);
+            break;
+
+        case AST_BINARY:
+            compileRegisterBinary(compiler, node, dst);
+            break;
+
+        case AST_UNARY:
+            compileRegisterUnary(compiler, node, dst);
+            break;
+
+        case AST_CAST: {
+            compileRegisterExpression(compiler, node->left, dst);
+            TypeKind from = node->left->valueType ? node->left->valueType->kind : TYPE_I32;
+            emitRegisterConversion(compiler, dst, from, node->data.cast.type->kind);
+            break;
+        }
+
+        case AST_VARIABLE:
+            emitLoadVariable(compiler, dst, node->data.variable.index);
+            break;
+
+        case AST_ASSIGNMENT:
+            compileRegisterExpression(compiler, node->left, dst);
+            emitStoreVariable(compiler, dst, node->data.variable.index);
+            break;
+
+        case AST_CALL:
+            compileRegisterCall(compiler, node, dst);
+            break;
+
+        case AST_ARRAY:
+        case AST_STRUCT_LITERAL: {
+            // Structs share the array representation; instances are tagged
+            // with their shape so fields can also be found by name
+            uint16_t shape = 0;
+            if (node->type == AST_STRUCT_LITERAL) {
+                compiler->currentColumn = tokenColumn(compiler, &node->data.structLiteral.name);
+                shape = structShape(compiler, node->valueType);
+            }
+            uint8_t mark = compiler->nextWindowSlot;
+            int count = 0;
+            ASTNode* first = node->type == AST_ARRAY ? node->data.array.elements
+                                                     : node->data.structLiteral.values;
+            uint8_t base = compileRegisterList(compiler, first, &count);
+            if (shape != 0) {
+                emitRegisterOp(compiler, ROP_NEW_STRUCT, dst, base, (uint8_t)(shape - 1));
+            } else {
+                emitRegisterOp(compiler,
+                               packedElementType(node->valueType) ? ROP_NEW_PACKED_ARRAY
+                                                                  : ROP_NEW_ARRAY,
+                               dst, base, (uint8_t)count);
+            }
+            compiler->nextWindowSlot = mark;
+            break;
+        }
+
+        case AST_ARRAY_SET: {
+            uint8_t mark = compiler->nextRegister;
+            uint8_t array = compileRegisterOperand(compiler, node->right,
+                                                   allocateRegister(compiler), node);
+            uint8_t index = compileRegisterOperand(compiler, node->data.arraySet.index,
+                                                   allocateRegister(compiler), node->left);
+            compileRegisterExpression(compiler, node->left, dst);
+            emitRegisterOp(compiler, ROP_SET_INDEX, array, index, dst);
+            releaseRegisters(compiler, mark);
+            break;
+        }
+
+        case AST_SLICE: {
+            uint8_t mark = compiler->nextRegister;
+            uint8_t windowMark = compiler->nextWindowSlot;
+            uint8_t array = compileRegisterOperand(compiler, node->left,
+                                                   allocateRegister(compiler), node);
+            uint8_t start = allocateWindowSlot(compiler);
+            uint8_t end = allocateWindowSlot(compiler);
+            if (node->data.slice.start) {
+                compileRegisterExpression(compiler, node->data.slice.start, start);
+            } else {
+                emitLoadValue(compiler, start, NIL_VAL);
+            }
+            if (node->data.slice.end) {
+                compileRegisterExpression(compiler, node->data.slice.end, end);
+            } else {
+                emitLoadValue(compiler, end, NIL_VAL);
+            }
+            emitRegisterOp(compiler, ROP_ARRAY_SLICE, dst, array, start);
+            compiler->nextWindowSlot = windowMark;
+            releaseRegisters(compiler, mark);
+            break;
+        }
+
+        case AST_FIELD: {
+            compiler->currentColumn = tokenColumn(compiler, &node->data.field.fieldName);
+            uint8_t mark = compiler->nextRegister;
+            uint8_t object = compileRegisterOperand(compiler, node->left, dst, NULL);
+            Type* structType = node->left->valueType;
+            if (structShape(compiler, structType) != 0) {
+                // Looked up by name through the instruction's inline cache
+                emitRegisterOp(compiler, ROP_GET_FIELD, dst, object,
+                               structFieldName(compiler, structType, node->data.field.index));
+            } else {
+                uint8_t index = allocateRegister(compiler);
+                emitLoadValue(compiler, index, I32_VAL(node->data.field.index));
+                emitRegisterOp(compiler, ROP_GET_INDEX, dst, object, index);
+            }
+            releaseRegisters(compiler, mark);
+            break;
+        }
+
+        case AST_FIELD_SET: {
+            compiler->currentColumn = tokenColumn(compiler, &node->data.fieldSet.fieldName);
+            uint8_t mark = compiler->nextRegister;
+            uint8_t object = compileRegisterOperand(compiler, node->right,
+                                                    allocateRegister(compiler), node);
+            Type* structType = node->right->valueType;
+            if (structShape(compiler, structType) != 0) {
+                compileRegisterExpression(compiler, node->left, dst);
+                emitRegisterOp(compiler, ROP_SET_FIELD, object,
+                               structFieldName(compiler, structType, node->data.fieldSet.index),
+                               dst);
+            } else {
+                uint8_t index = allocateRegister(compiler);
+                emitLoadValue(compiler, index, I32_VAL(node->data.fieldSet.index));
+                compileRegisterExpression(compiler, node->left, dst);
+                emitRegisterOp(compiler, ROP_SET_INDEX, object, index, dst);
+            }
+            releaseRegisters(compiler, mark);
+            break;
+        }
+
+        case AST_TERNARY: {
+            uint8_t mark = compiler->nextRegister;
+            uint8_t condition = compileRegisterOperand(compiler, node->data.ternary.condition,
+                                                       allocateRegister(compiler), NULL);
+            uint32_t elseJump = emitRegisterJump(compiler, ROP_JZ, condition);
+            releaseRegisters(compiler, mark);
+            // Both arms write straight into dst
+            compileRegisterExpression(compiler, node->data.ternary.thenExpr, dst);
+            uint32_t endJump = emitRegisterJump(compiler, ROP_JMP, 0);
+            patchRegisterJump(compiler, elseJump);
+            compileRegisterExpression(compiler, node->data.ternary.elseExpr, dst);
+            patchRegisterJump(compiler, endJump);
+            break;
+        }
+
+        case AST_ENUM_VARIANT: {
+            Type* enumType = node->data.enumVariant.enumType;
+            uint8_t mark = compiler->nextWindowSlot;
+            uint8_t base = allocateWindowSlot(compiler);
+            emitLoadValue(compiler, base, STRING_VAL(enumType->info.enumeration.name));
+            emitLoadValue(compiler, allocateWindowSlot(compiler),
+                          I32_VAL(node->data.enumVariant.variantIndex));
+            int argCount = 0;
+            compileRegisterList(compiler, node->left, &argCount);
+            emitRegisterOp(compiler, ROP_NEW_ENUM, dst, base, (uint8_t)argCount);
+            compiler->nextWindowSlot = mark;
+            break;
+        }
+
+        default:
+            error(compiler, "Unsupported AST node type in register code generator.");
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Statements
+// -----------------------------------------------------------------------------
+
+// Compile a condition and return the jump taken when it is false
+static uint32_t compileRegisterCondition(Compiler* compiler, ASTNode* condition) {
+    uint8_t mark = compiler->nextRegister;
+    uint32_t jump;
+    if (usesFlagComparison(condition)) {
+        TypeKind kind = condition->left->valueType->kind;
+        uint8_t left = compileRegisterOperand(compiler, condition->left,
+                                              allocateRegister(compiler), condition->right);
+        uint8_t right = compileRegisterOperand(compiler, condition->right,
+                                               allocateRegister(compiler), NULL);
+        emitRegisterOp(compiler, flagCompareOpcode(compiler, kind), 0, left, right);
+        jump = emitRegisterJump(compiler,
+            flagJumpOpcode(condition->data.operation.operator.type, true), 0);
+    } else {
+        uint8_t reg = compileRegisterOperand(compiler, condition, allocateRegister(compiler),
+                                             NULL);
+        jump = emitRegisterJump(compiler, ROP_JZ, reg);
+    }
+    releaseRegisters(compiler, mark);
+    return jump;
+}
+
+static void patchRegisterLoopJumps(Compiler* compiler, ObjIntArray* jumps, int* count,
+                                   int first, uint32_t target) {
+    for (int i = first; i < *count; i++) {
+        patchRegisterJumpTo(compiler, (uint32_t)jumps->elements[i], target);
+    }
+    *count = first;
+}
+
+static void compileRegisterPrint(Compiler* compiler, ASTNode* node) {
+    ASTNode* format = node->data.print.format;
+    uint8_t noNewline = node->data.print.newline ? 0 : 1;
+    uint8_t text = allocateRegister(compiler);
+
+    if (!node->data.print.arguments) {
+        uint8_t callIndex = UINT8_MAX;
+        if (format->valueType && format->valueType->kind == TYPE_STRUCT) {
+            callIndex = resolveToStringFunction(compiler, format->valueType);
+        }
+        if (callIndex != UINT8_MAX) {
+            // The struct is the only argument of its to_string function
+            uint8_t mark = compiler->nextWindowSlot;
+            text = allocateWindowSlot(compiler);
+            compileRegisterExpression(compiler, format, text);
+            emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_CALL, text, callIndex));
+            emitRegisterOp(compiler, ROP_PRINT, 0, text, noNewline);
+            compiler->nextWindowSlot = mark;
+            return;
+        }
+        compileRegisterExpression(compiler, format, text);
+        emitRegisterOp(compiler, ROP_PRINT, 0, text, noNewline);
+        return;
+    }
+
+    if (format->type != AST_LITERAL || !IS_STRING(format->data.literal)) {
+        error(compiler, "print() needs a literal format string.");
+        return;
+    }
+
+    // Interpolation is lowered to string concatenation at compile time
+    ObjString* fmt = AS_STRING(format->data.literal);
+    const char* chars = fmt->chars;
+    int length = fmt->length;
+    int segmentStart = 0;
+    bool empty = true;
+    bool endsWithVoid = false;
+    ASTNode* arg = node->data.print.arguments;
+    uint8_t piece = allocateRegister(compiler);
+
+    for (int i = 0; i <= length && !compiler->hadError; i++) {
+        bool placeholder = i + 1 < length && chars[i] == '{' && chars[i + 1] == '}' && arg;
+        if (!placeholder && i < length) continue;
+
+        if (i > segmentStart) {
+            uint8_t target = empty ? text : piece;
+            emitLoadValue(compiler, target,
+                          STRING_VAL(allocateString(chars + segmentStart, i - segmentStart)));
+            if (!empty) emitRegisterOp(compiler, ROP_STR_CONCAT, text, text, piece);
+            empty = false;
+            endsWithVoid = false;
+        }
+        if (!placeholder) break;
+
+        if (arg->valueType &&
+            (arg->valueType->kind == TYPE_VOID || arg->valueType->kind == TYPE_NIL)) {
+            // A void call prints its own output; flush what we have first
+            if (!empty) emitRegisterOp(compiler, ROP_PRINT, 0, text, 1);
+            compileRegisterExpression(compiler, arg, piece);
+            empty = true;
+            endsWithVoid = true;
+        } else {
+            uint8_t target = empty ? text : piece;
+            compileRegisterExpression(compiler, arg, target);
+            if (!arg->valueType || arg->valueType->kind != TYPE_STRING) {
+                emitRegisterOp(compiler, ROP_CAST_TO_STR, target, target, 0);
+            }
+            if (!empty) emitRegisterOp(compiler, ROP_STR_CONCAT, text, text, piece);
+            empty = false;
+            endsWithVoid = false;
+        }
+        arg = arg->next;
+        segmentStart = i + 2;
+        i++;
+    }
+
+    // Output ending in a void call has already been printed without newline
+    if (empty && endsWithVoid) return;
+    if (empty) emitLoadValue(compiler, text, STRING_VAL(allocateString("", 0)));
+    emitRegisterOp(compiler, ROP_PRINT, 0, text, noNewline);
+}
+
+static void compileRegisterIf(Compiler* compiler, ASTNode* node) {
+    uint32_t endJumps[UINT8_COUNT];
+    int endCount = 0;
+
+    uint32_t next = compileRegisterCondition(compiler, node->data.ifStmt.condition);
+    compileRegisterStatement(compiler, node->data.ifStmt.thenBranch);
+
+    ASTNode* elifCondition = node->data.ifStmt.elifConditions;
+    ASTNode* elifBranch = node->data.ifStmt.elifBranches;
+    while (elifCondition && elifBranch && !compiler->hadError) {
+        if (endCount == UINT8_COUNT) {
+            error(compiler, "Too many elif branches.");
+            return;
+        }
+        endJumps[endCount++] = emitRegisterJump(compiler, ROP_JMP, 0);
+        patchRegisterJump(compiler, next);
+        next = compileRegisterCondition(compiler, elifCondition);
+        compileRegisterStatement(compiler, elifBranch);
+        elifCondition = elifCondition->next;
+        elifBranch = elifBranch->next;
+    }
+
+    if (node->data.ifStmt.elseBranch) {
+        uint32_t skipElse = emitRegisterJump(compiler, ROP_JMP, 0);
+        patchRegisterJump(compiler, next);
+        compileRegisterStatement(compiler, node->data.ifStmt.elseBranch);
+        patchRegisterJump(compiler, skipElse);
+    } else {
+        patchRegisterJump(compiler, next);
+    }
+    for (int i = 0; i < endCount; i++) {
+        patchRegisterJump(compiler, endJumps[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Loop string builders
+// -----------------------------------------------------------------------------
+//
+// `s = s + e` in a loop copies all of s on every iteration. When a string
+// local is only ever appended to inside a loop, the loop works on a string
+// builder instead: STR_BUILDER_NEW seeds it from s before the loop, each
+// append becomes STR_BUILDER_APPEND, and STR_BUILDER_FINISH writes the
+// result back to s where the loop exits (breaks land there too). s itself is
+// stale inside the loop, which is why no other use of it is allowed there.
+
+#define MAX_LOOP_BUILDERS 8
+
+// Stands in for "too many uses to count": the variable is never rewritten
+#define UNKNOWN_USES 0x10000
+
+// Whether `node` is the assignment `s = s + e` of two strings
+static bool isStringAppend(ASTNode* node) {
+    if (node->type != AST_ASSIGNMENT) return false;
+    ASTNode* sum = node->left;
+    return sum && sum->type == AST_BINARY &&
+           sum->data.operation.operator.type == TOKEN_PLUS &&
+           !sum->data.operation.convertLeft && !sum->data.operation.convertRight &&
+           sum->valueType && sum->valueType->kind == TYPE_STRING &&
+           sum->right->valueType && sum->right->valueType->kind == TYPE_STRING &&
+           sum->left->type == AST_VARIABLE &&
+           sum->left->data.variable.index == node->data.variable.index;
+}
+
+static int countVariableUses(ASTNode* node, uint8_t index);
+
+static int countListUses(ASTNode* node, uint8_t index) {
+    int uses = 0;
+    for (; node; node = node->next) {
+        uses += countVariableUses(node, index);
+    }
+    return uses;
+}
+
+// How many times `node` declares, reads or assigns variable `index`
+static int countVariableUses(ASTNode* node, uint8_t index) {
+    if (!node) return 0;
+    int uses = 0;
+    switch (node->type) {
+        case AST_VARIABLE:
+        case AST_ASSIGNMENT:
+            if (node->data.variable.index == index) uses++;
+            break;
+        case AST_LET:
+        case AST_STATIC:
+            if (node->data.let.index == index) uses++;
+            uses += countVariableUses(node->data.let.initializer, index);
+            break;
+        case AST_LITERAL:
+        case AST_BINARY:
+        case AST_UNARY:
+        case AST_CAST:
+        case AST_FIELD:
+        case AST_FIELD_SET:
+        case AST_CONST:
+        case AST_ENUM:
+        case AST_BREAK:
+        case AST_CONTINUE:
+            break;
+        case AST_CALL:
+            uses += countListUses(node->data.call.arguments, index);
+            break;
+        case AST_ARRAY:
+            uses += countListUses(node->data.array.elements, index);
+            break;
+        case AST_STRUCT_LITERAL:
+            uses += countListUses(node->data.structLiteral.values, index);
+            break;
+        case AST_ARRAY_SET:
+            uses += countVariableUses(node->data.arraySet.index, index);
+            break;
+        case AST_SLICE:
+            uses += countVariableUses(node->data.slice.start, index) +
+                    countVariableUses(node->data.slice.end, index);
+            break;
+        case AST_PRINT:
+            uses += countVariableUses(node->data.print.format, index) +
+                    countListUses(node->data.print.arguments, index);
+            break;
+        case AST_IF:
+            uses += countVariableUses(node->data.ifStmt.condition, index) +
+                    countVariableUses(node->data.ifStmt.thenBranch, index) +
+                    countListUses(node->data.ifStmt.elifConditions, index) +
+                    countListUses(node->data.ifStmt.elifBranches, index) +
+                    countVariableUses(node->data.ifStmt.elseBranch, index);
+            break;
+        case AST_TERNARY:
+            uses += countVariableUses(node->data.ternary.condition, index) +
+                    countVariableUses(node->data.ternary.thenExpr, index) +
+                    countVariableUses(node->data.ternary.elseExpr, index);
+            break;
+        case AST_BLOCK:
+            uses += countListUses(node->data.block.statements, index);
+            break;
+        case AST_WHILE:
+            uses += countVariableUses(node->data.whileStmt.condition, index) +
+                    countVariableUses(node->data.whileStmt.body, index);
+            break;
+        case AST_FOR:
+            uses += countVariableUses(node->data.forStmt.startExpr, index) +
+                    countVariableUses(node->data.forStmt.endExpr, index) +
+                    countVariableUses(node->data.forStmt.stepExpr, index) +
+                    countVariableUses(node->data.forStmt.body, index);
+            break;
+        case AST_RETURN:
+            uses += countVariableUses(node->data.returnStmt.value, index);
+            break;
+        default:
+            // try blocks, matches, nested functions: not worth following
+            return UNKNOWN_USES;
+    }
+    return uses + countVariableUses(node->left, index) +
+           countVariableUses(node->right, index);
+}
+
+// Find the string appends that run as statements in `node`. Each one's
+// variable is added to `indices` (once); `appends` counts them per variable.
+static void collectStringAppends(ASTNode* node, uint8_t* indices, int* count,
+                                 int* appends) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT: {
+                if (!isStringAppend(node)) break;
+                uint8_t index = node->data.variable.index;
+                int i = 0;
+                while (i < *count && indices[i] != index) i++;
+                if (i == *count) {
+                    if (*count == MAX_LOOP_BUILDERS) break;
+                    indices[(*count)++] = index;
+                    appends[i] = 0;
+                }
+                appends[i]++;
+                break;
+            }
+            case AST_BLOCK:
+                collectStringAppends(node->data.block.statements, indices, count, appends);
+                break;
+            case AST_IF:
+                collectStringAppends(node->data.ifStmt.thenBranch, indices, count, appends);
+                collectStringAppends(node->data.ifStmt.elifBranches, indices, count, appends);
+                collectStringAppends(node->data.ifStmt.elseBranch, indices, count, appends);
+                break;
+            case AST_WHILE:
+                collectStringAppends(node->data.whileStmt.body, indices, count, appends);
+                break;
+            case AST_FOR:
+                collectStringAppends(node->data.forStmt.body, indices, count, appends);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Start builders for the string locals `loop` only appends to, recording
+// their variables in `indices`. Returns how many were started.
+static int beginLoopBuilders(Compiler* compiler, ASTNode* loop, uint8_t* indices) {
+    // A catch block could observe the stale variable
+    if (!compiler->promoteLocals || compiler->tryDepth > 0) return 0;
+
+    uint8_t candidates[MAX_LOOP_BUILDERS];
+    int appends[MAX_LOOP_BUILDERS];
+    int candidateCount = 0;
+    ASTNode* body = loop->type == AST_WHILE ? loop->data.whileStmt.body
+                                            : loop->data.forStmt.body;
+    collectStringAppends(body, candidates, &candidateCount, appends);
+
+    int count = 0;
+    for (int i = 0; i < candidateCount; i++) {
+        uint8_t index = candidates[i];
+        uint8_t local = localRegister(compiler, index);
+        if (local == NO_LOCAL_REGISTER ||
+            compiler->builderRegisters[index] != NO_LOCAL_REGISTER ||
+            countVariableUses(loop, index) != 2 * appends[i]) {
+            continue;
+        }
+        uint8_t builder = allocateRegister(compiler);
+        emitRegisterOp(compiler, ROP_STR_BUILDER_NEW, builder, local, 0);
+        compiler->builderRegisters[index] = builder;
+        indices[count++] = index;
+    }
+    return count;
+}
+
+// Write the builders back to their variables at the loop exit
+static void endLoopBuilders(Compiler* compiler, uint8_t* indices, int count) {
+    for (int i = 0; i < count; i++) {
+        uint8_t index = indices[i];
+        emitRegisterOp(compiler, ROP_STR_BUILDER_FINISH, localRegister(compiler, index),
+                       compiler->builderRegisters[index], 0);
+        compiler->builderRegisters[index] = NO_LOCAL_REGISTER;
+    }
+}
+
+static void compileRegisterWhile(Compiler* compiler, ASTNode* node) {
+    int enclosingLoopDepth = compiler->loopDepth;
+    int breakBase = compiler->breakJumpCount;
+    int continueBase = compiler->continueJumpCount;
+    compiler->loopDepth++;
+
+    uint8_t builders[MAX_LOOP_BUILDERS];
+    int builderCount = beginLoopBuilders(compiler, node, builders);
+
+    uint32_t loopStart = currentRegisterAddress(compiler);
+    uint32_t exitJump = compileRegisterCondition(compiler, node->data.whileStmt.condition);
+
+    beginScope(compiler);
+    compileRegisterStatement(compiler, node->data.whileStmt.body);
+    endScope(compiler);
+
+    patchRegisterLoopJumps(compiler, compiler->continueJumps, &compiler->continueJumpCount,
+                           continueBase, loopStart);
+    uint32_t back = emitRegisterJump(compiler, ROP_JMP, 0);
+    patchRegisterJumpTo(compiler, back, loopStart);
+    patchRegisterJump(compiler, exitJump);
+    patchRegisterLoopJumps(compiler, compiler->breakJumps, &compiler->breakJumpCount,
+                           breakBase, currentRegisterAddress(compiler));
+    endLoopBuilders(compiler, builders, builderCount);
+
+    compiler->loopDepth = enclosingLoopDepth;
+}
+
+static void compileRegisterFor(Compiler* compiler, ASTNode* node) {
+    Type* iterType = node->data.forStmt.startExpr->valueType;
+    TypeKind kind = iterType ? iterType->kind : TYPE_I32;
+    uint8_t iterator = node->data.forStmt.iteratorIndex;
+    RegisterOpcode addOp;
+    Value one;
+    switch (kind) {
+        case TYPE_I32: addOp = ROP_ADD_I32; one = I32_VAL(1); break;
+        case TYPE_I64: addOp = ROP_ADD_I64; one = I64_VAL(1); break;
+        case TYPE_U32: addOp = ROP_ADD_U32; one = U32_VAL(1); break;
+        case TYPE_U64: addOp = ROP_ADD_U64; one = U64_VAL(1); break;
+        default:
+            error(compiler, "Unsupported iterator type for for loop.");
+            return;
+    }
+
+    beginScope(compiler);
+    int enclosingLoopDepth = compiler->loopDepth;
+    int breakBase = compiler->breakJumpCount;
+    int continueBase = compiler->continueJumpCount;
+
+    uint8_t loopMark = compiler->nextRegister;
+    if (canPromoteLocal(compiler)) {
+        compiler->localRegisters[iterator] = allocateRegister(compiler);
+    }
+    uint8_t builders[MAX_LOOP_BUILDERS];
+    int builderCount = beginLoopBuilders(compiler, node, builders);
+    uint8_t mark = compiler->nextRegister;
+    uint8_t value = compileRegisterOperand(compiler, node->data.forStmt.startExpr,
+                                           allocateRegister(compiler), NULL);
+    emitStoreVariable(compiler, value, iterator);
+    releaseRegisters(compiler, mark);
+
+    uint32_t loopStart = currentRegisterAddress(compiler);
+    compiler->loopDepth++;
+
+    uint8_t current = localRegister(compiler, iterator);
+    if (current == NO_LOCAL_REGISTER) {
+        current = allocateRegister(compiler);
+        emitLoadGlobal(compiler, current, iterator);
+    }
+    uint8_t end = compileRegisterOperand(compiler, node->data.forStmt.endExpr,
+                                         allocateRegister(compiler), NULL);
+    uint32_t exitJump;
+    if (kind == TYPE_I32) {
+        uint8_t test = allocateRegister(compiler);
+        emitRegisterOp(compiler, ROP_LT_I32, test, current, end);
+        exitJump = emitRegisterJump(compiler, ROP_JZ, test);
+    } else {
+        emitRegisterOp(compiler, flagCompareOpcode(compiler, kind), 0, current, end);
+        exitJump = emitRegisterJump(compiler, ROP_JGE, 0);
+    }
+    releaseRegisters(compiler, mark);
+
+    compileRegisterStatement(compiler, node->data.forStmt.body);
+
+    // Continue point: advance the iterator
+    patchRegisterLoopJumps(compiler, compiler->continueJumps, &compiler->continueJumpCount,
+                           continueBase, currentRegisterAddress(compiler));
+    current = localRegister(compiler, iterator);
+    if (current == NO_LOCAL_REGISTER) {
+        current = allocateRegister(compiler);
+        emitLoadGlobal(compiler, current, iterator);
+    }
+    uint8_t step = allocateRegister(compiler);
+    if (node->data.forStmt.stepExpr) {
+        step = compileRegisterOperand(compiler, node->data.forStmt.stepExpr, step, NULL);
+    } else {
+        emitLoadValue(compiler, step, one);
+    }
+    emitRegisterOp(compiler, addOp, current, current, step);
+    emitStoreVariable(compiler, current, iterator);
+    releaseRegisters(compiler, mark);
+
+    uint32_t back = emitRegisterJump(compiler, ROP_JMP, 0);
+    patchRegisterJumpTo(compiler, back, loopStart);
+    patchRegisterJump(compiler, exitJump);
+    patchRegisterLoopJumps(compiler, compiler->breakJumps, &compiler->breakJumpCount,
+                           breakBase, currentRegisterAddress(compiler));
+    endLoopBuilders(compiler, builders, builderCount);
+
+    compiler->loopDepth = enclosingLoopDepth;
+    releaseRegisters(compiler, loopMark);
+    endScope(compiler);
+}
+
+// Whether a statement declares a function anywhere inside it
+static bool containsFunction(ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_FUNCTION:
+                return true;
+            case AST_BLOCK:
+                if (containsFunction(node->data.block.statements)) return true;
+                break;
+            case AST_IF:
+                if (containsFunction(node->data.ifStmt.thenBranch) ||
+                    containsFunction(node->data.ifStmt.elifBranches) ||
+                    containsFunction(node->data.ifStmt.elseBranch)) return true;
+                break;
+            case AST_WHILE:
+                if (containsFunction(node->data.whileStmt.body)) return true;
+                break;
+            case AST_FOR:
+                if (containsFunction(node->data.forStmt.body)) return true;
+                break;
+            case AST_TRY:
+                if (containsFunction(node->data.tryStmt.tryBlock) ||
+                    containsFunction(node->data.tryStmt.catchBlock)) return true;
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+// Record the public global `index` in the chunk's export table under the
+// name importers look it up by. Functions are exported by start address,
+// everything else by global slot.
+static void emitRegisterExport(Compiler* compiler, uint8_t index, uint32_t address,
+                               Type* type, bool isFunction) {
+    ObjString* name = vm.variableNames[index].name;
+    if (!name) return;
+    if (!register_chunk_add_export(compiler->rchunk, name->chars, address,
+                                   valueTypeForKind(type), isFunction)) {
+        error(compiler, "Out of memory for register chunk exports.");
+    }
+}
+
+// Compile the parameters and body of a function starting at the current
+// address, with the locals promoted as far as `compiler->promoteLimit`
+static int compileRegisterFunctionBody(Compiler* compiler, ASTNode* node) {
+    // Arguments arrive in R0..Rn-1, which the allocator keeps for v0..vn-1
+    int paramCount = 0;
+    for (ASTNode* param = node->data.function.parameters; param; param = param->next) {
+        uint8_t reg = allocateRegister(compiler);
+        if (compiler->promoteLocals) {
+            compiler->localRegisters[param->data.let.index] = reg;
+        } else {
+            emitStoreGlobal(compiler, reg, param->data.let.index);
+        }
+        paramCount++;
+    }
+    if (!compiler->promoteLocals) {
+        releaseRegisters(compiler, 0);
+    }
+
+    compileRegisterStatement(compiler, node->data.function.body);
+    if (node->data.function.returnType &&
+        node->data.function.returnType->kind != TYPE_VOID) {
+        uint8_t reg = allocateRegister(compiler);
+        emitLoadValue(compiler, reg, NIL_VAL);
+        emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_RET_VAL, reg, 0));
+    } else {
+        emitRegisterOp(compiler, ROP_RET, 0, 0, 0);
+    }
+    return paramCount;
+}
+
+static void compileRegisterFunction(Compiler* compiler, ASTNode* node) {
+    beginScope(compiler);
+
+    // The body gets its own virtual registers and argument windows. Its
+    // locals can live in registers unless a nested function might read them
+    // through their globals.
+    uint8_t enclosingNext = compiler->nextRegister;
+    uint8_t enclosingWindow = compiler->nextWindowSlot;
+    uint8_t enclosingLane = compiler->nextLane;
+    bool enclosingPromote = compiler->promoteLocals;
+    uint8_t enclosingLimit = compiler->promoteLimit;
+    uint8_t enclosingLocals[UINT8_COUNT];
+    memcpy(enclosingLocals, compiler->localRegisters, sizeof(enclosingLocals));
+    bool promote = !containsFunction(node->data.function.body);
+
+    uint32_t jumpOverFunction = emitRegisterJump(compiler, ROP_JMP, 0);
+    uint32_t functionStart = currentRegisterAddress(compiler);
+
+    char name[node->data.function.name.length + 1];
+    memcpy(name, node->data.function.name.start, node->data.function.name.length);
+    name[node->data.function.name.length] = '\0';
+
+    // Too many locals live at once to fit the register file: compile the
+    // body again with fewer of them promoted, the rest in their globals
+    static const uint8_t limits[] = { UINT8_MAX, REGISTER_COUNT * 3 / 4,
+                                      REGISTER_COUNT / 2, REGISTER_COUNT / 4, 0 };
+    int paramCount = 0;
+    uint16_t funcIndex = UINT16_MAX;
+    for (size_t attempt = 0; attempt < sizeof(limits) / sizeof(limits[0]); attempt++) {
+        register_chunk_truncate(compiler->rchunk, functionStart);
+        memcpy(compiler->localRegisters, enclosingLocals, sizeof(enclosingLocals));
+        compiler->nextRegister = 0;
+        compiler->nextWindowSlot = 0;
+        compiler->nextLane = 0;
+        compiler->promoteLocals = promote && limits[attempt] > 0;
+        compiler->promoteLimit = limits[attempt];
+
+        paramCount = compileRegisterFunctionBody(compiler, node);
+        funcIndex = register_chunk_add_function(
+            compiler->rchunk, name, functionStart, currentRegisterAddress(compiler) - 1,
+            (uint8_t)paramCount, valueTypeForKind(node->data.function.returnType));
+        if (compiler->hadError || funcIndex == UINT16_MAX ||
+            register_function_fits(compiler->rchunk, funcIndex)) {
+            break;
+        }
+        if (!compiler->promoteLocals) {
+            compiler->currentLine = node->line;
+            compiler->currentColumn = firstNonWhitespaceColumn(compiler, node->line);
+            errorFmt(compiler, "Function '%s' needs more than %d registers.", name,
+                     REGISTER_COUNT);
+            break;
+        }
+    }
+    patchRegisterJump(compiler, jumpOverFunction);
+
+    if (funcIndex == UINT16_MAX) {
+        error(compiler, "Too many functions defined.");
+    } else {
+        reserveRegisterGlobal(compiler, node->data.function.index);
+        register_chunk_set_global(compiler->rchunk, node->data.function.index,
+                                  I32_VAL(funcIndex));
+        compiler->rchunk->functions[funcIndex].global_index = node->data.function.index;
+        if (node->data.function.isPublic) {
+            emitRegisterExport(compiler, node->data.function.index, functionStart,
+                               node->data.function.returnType, true);
+        }
+    }
+
+    compiler->nextRegister = enclosingNext;
+    compiler->nextWindowSlot = enclosingWindow;
+    compiler->nextLane = enclosingLane;
+    compiler->promoteLocals = enclosingPromote;
+    compiler->promoteLimit = enclosingLimit;
+    endScope(compiler);
+}
+
+static void compileRegisterStatement(Compiler* compiler, ASTNode* node) {
+    if (!node || compiler->hadError) return;
+    compiler->currentLine = node->line;
+    uint8_t mark = compiler->nextRegister;
+
+    switch (node->type) {
+        case AST_LET:
+        case AST_STATIC: {
+            if (node->type == AST_LET && canPromoteLocal(compiler)) {
+                // The local keeps its register until the enclosing scope ends
+                uint8_t local = allocateRegister(compiler);
+                compiler->localRegisters[node->data.let.index] = local;
+                mark = compiler->nextRegister;
+                if (node->data.let.initializer) {
+                    compileRegisterExpression(compiler, node->data.let.initializer, local);
+                } else {
+                    emitLoadValue(compiler, local, NIL_VAL);
+                }
+                break;
+            }
+            uint8_t value = allocateRegister(compiler);
+            if (node->data.let.initializer) {
+                compileRegisterExpression(compiler, node->data.let.initializer, value);
+            } else {
+                emitLoadValue(compiler, value, NIL_VAL);
+            }
+            emitStoreGlobal(compiler, value, node->data.let.index);
+            if (node->data.let.isPublic) {
+                emitRegisterExport(compiler, node->data.let.index, node->data.let.index,
+                                   node->valueType, false);
+            }
+            break;
+        }
+
+        case AST_CONST:
+            // Resolved at compile time; importers read the recorded value
+            if (node->data.constant.isPublic) {
+                reserveRegisterGlobal(compiler, node->data.constant.index);
+                emitRegisterExport(compiler, node->data.constant.index, node->data.constant.index,
+                                   node->valueType, false);
+            }
+            break;
+
+        case AST_ENUM:
+            // Resolved at compile time
+            break;
+
+        case AST_PRINT:
+            compileRegisterPrint(compiler, node);
+            break;
+
+        case AST_IF:
+            compileRegisterIf(compiler, node);
+            break;
+
+        case AST_BLOCK: {
+            if (node->data.block.scoped) beginScope(compiler);
+            for (ASTNode* stmt = node->data.block.statements; stmt && !compiler->hadError;
+                 stmt = stmt->next) {
+                compileRegisterStatement(compiler, stmt);
+            }
+            if (node->data.block.scoped) endScope(compiler);
+            break;
+        }
+
+        case AST_WHILE:
+            compileRegisterWhile(compiler, node);
+            break;
+
+        case AST_FOR:
+            compileRegisterFor(compiler, node);
+            break;
+
+        case AST_FUNCTION:
+            compileRegisterFunction(compiler, node);
+            break;
+
+        case AST_RETURN:
+            if (node->data.returnStmt.value) {
+                uint8_t value = compileRegisterOperand(compiler, node->data.returnStmt.value,
+                                                       allocateRegister(compiler), NULL);
+                emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_RET_VAL, value, 0));
+            } else {
+                emitRegisterOp(compiler, ROP_RET, 0, 0, 0);
+            }
+            break;
+
+        case AST_BREAK:
+            if (compiler->loopDepth == 0) {
+                error(compiler, "Cannot use 'break' outside of a loop.");
+                return;
+            }
+            addBreakJump(compiler, (int)emitRegisterJump(compiler, ROP_JMP, 0));
+            break;
+
+        case AST_CONTINUE:
+            if (compiler->loopDepth == 0) {
+                error(compiler, "Cannot use 'continue' outside of a loop.");
+                return;
+            }
+            addContinueJump(compiler, (int)emitRegisterJump(compiler, ROP_JMP, 0));
+            break;
+
+        case AST_TRY: {
+            beginScope(compiler);
+            uint8_t errorIndex = node->data.tryStmt.errorIndex;
+            reserveRegisterGlobal(compiler, errorIndex);
+            uint32_t setup = emitRegisterJump(compiler, ROP_TRY_BEGIN, errorIndex);
+            compiler->tryDepth++;
+            compileRegisterStatement(compiler, node->data.tryStmt.tryBlock);
+            compiler->tryDepth--;
+            emitRegisterOp(compiler, ROP_TRY_END, 0, 0, 0);
+            uint32_t jumpOver = emitRegisterJump(compiler, ROP_JMP, 0);
+            patchRegisterJump(compiler, setup);
+            compileRegisterStatement(compiler, node->data.tryStmt.catchBlock);
+            patchRegisterJump(compiler, jumpOver);
+            endScope(compiler);
+            break;
+        }
+
+        case AST_ASSIGNMENT: {
+            uint8_t builder = compiler->builderRegisters[node->data.variable.index];
+            if (builder != NO_LOCAL_REGISTER && isStringAppend(node)) {
+                uint8_t piece = compileRegisterOperand(compiler, node->left->right,
+                                                       allocateRegister(compiler), NULL);
+                emitRegisterOp(compiler, ROP_STR_BUILDER_APPEND, builder, piece, 0);
+                break;
+            }
+            uint8_t value = allocateRegister(compiler);
+            compileRegisterExpression(compiler, node, value);
+            break;
+        }
+
+        case AST_IMPORT:
+        case AST_USE: {
+            ObjString* path = node->type == AST_IMPORT ? node->data.importStmt.path
+                                                       : node->data.useStmt.path;
+            uint32_t constant = register_chunk_add_constant(compiler->rchunk, STRING_VAL(path));
+            emitRegisterInstruction(compiler, MAKE_IMM_INSTRUCTION(ROP_IMPORT, 0, constant));
+            break;
+        }
+
+        default: {
+            // Expression statement
+            uint8_t value = allocateRegister(compiler);
+            compileRegisterExpression(compiler, node, value);
+            break;
+        }
+    }
+
+    releaseRegisters(compiler, mark);
+}
+
+// Resolve CALL targets from function global indices to start addresses.
+// Functions that live in another module are called through ROP_MODULE_CALL.
+static void linkRegisterCalls(RegisterChunk* rchunk) {
+    for (uint32_t i = 0; i < rchunk->code_count; i++) {
+        uint32_t instruction = rchunk->code[i];
+        if (GET_OPCODE(instruction) != ROP_CALL) continue;
+        uint16_t global = GET_IMM(instruction);
+        Value fn = global < rchunk->global_count ? rchunk->globals[global] : NIL_VAL;
+        if (IS_I32(fn) && AS_I32(fn) >= 0 && AS_I32(fn) < rchunk->function_count) {
+            uint32_t start = rchunk->functions[AS_I32(fn)].start_address;
+            rchunk->code[i] = MAKE_IMM_INSTRUCTION(ROP_CALL, GET_DST(instruction), start);
+        } else {
+            rchunk->code[i] = MAKE_IMM_INSTRUCTION(ROP_MODULE_CALL, GET_DST(instruction), global);
+        }
+    }
+}
+
+// Direct register VM compilation entry point
+bool compileToRegisterDirect(ASTNode* ast, RegisterChunk* rchunk,
+                            const char* filePath, const char* sourceCode, bool requireMain) {
+    Compiler compiler;
+    initRegisterCompiler(&compiler, rchunk, filePath, sourceCode);
+
+    // Every instruction records the line it came from, for runtime errors
+    // and profiles
+    if (!register_chunk_enable_debug(rchunk) ||
+        register_chunk_add_source_file(rchunk, filePath ? filePath : "<input>") == UINT16_MAX) {
+        error(&compiler, "Out of memory for register chunk debug info.");
+    }
+
+    initTypeSystem();
+    recordFunctionDeclarations(ast, &compiler);
+    for (ASTNode* current = ast; current; current = current->next) {
+        typeCheckNode(&compiler, current);
+        if (!compiler.hadError) {
+            compileRegisterStatement(&compiler, current);
+        }
+    }
+
+    // Automatically invoke `main` if it exists or report an error
+    Token mainTok;
+    mainTok.type = TOKEN_IDENTIFIER;
+    mainTok.start = "main";
+    mainTok.length = 4;
+    mainTok.line = 0;
+    uint8_t mainIndex = resolveVariable(&compiler, mainTok);
+
+    if (mainIndex != UINT8_MAX) {
+        emitRegisterInstruction(&compiler,
+            MAKE_IMM_INSTRUCTION(ROP_CALL, WINDOW_REGISTER(0), mainIndex));
+    } else if (requireMain) {
+        error(&compiler, "No 'main' function defined.");
+    }
+    emitRegisterOp(&compiler, ROP_HALT, 0, 0, 0);
+
+    if (!compiler.hadError) {
+        reserveRegisterGlobal(&compiler, (uint8_t)(vm.variableCount > 0 ? vm.variableCount - 1 : 0));
+        uint16_t failed;
+        if (!register_allocate_chunk(rchunk, &failed)) {
+            if (failed == UINT16_MAX) {
+                error(&compiler, "Out of memory during register allocation.");
+            } else if (failed < rchunk->function_count) {
+                errorFmt(&compiler, "Function '%s' needs more than %d registers.",
+                         rchunk->functions[failed].name, REGISTER_COUNT);
+            } else {
+                errorFmt(&compiler, "Top-level code needs more than %d registers.",
+                         REGISTER_COUNT);
+            }
+        } else {
+            linkRegisterCalls(rchunk);
+        }
+    }
+
+    freeCompiler(&compiler);
+    return !compiler.hadError;
+}
+
+bool typeCheckModule(ASTNode* ast, const char* filePath, const char* sourceCode) {
+    Compiler compiler;
+    initRegisterCompiler(&compiler, NULL, filePath, sourceCode);
+
+    initTypeSystem();
+    recordFunctionDeclarations(ast, &compiler);
+    for (ASTNode* current = ast; current && !compiler.hadError; current = current->next) {
+        typeCheckNode(&compiler, current);
+    }
+
+    freeCompiler(&compiler);
+    return !compiler.hadError;
+}
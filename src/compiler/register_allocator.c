@@ -0,0 +1,879 @@
+/**
+ * @file register_allocator.c
+ * @brief Orus Register Allocator
+ *
+ * Maps the virtual registers emitted by the register code generator onto
+ * the VM register file, one function at a time:
+ *
+ * 1. Split the chunk into regions: each function body, plus the top-level
+ *    code around them. Nested function bodies belong to their own region.
+ * 2. Compute liveness backwards over each region's control flow. Code in a
+ *    try block also flows to its handler.
+ * 3. Build the interference sets: a value defined by an instruction
+ *    interferes with everything live after it, except the source of a MOVE.
+ * 4. Visit the virtual registers in order of their first appearance and
+ *    give each the lowest free register, preferring the register of its MOVE
+ *    partner. Because interference follows exact liveness, a register freed
+ *    in a lifetime hole is reused right away.
+ * 5. Rewrite the operands, place argument windows after the ordinary
+ *    registers and strip the moves that became self moves.
+ *
+ * @author Orus Development Team
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../include/register_allocator.h"
+#include "../../include/register_chunk.h"
+#include "../../include/register_opcodes.h"
+#include "../../include/register_vm.h"
+
+// =============================================================================
+// PRIVATE CONSTANTS
+// =============================================================================
+
+/** Words in a set of virtual registers */
+#define SET_WORDS ((VIRTUAL_REGISTER_COUNT + 63) / 64)
+
+/** Marker for a virtual register that has no register yet */
+#define UNASSIGNED 0xFF
+
+/** Marker for an instruction outside any try block */
+#define NO_HANDLER UINT32_MAX
+
+/** Deepest try nesting tracked per region */
+#define MAX_TRY_DEPTH 64
+
+#if REGISTER_COUNT > 64
+#error "register_allocator.c keeps free registers in a 64-bit mask"
+#endif
+
+// =============================================================================
+// PRIVATE TYPES
+// =============================================================================
+
+/**
+ * @brief Set of ordinary virtual registers
+ */
+typedef struct {
+    uint64_t bits[SET_WORDS];
+} VirtualSet;
+
+/**
+ * @brief How an instruction uses one of its operand bytes
+ */
+typedef enum {
+    OPERAND_NONE,                 /**< Not a register, or a lane */
+    OPERAND_USE,                  /**< Register read */
+    OPERAND_DEF                   /**< Register written */
+} OperandRole;
+
+/**
+ * @brief Operand roles of the dst, src1 and src2 bytes
+ */
+typedef struct {
+    uint8_t role[3];
+} OperandRoles;
+
+/**
+ * @brief Working state for one region
+ */
+typedef struct {
+    const RegisterChunk* chunk;
+    const uint16_t* owner;        /**< Region of each instruction */
+    const uint32_t* handler;      /**< Innermost try handler of each instruction */
+    uint16_t region;              /**< Region being allocated */
+
+    uint32_t* addresses;          /**< Region instructions in address order */
+    uint32_t count;               /**< Number of region instructions */
+    uint32_t* position;           /**< Index in addresses of each instruction */
+
+    VirtualSet* live_in;          /**< Live before each region instruction */
+    VirtualSet* live_out;         /**< Live after each region instruction */
+    VirtualSet interferes[VIRTUAL_REGISTER_COUNT];
+
+    uint32_t start[VIRTUAL_REGISTER_COUNT];    /**< First appearance */
+    uint8_t hint[VIRTUAL_REGISTER_COUNT];      /**< MOVE partner */
+    uint8_t physical[VIRTUAL_REGISTER_COUNT];  /**< Assigned register */
+    bool seen[VIRTUAL_REGISTER_COUNT];         /**< Appears in the region */
+} RegionState;
+
+// =============================================================================
+// VIRTUAL REGISTER SETS
+// =============================================================================
+
+static void set_add(VirtualSet* set, uint8_t reg) {
+    set->bits[reg / 64] |= (uint64_t)1 << (reg % 64);
+}
+
+static void set_remove(VirtualSet* set, uint8_t reg) {
+    set->bits[reg / 64] &= ~((uint64_t)1 << (reg % 64));
+}
+
+static bool set_contains(const VirtualSet* set, uint8_t reg) {
+    return (set->bits[reg / 64] >> (reg % 64)) & 1;
+}
+
+/**
+ * @brief Add `from` to `into`
+ *
+ * @return true if `into` changed
+ */
+static bool set_union(VirtualSet* into, const VirtualSet* from) {
+    bool changed = false;
+    for (int i = 0; i < SET_WORDS; i++) {
+        uint64_t merged = into->bits[i] | from->bits[i];
+        changed |= merged != into->bits[i];
+        into->bits[i] = merged;
+    }
+    return changed;
+}
+
+static bool is_virtual(uint8_t reg) {
+    return reg < VIRTUAL_REGISTER_COUNT;
+}
+
+// =============================================================================
+// INSTRUCTION OPERANDS
+// =============================================================================
+
+/**
+ * @brief Register operands of an instruction as the code generator emits it
+ *
+ * @param opcode Instruction opcode
+ * @param roles Output roles
+ * @return false for opcodes the code generator never emits
+ */
+static bool get_operand_roles(RegisterOpcode opcode, OperandRoles* roles) {
+    uint8_t* role = roles->role;
+    role[0] = role[1] = role[2] = OPERAND_NONE;
+
+    switch (opcode) {
+        case ROP_NOP:
+        case ROP_HALT:
+        case ROP_JMP:
+        case ROP_JEQ:
+        case ROP_JNE:
+        case ROP_JLT:
+        case ROP_JLE:
+        case ROP_JGT:
+        case ROP_JGE:
+        case ROP_RET:
+        case ROP_TRY_BEGIN:
+        case ROP_TRY_END:
+        case ROP_IMPORT:
+        case ROP_LANE_ADD_I64:
+        case ROP_LANE_SUB_I64:
+        case ROP_LANE_MUL_I64:
+        case ROP_LANE_ADD_F64:
+        case ROP_LANE_SUB_F64:
+        case ROP_LANE_MUL_F64:
+        case ROP_LANE_DIV_F64:
+            return true;
+
+        case ROP_JZ:
+        case ROP_JNZ:
+        case ROP_STORE_GLOBAL:
+        case ROP_RET_VAL:
+            role[0] = OPERAND_USE;
+            return true;
+
+        case ROP_PRINT:
+        case ROP_UNBOX_I64:
+        case ROP_UNBOX_F64:
+            role[1] = OPERAND_USE;
+            return true;
+
+        case ROP_LOAD_IMM:
+        case ROP_LOAD_CONST:
+        case ROP_LOAD_GLOBAL:
+        case ROP_BOX_I64:
+        case ROP_BOX_F64:
+        case ROP_LANE_LT_I64:
+        case ROP_CALL:
+        case ROP_MODULE_CALL:
+        case ROP_CALL_STATIC:
+            role[0] = OPERAND_DEF;
+            return true;
+
+        case ROP_MOVE:
+        case ROP_NEG_I32:
+        case ROP_NEG_I64:
+        case ROP_NEG_F64:
+        case ROP_NEG_ANY:
+        case ROP_NOT:
+        case ROP_BOOL_NOT:
+        case ROP_CAST_I32_I64:
+        case ROP_CAST_I32_U32:
+        case ROP_CAST_I32_F64:
+        case ROP_CAST_I64_I32:
+        case ROP_CAST_F64_I32:
+        case ROP_CAST_TO_STR:
+        case ROP_CAST_TO_BOOL:
+        case ROP_GENERIC_CAST:
+        case ROP_TYPE_OF:
+        case ROP_LEN:
+        case ROP_NEW_ARRAY:
+        case ROP_NEW_PACKED_ARRAY:
+        case ROP_NEW_STRUCT:
+        case ROP_NEW_ENUM:
+        case ROP_GET_FIELD:
+        case ROP_STR_BUILDER_NEW:
+        case ROP_STR_BUILDER_FINISH:
+        case ROP_ARRAY_POP:
+            role[0] = OPERAND_DEF;
+            role[1] = OPERAND_USE;
+            return true;
+
+        case ROP_ADD_I32:
+        case ROP_SUB_I32:
+        case ROP_MUL_I32:
+        case ROP_DIV_I32:
+        case ROP_MOD_I32:
+        case ROP_ADD_I64:
+        case ROP_SUB_I64:
+        case ROP_MUL_I64:
+        case ROP_DIV_I64:
+        case ROP_MOD_I64:
+        case ROP_ADD_U32:
+        case ROP_ADD_U64:
+        case ROP_SUB_U32:
+        case ROP_SUB_U64:
+        case ROP_MUL_U32:
+        case ROP_MUL_U64:
+        case ROP_DIV_U32:
+        case ROP_DIV_U64:
+        case ROP_MOD_U32:
+        case ROP_MOD_U64:
+        case ROP_ADD_ANY:
+        case ROP_SUB_ANY:
+        case ROP_MUL_ANY:
+        case ROP_DIV_ANY:
+        case ROP_MOD_ANY:
+        case ROP_ADD_F64:
+        case ROP_SUB_F64:
+        case ROP_MUL_F64:
+        case ROP_DIV_F64:
+        case ROP_AND:
+        case ROP_OR:
+        case ROP_XOR:
+        case ROP_SHL:
+        case ROP_SHR:
+        case ROP_SAR:
+        case ROP_BOOL_AND:
+        case ROP_BOOL_OR:
+        case ROP_EQ_I32:
+        case ROP_NE_I32:
+        case ROP_LT_I32:
+        case ROP_LE_I32:
+        case ROP_GT_I32:
+        case ROP_GE_I32:
+        case ROP_EQ_STR:
+        case ROP_EQ_OBJ:
+        case ROP_STR_CONCAT:
+        case ROP_GET_INDEX:
+        case ROP_ARRAY_SLICE:
+            role[0] = OPERAND_DEF;
+            role[1] = OPERAND_USE;
+            role[2] = OPERAND_USE;
+            return true;
+
+        case ROP_CMP_I32:
+        case ROP_CMP_I64:
+        case ROP_CMP_U32:
+        case ROP_CMP_U64:
+        case ROP_CMP_F64:
+            role[1] = OPERAND_USE;
+            role[2] = OPERAND_USE;
+            return true;
+
+        case ROP_SET_INDEX:
+            role[0] = OPERAND_USE;
+            role[1] = OPERAND_USE;
+            role[2] = OPERAND_USE;
+            return true;
+
+        case ROP_SET_FIELD:
+            role[0] = OPERAND_USE;
+            role[2] = OPERAND_USE;
+            return true;
+
+        case ROP_STR_BUILDER_APPEND:
+        case ROP_ARRAY_PUSH:
+        case ROP_ARRAY_RESERVE:
+            // The builder or array is updated in place
+            role[0] = OPERAND_USE;
+            role[1] = OPERAND_USE;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Read operand byte `index` (0 = dst, 1 = src1, 2 = src2)
+ */
+static uint8_t get_operand(uint32_t instruction, int index) {
+    return (uint8_t)(instruction >> (8 * (index + 1)));
+}
+
+static uint32_t with_operand(uint32_t instruction, int index, uint8_t reg) {
+    int shift = 8 * (index + 1);
+    return (instruction & ~((uint32_t)0xFF << shift)) | ((uint32_t)reg << shift);
+}
+
+static bool is_jump(RegisterOpcode opcode) {
+    return opcode == ROP_JMP || (opcode >= ROP_JZ && opcode <= ROP_JGE);
+}
+
+/**
+ * @brief Whether the immediate of an instruction is a code address
+ *
+ * CALL immediates still hold function indices at this point.
+ */
+static bool has_code_target(RegisterOpcode opcode) {
+    return is_jump(opcode) || opcode == ROP_TRY_BEGIN;
+}
+
+// =============================================================================
+// REGIONS
+// =============================================================================
+
+/**
+ * @brief Assign every instruction to its innermost function, or top level
+ */
+static void find_regions(const RegisterChunk* chunk, uint16_t* owner) {
+    uint16_t top_level = chunk->function_count;
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        owner[address] = top_level;
+    }
+
+    for (uint16_t f = 0; f < chunk->function_count; f++) {
+        const FunctionInfo* func = &chunk->functions[f];
+        uint32_t size = func->end_address - func->start_address;
+        for (uint32_t address = func->start_address;
+             address <= func->end_address && address < chunk->code_count; address++) {
+            uint16_t current = owner[address];
+            if (current == top_level) {
+                owner[address] = f;
+                continue;
+            }
+            const FunctionInfo* other = &chunk->functions[current];
+            if (other->end_address - other->start_address > size) {
+                owner[address] = f;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Record the innermost try handler of every instruction in a region
+ *
+ * Try blocks are emitted lexically nested, so a stack suffices.
+ */
+static void find_handlers(const RegisterChunk* chunk, const uint16_t* owner,
+                          uint16_t region, uint32_t* handler) {
+    uint32_t stack[MAX_TRY_DEPTH];
+    int depth = 0;
+    int overflow = 0;
+
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        if (owner[address] != region) continue;
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[address]);
+
+        if (opcode == ROP_TRY_END) {
+            if (overflow > 0) {
+                overflow--;
+            } else if (depth > 0) {
+                depth--;
+            }
+        }
+        handler[address] = depth > 0 ? stack[depth - 1] : NO_HANDLER;
+        if (opcode == ROP_TRY_BEGIN) {
+            if (depth < MAX_TRY_DEPTH) {
+                stack[depth++] = GET_IMM(chunk->code[address]);
+            } else {
+                overflow++;
+            }
+        }
+    }
+}
+
+// =============================================================================
+// LIVENESS
+// =============================================================================
+
+/**
+ * @brief Successors of a region instruction that stay in the region
+ *
+ * @return Number of successors written (at most three)
+ */
+static int get_successors(const RegionState* state, uint32_t address, uint32_t* successors) {
+    const RegisterChunk* chunk = state->chunk;
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[address]);
+    uint32_t candidates[3];
+    int count = 0;
+
+    if (opcode != ROP_HALT && opcode != ROP_RET && opcode != ROP_RET_VAL) {
+        if (has_code_target(opcode)) {
+            candidates[count++] = GET_IMM(chunk->code[address]);
+        }
+        if (opcode != ROP_JMP) {
+            candidates[count++] = address + 1;
+        }
+    }
+    if (state->handler[address] != NO_HANDLER) {
+        candidates[count++] = state->handler[address];
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (candidates[i] < chunk->code_count &&
+            state->owner[candidates[i]] == state->region) {
+            successors[kept++] = candidates[i];
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief live_in = uses + (live_out - def) for one instruction
+ */
+static void transfer(uint32_t instruction, const VirtualSet* live_out, VirtualSet* live_in) {
+    OperandRoles roles;
+    get_operand_roles((RegisterOpcode)GET_OPCODE(instruction), &roles);
+
+    *live_in = *live_out;
+    for (int i = 0; i < 3; i++) {
+        uint8_t reg = get_operand(instruction, i);
+        if (roles.role[i] == OPERAND_DEF && is_virtual(reg)) {
+            set_remove(live_in, reg);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        uint8_t reg = get_operand(instruction, i);
+        if (roles.role[i] == OPERAND_USE && is_virtual(reg)) {
+            set_add(live_in, reg);
+        }
+    }
+}
+
+static void compute_liveness(RegionState* state) {
+    const RegisterChunk* chunk = state->chunk;
+    memset(state->live_in, 0, state->count * sizeof(VirtualSet));
+    memset(state->live_out, 0, state->count * sizeof(VirtualSet));
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = state->count; i-- > 0;) {
+            uint32_t address = state->addresses[i];
+            uint32_t successors[3];
+            int count = get_successors(state, address, successors);
+            for (int s = 0; s < count; s++) {
+                uint32_t next = state->position[successors[s]];
+                changed |= set_union(&state->live_out[i], &state->live_in[next]);
+            }
+
+            VirtualSet live_in;
+            transfer(chunk->code[address], &state->live_out[i], &live_in);
+            changed |= set_union(&state->live_in[i], &live_in);
+        }
+    }
+}
+
+// =============================================================================
+// INTERFERENCE
+// =============================================================================
+
+static void add_interference(RegionState* state, uint8_t a, uint8_t b) {
+    if (a == b) return;
+    set_add(&state->interferes[a], b);
+    set_add(&state->interferes[b], a);
+}
+
+static void note_appearance(RegionState* state, uint8_t reg, uint32_t index) {
+    if (!state->seen[reg]) {
+        state->seen[reg] = true;
+        state->start[reg] = index;
+    }
+}
+
+static void build_interference(RegionState* state) {
+    const RegisterChunk* chunk = state->chunk;
+    memset(state->interferes, 0, sizeof(state->interferes));
+    memset(state->seen, 0, sizeof(state->seen));
+    memset(state->hint, UNASSIGNED, sizeof(state->hint));
+
+    // Values live on entry (the parameters) are all present together
+    if (state->count > 0) {
+        for (int a = 0; a < VIRTUAL_REGISTER_COUNT; a++) {
+            if (!set_contains(&state->live_in[0], (uint8_t)a)) continue;
+            note_appearance(state, (uint8_t)a, 0);
+            for (int b = a + 1; b < VIRTUAL_REGISTER_COUNT; b++) {
+                if (set_contains(&state->live_in[0], (uint8_t)b)) {
+                    add_interference(state, (uint8_t)a, (uint8_t)b);
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < state->count; i++) {
+        uint32_t instruction = chunk->code[state->addresses[i]];
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+        OperandRoles roles;
+        get_operand_roles(opcode, &roles);
+
+        for (int op = 0; op < 3; op++) {
+            uint8_t reg = get_operand(instruction, op);
+            if (roles.role[op] != OPERAND_NONE && is_virtual(reg)) {
+                note_appearance(state, reg, i);
+            }
+        }
+
+        uint8_t def = get_operand(instruction, 0);
+        if (roles.role[0] != OPERAND_DEF || !is_virtual(def)) continue;
+
+        // A move's source may share the destination's register
+        int exempt = -1;
+        if (opcode == ROP_MOVE && is_virtual(GET_SRC1(instruction))) {
+            uint8_t src = GET_SRC1(instruction);
+            exempt = src;
+            if (state->hint[def] == UNASSIGNED) state->hint[def] = src;
+            if (state->hint[src] == UNASSIGNED) state->hint[src] = def;
+        }
+
+        for (int reg = 0; reg < VIRTUAL_REGISTER_COUNT; reg++) {
+            if (reg != exempt && set_contains(&state->live_out[i], (uint8_t)reg)) {
+                add_interference(state, def, (uint8_t)reg);
+            }
+        }
+    }
+}
+
+// =============================================================================
+// ASSIGNMENT
+// =============================================================================
+
+/**
+ * @brief Registers taken by already assigned neighbours of `reg`
+ */
+static uint64_t taken_registers(const RegionState* state, uint8_t reg) {
+    uint64_t taken = 0;
+    for (int other = 0; other < VIRTUAL_REGISTER_COUNT; other++) {
+        if (state->physical[other] != UNASSIGNED &&
+            set_contains(&state->interferes[reg], (uint8_t)other)) {
+            taken |= (uint64_t)1 << state->physical[other];
+        }
+    }
+    return taken;
+}
+
+/**
+ * @brief Give every virtual register of the region a register
+ *
+ * @param state Region with interference built
+ * @param pinned Virtual registers fixed to the same register (parameters)
+ * @param limit Registers available for ordinary values
+ * @return Frame size (ordinary registers used), or -1 if `limit` is too small
+ */
+static int assign_registers(RegionState* state, int pinned, int limit) {
+    uint8_t order[VIRTUAL_REGISTER_COUNT];
+    int count = 0;
+
+    memset(state->physical, UNASSIGNED, sizeof(state->physical));
+    for (int reg = 0; reg < pinned; reg++) {
+        state->physical[reg] = (uint8_t)reg;
+    }
+
+    for (int reg = pinned; reg < VIRTUAL_REGISTER_COUNT; reg++) {
+        if (!state->seen[reg]) continue;
+        // Insertion sort by first appearance keeps equal starts stable
+        int at = count++;
+        while (at > 0 && state->start[order[at - 1]] > state->start[reg]) {
+            order[at] = order[at - 1];
+            at--;
+        }
+        order[at] = (uint8_t)reg;
+    }
+
+    int frame = pinned;
+    for (int i = 0; i < count; i++) {
+        uint8_t reg = order[i];
+        uint64_t taken = taken_registers(state, reg);
+        int choice = -1;
+
+        uint8_t partner = state->hint[reg];
+        if (partner != UNASSIGNED && state->physical[partner] != UNASSIGNED &&
+            state->physical[partner] < limit &&
+            !((taken >> state->physical[partner]) & 1)) {
+            choice = state->physical[partner];
+        }
+        for (int candidate = 0; choice < 0 && candidate < limit; candidate++) {
+            if (!((taken >> candidate) & 1)) {
+                choice = candidate;
+            }
+        }
+        if (choice < 0) {
+            return -1;
+        }
+
+        state->physical[reg] = (uint8_t)choice;
+        if (choice + 1 > frame) {
+            frame = choice + 1;
+        }
+    }
+    return frame;
+}
+
+/**
+ * @brief Number of argument window slots a region uses
+ */
+static int count_window_slots(const RegionState* state) {
+    int slots = 0;
+    for (uint32_t i = 0; i < state->count; i++) {
+        uint32_t instruction = state->chunk->code[state->addresses[i]];
+        OperandRoles roles;
+        get_operand_roles((RegisterOpcode)GET_OPCODE(instruction), &roles);
+        for (int op = 0; op < 3; op++) {
+            uint8_t reg = get_operand(instruction, op);
+            if (roles.role[op] != OPERAND_NONE && IS_WINDOW_REGISTER(reg) &&
+                reg - WINDOW_REGISTER_BASE + 1 > slots) {
+                slots = reg - WINDOW_REGISTER_BASE + 1;
+            }
+        }
+    }
+    return slots;
+}
+
+static void rewrite_region(RegionState* state, RegisterChunk* chunk, int frame) {
+    for (uint32_t i = 0; i < state->count; i++) {
+        uint32_t address = state->addresses[i];
+        uint32_t instruction = chunk->code[address];
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+        OperandRoles roles;
+        get_operand_roles(opcode, &roles);
+
+        for (int op = 0; op < 3; op++) {
+            if (roles.role[op] == OPERAND_NONE) continue;
+            uint8_t reg = get_operand(instruction, op);
+            uint8_t mapped = IS_WINDOW_REGISTER(reg)
+                ? (uint8_t)(frame + reg - WINDOW_REGISTER_BASE)
+                : state->physical[reg];
+            instruction = with_operand(instruction, op, mapped);
+        }
+
+        if (opcode == ROP_MOVE && GET_DST(instruction) == GET_SRC1(instruction)) {
+            instruction = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+        }
+        chunk->code[address] = instruction;
+    }
+}
+
+/**
+ * @brief Allocate one region
+ *
+ * @param rewrite false to only find out whether the region fits
+ * @return Registers the region needs, or -1 if it does not fit
+ */
+static int allocate_region(RegionState* state, RegisterChunk* chunk, int parameters,
+                           bool rewrite) {
+    compute_liveness(state);
+    build_interference(state);
+
+    int slots = count_window_slots(state);
+    if (parameters > REGISTER_COUNT - slots) {
+        return -1;
+    }
+    int frame = assign_registers(state, parameters, REGISTER_COUNT - slots);
+    if (frame < 0) {
+        return -1;
+    }
+    if (rewrite) {
+        rewrite_region(state, chunk, frame);
+    }
+    return frame + slots;
+}
+
+// =============================================================================
+// NOP REMOVAL
+// =============================================================================
+
+/**
+ * @brief Remove the NOPs left by coalesced moves
+ *
+ * Jump and handler targets, function ranges, debug locations and exported
+ * function addresses follow the instructions they point at.
+ */
+static bool strip_coalesced_moves(RegisterChunk* chunk) {
+    uint32_t old_count = chunk->code_count;
+    uint32_t* map = malloc((old_count + 1) * sizeof(uint32_t));
+    if (!map) {
+        return false;
+    }
+
+    uint32_t new_count = 0;
+    for (uint32_t address = 0; address < old_count; address++) {
+        map[address] = new_count;
+        // A trailing NOP stays so jumps to the end remain in bounds
+        if (GET_OPCODE(chunk->code[address]) != ROP_NOP || address + 1 == old_count) {
+            new_count++;
+        }
+    }
+    map[old_count] = new_count;
+
+    if (new_count == old_count) {
+        free(map);
+        return true;
+    }
+
+    DebugInfo* debug = chunk->debug;
+    bool has_locations = debug && debug->locations && debug->location_count == old_count;
+    uint32_t next = 0;
+    for (uint32_t address = 0; address < old_count; address++) {
+        uint32_t instruction = chunk->code[address];
+        if (GET_OPCODE(instruction) == ROP_NOP && address + 1 != old_count) continue;
+
+        if (has_code_target((RegisterOpcode)GET_OPCODE(instruction))) {
+            uint32_t target = GET_IMM(instruction);
+            instruction = (instruction & 0xFFFFu) |
+                          ((target <= old_count ? map[target] : target) << 16);
+        }
+        chunk->code[next] = instruction;
+        if (has_locations) {
+            debug->locations[next] = debug->locations[address];
+        }
+        next++;
+    }
+    chunk->code_count = new_count;
+    if (has_locations) {
+        debug->location_count = new_count;
+    }
+
+    for (uint16_t f = 0; f < chunk->function_count; f++) {
+        FunctionInfo* func = &chunk->functions[f];
+        uint32_t start = map[func->start_address];
+        uint32_t end = func->end_address < old_count ? map[func->end_address + 1] : new_count;
+        func->start_address = start;
+        func->end_address = end > start ? end - 1 : start;
+    }
+    if (chunk->module) {
+        for (uint16_t i = 0; i < chunk->module->export_count; i++) {
+            ExportEntry* entry = &chunk->module->exports[i];
+            if (entry->is_function && entry->address <= old_count) {
+                entry->address = map[entry->address];
+            }
+        }
+    }
+
+    free(map);
+    return true;
+}
+
+// =============================================================================
+// PUBLIC INTERFACE
+// =============================================================================
+
+/**
+ * @brief Allocate every region, or only check region `only`
+ *
+ * @param only Region to check without changing the chunk, or UINT16_MAX to
+ *        allocate the whole chunk
+ */
+static bool allocate_chunk(RegisterChunk* chunk, uint16_t only, uint16_t* failed_function) {
+    uint32_t count = chunk->code_count;
+    uint16_t region_count = (uint16_t)(chunk->function_count + 1);
+    bool rewrite = only == UINT16_MAX;
+    *failed_function = UINT16_MAX;
+    if (count == 0) {
+        return true;
+    }
+
+    // Every instruction must be one the code generator emits
+    for (uint32_t address = 0; address < count; address++) {
+        OperandRoles roles;
+        if (!get_operand_roles((RegisterOpcode)GET_OPCODE(chunk->code[address]), &roles)) {
+            *failed_function = chunk->function_count;
+            return false;
+        }
+    }
+
+    uint16_t* owner = malloc(count * sizeof(uint16_t));
+    uint32_t* handler = malloc(count * sizeof(uint32_t));
+    RegionState* state = malloc(sizeof(RegionState));
+    uint32_t* addresses = malloc(count * sizeof(uint32_t));
+    uint32_t* position = malloc(count * sizeof(uint32_t));
+    VirtualSet* live_in = malloc(count * sizeof(VirtualSet));
+    VirtualSet* live_out = malloc(count * sizeof(VirtualSet));
+    bool ok = owner && handler && state && addresses && position && live_in && live_out;
+
+    if (ok) {
+        find_regions(chunk, owner);
+    }
+
+    int max_registers = 0;
+    for (uint16_t region = 0; ok && region < region_count; region++) {
+        if (!rewrite && region != only) continue;
+        find_handlers(chunk, owner, region, handler);
+        state->chunk = chunk;
+        state->owner = owner;
+        state->handler = handler;
+        state->region = region;
+        state->addresses = addresses;
+        state->position = position;
+        state->live_in = live_in;
+        state->live_out = live_out;
+        state->count = 0;
+        for (uint32_t address = 0; address < count; address++) {
+            if (owner[address] == region) {
+                position[address] = state->count;
+                addresses[state->count++] = address;
+            }
+        }
+
+        bool is_function = region < chunk->function_count;
+        int parameters = is_function ? chunk->functions[region].parameter_count : 0;
+        int registers = allocate_region(state, chunk, parameters, rewrite);
+        if (registers < 0) {
+            *failed_function = region;
+            ok = false;
+            break;
+        }
+        if (is_function && rewrite) {
+            chunk->functions[region].register_count = (uint8_t)registers;
+        }
+        if (registers > max_registers) {
+            max_registers = registers;
+        }
+    }
+
+    if (ok && rewrite) {
+        ok = strip_coalesced_moves(chunk);
+        chunk->max_registers = (uint8_t)max_registers;
+        chunk->is_verified = false;
+    }
+
+    free(owner);
+    free(handler);
+    free(state);
+    free(addresses);
+    free(position);
+    free(live_in);
+    free(live_out);
+    return ok;
+}
+
+bool register_allocate_chunk(RegisterChunk* chunk, uint16_t* failed_function) {
+    return allocate_chunk(chunk, UINT16_MAX, failed_function);
+}
+
+bool register_function_fits(RegisterChunk* chunk, uint16_t function) {
+    uint16_t failed;
+    return function < chunk->function_count && allocate_chunk(chunk, function, &failed);
+}
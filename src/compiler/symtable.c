@@ -32,7 +32,9 @@ void initSymbolTable(SymbolTable* table) {
  */
 void freeSymbolTable(SymbolTable* table) {
     // Types are managed elsewhere; do not free them here
-    free(table->symbols);
+    if (!inCompileArena(table->symbols)) {
+        free(table->symbols);
+    }
     table->symbols = NULL;
     table->count = 0;
     table->capacity = 0;
@@ -40,8 +42,19 @@ void freeSymbolTable(SymbolTable* table) {
 
 static void growCapacity(SymbolTable* table) {
     int newCapacity = table->capacity < 8 ? 8 : table->capacity * 2;
-    Symbol* newSymbols = (Symbol*)realloc(table->symbols, 
-                                         sizeof(Symbol) * newCapacity);
+    // Grow inside the compile arena when one is open; the old block is
+    // released with the arena
+    Symbol* newSymbols = (Symbol*)arenaAllocate(sizeof(Symbol) * newCapacity);
+    if (newSymbols) {
+        if (table->count > 0) {
+            memcpy(newSymbols, table->symbols, sizeof(Symbol) * table->count);
+        }
+        if (!inCompileArena(table->symbols)) {
+            free(table->symbols);
+        }
+    } else {
+        newSymbols = (Symbol*)realloc(table->symbols, sizeof(Symbol) * newCapacity);
+    }
     table->symbols = newSymbols;
     table->capacity = newCapacity;
 }
@@ -22,6 +22,13 @@ static Type* enumTypes[UINT8_COUNT] = {NULL};
 static int enumTypeCount = 0;
 static bool typeSystemInitialized = false;
 
+// Side arrays (parameter and field lists) live with their types in the
+// compile arena when one is open
+static void* allocateTypeData(size_t size) {
+    void* data = arenaAllocate(size);
+    return data ? data : malloc(size);
+}
+
 /**
  * Initialize the global type system and create primitive types.
  */
@@ -128,9 +135,23 @@ Type* createGenericType(ObjString* name) {
     return type;
 }
 
+// Whether a type name matches `name`; `key` is its interned string, if any.
+// Interned names compare by identity.
+static bool typeNameIs(ObjString* typeName, ObjString* key, const char* name) {
+    if (typeName->interned) return typeName == key;
+    return strcmp(typeName->chars, name) == 0;
+}
+
+static bool sameName(ObjString* a, ObjString* b) {
+    if (a == b) return true;
+    if (a->interned && b->interned) return false;
+    return strcmp(a->chars, b->chars) == 0;
+}
+
 Type* findStructType(const char* name) {
+    ObjString* key = findInternedString(name, (int)strlen(name));
     for (int i = 0; i < structTypeCount; i++) {
-        if (strcmp(structTypes[i]->info.structure.name->chars, name) == 0) {
+        if (typeNameIs(structTypes[i]->info.structure.name, key, name)) {
             return structTypes[i];
         }
     }
@@ -138,8 +159,9 @@ Type* findStructType(const char* name) {
 }
 
 Type* findEnumType(const char* name) {
+    ObjString* key = findInternedString(name, (int)strlen(name));
     for (int i = 0; i < enumTypeCount; i++) {
-        if (strcmp(enumTypes[i]->info.enumeration.name->chars, name) == 0) {
+        if (typeNameIs(enumTypes[i]->info.enumeration.name, key, name)) {
             return enumTypes[i];
         }
     }
@@ -204,16 +226,13 @@ bool typesEqual(Type* a, Type* b) {
         }
 
         case TYPE_STRUCT:
-            return strcmp(a->info.structure.name->chars,
-                          b->info.structure.name->chars) == 0;
+            return sameName(a->info.structure.name, b->info.structure.name);
 
         case TYPE_ENUM:
-            return strcmp(a->info.enumeration.name->chars,
-                          b->info.enumeration.name->chars) == 0;
+            return sameName(a->info.enumeration.name, b->info.enumeration.name);
 
         case TYPE_GENERIC:
-            return strcmp(a->info.generic.name->chars,
-                          b->info.generic.name->chars) == 0;
+            return sameName(a->info.generic.name, b->info.generic.name);
 
         default:
             return false;
@@ -336,7 +355,7 @@ Type* substituteGenerics(Type* type, ObjString** names, Type** subs, int count)
             int pc = type->info.function.paramCount;
             Type** params = NULL;
             if (pc > 0) {
-                params = (Type**)malloc(sizeof(Type*) * pc);
+                params = (Type**)allocateTypeData(sizeof(Type*) * pc);
                 for (int i = 0; i < pc; i++) {
                     params[i] = substituteGenerics(type->info.function.paramTypes[i],
                                                    names, subs, count);
@@ -355,7 +374,7 @@ Type* instantiateStructType(Type* base, Type** args, int argCount) {
     if (!base || base->kind != TYPE_STRUCT) return base;
     FieldInfo* fields = NULL;
     int fcount = base->info.structure.fieldCount;
-    if (fcount > 0) fields = (FieldInfo*)malloc(sizeof(FieldInfo) * fcount);
+    if (fcount > 0) fields = (FieldInfo*)allocateTypeData(sizeof(FieldInfo) * fcount);
     for (int i = 0; i < fcount; i++) {
         fields[i].name = base->info.structure.fields[i].name;
         fields[i].type = substituteGenerics(base->info.structure.fields[i].type,
@@ -364,3 +383,88 @@ Type* instantiateStructType(Type* base, Type** args, int argCount) {
     }
     return createStructType(base->info.structure.name, fields, fcount, NULL, 0);
 }
+
+// Copy an arena-allocated side array out of the arena
+static void* promoteTypeData(void* data, size_t size) {
+    if (!data || !inCompileArena(data)) return data;
+    void* copy = malloc(size);
+    memcpy(copy, data, size);
+    return copy;
+}
+
+/**
+ * Copy a type and everything it refers to out of the compile arena.
+ *
+ * The arena copy is left as a forwarding pointer (marked, next pointing at
+ * the promoted copy) so shared and recursive types stay shared.
+ *
+ * @param type Type to promote.
+ * @return The promoted type, or `type` itself when it is not in the arena.
+ */
+Type* promoteType(Type* type) {
+    if (!type || !inCompileArena(type)) return type;
+    if (type->obj.marked) return (Type*)type->obj.next;
+
+    Type* promoted = allocatePromotedType();
+    promoted->kind = type->kind;
+    promoted->info = type->info;
+    type->obj.marked = true;
+    type->obj.next = (Obj*)promoted;
+
+    switch (promoted->kind) {
+        case TYPE_ARRAY:
+            promoted->info.array.elementType =
+                promoteType(promoted->info.array.elementType);
+            break;
+        case TYPE_FUNCTION: {
+            int pc = promoted->info.function.paramCount;
+            promoted->info.function.returnType =
+                promoteType(promoted->info.function.returnType);
+            promoted->info.function.paramTypes = (Type**)promoteTypeData(
+                promoted->info.function.paramTypes, sizeof(Type*) * pc);
+            for (int i = 0; i < pc; i++) {
+                promoted->info.function.paramTypes[i] =
+                    promoteType(promoted->info.function.paramTypes[i]);
+            }
+            break;
+        }
+        case TYPE_STRUCT: {
+            int fc = promoted->info.structure.fieldCount;
+            promoted->info.structure.fields = (FieldInfo*)promoteTypeData(
+                promoted->info.structure.fields, sizeof(FieldInfo) * fc);
+            for (int i = 0; i < fc; i++) {
+                promoted->info.structure.fields[i].type =
+                    promoteType(promoted->info.structure.fields[i].type);
+            }
+            break;
+        }
+        case TYPE_ENUM: {
+            for (int i = 0; i < promoted->info.enumeration.variantCount; i++) {
+                VariantInfo* variant = &promoted->info.enumeration.variants[i];
+                for (int j = 0; j < variant->fieldCount; j++) {
+                    variant->fieldTypes[j] = promoteType(variant->fieldTypes[j]);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return promoted;
+}
+
+/**
+ * Promote the primitive, struct and enum types out of the compile arena.
+ * Called by endCompileArena before the arena is released.
+ */
+void promoteTypeRoots() {
+    for (int i = 0; i < TYPE_COUNT; i++) {
+        primitiveTypes[i] = promoteType(primitiveTypes[i]);
+    }
+    for (int i = 0; i < structTypeCount; i++) {
+        structTypes[i] = promoteType(structTypes[i]);
+    }
+    for (int i = 0; i < enumTypeCount; i++) {
+        enumTypes[i] = promoteType(enumTypes[i]);
+    }
+}
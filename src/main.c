@@ -7,17 +7,36 @@
 #include "../include/compiler.h"
 #include "../include/debug.h"
 #include "../include/parser.h"
+#include "../include/register_chunk.h"
+#include "../include/register_vm.h"
 #include "../include/file_utils.h"
 #include "../include/modules.h"
 #include "../include/builtin_stdlib.h"
 #include "../include/error.h"
+#include "../include/memory.h"
 #include "../include/string_utils.h"
 #include "../include/version.h"
+#include "../include/vm.h"
 #include <limits.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
-extern VM vm;
+
+// Program being compiled or run, and the VM running it
+static RegisterChunk programChunk;
+static RegisterVM programVM;
+
+// Level passed to register_chunk_optimize, selected with -O
+static uint32_t optimizationLevel = 0;
+
+// Worker processes for module back ends, selected with -j
+static int buildJobs = 1;
+
+// Allocation sites to print after running, 0 unless --alloc-profile
+static int allocationProfileTop = 0;
+
+// File the heap is dumped to after running, from --heap-snapshot
+static const char* heapSnapshotPath = NULL;
 
 static void deriveRuntimeHelp(const char* message,
                               char** helpOut,
@@ -46,12 +65,10 @@ static void deriveRuntimeHelp(const char* message,
             memcpy(modName, start + 1, len);
             modName[len] = '\0';
             int bestDist = 4;
-            for (int i = 0; i < vm.moduleCount; i++) {
-                if (vm.loadedModules[i]) {
-                    const char* cand = vm.loadedModules[i]->chars;
-                    int dist = levenshteinDistance(modName, cand);
-                    if (dist < bestDist) { bestDist = dist; suggestion = cand; }
-                }
+            for (int i = 0; i < get_module_count(); i++) {
+                const char* cand = get_module_at(i)->module_name;
+                int dist = levenshteinDistance(modName, cand);
+                if (dist < bestDist) { bestDist = dist; suggestion = cand; }
             }
         }
         if (suggestion) {
@@ -100,8 +117,6 @@ static void printError(ObjError* err) {
     if (help) free(help);
 }
 
-extern VM vm;
-
 static void repl() {
     char buffer[4096]; // Larger buffer for multiline input
     char line[1024];
@@ -129,7 +144,8 @@ static void repl() {
         // Copy line to buffer for processing
         strcpy(buffer, line);
 
-        // Process the input
+        // Process the input. No compile arena here: later lines refer
+        // back to the declarations made by earlier ones.
         ASTNode* ast;
         if (!parse(buffer, "<repl>", &ast)) {
             printf("Parsing failed.\n");
@@ -137,113 +153,227 @@ static void repl() {
             continue;
         }
 
-        // Check if this is a print statement or other statement that doesn't need result echoing
-        bool isPrintStmt = false;
-        if (ast && ast->type == AST_PRINT) {
-            isPrintStmt = true;
-        }
-
-        freeRegisterChunk(&vm.regChunk);
-        initRegisterChunk(&vm.regChunk);
+        register_chunk_free(&programChunk);
+        register_chunk_init(&programChunk, "<repl>");
         vm.filePath = "<repl>";
         vm.astRoot = ast;
-        if (!compileToRegister(ast, &vm.regChunk, "<repl>", buffer, false)) {
+        bool compiled = compileToRegister(ast, &programChunk, "<repl>", buffer, false);
+        if (!finish_module_builds() || !compiled) {
             printf("Compilation failed.\n");
             vm.astRoot = NULL;
-            freeRegisterChunk(&vm.regChunk);
+            register_chunk_free(&programChunk);
             fflush(stdout);
             continue;
         }
+        register_chunk_optimize(&programChunk, optimizationLevel);
         vm.astRoot = NULL;
 
-        initRegisterVM(&vm.regVM, &vm.regChunk);
-        InterpretResult result = INTERPRET_OK;
-        runRegisterVM(&vm.regVM);
-        if (IS_ERROR(vm.lastError)) {
-            result = INTERPRET_RUNTIME_ERROR;
+        if (!registervm_init(&programVM, &programChunk)) {
+            printf("Out of memory.\n");
+            register_chunk_free(&programChunk);
+            fflush(stdout);
+            continue;
         }
-        freeRegisterVM(&vm.regVM);
-        freeRegisterChunk(&vm.regChunk);
-        vm.filePath = NULL;
-        if (result == INTERPRET_COMPILE_ERROR) {
-            printf("Compile error.\n");
-        } else if (result == INTERPRET_RUNTIME_ERROR) {
-            if (IS_ERROR(vm.lastError)) {
-                printError(AS_ERROR(vm.lastError));
+        if (registervm_execute(&programVM) != EXEC_OK) {
+            Value error = registervm_get_last_error(&programVM);
+            if (IS_ERROR(error)) {
+                printError(AS_ERROR(error));
             } else {
                 printf("Runtime error.\n");
             }
-        } else if (!isPrintStmt && vm.stackTop > vm.stack &&
-                   !IS_NIL(*(vm.stackTop - 1))) {
-            // Print the result of the expression if there's a value on the stack
-            // that isn't nil and it's not a print statement (which already outputs its value)
-            printValue(*(vm.stackTop - 1));  // Print the top value on the stack
-            printf("\n");
         }
-
-        vm.stackTop = vm.stack;  // Reset stack after execution
+        registervm_free(&programVM);
+        register_chunk_free(&programChunk);
+        vm.filePath = NULL;
         fflush(stdout);
     }
 }
 
 
-static void runFile(const char* path) {
+// Parse and compile the program at `path`, imports included, into
+// programChunk. Exits on failure.
+static void compileFile(const char* path) {
     char* source = readFile(path);
     if (source == NULL) {
         // readFile already prints an error message when it fails
         exit(65);
     }
+    // The AST and compile-time types of the whole program, imports
+    // included, are released once it is compiled
+    beginCompileArena();
     ASTNode* ast;
     if (!parse(source, path, &ast)) {
         fprintf(stderr, "Parsing failed for \"%s\".\n", path);
+        endCompileArena();
         free(source);
         exit(65);
     }
-    InterpretResult result = INTERPRET_OK;
-    freeRegisterChunk(&vm.regChunk);
-    initRegisterChunk(&vm.regChunk);
+    register_chunk_free(&programChunk);
+    register_chunk_init(&programChunk, path);
     vm.filePath = path;
     vm.astRoot = ast;
-    if (!compileToRegister(ast, &vm.regChunk, path, source, true)) {
+    if (!compileToRegister(ast, &programChunk, path, source, true)) {
         fprintf(stderr, "Compilation failed for \"%s\".\n", path);
         vm.astRoot = NULL;
-        freeRegisterChunk(&vm.regChunk);
+        endCompileArena();
+        register_chunk_free(&programChunk);
         free(source);
         exit(65);
     }
+    // Imported modules still being compiled in child processes by -j
+    if (!finish_module_builds()) {
+        fprintf(stderr, "Compilation failed for \"%s\".\n", path);
+        vm.astRoot = NULL;
+        endCompileArena();
+        register_chunk_free(&programChunk);
+        free(source);
+        exit(65);
+    }
+    register_chunk_optimize(&programChunk, optimizationLevel);
     vm.astRoot = NULL;
-    initRegisterVM(&vm.regVM, &vm.regChunk);
+    endCompileArena();
+    free(source);
+}
+
+// Run programChunk, loaded from `path`, and release it
+static void runChunk(const char* path) {
+    if (!registervm_init(&programVM, &programChunk)) {
+        fprintf(stderr, "Out of memory running \"%s\".\n", path);
+        exit(70);
+    }
+    if (allocationProfileTop > 0 || heapSnapshotPath) {
+        registervm_enable_allocation_profiling(&programVM);
+    }
     if (vm.trace) {
-#ifdef DEBUG_TRACE_EXECUTION
-        disassembleRegisterChunk(&vm.regChunk, "register chunk");
-        printf("Function offsets:\n");
-        for (int i = 0; i < vm.regChunk.functionCount; i++) {
-            printf("%d -> %d\n", i, vm.regChunk.functionOffsets[i]);
+        disassembleRegisterChunk(&programChunk, path);
+        registervm_set_debug_options(&programVM, true, false);
+    }
+    ExecutionResult result = registervm_execute(&programVM);
+    // The snapshot fills in the live and retained columns of the profile
+    if (heapSnapshotPath) {
+        FILE* out = fopen(heapSnapshotPath, "w");
+        if (!out || !registervm_heap_snapshot(&programVM, out)) {
+            fprintf(stderr, "Could not write heap snapshot \"%s\".\n", heapSnapshotPath);
+        }
+        if (out) {
+            fclose(out);
         }
-#endif
     }
-    runRegisterVM(&vm.regVM);
-    if (IS_ERROR(vm.lastError)) {
-        result = INTERPRET_RUNTIME_ERROR;
+    if (allocationProfileTop > 0) {
+        registervm_print_allocation_profile(&programVM, allocationProfileTop);
     }
-    freeRegisterVM(&vm.regVM);
-    freeRegisterChunk(&vm.regChunk);
-    
-    free(source);
+    if (getenv("ORUS_OPCODE_PROFILE")) {
+        registervm_print_opcode_profile(&programVM, 20);
+    }
+    if (getenv("ORUS_GC_PAUSES")) {
+        registervm_print_gc_pauses(&programVM);
+    }
+    if (getenv("ORUS_SLAB_STATS")) {
+        printSlabStats();
+    }
+    Value error = registervm_get_last_error(&programVM);
+
     vm.filePath = NULL;
-    if (result == INTERPRET_RUNTIME_ERROR) {
+    if (result != EXEC_OK) {
         fprintf(stderr, "Runtime error in \"%s\".\n", path);
-        if (IS_ERROR(vm.lastError)) {
-            printError(AS_ERROR(vm.lastError));
+        if (IS_ERROR(error)) {
+            printError(AS_ERROR(error));
         }
         exit(70);
     }
+    registervm_free(&programVM);
+    register_chunk_free(&programChunk);
+}
+
+// Link programChunk with every module it imports into `linked`. Exits on
+// failure.
+static void linkProgram(const char* path, RegisterChunk* linked) {
+    // Modules come in load order, so their top levels run before the
+    // modules importing them; the program runs last
+    int count = get_module_count();
+    RegisterChunk** units = malloc(sizeof(RegisterChunk*) * (size_t)(count + 1));
+    if (!units || count + 1 > UINT16_MAX) {
+        fprintf(stderr, "Linking failed for \"%s\": too many modules.\n", path);
+        exit(65);
+    }
+    for (int i = 0; i < count; i++) {
+        Module* module = get_module_at(i);
+        if (!module->regBytecode) {
+            fprintf(stderr, "Linking failed for \"%s\": module \"%s\" has no register code.\n",
+                    path, module->module_name);
+            exit(65);
+        }
+        units[i] = module->regBytecode;
+    }
+    units[count] = &programChunk;
+
+    char message[256];
+    if (!register_chunk_link(units, (uint16_t)(count + 1), linked, message, sizeof(message))) {
+        fprintf(stderr, "Linking failed for \"%s\": %s\n", path, message);
+        exit(65);
+    }
+    free(units);
+}
+
+// The register VM has no module loader: a program that imports modules
+// runs linked with them
+static void runFile(const char* path) {
+    compileFile(path);
+    if (get_module_count() > 0) {
+        RegisterChunk linked;
+        linkProgram(path, &linked);
+        register_chunk_free(&programChunk);
+        programChunk = linked;
+    }
+    runChunk(path);
+}
+
+// Run an image written by `orusc link`
+static void runImage(const char* path) {
+    register_chunk_free(&programChunk);
+    if (!register_chunk_map_file(path, &programChunk)) {
+        fprintf(stderr, "Could not load image \"%s\".\n", path);
+        exit(65);
+    }
+    vm.filePath = path;
+    runChunk(path);
+}
+
+static bool has_suffix(const char* path, const char* suffix) {
+    size_t len = strlen(path);
+    size_t suffixLen = strlen(suffix);
+    return len > suffixLen && strcmp(path + len - suffixLen, suffix) == 0;
+}
+
+// Compile the program at `path` and link it with every module it imports
+// into a single image at `output`, by default `path` with .orbc for .orus
+static void linkFile(const char* path, const char* output) {
+    compileFile(path);
+
+    char defaultOutput[PATH_MAX];
+    if (!output) {
+        size_t len = strlen(path);
+        if (has_suffix(path, ".orus")) len -= 5;
+        snprintf(defaultOutput, sizeof(defaultOutput), "%.*s.orbc", (int)len, path);
+        output = defaultOutput;
+    }
+
+    RegisterChunk linked;
+    linkProgram(path, &linked);
+    if (!register_chunk_write_file(&linked, output)) {
+        fprintf(stderr, "Could not write image \"%s\".\n", output);
+        exit(74);
+    }
+    register_chunk_free(&linked);
+    register_chunk_free(&programChunk);
+    vm.filePath = NULL;
 }
 
 static bool file_has_main(const char* path) {
     char* source = readFile(path);
     if (!source) return false;
 
+    beginCompileArena();
     ASTNode* ast;
     bool ok = parse(source, path, &ast);
     bool found = false;
@@ -257,6 +387,7 @@ static bool file_has_main(const char* path) {
             }
         }
     }
+    endCompileArena();
 
     free(source);
     return found;
@@ -376,9 +507,13 @@ int main(int argc, const char* argv[]) {
     char defaultStdPath[PATH_MAX];
     const char* path = NULL;
     const char* projectDir = NULL;
+    const char* outputPath = NULL;
+    bool linkMode = false;
 
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--version") == 0 || strcmp(argv[i], "-v") == 0) {
+        if (i == 1 && strcmp(argv[i], "link") == 0) {
+            linkMode = true;
+        } else if (strcmp(argv[i], "--version") == 0 || strcmp(argv[i], "-v") == 0) {
             printf("Orus %s\n", ORUS_VERSION);
             return 0;
         } else if (strcmp(argv[i], "--trace") == 0) {
@@ -395,16 +530,51 @@ int main(int argc, const char* argv[]) {
             dumpStdlib = true;
         } else if (strcmp(argv[i], "--dev") == 0) {
             devFlag = true;
+        } else if (strcmp(argv[i], "--alloc-profile") == 0) {
+            allocationProfileTop = 20;
+        } else if (strcmp(argv[i], "--heap-snapshot") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Usage: --heap-snapshot <file>\n");
+                return 64;
+            }
+            heapSnapshotPath = argv[++i];
         } else if (strcmp(argv[i], "--project") == 0) {
             if (i + 1 >= argc) {
                 fprintf(stderr, "Usage: orusc --project <dir>\n");
                 return 64;
             }
             projectDir = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Usage: -o <image>\n");
+                return 64;
+            }
+            outputPath = argv[++i];
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            // -O alone means -O2
+            const char* level = argv[i] + 2;
+            if (level[0] == '\0') {
+                optimizationLevel = 2;
+            } else if (level[0] >= '0' && level[0] <= '3' && level[1] == '\0') {
+                optimizationLevel = (uint32_t)(level[0] - '0');
+            } else {
+                fprintf(stderr, "Usage: -O[0-3]\n");
+                return 64;
+            }
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            // -j alone means one job per core
+            const char* jobs = argv[i] + 2;
+            char* end;
+            long count = jobs[0] == '\0' ? sysconf(_SC_NPROCESSORS_ONLN) : strtol(jobs, &end, 10);
+            if (jobs[0] != '\0' && (*end != '\0' || count < 1 || count > UINT8_MAX)) {
+                fprintf(stderr, "Usage: -j[1-255]\n");
+                return 64;
+            }
+            buildJobs = count < 1 ? 1 : (count > UINT8_MAX ? UINT8_MAX : (int)count);
         } else if (!path) {
             path = argv[i];
         } else {
-            fprintf(stderr, "Usage: orusc [--trace] [--trace-imports] [--std-path dir] [--dump-stdlib] [--dev] [--project dir] [path]\n");
+            fprintf(stderr, "Usage: orusc [--trace] [--trace-imports] [--std-path dir] [--dump-stdlib] [--dev] [-O[0-3]] [-j[N]] [--alloc-profile] [--heap-snapshot file] [--project dir] [-o image] [path | link path]\n");
             return 64;
         }
     }
@@ -428,6 +598,8 @@ int main(int argc, const char* argv[]) {
     if (devFlag) vm.devMode = true;
     if (traceFlag) vm.trace = true;
     if (traceImportsFlag) traceImports = true;
+    moduleOptimizationLevel = optimizationLevel;
+    moduleBuildJobs = buildJobs;
 
     if (dumpStdlib) {
         dumpEmbeddedStdlib(vm.stdPath);
@@ -436,11 +608,19 @@ int main(int argc, const char* argv[]) {
         return 0;
     }
 
-    vm.useRegisterVM = true;
-    if (projectDir) {
+    if (linkMode) {
+        if (!path) {
+            fprintf(stderr, "Usage: orusc link <path> [-o image]\n");
+            freeVM();
+            return 64;
+        }
+        linkFile(path, outputPath);
+    } else if (projectDir) {
         runProject(projectDir);
     } else if (!path) {
         repl();
+    } else if (has_suffix(path, ".orbc")) {
+        runImage(path);
     } else {
         runFile(path);
     }
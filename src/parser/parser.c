@@ -38,7 +38,7 @@ static ASTNode* parseStructLiteral(Parser* parser, Token structName,
                                    Type** genericArgs, int genericArgCount);
 static Type* findStructTypeToken(Token token);
 static Type* findEnumTypeToken(Token token);
-static bool looksLikeGeneric();
+static bool looksLikeGeneric(Parser* parser);
 static ASTNode* parseBoolean(Parser* parser);
 static ASTNode* parseVariable(Parser* parser);
 static ASTNode* parseNil(Parser* parser);
@@ -79,7 +79,7 @@ static void errorAt(Parser* parser, Token* token, const char* message) {
     diagnostic.primarySpan.line = token->line;
 
     const char* lineStart = token->start;
-    while (lineStart > scanner.source && lineStart[-1] != '\n') lineStart--;
+    while (lineStart > parser->scanner->source && lineStart[-1] != '\n') lineStart--;
     diagnostic.primarySpan.column = (int)(token->start - lineStart) + 1;
     diagnostic.primarySpan.length = token->length > 0 ? token->length : 1;
     diagnostic.primarySpan.filePath =
@@ -124,7 +124,7 @@ static void error(Parser* parser, const char* message) {
 static void advance(Parser* parser) {
     parser->previous = parser->current;
     for (;;) {
-        Token token = scan_token();
+        Token token = scan_token(parser->scanner);
 
         if (token.type == TOKEN_LEFT_PAREN || token.type == TOKEN_LEFT_BRACKET) {
             parser->parenDepth++;
@@ -178,7 +178,7 @@ static bool match(Parser* parser, TokenType type) {
         parser->previous = parser->current;
 
         // Safely get the next token
-        Token next = scan_token();
+        Token next = scan_token(parser->scanner);
         parser->current = next;
         return true;
     }
@@ -197,10 +197,10 @@ static bool check(Parser* parser, TokenType type) {
 /**
  * Peek at the next token without consuming it.
  */
-static bool checkNext(TokenType type) {
-    Scanner backup = scanner;
-    Token next = scan_token();
-    scanner = backup;
+static bool checkNext(Parser* parser, TokenType type) {
+    Scanner backup = *parser->scanner;
+    Token next = scan_token(parser->scanner);
+    *parser->scanner = backup;
     return next.type == type;
 }
 
@@ -625,7 +625,7 @@ static ASTNode* parseDot(Parser* parser, ASTNode* left) {
     // Optional generic arguments after the property/method name
     Type** genericArgs = NULL;
     int genericCount = 0;
-    if (check(parser, TOKEN_LESS) && looksLikeGeneric()) {
+    if (check(parser, TOKEN_LESS) && looksLikeGeneric(parser)) {
         advance(parser); // consume '<'
         do {
             Type* argType = parseType(parser);
@@ -765,20 +765,20 @@ static ASTNode* parseDot(Parser* parser, ASTNode* left) {
  * Heuristically check if a `<` following an identifier begins a list of
  * generic type arguments rather than a comparison.
  */
-static bool looksLikeGeneric() {
-    Scanner backup = scanner;
+static bool looksLikeGeneric(Parser* parser) {
+    Scanner backup = *parser->scanner;
     int depth = 1;
     while (depth > 0) {
-        Token t = scan_token();
+        Token t = scan_token(parser->scanner);
         if (t.type == TOKEN_EOF || t.type == TOKEN_NEWLINE) {
-            scanner = backup;
+            *parser->scanner = backup;
             return false;
         }
         if (t.type == TOKEN_LESS) depth++;
         else if (t.type == TOKEN_GREATER) depth--;
     }
-    Token after = scan_token();
-    scanner = backup;
+    Token after = scan_token(parser->scanner);
+    *parser->scanner = backup;
     return after.type == TOKEN_LEFT_BRACE || after.type == TOKEN_LEFT_PAREN;
 }
 
@@ -790,7 +790,7 @@ static ASTNode* parseVariable(Parser* parser) {
     Type** genericArgs = NULL;
     int genericCount = 0;
 
-    if (check(parser, TOKEN_LESS) && looksLikeGeneric()) {
+    if (check(parser, TOKEN_LESS) && looksLikeGeneric(parser)) {
         advance(parser); // consume '<'
         do {
             Type* argType = parseType(parser);
@@ -1524,7 +1524,7 @@ static void useStatement(Parser* parser, ASTNode** ast) {
     parts = realloc(parts, sizeof(ObjString*) * (partCount + 1));
     parts[partCount++] = allocateString(nameTok.start, nameTok.length);
 
-    while (check(parser, TOKEN_DOUBLE_COLON) && checkNext(TOKEN_IDENTIFIER)) {
+    while (check(parser, TOKEN_DOUBLE_COLON) && checkNext(parser, TOKEN_IDENTIFIER)) {
         advance(parser); // consume '::'
         consume(parser, TOKEN_IDENTIFIER, "Expect identifier after '::'.");
         Token t = parser->previous;
@@ -2243,7 +2243,7 @@ void initParser(Parser* parser, Scanner* scanner, const char* filePath) {
 bool parse(const char* source, const char* filePath, ASTNode** ast) {
     // fprintf(stderr, ">>> ENTERED PARSE FUNCTION <<<\n");
     Scanner scanner;
-    init_scanner(source);
+    init_scanner(&scanner, source);
     Parser parser;
     initParser(&parser, &scanner, filePath);
     advance(&parser);
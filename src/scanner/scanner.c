@@ -14,8 +14,6 @@
  * tracking line information for diagnostics.
  */
 
-Scanner scanner;
-
 // Hash table size (should be a prime number for better distribution)
 #define HASH_TABLE_SIZE 67
 
@@ -76,17 +74,25 @@ void init_keyword_table() {
 }
 
 /**
- * Initialise the global scanner state for a new source buffer.
+ * Initialise a scanner for a new source buffer.
+ *
+ * Each scanner carries its own position, so several sources can be
+ * scanned at once.
  *
+ * @param scanner Scanner to initialise.
  * @param source Pointer to the null terminated string containing the program
  *               source code.
  */
-void init_scanner(const char* source) {
-    scanner.start = source;
-    scanner.current = source;
-    scanner.source = source; // store the beginning of the entire source
-    scanner.line = 1;
-    init_keyword_table();
+void init_scanner(Scanner* scanner, const char* source) {
+    scanner->start = source;
+    scanner->current = source;
+    scanner->source = source; // store the beginning of the entire source
+    scanner->line = 1;
+    static bool keywordsReady = false;
+    if (!keywordsReady) {
+        init_keyword_table();
+        keywordsReady = true;
+    }
 }
 
 /**
@@ -128,8 +134,8 @@ static bool is_hex_digit(char c) {
  *
  * @return true when the current position is at the terminating null byte.
  */
-static bool is_at_end() {
-    return *scanner.current == '\0';
+static bool is_at_end(Scanner* scanner) {
+    return *scanner->current == '\0';
 }
 
 /**
@@ -137,24 +143,24 @@ static bool is_at_end() {
  *
  * @return The consumed character.
  */
-static char advance() {
-    scanner.current++;
-    return scanner.current[-1];
+static char advance(Scanner* scanner) {
+    scanner->current++;
+    return scanner->current[-1];
 }
 
 /**
  * Peek at the current character without consuming it.
  */
-static char peek() {
-    return *scanner.current;
+static char peek(Scanner* scanner) {
+    return *scanner->current;
 }
 
 /**
  * Look ahead one character without advancing.
  */
-static char peek_next() {
-    if (is_at_end()) return '\0';
-    return scanner.current[1];
+static char peek_next(Scanner* scanner) {
+    if (is_at_end(scanner)) return '\0';
+    return scanner->current[1];
 }
 
 /**
@@ -163,10 +169,10 @@ static char peek_next() {
  * @param expected Character to match.
  * @return true if the character was consumed.
  */
-static bool match(char expected) {
-    if (is_at_end()) return false;
-    if (*scanner.current != expected) return false;
-    scanner.current++;
+static bool match(Scanner* scanner, char expected) {
+    if (is_at_end(scanner)) return false;
+    if (*scanner->current != expected) return false;
+    scanner->current++;
     return true;
 }
 
@@ -175,12 +181,12 @@ static bool match(char expected) {
  *
  * @param type Token type to assign.
  */
-static Token make_token(TokenType type) {
+static Token make_token(Scanner* scanner, TokenType type) {
     Token token;
     token.type = type;
-    token.start = scanner.start;
-    token.length = (int)(scanner.current - scanner.start);
-    token.line = scanner.line;
+    token.start = scanner->start;
+    token.length = (int)(scanner->current - scanner->start);
+    token.line = scanner->line;
     return token;
 }
 
@@ -189,54 +195,54 @@ static Token make_token(TokenType type) {
  *
  * @param message Static error message.
  */
-static Token error_token(const char* message) {
+static Token error_token(Scanner* scanner, const char* message) {
     Token token;
     token.type = TOKEN_ERROR;
     token.start = message;
     token.length = (int)(strlen(message));
-    token.line = scanner.line;
+    token.line = scanner->line;
     return token;
 }
 
 /**
  * Consume whitespace and comments, stopping at newlines.
  */
-static void skip_whitespace() {
+static void skip_whitespace(Scanner* scanner) {
     for (;;) {
-        char c = peek();
+        char c = peek(scanner);
         switch (c) {
             case ' ':
             case '\r':
             case '\t':
-                advance();
+                advance(scanner);
                 break;
             case '\n':
                 // Don't skip newlines, they're significant
                 return;
             case '/':
-                if (peek_next() == '/') {
+                if (peek_next(scanner) == '/') {
                     // Single-line comment
-                    while (peek() != '\n' && !is_at_end()) {
-                        advance();
+                    while (peek(scanner) != '\n' && !is_at_end(scanner)) {
+                        advance(scanner);
                     }
-                } else if (peek_next() == '*') {
+                } else if (peek_next(scanner) == '*') {
                     // Block comment
-                    advance();
-                    advance();
-                    while (!is_at_end()) {
-                        if (peek() == '*' && peek_next() == '/') {
-                            advance();
-                            advance();
+                    advance(scanner);
+                    advance(scanner);
+                    while (!is_at_end(scanner)) {
+                        if (peek(scanner) == '*' && peek_next(scanner) == '/') {
+                            advance(scanner);
+                            advance(scanner);
                             break;
                         }
-                        if (peek() == '\n') {
+                        if (peek(scanner) == '\n') {
                             // Return newline token even in comments
                             return;
                         }
-                        advance();
+                        advance(scanner);
                     }
-                    if (is_at_end()) {
-                        error_token("Unterminated block comment.");
+                    if (is_at_end(scanner)) {
+                        error_token(scanner, "Unterminated block comment.");
                     }
                 } else {
                     return;
@@ -278,15 +284,15 @@ static TokenType get_keyword_type(const char* start, int length) {
  *
  * @return The constructed token with appropriate type.
  */
-static Token identifier() {
-    while (is_alpha(peek()) || is_digit(peek())) {
-        advance();
+static Token identifier(Scanner* scanner) {
+    while (is_alpha(peek(scanner)) || is_digit(peek(scanner))) {
+        advance(scanner);
     }
 
-    int length = (int)(scanner.current - scanner.start);
-    TokenType type = get_keyword_type(scanner.start, length);
+    int length = (int)(scanner->current - scanner->start);
+    TokenType type = get_keyword_type(scanner->start, length);
 
-    return make_token(type);
+    return make_token(scanner, type);
 }
 
 // Scan a number literal
@@ -296,141 +302,141 @@ static Token identifier() {
  * Handles hexadecimal prefixes, underscores and optional unsigned suffixes.
  * @return Token for the numeric literal.
  */
-static Token number() {
+static Token number(Scanner* scanner) {
     // Check for hexadecimal prefix 0x or 0X
-    if (scanner.start[0] == '0' && (peek() == 'x' || peek() == 'X')) {
-        advance(); // consume 'x' or 'X'
-        if (!is_hex_digit(peek())) {
-            return error_token("Invalid hexadecimal literal.");
+    if (scanner->start[0] == '0' && (peek(scanner) == 'x' || peek(scanner) == 'X')) {
+        advance(scanner); // consume 'x' or 'X'
+        if (!is_hex_digit(peek(scanner))) {
+            return error_token(scanner, "Invalid hexadecimal literal.");
         }
-        while (is_hex_digit(peek()) || peek() == '_') {
-            if (peek() == '_') {
-                advance();
-                if (!is_hex_digit(peek())) {
-                    return error_token(
+        while (is_hex_digit(peek(scanner)) || peek(scanner) == '_') {
+            if (peek(scanner) == '_') {
+                advance(scanner);
+                if (!is_hex_digit(peek(scanner))) {
+                    return error_token(scanner, 
                         "Invalid underscore placement in number.");
                 }
             } else {
-                advance();
+                advance(scanner);
             }
         }
         // Handle type suffixes for hexadecimal numbers too
-        if (peek() == 'u' || peek() == 'U') {
-            advance();
+        if (peek(scanner) == 'u' || peek(scanner) == 'U') {
+            advance(scanner);
             // Check for specific unsigned suffixes (u32, u64)
-            if (peek() == '3' && peek_next() == '2') {
-                advance(); // '3'
-                advance(); // '2'
-            } else if (peek() == '6' && peek_next() == '4') {
-                advance(); // '6'
-                advance(); // '4'
+            if (peek(scanner) == '3' && peek_next(scanner) == '2') {
+                advance(scanner); // '3'
+                advance(scanner); // '2'
+            } else if (peek(scanner) == '6' && peek_next(scanner) == '4') {
+                advance(scanner); // '6'
+                advance(scanner); // '4'
             }
-        } else if (peek() == 'i') {
-            advance(); // 'i'
+        } else if (peek(scanner) == 'i') {
+            advance(scanner); // 'i'
             // Check for specific signed suffixes (i32, i64)
-            if (peek() == '3' && peek_next() == '2') {
-                advance(); // '3'
-                advance(); // '2'
-            } else if (peek() == '6' && peek_next() == '4') {
-                advance(); // '6'
-                advance(); // '4'
+            if (peek(scanner) == '3' && peek_next(scanner) == '2') {
+                advance(scanner); // '3'
+                advance(scanner); // '2'
+            } else if (peek(scanner) == '6' && peek_next(scanner) == '4') {
+                advance(scanner); // '6'
+                advance(scanner); // '4'
             } else {
                 // Just 'i' is not a valid suffix, back up
-                scanner.current--;
+                scanner->current--;
             }
         }
-        return make_token(TOKEN_NUMBER);
+        return make_token(scanner, TOKEN_NUMBER);
     }
 
     // Process the integer part for decimal numbers
-    while (is_digit(peek()) || peek() == '_') {
-        if (peek() == '_') {
-            advance();
-            if (!is_digit(peek())) {
-                return error_token("Invalid underscore placement in number.");
+    while (is_digit(peek(scanner)) || peek(scanner) == '_') {
+        if (peek(scanner) == '_') {
+            advance(scanner);
+            if (!is_digit(peek(scanner))) {
+                return error_token(scanner, "Invalid underscore placement in number.");
             }
         } else {
-            advance();
+            advance(scanner);
         }
     }
 
     // Process the fractional part
-    if (peek() == '.' && is_digit(peek_next())) {
-        advance();  // Consume the dot
-        while (is_digit(peek()) || peek() == '_') {
-            if (peek() == '_') {
-                advance();
-                if (!is_digit(peek())) {
-                    return error_token(
+    if (peek(scanner) == '.' && is_digit(peek_next(scanner))) {
+        advance(scanner);  // Consume the dot
+        while (is_digit(peek(scanner)) || peek(scanner) == '_') {
+            if (peek(scanner) == '_') {
+                advance(scanner);
+                if (!is_digit(peek(scanner))) {
+                    return error_token(scanner, 
                         "Invalid underscore placement in number.");
                 }
             } else {
-                advance();
+                advance(scanner);
             }
         }
     }
 
     // Process the exponent part
-    if (peek() == 'e' || peek() == 'E') {
-        advance();  // Consume 'e' or 'E'
+    if (peek(scanner) == 'e' || peek(scanner) == 'E') {
+        advance(scanner);  // Consume 'e' or 'E'
 
-        if (peek() == '-' || peek() == '+') {
-            advance();  // Consume the sign
+        if (peek(scanner) == '-' || peek(scanner) == '+') {
+            advance(scanner);  // Consume the sign
         }
 
-        if (!is_digit(peek())) {
-            return error_token(
+        if (!is_digit(peek(scanner))) {
+            return error_token(scanner, 
                 "Invalid scientific notation: Expected digit after 'e' or "
                 "'E'.");
         }
 
-        while (is_digit(peek()) || peek() == '_') {
-            if (peek() == '_') {
-                advance();
-                if (!is_digit(peek())) {
-                    return error_token(
+        while (is_digit(peek(scanner)) || peek(scanner) == '_') {
+            if (peek(scanner) == '_') {
+                advance(scanner);
+                if (!is_digit(peek(scanner))) {
+                    return error_token(scanner, 
                         "Invalid underscore placement in number.");
                 }
             } else {
-                advance();
+                advance(scanner);
             }
         }
     }
 
     // Optional type suffix (u, i32, i64, u32, u64, f64)
-    if (peek() == 'u' || peek() == 'U') {
-        advance();
+    if (peek(scanner) == 'u' || peek(scanner) == 'U') {
+        advance(scanner);
         // Check for specific unsigned suffixes (u32, u64)
-        if (peek() == '3' && peek_next() == '2') {
-            advance(); // '3'
-            advance(); // '2'
-        } else if (peek() == '6' && peek_next() == '4') {
-            advance(); // '6'
-            advance(); // '4'
+        if (peek(scanner) == '3' && peek_next(scanner) == '2') {
+            advance(scanner); // '3'
+            advance(scanner); // '2'
+        } else if (peek(scanner) == '6' && peek_next(scanner) == '4') {
+            advance(scanner); // '6'
+            advance(scanner); // '4'
         }
-    } else if (peek() == 'i') {
-        advance(); // 'i'
+    } else if (peek(scanner) == 'i') {
+        advance(scanner); // 'i'
         // Check for specific signed suffixes (i32, i64)
-        if (peek() == '3' && peek_next() == '2') {
-            advance(); // '3'
-            advance(); // '2'
-        } else if (peek() == '6' && peek_next() == '4') {
-            advance(); // '6'
-            advance(); // '4'
+        if (peek(scanner) == '3' && peek_next(scanner) == '2') {
+            advance(scanner); // '3'
+            advance(scanner); // '2'
+        } else if (peek(scanner) == '6' && peek_next(scanner) == '4') {
+            advance(scanner); // '6'
+            advance(scanner); // '4'
         } else {
             // Just 'i' is not a valid suffix, back up
-            scanner.current--;
+            scanner->current--;
         }
-    } else if (peek() == 'f' && peek_next() == '6') {
+    } else if (peek(scanner) == 'f' && peek_next(scanner) == '6') {
         // Check if we have enough characters left and the third character is '4'
-        if (!is_at_end() && scanner.current[1] != '\0' && scanner.current[2] == '4') {
-            advance(); // 'f'
-            advance(); // '6'
-            advance(); // '4'
+        if (!is_at_end(scanner) && scanner->current[1] != '\0' && scanner->current[2] == '4') {
+            advance(scanner); // 'f'
+            advance(scanner); // '6'
+            advance(scanner); // '4'
         }
     }
 
-    return make_token(TOKEN_NUMBER);
+    return make_token(scanner, TOKEN_NUMBER);
 }
 
 // Scan a string literal
@@ -439,29 +445,29 @@ static Token number() {
  *
  * @return Token for the parsed string.
  */
-static Token string() {
-    while (peek() != '"' && !is_at_end()) {
-        if (peek() == '\n') scanner.line++;
-        if (peek() == '\\') {
-            advance();
-            switch (peek()) {
+static Token string(Scanner* scanner) {
+    while (peek(scanner) != '"' && !is_at_end(scanner)) {
+        if (peek(scanner) == '\n') scanner->line++;
+        if (peek(scanner) == '\\') {
+            advance(scanner);
+            switch (peek(scanner)) {
                 case 'n':
                 case 't':
                 case '\\':
                 case '"':
-                    advance();
+                    advance(scanner);
                     break;
                 default:
-                    return error_token("Invalid escape sequence.");
+                    return error_token(scanner, "Invalid escape sequence.");
             }
         } else {
-            advance();
+            advance(scanner);
         }
     }
 
-    if (is_at_end()) return error_token("Unterminated string.");
-    advance();  // Consume the closing quote
-    return make_token(TOKEN_STRING);
+    if (is_at_end(scanner)) return error_token(scanner, "Unterminated string.");
+    advance(scanner);  // Consume the closing quote
+    return make_token(scanner, TOKEN_STRING);
 }
 
 /**
@@ -469,92 +475,92 @@ static Token string() {
  *
  * @return The next token describing the lexeme.
  */
-Token scan_token() {
-    skip_whitespace();
-    scanner.start = scanner.current;
+Token scan_token(Scanner* scanner) {
+    skip_whitespace(scanner);
+    scanner->start = scanner->current;
 
-    if (is_at_end()) {
-        return make_token(TOKEN_EOF);
+    if (is_at_end(scanner)) {
+        return make_token(scanner, TOKEN_EOF);
     }
 
-    char c = advance();
+    char c = advance(scanner);
 
     // Handle newline as a token
     if (c == '\n') {
-        scanner.line++;
-        return make_token(TOKEN_NEWLINE);
+        scanner->line++;
+        return make_token(scanner, TOKEN_NEWLINE);
     }
 
     if (is_alpha(c)) {
-        Token token = identifier();
+        Token token = identifier(scanner);
         return token;
     }
-    if (is_digit(c)) return number();
+    if (is_digit(c)) return number(scanner);
 
     switch (c) {
-        case '(': return make_token(TOKEN_LEFT_PAREN);
-        case ')': return make_token(TOKEN_RIGHT_PAREN);
-        case '{': return make_token(TOKEN_LEFT_BRACE);
-        case '}': return make_token(TOKEN_RIGHT_BRACE);
-        case '[': return make_token(TOKEN_LEFT_BRACKET);
-        case ']': return make_token(TOKEN_RIGHT_BRACKET);
-        case ';': return make_token(TOKEN_SEMICOLON);
-        case ',': return make_token(TOKEN_COMMA);
+        case '(': return make_token(scanner, TOKEN_LEFT_PAREN);
+        case ')': return make_token(scanner, TOKEN_RIGHT_PAREN);
+        case '{': return make_token(scanner, TOKEN_LEFT_BRACE);
+        case '}': return make_token(scanner, TOKEN_RIGHT_BRACE);
+        case '[': return make_token(scanner, TOKEN_LEFT_BRACKET);
+        case ']': return make_token(scanner, TOKEN_RIGHT_BRACKET);
+        case ';': return make_token(scanner, TOKEN_SEMICOLON);
+        case ',': return make_token(scanner, TOKEN_COMMA);
         case '.':
-            if (peek() == '.') {
-                advance();
-                return make_token(TOKEN_DOT_DOT);
+            if (peek(scanner) == '.') {
+                advance(scanner);
+                return make_token(scanner, TOKEN_DOT_DOT);
             }
-            return make_token(TOKEN_DOT);
+            return make_token(scanner, TOKEN_DOT);
         case '?':
-            return make_token(TOKEN_QUESTION);
+            return make_token(scanner, TOKEN_QUESTION);
         case '-':
-            if (peek() == '>') {
-                advance();
-                return make_token(TOKEN_ARROW);
+            if (peek(scanner) == '>') {
+                advance(scanner);
+                return make_token(scanner, TOKEN_ARROW);
             }
-            if (match('=')) return make_token(TOKEN_MINUS_EQUAL);
-            return make_token(TOKEN_MINUS);
+            if (match(scanner, '=')) return make_token(scanner, TOKEN_MINUS_EQUAL);
+            return make_token(scanner, TOKEN_MINUS);
         case '+':
-            if (match('=')) return make_token(TOKEN_PLUS_EQUAL);
-            return make_token(TOKEN_PLUS);
+            if (match(scanner, '=')) return make_token(scanner, TOKEN_PLUS_EQUAL);
+            return make_token(scanner, TOKEN_PLUS);
         case '/':
-            if (match('=')) return make_token(TOKEN_SLASH_EQUAL);
-            return make_token(TOKEN_SLASH);
+            if (match(scanner, '=')) return make_token(scanner, TOKEN_SLASH_EQUAL);
+            return make_token(scanner, TOKEN_SLASH);
         case '%':
-            if (match('=')) return make_token(TOKEN_MODULO_EQUAL);
-            return make_token(TOKEN_MODULO);
+            if (match(scanner, '=')) return make_token(scanner, TOKEN_MODULO_EQUAL);
+            return make_token(scanner, TOKEN_MODULO);
         case '*':
-            if (match('=')) return make_token(TOKEN_STAR_EQUAL);
-            return make_token(TOKEN_STAR);
+            if (match(scanner, '=')) return make_token(scanner, TOKEN_STAR_EQUAL);
+            return make_token(scanner, TOKEN_STAR);
         case '!':
-            if (match('=')) {
-                return make_token(TOKEN_BANG_EQUAL);
+            if (match(scanner, '=')) {
+                return make_token(scanner, TOKEN_BANG_EQUAL);
             }
-            return make_token(TOKEN_BIT_NOT);
+            return make_token(scanner, TOKEN_BIT_NOT);
         case '=':
-            return make_token(
-                match('=') ? TOKEN_EQUAL_EQUAL : TOKEN_EQUAL);
+            return make_token(scanner, 
+                match(scanner, '=') ? TOKEN_EQUAL_EQUAL : TOKEN_EQUAL);
         case '<':
-            if (match('<')) return make_token(TOKEN_SHIFT_LEFT);
-            return make_token(match('=') ? TOKEN_LESS_EQUAL : TOKEN_LESS);
+            if (match(scanner, '<')) return make_token(scanner, TOKEN_SHIFT_LEFT);
+            return make_token(scanner, match(scanner, '=') ? TOKEN_LESS_EQUAL : TOKEN_LESS);
         case '>':
-            if (peek() == '>' && peek_next() != '{' && peek_next() != '>') {
-                advance();
-                return make_token(TOKEN_SHIFT_RIGHT);
+            if (peek(scanner) == '>' && peek_next(scanner) != '{' && peek_next(scanner) != '>') {
+                advance(scanner);
+                return make_token(scanner, TOKEN_SHIFT_RIGHT);
             }
-            return make_token(match('=') ? TOKEN_GREATER_EQUAL : TOKEN_GREATER);
+            return make_token(scanner, match(scanner, '=') ? TOKEN_GREATER_EQUAL : TOKEN_GREATER);
         case '&':
-            return make_token(TOKEN_BIT_AND);
+            return make_token(scanner, TOKEN_BIT_AND);
         case '|':
-            return make_token(TOKEN_BIT_OR);
+            return make_token(scanner, TOKEN_BIT_OR);
         case '^':
-            return make_token(TOKEN_BIT_XOR);
-        case '"': return string();
+            return make_token(scanner, TOKEN_BIT_XOR);
+        case '"': return string(scanner);
         case ':':
-            if (match(':')) return make_token(TOKEN_DOUBLE_COLON);
-            return make_token(TOKEN_COLON);
+            if (match(scanner, ':')) return make_token(scanner, TOKEN_DOUBLE_COLON);
+            return make_token(scanner, TOKEN_COLON);
     }
 
-    return error_token("Unexpected character.");
+    return error_token(scanner, "Unexpected character.");
 }
@@ -15,8 +15,7 @@
 #include "../../include/register_opcodes.h"
 #include "../../include/type.h"
 #include "../../include/modules.h"
-
-extern RegisterVM vm;
+#include "../../include/vm.h"
 
 
 /**
@@ -83,7 +82,10 @@ static Value native_push(int argCount, Value* args) {
         return NIL_VAL;
     }
     ObjArray* arr = AS_ARRAY(args[0]);
-    arrayPush(&vm, arr, args[1]);
+    if (!arrayPush(arr, args[1])) {
+        vmRuntimeError("Out of memory growing array.");
+        return NIL_VAL;
+    }
     return args[0];
 }
 
@@ -131,12 +133,8 @@ static Value native_reserve(int argCount, Value* args) {
                                 (int)AS_U64(args[1]);
     if (cap <= 0) return args[0];
     ObjArray* arr = AS_ARRAY(args[0]);
-    if (cap > arr->capacity) {
-        int oldCap = arr->capacity;
-        arr->capacity = cap;
-        arr->elements = GROW_ARRAY(Value, arr->elements, oldCap, arr->capacity);
-        vm.bytesAllocated += sizeof(Value) * (arr->capacity - oldCap);
-    }
+    // Only a hint: a nursery array that cannot grow in place keeps its size
+    reserveArray(arr, cap);
     return args[0];
 }
 
@@ -179,7 +177,7 @@ static Value native_range(int argCount, Value* args) {
  * @return    Name of the value's type.
  */
 static const char* getValueTypeName(Value val) {
-    switch (val.type) {
+    switch (VALUE_TYPE(val)) {
         case VAL_I32:   return "i32";
         case VAL_I64:   return "i64";
         case VAL_U32:   return "u32";
@@ -358,10 +356,41 @@ static Value native_sum(int argCount, Value* args) {
         return NIL_VAL;
     }
     ObjArray* arr = AS_ARRAY(args[0]);
+
+    // Packed integers are summed exactly in loops the compiler vectorizes
+    switch ((ArrayKind)arr->kind) {
+        case ARRAY_I32: {
+            const int32_t* data = ARRAY_DATA(arr, int32_t);
+            int64_t total = 0;
+            for (int i = 0; i < arr->length; i++) total += data[i];
+            return I32_VAL((int32_t)total);
+        }
+        case ARRAY_I64: {
+            const int64_t* data = ARRAY_DATA(arr, int64_t);
+            uint64_t total = 0;
+            for (int i = 0; i < arr->length; i++) total += (uint64_t)data[i];
+            return I32_VAL((int32_t)total);
+        }
+        case ARRAY_U32: {
+            const uint32_t* data = ARRAY_DATA(arr, uint32_t);
+            uint64_t total = 0;
+            for (int i = 0; i < arr->length; i++) total += data[i];
+            return I32_VAL((int32_t)total);
+        }
+        case ARRAY_F64: {
+            const double* data = ARRAY_DATA(arr, double);
+            double total = 0;
+            for (int i = 0; i < arr->length; i++) total += data[i];
+            return F64_VAL(total);
+        }
+        default:
+            break;
+    }
+
     double total = 0;
     bool asFloat = false;
     for (int i = 0; i < arr->length; i++) {
-        Value v = arr->elements[i];
+        Value v = arrayGet(arr, i);
         if (IS_I32(v)) {
             total += AS_I32(v);
         } else if (IS_I64(v)) {
@@ -382,6 +411,18 @@ static Value native_sum(int argCount, Value* args) {
         return I32_VAL((int32_t)total);
 }
 
+// Smallest or largest element of a packed array of `type`, found in a loop
+// the compiler vectorizes. `better` is < for the minimum, > for the maximum.
+#define PACKED_EXTREME(array, type, better, result)              \
+    do {                                                         \
+        const type* data = ARRAY_DATA(array, type);              \
+        type best = data[0];                                     \
+        for (int i = 1; i < (array)->length; i++) {              \
+            best = data[i] better best ? data[i] : best;         \
+        }                                                        \
+        (result) = (double)best;                                 \
+    } while (0)
+
 /**
  * Returns the smallest numeric element of an array.
  *
@@ -400,7 +441,16 @@ static Value native_min(int argCount, Value* args) {
     ObjArray* arr = AS_ARRAY(args[0]);
     if (arr->length == 0) return NIL_VAL;
 
-    Value first = arr->elements[0];
+    double extreme;
+    switch ((ArrayKind)arr->kind) {
+        case ARRAY_I32: PACKED_EXTREME(arr, int32_t, <, extreme); return I32_VAL((int32_t)extreme);
+        case ARRAY_I64: PACKED_EXTREME(arr, int64_t, <, extreme); return I32_VAL((int32_t)extreme);
+        case ARRAY_U32: PACKED_EXTREME(arr, uint32_t, <, extreme); return I32_VAL((int32_t)extreme);
+        case ARRAY_F64: PACKED_EXTREME(arr, double, <, extreme); return F64_VAL(extreme);
+        default: break;
+    }
+
+    Value first = arrayGet(arr, 0);
     double best;
     bool asFloat = false;
     if (IS_I32(first)) {
@@ -418,7 +468,7 @@ static Value native_min(int argCount, Value* args) {
     }
 
     for (int i = 1; i < arr->length; i++) {
-        Value v = arr->elements[i];
+        Value v = arrayGet(arr, i);
         double val;
         if (IS_I32(v)) {
             val = AS_I32(v);
@@ -460,7 +510,16 @@ static Value native_max(int argCount, Value* args) {
     ObjArray* arr = AS_ARRAY(args[0]);
     if (arr->length == 0) return NIL_VAL;
 
-    Value first = arr->elements[0];
+    double extreme;
+    switch ((ArrayKind)arr->kind) {
+        case ARRAY_I32: PACKED_EXTREME(arr, int32_t, >, extreme); return I32_VAL((int32_t)extreme);
+        case ARRAY_I64: PACKED_EXTREME(arr, int64_t, >, extreme); return I32_VAL((int32_t)extreme);
+        case ARRAY_U32: PACKED_EXTREME(arr, uint32_t, >, extreme); return I32_VAL((int32_t)extreme);
+        case ARRAY_F64: PACKED_EXTREME(arr, double, >, extreme); return F64_VAL(extreme);
+        default: break;
+    }
+
+    Value first = arrayGet(arr, 0);
     double best;
     bool asFloat = false;
     if (IS_I32(first)) {
@@ -478,7 +537,7 @@ static Value native_max(int argCount, Value* args) {
     }
 
     for (int i = 1; i < arr->length; i++) {
-        Value v = arr->elements[i];
+        Value v = arrayGet(arr, i);
         double val;
         if (IS_I32(v)) {
             val = AS_I32(v);
@@ -630,6 +689,21 @@ static void timSort(Value* arr, int n, bool reverse) {
     free(temp);
 }
 
+// qsort comparators for packed elements, ordered like compareValues
+#define DEFINE_PACKED_COMPARE(name, type)                              \
+    static int compare##name##Ascending(const void* a, const void* b) {  \
+        type x = *(const type*)a;                                      \
+        type y = *(const type*)b;                                      \
+        return (x > y) - (x < y);                                      \
+    }                                                                  \
+    static int compare##name##Descending(const void* a, const void* b) { \
+        return compare##name##Ascending(b, a);                         \
+    }
+
+DEFINE_PACKED_COMPARE(I32, int32_t)
+DEFINE_PACKED_COMPARE(U32, uint32_t)
+DEFINE_PACKED_COMPARE(F64, double)
+
 /**
  * Returns a sorted copy of an array. A boolean argument may reverse the order.
  *
@@ -667,11 +741,29 @@ static Value native_sorted(int argCount, Value* args) {
         reverse = AS_BOOL(args[2]);
     }
 
+    // Packed numbers are copied and sorted as raw elements
+    int (*compare)(const void*, const void*) = NULL;
+    ArrayKind kind = (ArrayKind)AS_ARRAY(args[0])->kind;
+    switch (kind) {
+        case ARRAY_I32: compare = reverse ? compareI32Descending : compareI32Ascending; break;
+        case ARRAY_U32: compare = reverse ? compareU32Descending : compareU32Ascending; break;
+        case ARRAY_F64: compare = reverse ? compareF64Descending : compareF64Ascending; break;
+        default: break;
+    }
+    if (compare) {
+        int length = AS_ARRAY(args[0])->length;
+        ObjArray* out = allocateArrayOfKind(kind, length);
+        // Allocating may have moved the input
+        memcpy(out->elements, AS_ARRAY(args[0])->elements, arrayElementSize(kind) * (size_t)length);
+        qsort(out->elements, (size_t)length, arrayElementSize(kind), compare);
+        return ARRAY_VAL(out);
+    }
+
+    ObjArray* out = allocateArray(AS_ARRAY(args[0])->length);
     ObjArray* in = AS_ARRAY(args[0]);
-    ObjArray* out = allocateArray(in->length);
     out->length = in->length;
     for (int i = 0; i < in->length; i++) {
-        out->elements[i] = in->elements[i];
+        out->elements[i] = arrayGet(in, i);
     }
 
     timSort(out->elements, out->length, reverse);
@@ -12,25 +12,26 @@
 #define ORBC_VERSION 1
 
 static bool writeValue(FILE* f, Value v) {
-    fwrite(&v.type, 1, 1, f);
-    switch (v.type) {
-        case VAL_I32:  fwrite(&v.as.i32, sizeof(int32_t), 1, f); break;
-        case VAL_I64:  fwrite(&v.as.i64, sizeof(int64_t), 1, f); break;
-        case VAL_U32:  fwrite(&v.as.u32, sizeof(uint32_t),1,f); break;
-        case VAL_U64:  fwrite(&v.as.u64, sizeof(uint64_t),1,f); break;
-        case VAL_F64:  fwrite(&v.as.f64, sizeof(double),1,f); break;
-        case VAL_BOOL: fwrite(&v.as.boolean, sizeof(bool),1,f); break;
+    uint8_t type = (uint8_t)VALUE_TYPE(v);
+    fwrite(&type, 1, 1, f);
+    switch (type) {
+        case VAL_I32: { int32_t x = AS_I32(v); fwrite(&x, sizeof(int32_t), 1, f); break; }
+        case VAL_I64: { int64_t x = AS_I64(v); fwrite(&x, sizeof(int64_t), 1, f); break; }
+        case VAL_U32: { uint32_t x = AS_U32(v); fwrite(&x, sizeof(uint32_t),1,f); break; }
+        case VAL_U64: { uint64_t x = AS_U64(v); fwrite(&x, sizeof(uint64_t),1,f); break; }
+        case VAL_F64: { double x = AS_F64(v); fwrite(&x, sizeof(double),1,f); break; }
+        case VAL_BOOL: { bool x = AS_BOOL(v); fwrite(&x, sizeof(bool),1,f); break; }
         case VAL_STRING: {
-            int len = v.as.string->length;
+            int len = AS_STRING(v)->length;
             fwrite(&len, sizeof(int),1,f);
-            fwrite(v.as.string->chars, 1, len, f);
+            fwrite(AS_STRING(v)->chars, 1, len, f);
             break;
         }
         case VAL_ARRAY: {
-            int len = v.as.array->length;
+            int len = AS_ARRAY(v)->length;
             fwrite(&len, sizeof(int),1,f);
             for (int i=0;i<len;i++) {
-                if (!writeValue(f, v.as.array->elements[i])) return false;
+                if (!writeValue(f, arrayGet(AS_ARRAY(v), i))) return false;
             }
             break;
         }
@@ -43,20 +44,19 @@ static bool writeValue(FILE* f, Value v) {
 static bool readValue(FILE* f, Value* out) {
     uint8_t type;
     if (fread(&type,1,1,f)!=1) return false;
-    out->type = (ValueType)type;
     switch (type) {
-        case VAL_I32: fread(&out->as.i32,sizeof(int32_t),1,f); break;
-        case VAL_I64: fread(&out->as.i64,sizeof(int64_t),1,f); break;
-        case VAL_U32: fread(&out->as.u32,sizeof(uint32_t),1,f); break;
-        case VAL_U64: fread(&out->as.u64,sizeof(uint64_t),1,f); break;
-        case VAL_F64: fread(&out->as.f64,sizeof(double),1,f); break;
-        case VAL_BOOL: fread(&out->as.boolean,sizeof(bool),1,f); break;
+        case VAL_I32: { int32_t x; if (fread(&x,sizeof(int32_t),1,f)!=1) return false; *out = I32_VAL(x); break; }
+        case VAL_I64: { int64_t x; if (fread(&x,sizeof(int64_t),1,f)!=1) return false; *out = I64_VAL(x); break; }
+        case VAL_U32: { uint32_t x; if (fread(&x,sizeof(uint32_t),1,f)!=1) return false; *out = U32_VAL(x); break; }
+        case VAL_U64: { uint64_t x; if (fread(&x,sizeof(uint64_t),1,f)!=1) return false; *out = U64_VAL(x); break; }
+        case VAL_F64: { double x; if (fread(&x,sizeof(double),1,f)!=1) return false; *out = F64_VAL(x); break; }
+        case VAL_BOOL: { bool x; if (fread(&x,sizeof(bool),1,f)!=1) return false; *out = BOOL_VAL(x); break; }
         case VAL_STRING: {
             int len; if (fread(&len,sizeof(int),1,f)!=1) return false;
             char* buf = malloc(len+1); if (!buf) return false;
             if (fread(buf,1,len,f)!= (size_t)len) { free(buf); return false; }
             buf[len]=0;
-            out->as.string = allocateString(buf,len);
+            *out = STRING_VAL(allocateString(buf,len));
             free(buf);
             break;
         }
@@ -66,12 +66,11 @@ static bool readValue(FILE* f, Value* out) {
             arr->length = len;
             for (int i=0;i<len;i++) {
                 if (!readValue(f, &arr->elements[i])) {
-                    free(arr->elements);
-                    free(arr);
+                    // The array is on the heap list; the collector frees it
                     return false;
                 }
             }
-            out->as.array = arr;
+            *out = ARRAY_VAL(arr);
             break;
         }
         default:
@@ -35,10 +35,8 @@ void freeChunk(Chunk* chunk) {
     FREE_ARRAY(LineInfo, chunk->line_info, chunk->line_capcity);
     for (int i = 0; i < chunk->constants.count; i++) {
         Value v = chunk->constants.values[i];
-        if (v.type == VAL_STRING) {
-            chunk->constants.values[i].as.string = NULL;
-        } else if (v.type == VAL_ARRAY) {
-            chunk->constants.values[i].as.array = NULL;
+        if (IS_STRING(v) || IS_ARRAY(v)) {
+            chunk->constants.values[i] = NIL_VAL;
         }
     }
     freeValueArray(&chunk->constants);
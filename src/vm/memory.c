@@ -1,9 +1,38 @@
 /**
- * @file memory_stub.c
- * @brief Minimal memory management stub for register VM tests
- * 
- * This file provides minimal implementations of memory management functions
- * needed by the register VM tests without full garbage collection.
+ * @file memory.c
+ * @brief Object allocation and mark-sweep garbage collection
+ *
+ * Objects allocated while a register VM runs are generational:
+ * - Strings, arrays, range iterators and boxed integers start in the VM's
+ *   nursery, a fixed block carved up by bumping a pointer. Their buffers
+ *   live inline right after the header. When the nursery fills up,
+ *   registervm_gc_minor copies whatever the roots and the remembered set
+ *   still reach into the old space and resets the pointer, so a minor
+ *   collection costs time proportional to the surviving objects only.
+ * - Everything else, objects too large for the nursery and promoted
+ *   survivors are old. They are threaded onto the VM's heap list
+ *   (`RegisterVM.objects`), accounted in `bytes_allocated`, and reclaimed
+ *   by the mark-sweep collection in registervm_gc_collect.
+ *
+ * Old objects that are made to point at nursery objects must be recorded
+ * with writeBarrier (or WRITE_BARRIER) so minor collections see them.
+ *
+ * Objects allocated while no VM is running (AST nodes, types, and the
+ * strings and constants created by the compiler) go on a permanent list.
+ * They are traced through but never swept. While a compile arena is open,
+ * AST nodes and types are bump-allocated from it instead and released
+ * together when it closes; the types the runtime keeps are copied out
+ * first (promoteTypeRoots).
+ *
+ * Old-space collection is tri-color marking followed by a sweep, split
+ * into phases (GCPhase) so the VM can run it in bounded steps: traceGray
+ * blackens a fixed number of gray objects and sweepHeap frees a fixed
+ * number of objects per call. While marking, new old objects are allocated
+ * black and writeBarrier shades whatever a marked object is made to point
+ * at. Roots are not barriered; they are scanned again when marking ends.
+ *
+ * Collections are paced by the VM at instruction boundaries. In stress mode
+ * every allocation made while the VM runs collects first.
  */
 
 #include <stdlib.h>
@@ -15,50 +44,892 @@
 #include "../../include/error.h"
 #include "../../include/ast.h"
 #include "../../include/type.h"
+#include "../../include/register_vm.h"
+
+// VM whose heap receives new objects while it runs
+static RegisterVM* gcHeap = NULL;
+
+// Objects allocated outside execution; traced but never swept
+static Obj* permanentObjects = NULL;
+
+// Nesting depth of pauseGC
+static int gcPauseDepth = 0;
+
+typedef struct {
+    Obj** items;
+    int count;
+    int capacity;
+} ObjStack;
+
+// Marked objects whose children are still to be traced
+static ObjStack grayStack = {NULL, 0, 0};
+
+// Objects promoted by the current minor collection, still to be forwarded
+static ObjStack promotedStack = {NULL, 0, 0};
+
+// Nursery allocations are rounded up to keep headers aligned
+#define NURSERY_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+// Objects above this fraction of the nursery are allocated old
+#define NURSERY_MAX_OBJECT_FRACTION 16
+
+// =============================================================================
+// SLAB ALLOCATOR
+// =============================================================================
+
+// Bytes carved into blocks at a time
+#define SLAB_SIZE (64 * 1024)
+
+static const size_t slabClassSizes[SLAB_CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256
+};
+
+typedef struct SlabBlock {
+    struct SlabBlock* next;
+} SlabBlock;
+
+typedef struct {
+    SlabBlock* freeList;   // Freed blocks, reused first
+    uint8_t* bump;         // Uncarved part of the newest slab
+    uint8_t* end;
+    SlabStats stats;
+} SlabClass;
+
+static SlabClass slabClasses[SLAB_CLASS_COUNT];
+
+// Allocations above SLAB_MAX_SIZE go to malloc
+static SlabStats largeStats;
+
+// Size class for `size` bytes, or -1 when it is served by malloc
+static int slabClassFor(size_t size) {
+    if (size > SLAB_MAX_SIZE) {
+        return -1;
+    }
+    int index = 0;
+    while (slabClassSizes[index] < size) {
+        index++;
+    }
+    return index;
+}
+
+void* slabAllocate(size_t size) {
+    int index = slabClassFor(size);
+    if (index < 0) {
+        void* pointer = malloc(size);
+        if (pointer) {
+            largeStats.liveBlocks++;
+            largeStats.allocations++;
+        }
+        return pointer;
+    }
+
+    SlabClass* slabClass = &slabClasses[index];
+    size_t blockSize = slabClassSizes[index];
+    void* block;
+    if (slabClass->freeList) {
+        block = slabClass->freeList;
+        slabClass->freeList = slabClass->freeList->next;
+        slabClass->stats.freeBlocks--;
+    } else {
+        if ((size_t)(slabClass->end - slabClass->bump) < blockSize) {
+            // The rest of the old slab is too small for a block and dropped
+            uint8_t* slab = malloc(SLAB_SIZE);
+            if (!slab) {
+                return NULL;
+            }
+            slabClass->bump = slab;
+            slabClass->end = slab + SLAB_SIZE;
+            slabClass->stats.slabs++;
+        }
+        block = slabClass->bump;
+        slabClass->bump += blockSize;
+    }
+    slabClass->stats.liveBlocks++;
+    slabClass->stats.allocations++;
+    return block;
+}
+
+void slabFree(void* pointer, size_t size) {
+    if (!pointer) {
+        return;
+    }
+    int index = slabClassFor(size);
+    if (index < 0) {
+        free(pointer);
+        largeStats.liveBlocks--;
+        return;
+    }
+
+    SlabClass* slabClass = &slabClasses[index];
+    SlabBlock* block = (SlabBlock*)pointer;
+    block->next = slabClass->freeList;
+    slabClass->freeList = block;
+    slabClass->stats.liveBlocks--;
+    slabClass->stats.freeBlocks++;
+}
+
+void getSlabStats(SlabStats stats[SLAB_CLASS_COUNT + 1]) {
+    for (int i = 0; i < SLAB_CLASS_COUNT; i++) {
+        stats[i] = slabClasses[i].stats;
+        stats[i].blockSize = slabClassSizes[i];
+    }
+    stats[SLAB_CLASS_COUNT] = largeStats;
+    stats[SLAB_CLASS_COUNT].blockSize = 0;
+}
+
+void printSlabStats() {
+    SlabStats stats[SLAB_CLASS_COUNT + 1];
+    getSlabStats(stats);
+    printf("=== Slab Allocator ===\n");
+    printf("%-8s %10s %10s %8s %14s\n", "class", "live", "free", "slabs", "allocations");
+    for (int i = 0; i <= SLAB_CLASS_COUNT; i++) {
+        if (i < SLAB_CLASS_COUNT) {
+            printf("%-8zu", stats[i].blockSize);
+        } else {
+            printf("%-8s", "large");
+        }
+        printf(" %10zu %10zu %8zu %14llu\n", stats[i].liveBlocks, stats[i].freeBlocks,
+               stats[i].slabs, (unsigned long long)stats[i].allocations);
+    }
+}
 
-// Simple allocation without GC
 void* reallocate(void* pointer, size_t oldSize, size_t newSize) {
     if (newSize == 0) {
-        free(pointer);
+        slabFree(pointer, oldSize);
+        return NULL;
+    }
+    if (!pointer) {
+        return slabAllocate(newSize);
+    }
+
+    int oldClass = slabClassFor(oldSize);
+    int newClass = slabClassFor(newSize);
+    if (oldClass < 0 && newClass < 0) {
+        return realloc(pointer, newSize);
+    }
+    if (oldClass == newClass) {
+        return pointer;
+    }
+
+    void* result = slabAllocate(newSize);
+    if (!result) {
         return NULL;
     }
-    return realloc(pointer, newSize);
+    memcpy(result, pointer, oldSize < newSize ? oldSize : newSize);
+    slabFree(pointer, oldSize);
+    return result;
 }
 
-// Allocate string object
-ObjString* allocateString(const char* chars, int length) {
-    ObjString* string = malloc(sizeof(ObjString));
+// =============================================================================
+// COMPILE ARENA
+// =============================================================================
+
+// Bytes reserved per arena chunk; larger requests get a chunk of their own
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* prev;
+    uint8_t* top;
+    uint8_t* end;
+    uint8_t data[];
+} ArenaChunk;
+
+// Newest chunk of the open arena, NULL when none is open
+static ArenaChunk* arenaChunks = NULL;
+
+// Empty chunk kept between compilations
+static ArenaChunk* arenaSpare = NULL;
+
+// Nesting depth of beginCompileArena
+static int arenaDepth = 0;
+
+static ArenaChunk* newArenaChunk(size_t size) {
+    ArenaChunk* chunk;
+    if (size <= ARENA_CHUNK_SIZE && arenaSpare) {
+        chunk = arenaSpare;
+        arenaSpare = NULL;
+    } else {
+        size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = malloc(sizeof(ArenaChunk) + size);
+        if (!chunk) {
+            fprintf(stderr, "Out of memory in compile arena!\n");
+            exit(1);
+        }
+        chunk->end = chunk->data + size;
+    }
+    chunk->top = chunk->data;
+    chunk->prev = arenaChunks;
+    arenaChunks = chunk;
+    return chunk;
+}
+
+void beginCompileArena() {
+    arenaDepth++;
+}
+
+void endCompileArena() {
+    if (arenaDepth == 0 || --arenaDepth > 0) {
+        return;
+    }
+
+    // Copy out the types the runtime keeps before the memory goes away
+    promoteTypeRoots();
+
+    while (arenaChunks) {
+        ArenaChunk* prev = arenaChunks->prev;
+        if (!arenaSpare && arenaChunks->end - arenaChunks->data == ARENA_CHUNK_SIZE) {
+            arenaSpare = arenaChunks;
+        } else {
+            free(arenaChunks);
+        }
+        arenaChunks = prev;
+    }
+}
+
+bool compileArenaActive() {
+    return arenaDepth > 0;
+}
+
+void* arenaAllocate(size_t size) {
+    if (arenaDepth == 0) {
+        return NULL;
+    }
+    size = NURSERY_ALIGN(size);
+    ArenaChunk* chunk = arenaChunks;
+    if (!chunk || size > (size_t)(chunk->end - chunk->top)) {
+        chunk = newArenaChunk(size);
+    }
+    void* pointer = chunk->top;
+    chunk->top += size;
+    return pointer;
+}
+
+bool inCompileArena(const void* pointer) {
+    for (ArenaChunk* chunk = arenaChunks; chunk; chunk = chunk->prev) {
+        if ((const uint8_t*)pointer >= chunk->data && (const uint8_t*)pointer < chunk->end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// OBJECT ALLOCATION
+// =============================================================================
+
+void setGCHeap(RegisterVM* vm) {
+    gcHeap = vm;
+}
+
+// Whether an object lives in the attached VM's nursery
+static inline bool isYoung(Obj* object) {
+    return gcHeap && (uintptr_t)object >= (uintptr_t)gcHeap->nursery &&
+           (uintptr_t)object < (uintptr_t)gcHeap->nursery_top;
+}
+
+// Whether new objects belong to the attached VM rather than the permanent list
+static inline bool heapActive() {
+    return gcHeap && (gcHeap->running || gcHeap->gc_running);
+}
+
+// Collect before an allocation in stress mode
+static void stressCollect() {
+    if (gcHeap && gcHeap->running && gcHeap->gc_stress &&
+        gcPauseDepth == 0 && !gcHeap->gc_running) {
+        registervm_gc_step(gcHeap);
+    }
+}
+
+static void initHeader(Obj* object, ObjType type) {
+    object->type = type;
+    object->marked = false;
+    object->remembered = false;
+    object->site = 0;
+    object->next = NULL;
+}
+
+// Bump-allocate `size` bytes in the nursery, running a minor collection when
+// it is full. Returns NULL when the object has to be allocated old instead.
+static Obj* allocateYoung(size_t size, ObjType type) {
+    if (!gcHeap || !gcHeap->running || !gcHeap->nursery) {
+        return NULL;
+    }
+    size = NURSERY_ALIGN(size);
+    size_t capacity = (size_t)(gcHeap->nursery_end - gcHeap->nursery);
+    if (size > capacity / NURSERY_MAX_OBJECT_FRACTION) {
+        return NULL;
+    }
+    if (size > (size_t)(gcHeap->nursery_end - gcHeap->nursery_top)) {
+        if (gcPauseDepth > 0 || gcHeap->gc_running) {
+            return NULL;
+        }
+        registervm_gc_minor(gcHeap);
+        if (size > (size_t)(gcHeap->nursery_end - gcHeap->nursery_top)) {
+            return NULL;
+        }
+    }
+
+    Obj* object = (Obj*)gcHeap->nursery_top;
+    gcHeap->nursery_top += size;
+    initHeader(object, type);
+    return object;
+}
+
+// Allocate an old object of `size` bytes (header plus inline payload) from
+// the slabs and thread it onto the heap or permanent list
+static Obj* allocateOld(size_t size, ObjType type) {
+    Obj* object = slabAllocate(size);
+    if (!object) {
+        fprintf(stderr, "Out of memory allocating object!\n");
+        exit(1);
+    }
+    initHeader(object, type);
+    if (heapActive()) {
+        // Allocate black while marking; the current cycle keeps it
+        object->marked = gcHeap->gc_phase == GC_PHASE_MARK;
+        gcHeap->bytes_allocated += size;
+        object->next = gcHeap->objects;
+        gcHeap->objects = object;
+    } else {
+        object->next = permanentObjects;
+        permanentObjects = object;
+    }
+    return object;
+}
+
+// Count an allocation made for the program; promotions are not counted
+static Obj* recordAllocation(Obj* object, size_t size) {
+    if (!heapActive()) {
+        return object;
+    }
+    if (gcHeap->perf) {
+        gcHeap->perf->memory_allocations++;
+    }
+    if (gcHeap->alloc_profile) {
+        registervm_record_allocation(gcHeap, object, size);
+    }
+    return object;
+}
+
+// Attribute buffer growth to the allocation site of the buffer's owner
+static void recordGrowth(Obj* owner, size_t bytes) {
+    if (heapActive() && gcHeap->alloc_profile &&
+        owner->site < gcHeap->alloc_profile->count) {
+        gcHeap->alloc_profile->sites[owner->site].bytes += bytes;
+    }
+}
+
+static Obj* allocateObject(size_t size, ObjType type) {
+    stressCollect();
+    return recordAllocation(allocateOld(size, type), size);
+}
+
+// Allocate an object, preferring the nursery
+static Obj* allocateSmall(size_t size, ObjType type) {
+    stressCollect();
+    Obj* object = allocateYoung(size, type);
+    return recordAllocation(object ? object : allocateOld(size, type), size);
+}
+
+#define ALLOCATE_OBJ(type, objectType, extra) \
+    (type*)allocateObject(sizeof(type) + (extra), (objectType))
+
+static size_t stringSize(int length) {
+    return sizeof(ObjString) + (size_t)length + 1;
+}
+
+// An empty packed array reserves room for the widest packed kind, so its
+// first push never has to move it
+size_t arrayElementSize(ArrayKind kind) {
+    switch (kind) {
+        case ARRAY_VALUES: return sizeof(Value);
+        case ARRAY_I32:
+        case ARRAY_U32: return sizeof(uint32_t);
+        case ARRAY_I64:
+        case ARRAY_U64:
+        case ARRAY_F64:
+        case ARRAY_PACKED: return sizeof(uint64_t);
+        case ARRAY_BOOL: return sizeof(uint8_t);
+    }
+    return sizeof(Value);
+}
+
+static size_t arraySize(int inlineSize) {
+    return sizeof(ObjArray) + (size_t)inlineSize;
+}
+
+static void initString(ObjString* string, const char* chars, int length) {
     string->length = length;
-    string->chars = malloc(length + 1);
+    string->hash = hashString(chars, length);
+    string->interned = false;
     memcpy(string->chars, chars, length);
     string->chars[length] = '\0';
+}
+
+static void initArray(ObjArray* array, ArrayKind kind, int length, int capacity) {
+    array->length = length;
+    array->capacity = capacity;
+    array->kind = (uint8_t)kind;
+    array->inlineSize = (int)(arrayElementSize(kind) * (size_t)capacity);
+    array->shape = 0;
+    array->elements = (Value*)(array + 1);
+}
+
+// Reset elements [from, to) to nil or zero
+static void clearArrayElements(ObjArray* array, int from, int to) {
+    if (array->kind == ARRAY_VALUES) {
+        for (int i = from; i < to; i++) {
+            array->elements[i] = NIL_VAL;
+        }
+        return;
+    }
+    size_t elementSize = arrayElementSize((ArrayKind)array->kind);
+    memset((char*)array->elements + elementSize * (size_t)from, 0,
+           elementSize * (size_t)(to - from));
+}
+
+// =============================================================================
+// STRING INTERNING
+// =============================================================================
+
+// Open-addressed set of canonical strings keyed by content hash. It holds
+// its strings weakly: a collected string is removed when it is freed.
+typedef struct {
+    ObjString** entries;
+    int count;       // Live entries plus tombstones
+    int capacity;    // Power of two
+} InternTable;
+
+static InternTable internTable = {NULL, 0, 0};
+
+// Marks a slot whose string was removed, so probing continues past it
+static ObjString internTombstone;
+#define INTERN_TOMBSTONE (&internTombstone)
+#define INTERN_MAX_LOAD 0.75
+
+uint32_t hashString(const char* chars, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Slot holding the string with these contents, or the empty slot (or first
+// tombstone on the way) where it would be inserted
+static ObjString** findInternSlot(ObjString** entries, int capacity,
+                                  const char* chars, int length, uint32_t hash) {
+    uint32_t index = hash & (uint32_t)(capacity - 1);
+    ObjString** tombstone = NULL;
+    for (;;) {
+        ObjString** slot = &entries[index];
+        ObjString* entry = *slot;
+        if (entry == NULL) {
+            return tombstone ? tombstone : slot;
+        }
+        if (entry == INTERN_TOMBSTONE) {
+            if (!tombstone) tombstone = slot;
+        } else if (entry->hash == hash && entry->length == length &&
+                   memcmp(entry->chars, chars, length) == 0) {
+            return slot;
+        }
+        index = (index + 1) & (uint32_t)(capacity - 1);
+    }
+}
+
+static void growInternTable() {
+    int capacity = internTable.capacity < 64 ? 64 : internTable.capacity * 2;
+    ObjString** entries = calloc(capacity, sizeof(ObjString*));
+    if (!entries) {
+        fprintf(stderr, "Out of memory growing the intern table!\n");
+        exit(1);
+    }
+
+    // Tombstones are dropped while rehashing
+    internTable.count = 0;
+    for (int i = 0; i < internTable.capacity; i++) {
+        ObjString* entry = internTable.entries[i];
+        if (entry == NULL || entry == INTERN_TOMBSTONE) continue;
+        *findInternSlot(entries, capacity, entry->chars, entry->length, entry->hash) = entry;
+        internTable.count++;
+    }
+    free(internTable.entries);
+    internTable.entries = entries;
+    internTable.capacity = capacity;
+}
+
+ObjString* findInternedString(const char* chars, int length) {
+    if (internTable.count == 0) {
+        return NULL;
+    }
+    uint32_t hash = hashString(chars, length);
+    ObjString* entry = *findInternSlot(internTable.entries, internTable.capacity,
+                                       chars, length, hash);
+    if (entry == NULL || entry == INTERN_TOMBSTONE) {
+        return NULL;
+    }
+
+    // A white string found mid-cycle is live again; keep the sweep off it
+    if (gcHeap && gcHeap->gc_phase != GC_PHASE_IDLE) {
+        entry->obj.marked = true;
+    }
+    return entry;
+}
+
+ObjString* internString(const char* chars, int length) {
+    ObjString* string = findInternedString(chars, length);
+    if (string) {
+        return string;
+    }
+
+    // Interned strings are old: the table must not see them move
+    string = (ObjString*)allocateObject(stringSize(length), OBJ_STRING);
+    initString(string, chars, length);
+    string->interned = true;
+
+    if (internTable.count + 1 > internTable.capacity * INTERN_MAX_LOAD) {
+        growInternTable();
+    }
+    ObjString** slot = findInternSlot(internTable.entries, internTable.capacity,
+                                      chars, length, string->hash);
+    if (*slot == NULL) {
+        internTable.count++;
+    }
+    *slot = string;
+    return string;
+}
+
+// Drop a string that is being freed from the table
+static void removeInternedString(ObjString* string) {
+    ObjString** slot = findInternSlot(internTable.entries, internTable.capacity,
+                                      string->chars, string->length, string->hash);
+    if (*slot == string) {
+        *slot = INTERN_TOMBSTONE;
+    }
+}
+
+// Names TYPE_OF and type_of() produce
+static const char* const runtimeTypeNames[] = {
+    "i32", "i64", "u32", "u64", "f64", "bool", "nil", "string",
+    "array", "error", "range", "enum", "unknown",
+};
+
+void initSmallStrings() {
+    static bool initialized = false;
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+
+    // Allocate outside any heap so these are never collected
+    struct RegisterVM* heap = gcHeap;
+    gcHeap = NULL;
+    internString("", 0);
+    for (int c = 0; c < 256; c++) {
+        char chars[1] = {(char)c};
+        internString(chars, 1);
+    }
+    for (size_t i = 0; i < sizeof(runtimeTypeNames) / sizeof(runtimeTypeNames[0]); i++) {
+        internString(runtimeTypeNames[i], (int)strlen(runtimeTypeNames[i]));
+    }
+    gcHeap = heap;
+}
+
+// Allocate string object. Strings created outside execution (compiler
+// constants, identifiers and names) are interned, and so are short strings
+// created while it runs.
+ObjString* allocateString(const char* chars, int length) {
+    if (!heapActive()) {
+        return internString(chars, length);
+    }
+    if (length <= SMALL_STRING_MAX) {
+        return internString(chars, length);
+    }
+    ObjString* string = (ObjString*)allocateSmall(stringSize(length), OBJ_STRING);
+    initString(string, chars, length);
+    return string;
+}
+
+ObjString* concatenateStrings(ObjString* a, ObjString* b) {
+    int length = a->length + b->length;
+    if (heapActive() && length <= SMALL_STRING_MAX) {
+        // Short results may already exist
+        char chars[SMALL_STRING_MAX];
+        memcpy(chars, a->chars, (size_t)a->length);
+        memcpy(chars + a->length, b->chars, (size_t)b->length);
+        return allocateString(chars, length);
+    }
+    if (!heapActive()) {
+        char* chars = malloc((size_t)length + 1);
+        if (!chars) {
+            fprintf(stderr, "Out of memory concatenating strings!\n");
+            exit(1);
+        }
+        memcpy(chars, a->chars, (size_t)a->length);
+        memcpy(chars + a->length, b->chars, (size_t)b->length);
+        ObjString* string = internString(chars, length);
+        free(chars);
+        return string;
+    }
+
+    // Neither operand may move before it has been copied
+    pauseGC();
+    ObjString* string = (ObjString*)allocateSmall(stringSize(length), OBJ_STRING);
+    resumeGC();
+    memcpy(string->chars, a->chars, (size_t)a->length);
+    memcpy(string->chars + a->length, b->chars, (size_t)b->length);
+    string->chars[length] = '\0';
+    string->length = length;
+    string->hash = hashString(string->chars, length);
+    string->interned = false;
     return string;
 }
 
 // Allocate array object
 ObjArray* allocateArray(int length) {
-    ObjArray* array = malloc(sizeof(ObjArray));
-    array->length = length;
-    array->capacity = length > 0 ? length : 8;
-    array->elements = malloc(sizeof(Value) * array->capacity);
-    for (int i = 0; i < array->capacity; i++) {
-        array->elements[i] = NIL_VAL;
-    }
+    return allocateArrayOfKind(ARRAY_VALUES, length);
+}
+
+ObjArray* allocateArrayOfKind(ArrayKind kind, int length) {
+    int capacity = length > 0 ? length : 8;
+    size_t size = arrayElementSize(kind) * (size_t)capacity;
+    ObjArray* array = (ObjArray*)allocateSmall(arraySize((int)size), OBJ_ARRAY);
+    initArray(array, kind, length, capacity);
+    clearArrayElements(array, 0, capacity);
     return array;
 }
 
+// Give `array` a buffer of `capacity` elements of `kind`, which is either
+// its own kind or ARRAY_VALUES, converting what it holds. A nursery array
+// takes fresh nursery space, which is only possible without collecting
+// since the caller holds `array`; false when there is none.
+static bool replaceArrayStorage(ObjArray* array, ArrayKind kind, int capacity) {
+    size_t oldSize = arrayElementSize((ArrayKind)array->kind) * (size_t)array->capacity;
+    size_t size = arrayElementSize(kind) * (size_t)capacity;
+    bool young = isYoung(&array->obj);
+    bool inlineStorage = array->elements == (Value*)(array + 1);
+
+    void* storage;
+    if (!young && !inlineStorage && kind == array->kind) {
+        storage = reallocate(array->elements, oldSize, size);
+        if (!storage) {
+            return false;
+        }
+    } else {
+        if (young) {
+            size_t aligned = NURSERY_ALIGN(size);
+            if (aligned > (size_t)(gcHeap->nursery_end - gcHeap->nursery_top)) {
+                return false;
+            }
+            storage = gcHeap->nursery_top;
+            gcHeap->nursery_top += aligned;
+        } else {
+            // Inline storage stays allocated with the header
+            storage = slabAllocate(size);
+            if (!storage) {
+                return false;
+            }
+        }
+        if (kind == array->kind) {
+            memcpy(storage, array->elements, arrayElementSize(kind) * (size_t)array->length);
+        } else {
+            // Boxing wide integers may allocate; the caller pauses the GC
+            Value* values = storage;
+            for (int i = 0; i < array->length; i++) {
+                values[i] = arrayGet(array, i);
+            }
+        }
+        if (!young && !inlineStorage) {
+            slabFree(array->elements, oldSize);
+        }
+    }
+
+    // Charge what objectSize will release for the array
+    size_t released = young || inlineStorage ? 0 : oldSize;
+    size_t grown = size > released ? size - released : 0;
+    if (heapActive() && !young) {
+        gcHeap->bytes_allocated += grown;
+    }
+    recordGrowth(&array->obj, grown);
+
+    array->elements = storage;
+    array->kind = (uint8_t)kind;
+    array->capacity = capacity;
+    clearArrayElements(array, array->length, capacity);
+    if (kind == ARRAY_VALUES) {
+        for (int i = 0; i < array->length; i++) {
+            WRITE_BARRIER(&array->obj, array->elements[i]);
+        }
+    }
+    return true;
+}
+
+bool reserveArray(ObjArray* array, int capacity) {
+    if (capacity <= array->capacity) {
+        return true;
+    }
+    return replaceArrayStorage(array, (ArrayKind)array->kind, capacity);
+}
+
+ArrayKind arrayKindOf(Value value) {
+    switch (VALUE_TYPE(value)) {
+        case VAL_I32: return ARRAY_I32;
+        case VAL_I64: return ARRAY_I64;
+        case VAL_U32: return ARRAY_U32;
+        case VAL_U64: return ARRAY_U64;
+        case VAL_F64: return ARRAY_F64;
+        case VAL_BOOL: return ARRAY_BOOL;
+        default: return ARRAY_VALUES;
+    }
+}
+
+// Make room for `value` in the element storage: an empty packed array
+// takes on its kind, any other mismatch converts the array to Values
+static bool prepareArrayStore(ObjArray* array, Value value) {
+    if (array->kind == ARRAY_VALUES) {
+        return true;
+    }
+    ArrayKind kind = arrayKindOf(value);
+    if (kind == array->kind) {
+        return true;
+    }
+    if (array->kind == ARRAY_PACKED && kind != ARRAY_VALUES) {
+        // Same bytes, reinterpreted as narrower or equal elements
+        array->capacity = (int)(array->capacity * arrayElementSize(ARRAY_PACKED) /
+                                arrayElementSize(kind));
+        array->kind = (uint8_t)kind;
+        return true;
+    }
+    pauseGC();
+    bool converted = replaceArrayStorage(array, ARRAY_VALUES, array->capacity);
+    resumeGC();
+    return converted;
+}
+
+Value arrayGet(ObjArray* array, int index) {
+    switch ((ArrayKind)array->kind) {
+        case ARRAY_VALUES: return array->elements[index];
+        case ARRAY_I32: return I32_VAL(ARRAY_DATA(array, int32_t)[index]);
+        case ARRAY_I64: return I64_VAL(ARRAY_DATA(array, int64_t)[index]);
+        case ARRAY_U32: return U32_VAL(ARRAY_DATA(array, uint32_t)[index]);
+        case ARRAY_U64: return U64_VAL(ARRAY_DATA(array, uint64_t)[index]);
+        case ARRAY_F64: return F64_VAL(ARRAY_DATA(array, double)[index]);
+        case ARRAY_BOOL: return BOOL_VAL(ARRAY_DATA(array, uint8_t)[index] != 0);
+        case ARRAY_PACKED: break;
+    }
+    return NIL_VAL;
+}
+
+bool arraySet(ObjArray* array, int index, Value value) {
+    if (!prepareArrayStore(array, value)) {
+        return false;
+    }
+    switch ((ArrayKind)array->kind) {
+        case ARRAY_VALUES:
+            array->elements[index] = value;
+            WRITE_BARRIER(&array->obj, value);
+            break;
+        case ARRAY_I32: ARRAY_DATA(array, int32_t)[index] = AS_I32(value); break;
+        case ARRAY_I64: ARRAY_DATA(array, int64_t)[index] = AS_I64(value); break;
+        case ARRAY_U32: ARRAY_DATA(array, uint32_t)[index] = AS_U32(value); break;
+        case ARRAY_U64: ARRAY_DATA(array, uint64_t)[index] = AS_U64(value); break;
+        case ARRAY_F64: ARRAY_DATA(array, double)[index] = AS_F64(value); break;
+        case ARRAY_BOOL: ARRAY_DATA(array, uint8_t)[index] = AS_BOOL(value); break;
+        case ARRAY_PACKED: break;
+    }
+    return true;
+}
+
+bool arrayPush(ObjArray* array, Value value) {
+    if (array->length >= array->capacity &&
+        !reserveArray(array, GROW_CAPACITY(array->capacity))) {
+        return false;
+    }
+    if (!prepareArrayStore(array, value)) {
+        return false;
+    }
+    array->length++;
+    return arraySet(array, array->length - 1, value);
+}
+
+Value arrayPop(ObjArray* array) {
+    if (array->length == 0) {
+        return NIL_VAL;
+    }
+    Value value = arrayGet(array, array->length - 1);
+    array->length--;
+    clearArrayElements(array, array->length, array->length + 1);
+    return value;
+}
+
+// Allocate a string builder holding a copy of `seed`
+ObjStringBuilder* allocateStringBuilder(ObjString* seed) {
+    int capacity = 16;
+    while (capacity <= seed->length) {
+        capacity *= 2;
+    }
+    // Copy before allocating the object, which may move a young `seed`
+    char* chars = slabAllocate((size_t)capacity);
+    if (!chars) {
+        fprintf(stderr, "Out of memory allocating string builder!\n");
+        exit(1);
+    }
+    int length = seed->length;
+    memcpy(chars, seed->chars, (size_t)length + 1);
+
+    ObjStringBuilder* builder = ALLOCATE_OBJ(ObjStringBuilder, OBJ_STRING_BUILDER, 0);
+    builder->length = length;
+    builder->capacity = capacity;
+    builder->chars = chars;
+    if (heapActive()) {
+        gcHeap->bytes_allocated += (size_t)capacity;
+    }
+    recordGrowth(&builder->obj, (size_t)capacity);
+    return builder;
+}
+
+bool appendStringBuilder(ObjStringBuilder* builder, const char* chars, int length) {
+    int needed = builder->length + length + 1;
+    if (needed > builder->capacity) {
+        int capacity = builder->capacity;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        char* grown = reallocate(builder->chars, (size_t)builder->capacity, (size_t)capacity);
+        if (!grown) {
+            return false;
+        }
+        if (heapActive()) {
+            gcHeap->bytes_allocated += (size_t)(capacity - builder->capacity);
+        }
+        recordGrowth(&builder->obj, (size_t)(capacity - builder->capacity));
+        builder->chars = grown;
+        builder->capacity = capacity;
+    }
+    memcpy(builder->chars + builder->length, chars, (size_t)length);
+    builder->length += length;
+    builder->chars[builder->length] = '\0';
+    return true;
+}
+
+ObjString* finishStringBuilder(ObjStringBuilder* builder) {
+    return allocateString(builder->chars, builder->length);
+}
+
 // Allocate integer array object
 ObjIntArray* allocateIntArray(int length) {
-    ObjIntArray* array = malloc(sizeof(ObjIntArray));
+    ObjIntArray* array = ALLOCATE_OBJ(ObjIntArray, OBJ_INT_ARRAY, sizeof(int64_t) * length);
     array->length = length;
-    array->elements = malloc(sizeof(int64_t) * length);
+    array->elements = (int64_t*)(array + 1);
     memset(array->elements, 0, sizeof(int64_t) * length);
     return array;
 }
 
 // Allocate range iterator
 ObjRangeIterator* allocateRangeIterator(int64_t start, int64_t end) {
-    ObjRangeIterator* it = malloc(sizeof(ObjRangeIterator));
+    ObjRangeIterator* it = (ObjRangeIterator*)allocateSmall(sizeof(ObjRangeIterator),
+                                                            OBJ_RANGE_ITERATOR);
     it->current = start;
     it->end = end;
     return it;
@@ -66,73 +937,637 @@ ObjRangeIterator* allocateRangeIterator(int64_t start, int64_t end) {
 
 // Allocate error object
 ObjError* allocateError(ErrorType type, const char* message, SrcLocation location) {
-    ObjError* err = malloc(sizeof(ObjError));
+    // The message is not reachable from any root until the error is built
+    pauseGC();
+    ObjError* err = ALLOCATE_OBJ(ObjError, OBJ_ERROR, 0);
     err->type = type;
-    err->message = allocateString(message, (int)strlen(message));
+    err->message = NULL;
     err->location = location;
+    err->message = allocateString(message, (int)strlen(message));
+    writeBarrier(&err->obj, STRING_VAL(err->message));
+    resumeGC();
     return err;
 }
 
+// Allocate out-of-line 64-bit integer (NaN-boxed builds only)
+ObjBoxedInt* allocateBoxedInt(ValueType type, uint64_t bits) {
+    ObjBoxedInt* boxed = (ObjBoxedInt*)allocateSmall(sizeof(ObjBoxedInt), OBJ_BOXED_INT);
+    boxed->type = type;
+    boxed->as.u64 = bits;
+    return boxed;
+}
+
+// Allocate a compile-time object from the open arena, or NULL without one.
+// Arena objects are on no list; the GC never runs while one is open.
+static Obj* allocateInArena(size_t size, ObjType type) {
+    Obj* object = arenaAllocate(size);
+    if (object) {
+        initHeader(object, type);
+    }
+    return object;
+}
+
 // Allocate AST node
 ASTNode* allocateASTNode() {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = (ASTNode*)allocateInArena(sizeof(ASTNode), OBJ_AST);
+    if (!node) {
+        node = ALLOCATE_OBJ(ASTNode, OBJ_AST, 0);
+    }
+    Obj header = node->obj;
     memset(node, 0, sizeof(ASTNode));
+    node->obj = header;
     return node;
 }
 
 // Allocate type
 Type* allocateType() {
-    return malloc(sizeof(Type));
+    Type* type = (Type*)allocateInArena(sizeof(Type), OBJ_TYPE);
+    return type ? type : ALLOCATE_OBJ(Type, OBJ_TYPE, 0);
+}
+
+Type* allocatePromotedType() {
+    return ALLOCATE_OBJ(Type, OBJ_TYPE, 0);
 }
 
 // Allocate enum object
 ObjEnum* allocateEnum(int variantIndex, Value* data, int dataCount, ObjString* typeName) {
-    ObjEnum* enumValue = malloc(sizeof(ObjEnum));
+    ObjEnum* enumValue = ALLOCATE_OBJ(ObjEnum, OBJ_ENUM, sizeof(Value) * dataCount);
     enumValue->variantIndex = variantIndex;
     enumValue->dataCount = dataCount;
     enumValue->typeName = typeName;
-    
+
     if (dataCount > 0) {
-        enumValue->data = malloc(sizeof(Value) * dataCount);
+        enumValue->data = (Value*)(enumValue + 1);
         for (int i = 0; i < dataCount; i++) {
             enumValue->data[i] = data[i];
+            writeBarrier(&enumValue->obj, data[i]);
         }
     } else {
         enumValue->data = NULL;
     }
-    
+    writeBarrier(&enumValue->obj, STRING_VAL(typeName));
+
     return enumValue;
 }
 
-// Stub GC functions (no-ops for tests)
+// Heap object referenced by a value, or NULL for immediates
+static Obj* valueObject(Value value) {
+#ifdef NAN_BOXING
+    return NANBOX_IS_TAG(value, NANBOX_OBJ) ? NANBOX_AS_OBJ(value) : NULL;
+#else
+    switch (value.type) {
+        case VAL_STRING: return (Obj*)AS_STRING(value);
+        case VAL_ARRAY: return (Obj*)AS_ARRAY(value);
+        case VAL_ERROR: return (Obj*)AS_ERROR(value);
+        case VAL_RANGE_ITERATOR: return (Obj*)AS_RANGE_ITERATOR(value);
+        case VAL_ENUM: return (Obj*)AS_ENUM(value);
+        case VAL_STRING_BUILDER: return (Obj*)AS_STRING_BUILDER(value);
+        default: return NULL;
+    }
+#endif
+}
+
 void markValue(Value value) {
-    // No-op for tests
+    markObject(valueObject(value));
+}
+
+static void pushObject(ObjStack* stack, Obj* object) {
+    if (stack->count >= stack->capacity) {
+        int capacity = GROW_CAPACITY(stack->capacity);
+        Obj** items = realloc(stack->items, sizeof(Obj*) * capacity);
+        if (!items) {
+            fprintf(stderr, "Out of memory tracing the heap!\n");
+            exit(1);
+        }
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = object;
+}
+
+static void freeObjStack(ObjStack* stack) {
+    free(stack->items);
+    stack->items = NULL;
+    stack->count = 0;
+    stack->capacity = 0;
+}
+
+// =============================================================================
+// HEAP SNAPSHOTS
+// =============================================================================
+
+// Snapshot being recorded by markObject, NULL when none is
+static HeapSnapshot* snapshot = NULL;
+
+// Entry whose children are being traced, -1 while marking roots
+static int32_t snapshotParent = -1;
+
+// Snapshot entry of each gray stack slot
+static int32_t* snapshotGray = NULL;
+static int snapshotGrayCapacity = 0;
+
+static void recordSnapshotEntry(Obj* object) {
+    if (snapshot->count >= snapshot->capacity) {
+        int capacity = GROW_CAPACITY(snapshot->capacity);
+        HeapSnapshotEntry* entries = realloc(snapshot->entries,
+                                             sizeof(HeapSnapshotEntry) * capacity);
+        if (!entries) {
+            fprintf(stderr, "Out of memory recording a heap snapshot!\n");
+            exit(1);
+        }
+        snapshot->entries = entries;
+        snapshot->capacity = capacity;
+    }
+    if (grayStack.capacity > snapshotGrayCapacity) {
+        int32_t* gray = realloc(snapshotGray, sizeof(int32_t) * grayStack.capacity);
+        if (!gray) {
+            fprintf(stderr, "Out of memory recording a heap snapshot!\n");
+            exit(1);
+        }
+        snapshotGray = gray;
+        snapshotGrayCapacity = grayStack.capacity;
+    }
+
+    size_t size = objectSize(object);
+    snapshotGray[grayStack.count - 1] = snapshot->count;
+    snapshot->entries[snapshot->count++] =
+        (HeapSnapshotEntry){object, size, size, snapshotParent};
+}
+
+void beginHeapSnapshot(HeapSnapshot* target) {
+    target->entries = NULL;
+    target->count = 0;
+    target->capacity = 0;
+    snapshot = target;
+    snapshotParent = -1;
+}
+
+void endHeapSnapshot() {
+    if (!snapshot) {
+        return;
+    }
+    // Entries come after the entry that marked them, so one backward pass
+    // adds every subtree into its parent
+    for (int i = snapshot->count - 1; i >= 0; i--) {
+        int32_t parent = snapshot->entries[i].parent;
+        if (parent >= 0) {
+            snapshot->entries[parent].retained += snapshot->entries[i].retained;
+        }
+    }
+    snapshot = NULL;
+    snapshotParent = -1;
+    free(snapshotGray);
+    snapshotGray = NULL;
+    snapshotGrayCapacity = 0;
+}
+
+void freeHeapSnapshot(HeapSnapshot* target) {
+    free(target->entries);
+    target->entries = NULL;
+    target->count = 0;
+    target->capacity = 0;
 }
 
+// =============================================================================
+// MARKING
+// =============================================================================
+
 void markObject(Obj* object) {
-    // No-op for tests
+    // Nursery objects are reached through minor collections instead
+    if (!object || object->marked || isYoung(object)) {
+        return;
+    }
+    object->marked = true;
+    pushObject(&grayStack, object);
+    if (snapshot) {
+        recordSnapshotEntry(object);
+    }
+}
+
+static void blackenObject(Obj* object);
+
+// =============================================================================
+// NURSERY
+// =============================================================================
+
+void writeBarrier(Obj* owner, Value value) {
+    if (!gcHeap) {
+        return;
+    }
+    Obj* target = valueObject(value);
+
+    // Incremental marking: a marked object must never point at a white one
+    if (owner->marked && gcHeap->gc_phase == GC_PHASE_MARK) {
+        markObject(target);
+    }
+
+    if (owner->remembered || isYoung(owner) || !isYoung(target)) {
+        return;
+    }
+
+    if (gcHeap->remembered_count >= gcHeap->remembered_capacity) {
+        size_t capacity = GROW_CAPACITY(gcHeap->remembered_capacity);
+        Obj** set = realloc(gcHeap->remembered_set, sizeof(Obj*) * capacity);
+        if (!set) {
+            fprintf(stderr, "Out of memory recording a write barrier!\n");
+            exit(1);
+        }
+        gcHeap->remembered_set = set;
+        gcHeap->remembered_capacity = capacity;
+    }
+    owner->remembered = true;
+    gcHeap->remembered_set[gcHeap->remembered_count++] = owner;
+}
+
+// Copy a nursery object into the old space, leaving a forwarding pointer
+// (marked + next) behind
+static Obj* promoteObject(Obj* object) {
+    if (object->marked) {
+        return object->next;
+    }
+
+    Obj* promoted = NULL;
+    switch (object->type) {
+        case OBJ_STRING: {
+            ObjString* string = (ObjString*)object;
+            promoted = allocateOld(stringSize(string->length), OBJ_STRING);
+            initString((ObjString*)promoted, string->chars, string->length);
+            break;
+        }
+        case OBJ_ARRAY: {
+            ObjArray* array = (ObjArray*)object;
+            ArrayKind kind = (ArrayKind)array->kind;
+            size_t size = arrayElementSize(kind) * (size_t)array->capacity;
+            ObjArray* copy = (ObjArray*)allocateOld(arraySize((int)size), OBJ_ARRAY);
+            initArray(copy, kind, array->length, array->capacity);
+            copy->shape = array->shape;
+            memcpy(copy->elements, array->elements, size);
+            promoted = (Obj*)copy;
+            // Its elements may still point into the nursery
+            pushObject(&promotedStack, promoted);
+            break;
+        }
+        case OBJ_RANGE_ITERATOR:
+            promoted = allocateOld(sizeof(ObjRangeIterator), OBJ_RANGE_ITERATOR);
+            ((ObjRangeIterator*)promoted)->current = ((ObjRangeIterator*)object)->current;
+            ((ObjRangeIterator*)promoted)->end = ((ObjRangeIterator*)object)->end;
+            break;
+        case OBJ_BOXED_INT:
+            promoted = allocateOld(sizeof(ObjBoxedInt), OBJ_BOXED_INT);
+            ((ObjBoxedInt*)promoted)->type = ((ObjBoxedInt*)object)->type;
+            ((ObjBoxedInt*)promoted)->as = ((ObjBoxedInt*)object)->as;
+            break;
+        default:
+            // Only the types above are allocated young
+            return object;
+    }
+
+    promoted->site = object->site;
+    object->marked = true;
+    object->next = promoted;
+    return promoted;
+}
+
+void forwardValue(Value* slot) {
+    Obj* object = valueObject(*slot);
+    if (!isYoung(object)) {
+        return;
+    }
+    Obj* promoted = promoteObject(object);
+#ifdef NAN_BOXING
+    *slot = NANBOX_OBJ_VAL(promoted);
+#else
+    switch (slot->type) {
+        case VAL_STRING: slot->as.string = (ObjString*)promoted; break;
+        case VAL_ARRAY: slot->as.array = (ObjArray*)promoted; break;
+        case VAL_RANGE_ITERATOR: slot->as.rangeIter = (ObjRangeIterator*)promoted; break;
+        default: break;
+    }
+#endif
+}
+
+static void forwardObject(Obj** slot) {
+    if (isYoung(*slot)) {
+        *slot = promoteObject(*slot);
+    }
+}
+
+// Forward every nursery reference held by an old object
+static void forwardChildren(Obj* object) {
+    switch (object->type) {
+        case OBJ_ARRAY: {
+            // Packed elements hold no references
+            ObjArray* array = (ObjArray*)object;
+            for (int i = 0; array->kind == ARRAY_VALUES && i < array->length; i++) {
+                forwardValue(&array->elements[i]);
+            }
+            break;
+        }
+        case OBJ_ERROR:
+            forwardObject((Obj**)&((ObjError*)object)->message);
+            break;
+        case OBJ_ENUM: {
+            ObjEnum* enumValue = (ObjEnum*)object;
+            forwardObject((Obj**)&enumValue->typeName);
+            for (int i = 0; i < enumValue->dataCount; i++) {
+                forwardValue(&enumValue->data[i]);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void collectNursery() {
+    if (!gcHeap || !gcHeap->nursery) {
+        return;
+    }
+
+    // Old objects written since the last minor collection
+    for (size_t i = 0; i < gcHeap->remembered_count; i++) {
+        Obj* object = gcHeap->remembered_set[i];
+        object->remembered = false;
+        forwardChildren(object);
+    }
+    gcHeap->remembered_count = 0;
+
+    // Promoted objects may reach further nursery objects. While marking they
+    // are allocated black, so their children are shaded as well.
+    bool marking = gcHeap->gc_phase == GC_PHASE_MARK;
+    while (promotedStack.count > 0) {
+        Obj* object = promotedStack.items[--promotedStack.count];
+        forwardChildren(object);
+        if (marking) {
+            blackenObject(object);
+        }
+    }
+
+    gcHeap->nursery_top = gcHeap->nursery;
+}
+
+static void markType(Type* type) {
+    markObject((Obj*)type);
+}
+
+// Mark everything an object refers to
+static void blackenObject(Obj* object) {
+    switch (object->type) {
+        case OBJ_ARRAY: {
+            ObjArray* array = (ObjArray*)object;
+            for (int i = 0; array->kind == ARRAY_VALUES && i < array->length; i++) {
+                markValue(array->elements[i]);
+            }
+            break;
+        }
+        case OBJ_ERROR:
+            markObject((Obj*)((ObjError*)object)->message);
+            break;
+        case OBJ_ENUM: {
+            ObjEnum* enumValue = (ObjEnum*)object;
+            markObject((Obj*)enumValue->typeName);
+            for (int i = 0; i < enumValue->dataCount; i++) {
+                markValue(enumValue->data[i]);
+            }
+            break;
+        }
+        case OBJ_TYPE: {
+            Type* type = (Type*)object;
+            switch (type->kind) {
+                case TYPE_ARRAY:
+                    markType(type->info.array.elementType);
+                    break;
+                case TYPE_FUNCTION:
+                    markType(type->info.function.returnType);
+                    for (int i = 0; i < type->info.function.paramCount; i++) {
+                        markType(type->info.function.paramTypes[i]);
+                    }
+                    break;
+                case TYPE_STRUCT:
+                    markObject((Obj*)type->info.structure.name);
+                    for (int i = 0; i < type->info.structure.fieldCount; i++) {
+                        markObject((Obj*)type->info.structure.fields[i].name);
+                        markType(type->info.structure.fields[i].type);
+                    }
+                    for (int i = 0; i < type->info.structure.genericCount; i++) {
+                        markObject((Obj*)type->info.structure.genericParams[i]);
+                    }
+                    break;
+                case TYPE_GENERIC:
+                    markObject((Obj*)type->info.generic.name);
+                    break;
+                case TYPE_ENUM:
+                    markObject((Obj*)type->info.enumeration.name);
+                    for (int i = 0; i < type->info.enumeration.variantCount; i++) {
+                        VariantInfo* variant = &type->info.enumeration.variants[i];
+                        markObject((Obj*)variant->name);
+                        for (int j = 0; j < variant->fieldCount; j++) {
+                            markType(variant->fieldTypes[j]);
+                            if (variant->fieldNames) {
+                                markObject((Obj*)variant->fieldNames[j]);
+                            }
+                        }
+                    }
+                    for (int i = 0; i < type->info.enumeration.genericCount; i++) {
+                        markObject((Obj*)type->info.enumeration.genericParams[i]);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+        }
+        case OBJ_STRING:
+        case OBJ_INT_ARRAY:
+        case OBJ_AST:
+        case OBJ_RANGE_ITERATOR:
+        case OBJ_BOXED_INT:
+        case OBJ_STRING_BUILDER:
+            break;
+    }
+}
+
+size_t objectSize(Obj* object) {
+    switch (object->type) {
+        case OBJ_STRING:
+            return stringSize(((ObjString*)object)->length);
+        case OBJ_ARRAY: {
+            ObjArray* array = (ObjArray*)object;
+            size_t size = arraySize(array->inlineSize);
+            if (array->elements != (Value*)(array + 1)) {
+                // Grown past the inline slots
+                size += arrayElementSize((ArrayKind)array->kind) * (size_t)array->capacity;
+            }
+            return size;
+        }
+        case OBJ_INT_ARRAY:
+            return sizeof(ObjIntArray) + sizeof(int64_t) * ((ObjIntArray*)object)->length;
+        case OBJ_ENUM:
+            return sizeof(ObjEnum) + sizeof(Value) * ((ObjEnum*)object)->dataCount;
+        case OBJ_ERROR: return sizeof(ObjError);
+        case OBJ_RANGE_ITERATOR: return sizeof(ObjRangeIterator);
+        case OBJ_BOXED_INT: return sizeof(ObjBoxedInt);
+        case OBJ_STRING_BUILDER:
+            return sizeof(ObjStringBuilder) + (size_t)((ObjStringBuilder*)object)->capacity;
+        case OBJ_AST: return sizeof(ASTNode);
+        case OBJ_TYPE: return sizeof(Type);
+    }
+    return 0;
+}
+
+// Release an object and the buffers it owns, returning the bytes charged
+static size_t freeObject(Obj* object) {
+    size_t size = objectSize(object);
+    switch (object->type) {
+        case OBJ_STRING:
+            if (((ObjString*)object)->interned) {
+                removeInternedString((ObjString*)object);
+            }
+            break;
+        case OBJ_ARRAY: {
+            ObjArray* array = (ObjArray*)object;
+            if (array->elements != (Value*)(array + 1)) {
+                slabFree(array->elements,
+                         arrayElementSize((ArrayKind)array->kind) * (size_t)array->capacity);
+            }
+            slabFree(object, arraySize(array->inlineSize));
+            return size;
+        }
+        case OBJ_STRING_BUILDER: {
+            ObjStringBuilder* builder = (ObjStringBuilder*)object;
+            slabFree(builder->chars, (size_t)builder->capacity);
+            slabFree(object, sizeof(ObjStringBuilder));
+            return size;
+        }
+        default:
+            break;
+    }
+    slabFree(object, size);
+    return size;
+}
+
+void beginMarking() {
+    if (gcHeap) {
+        gcHeap->gc_phase = GC_PHASE_MARK;
+    }
+}
+
+bool traceGray(size_t budget) {
+    while (grayStack.count > 0 && budget > 0) {
+        int top = --grayStack.count;
+        if (snapshot) {
+            snapshotParent = snapshotGray[top];
+        }
+        blackenObject(grayStack.items[top]);
+        budget--;
+    }
+    // Whatever is marked next is reached from a root
+    snapshotParent = -1;
+    return grayStack.count == 0;
+}
+
+void beginSweep() {
+    if (!gcHeap) {
+        return;
+    }
+    // Survivors and objects allocated during the sweep go back on the heap
+    // list; only what was allocated before marking finished is swept
+    gcHeap->gc_sweep = gcHeap->objects;
+    gcHeap->objects = NULL;
+    gcHeap->gc_sweep_permanent = permanentObjects;
+    gcHeap->gc_phase = GC_PHASE_SWEEP;
+}
+
+bool sweepHeap(size_t budget) {
+    if (!gcHeap) {
+        return true;
+    }
+
+    while (gcHeap->gc_sweep && budget > 0) {
+        Obj* object = gcHeap->gc_sweep;
+        gcHeap->gc_sweep = object->next;
+        if (object->marked) {
+            object->marked = false;
+            object->next = gcHeap->objects;
+            gcHeap->objects = object;
+        } else {
+            size_t size = freeObject(object);
+            gcHeap->bytes_allocated -= size < gcHeap->bytes_allocated ?
+                                       size : gcHeap->bytes_allocated;
+        }
+        budget--;
+    }
+
+    // Permanent objects were only traced through
+    while (!gcHeap->gc_sweep && gcHeap->gc_sweep_permanent && budget > 0) {
+        gcHeap->gc_sweep_permanent->marked = false;
+        gcHeap->gc_sweep_permanent = gcHeap->gc_sweep_permanent->next;
+        budget--;
+    }
+
+    if (gcHeap->gc_sweep || gcHeap->gc_sweep_permanent) {
+        return false;
+    }
+    gcHeap->gc_phase = GC_PHASE_IDLE;
+    return true;
 }
 
 void collectGarbage() {
-    // No-op for tests
+    if (!gcHeap) {
+        return;
+    }
+
+    // Trace from the roots marked by registervm_gc_mark_roots
+    traceGray(SIZE_MAX);
+    beginSweep();
+    sweepHeap(SIZE_MAX);
 }
 
 void freeObjects() {
-    // No-op for tests
+    if (!gcHeap) {
+        return;
+    }
+
+    Obj* lists[] = { gcHeap->objects, gcHeap->gc_sweep };
+    for (int i = 0; i < 2; i++) {
+        Obj* object = lists[i];
+        while (object) {
+            Obj* next = object->next;
+            freeObject(object);
+            object = next;
+        }
+    }
+    gcHeap->objects = NULL;
+    gcHeap->gc_sweep = NULL;
+    gcHeap->gc_sweep_permanent = NULL;
+    gcHeap->gc_phase = GC_PHASE_IDLE;
+    gcHeap->bytes_allocated = 0;
+
+    // Nursery objects own no buffers; dropping them is enough
+    gcHeap->nursery_top = gcHeap->nursery;
+    gcHeap->remembered_count = 0;
+
+    freeObjStack(&grayStack);
+    freeObjStack(&promotedStack);
 }
 
 void pauseGC() {
-    // No-op for tests
+    gcPauseDepth++;
 }
 
 void resumeGC() {
-    // No-op for tests
+    if (gcPauseDepth > 0) {
+        gcPauseDepth--;
+    }
 }
 
+bool isGCPaused() {
+    return gcPauseDepth > 0;
+}
 
 char* copyString(const char* chars, int length) {
     char* copy = malloc(length + 1);
     memcpy(copy, chars, length);
     copy[length] = '\0';
     return copy;
-}
\ No newline at end of file
+}
@@ -27,31 +27,100 @@ void* reallocate(void* pointer, size_t oldSize, size_t newSize) {
 
 // Allocate string object
 ObjString* allocateString(const char* chars, int length) {
-    ObjString* string = malloc(sizeof(ObjString));
+    ObjString* string = malloc(sizeof(ObjString) + length + 1);
+    string->obj.type = OBJ_STRING;
     string->length = length;
-    string->chars = malloc(length + 1);
+    string->hash = hashString(chars, length);
+    string->interned = false;
     memcpy(string->chars, chars, length);
     string->chars[length] = '\0';
     return string;
 }
 
+void initSmallStrings() {
+}
+
+uint32_t hashString(const char* chars, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// No intern table in tests; strings compare by contents
+ObjString* internString(const char* chars, int length) {
+    return allocateString(chars, length);
+}
+
+ObjString* findInternedString(const char* chars, int length) {
+    (void)chars;
+    (void)length;
+    return NULL;
+}
+
 // Allocate array object
 ObjArray* allocateArray(int length) {
-    ObjArray* array = malloc(sizeof(ObjArray));
+    int capacity = length > 0 ? length : 8;
+    ObjArray* array = malloc(sizeof(ObjArray) + sizeof(Value) * capacity);
+    array->obj.type = OBJ_ARRAY;
     array->length = length;
-    array->capacity = length > 0 ? length : 8;
-    array->elements = malloc(sizeof(Value) * array->capacity);
+    array->capacity = capacity;
+    array->inlineSize = (int)(sizeof(Value) * capacity);
+    array->shape = 0;
+    array->kind = ARRAY_VALUES;
+    array->elements = (Value*)(array + 1);
     for (int i = 0; i < array->capacity; i++) {
         array->elements[i] = NIL_VAL;
     }
     return array;
 }
 
+// Arrays are never packed in tests
+ObjArray* allocateArrayOfKind(ArrayKind kind, int length) {
+    (void)kind;
+    return allocateArray(length);
+}
+
+size_t arrayElementSize(ArrayKind kind) {
+    (void)kind;
+    return sizeof(Value);
+}
+
+ArrayKind arrayKindOf(Value value) {
+    (void)value;
+    return ARRAY_VALUES;
+}
+
+Value arrayGet(ObjArray* array, int index) {
+    return array->elements[index];
+}
+
+bool arraySet(ObjArray* array, int index, Value value) {
+    array->elements[index] = value;
+    return true;
+}
+
+bool arrayPush(ObjArray* array, Value value) {
+    // Test arrays cannot grow
+    if (array->length >= array->capacity) {
+        return false;
+    }
+    array->elements[array->length++] = value;
+    return true;
+}
+
+Value arrayPop(ObjArray* array) {
+    return array->length > 0 ? array->elements[--array->length] : NIL_VAL;
+}
+
 // Allocate integer array object
 ObjIntArray* allocateIntArray(int length) {
-    ObjIntArray* array = malloc(sizeof(ObjIntArray));
+    ObjIntArray* array = malloc(sizeof(ObjIntArray) + sizeof(int64_t) * length);
+    array->obj.type = OBJ_INT_ARRAY;
     array->length = length;
-    array->elements = malloc(sizeof(int64_t) * length);
+    array->elements = (int64_t*)(array + 1);
     memset(array->elements, 0, sizeof(int64_t) * length);
     return array;
 }
@@ -59,20 +128,69 @@ ObjIntArray* allocateIntArray(int length) {
 // Allocate range iterator
 ObjRangeIterator* allocateRangeIterator(int64_t start, int64_t end) {
     ObjRangeIterator* it = malloc(sizeof(ObjRangeIterator));
+    it->obj.type = OBJ_RANGE_ITERATOR;
     it->current = start;
     it->end = end;
     return it;
 }
 
+ObjString* concatenateStrings(ObjString* a, ObjString* b) {
+    char* chars = malloc(a->length + b->length + 1);
+    memcpy(chars, a->chars, a->length);
+    memcpy(chars + a->length, b->chars, b->length);
+    ObjString* string = allocateString(chars, a->length + b->length);
+    free(chars);
+    return string;
+}
+
+// Allocate string builder
+ObjStringBuilder* allocateStringBuilder(ObjString* seed) {
+    ObjStringBuilder* builder = malloc(sizeof(ObjStringBuilder));
+    builder->obj.type = OBJ_STRING_BUILDER;
+    builder->length = seed->length;
+    builder->capacity = seed->length + 1;
+    builder->chars = malloc(builder->capacity);
+    memcpy(builder->chars, seed->chars, builder->capacity);
+    return builder;
+}
+
+bool appendStringBuilder(ObjStringBuilder* builder, const char* chars, int length) {
+    int needed = builder->length + length + 1;
+    if (needed > builder->capacity) {
+        char* grown = realloc(builder->chars, needed * 2);
+        if (!grown) return false;
+        builder->chars = grown;
+        builder->capacity = needed * 2;
+    }
+    memcpy(builder->chars + builder->length, chars, length);
+    builder->length += length;
+    builder->chars[builder->length] = '\0';
+    return true;
+}
+
+ObjString* finishStringBuilder(ObjStringBuilder* builder) {
+    return allocateString(builder->chars, builder->length);
+}
+
 // Allocate error object
 ObjError* allocateError(ErrorType type, const char* message, SrcLocation location) {
     ObjError* err = malloc(sizeof(ObjError));
+    err->obj.type = OBJ_ERROR;
     err->type = type;
     err->message = allocateString(message, (int)strlen(message));
     err->location = location;
     return err;
 }
 
+// Allocate out-of-line 64-bit integer (NaN-boxed builds only)
+ObjBoxedInt* allocateBoxedInt(ValueType type, uint64_t bits) {
+    ObjBoxedInt* boxed = malloc(sizeof(ObjBoxedInt));
+    boxed->obj.type = OBJ_BOXED_INT;
+    boxed->type = type;
+    boxed->as.u64 = bits;
+    return boxed;
+}
+
 // Allocate AST node
 ASTNode* allocateASTNode() {
     ASTNode* node = malloc(sizeof(ASTNode));
@@ -85,15 +203,41 @@ Type* allocateType() {
     return malloc(sizeof(Type));
 }
 
+Type* allocatePromotedType() {
+    return malloc(sizeof(Type));
+}
+
+// No compile arena in tests; everything is malloced
+void beginCompileArena() {
+}
+
+void endCompileArena() {
+}
+
+bool compileArenaActive() {
+    return false;
+}
+
+void* arenaAllocate(size_t size) {
+    (void)size;
+    return NULL;
+}
+
+bool inCompileArena(const void* pointer) {
+    (void)pointer;
+    return false;
+}
+
 // Allocate enum object
 ObjEnum* allocateEnum(int variantIndex, Value* data, int dataCount, ObjString* typeName) {
-    ObjEnum* enumValue = malloc(sizeof(ObjEnum));
+    ObjEnum* enumValue = malloc(sizeof(ObjEnum) + sizeof(Value) * dataCount);
+    enumValue->obj.type = OBJ_ENUM;
     enumValue->variantIndex = variantIndex;
     enumValue->dataCount = dataCount;
     enumValue->typeName = typeName;
     
     if (dataCount > 0) {
-        enumValue->data = malloc(sizeof(Value) * dataCount);
+        enumValue->data = (Value*)(enumValue + 1);
         for (int i = 0; i < dataCount; i++) {
             enumValue->data[i] = data[i];
         }
@@ -113,6 +257,11 @@ void markObject(Obj* object) {
     // No-op for tests
 }
 
+void setGCHeap(struct RegisterVM* vm) {
+    // No heap to attach in tests
+    (void)vm;
+}
+
 void collectGarbage() {
     // No-op for tests
 }
@@ -121,6 +270,26 @@ void freeObjects() {
     // No-op for tests
 }
 
+size_t objectSize(Obj* object) {
+    (void)object;
+    return 0;
+}
+
+void beginHeapSnapshot(HeapSnapshot* snapshot) {
+    snapshot->entries = NULL;
+    snapshot->count = 0;
+    snapshot->capacity = 0;
+}
+
+void endHeapSnapshot() {
+    // Nothing is marked in tests
+}
+
+void freeHeapSnapshot(HeapSnapshot* snapshot) {
+    free(snapshot->entries);
+    snapshot->entries = NULL;
+}
+
 void pauseGC() {
     // No-op for tests
 }
@@ -129,6 +298,10 @@ void resumeGC() {
     // No-op for tests
 }
 
+bool isGCPaused() {
+    return false;
+}
+
 
 char* copyString(const char* chars, int length) {
     char* copy = malloc(length + 1);
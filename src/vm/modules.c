@@ -5,38 +5,279 @@
 #include "../../include/modules.h"
 #include "../../include/file_utils.h"
 #include "../../include/parser.h"
+#include "../../include/scanner.h"
 #include "../../include/compiler.h"
+#include "../../include/vm.h"
 #include "../../include/register_vm.h"
+#include "../../include/register_chunk.h"
 #include "../../include/builtin_stdlib.h"
-#include "../../include/bytecode_io.h"
+#include "../../include/memory.h"
+#include "../../include/version.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <errno.h>
 #include <limits.h>
+#include <poll.h>
+#include <signal.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-static Module module_cache[UINT8_COUNT];
-static uint8_t module_cache_count = 0;
-static const char* loading_stack[UINT8_COUNT];
-static uint8_t loading_stack_count = 0;
+// Loaded modules in load order, indexed by path in module_table
+static Module** modules = NULL;
+static int module_count = 0;
+static int module_capacity = 0;
+static NameTable module_table = {NULL, 0, 0};
+// Paths of the modules being compiled, to detect import cycles
+static NameTable loading_table = {NULL, 0, 0};
 
 bool traceImports = false;
+uint32_t moduleOptimizationLevel = 0;
+int moduleBuildJobs = 1;
 
 const char* moduleError = NULL;
 static char module_error_buffer[256];
 
+// Content keys of the modules seen so far, see module_content_key
+typedef struct {
+    char* path;
+    uint64_t key;
+} ContentKey;
+
+static NameTable content_key_table = {NULL, 0, 0};
+
 // extern VM vm;
 
-static char* cache_path_for(const char* module_path) {
+static NameEntry* find_entry(NameEntry* entries, int capacity, const char* key,
+                             uint32_t hash) {
+    NameEntry* removed = NULL;
+    for (uint32_t index = hash & (capacity - 1);; index = (index + 1) & (capacity - 1)) {
+        NameEntry* entry = &entries[index];
+        if (!entry->key) return removed ? removed : entry;
+        if (!entry->value) {
+            if (!removed) removed = entry;
+        } else if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+    }
+}
+
+/**
+ * Look up a name.
+ *
+ * @param table Table to search.
+ * @param key   Name to find.
+ * @return      Value stored for the name, or NULL.
+ */
+static void* name_table_get(const NameTable* table, const char* key) {
+    if (table->count == 0) return NULL;
+    uint32_t hash = hashString(key, (int)strlen(key));
+    NameEntry* entry = find_entry(table->entries, table->capacity, key, hash);
+    return entry->key ? entry->value : NULL;
+}
+
+/**
+ * Insert or replace a name. The table grows at three quarters full,
+ * counting removed entries, which growing drops.
+ *
+ * @param table Table to update.
+ * @param key   Name; must outlive the entry.
+ * @param value Non-NULL value.
+ * @return      False if the table could not grow.
+ */
+static bool name_table_set(NameTable* table, const char* key, void* value) {
+    if ((table->count + 1) * 4 > table->capacity * 3) {
+        int capacity = table->capacity < 16 ? 16 : table->capacity * 2;
+        NameEntry* entries = calloc((size_t)capacity, sizeof(NameEntry));
+        if (!entries) return false;
+        int count = 0;
+        for (int i = 0; i < table->capacity; i++) {
+            NameEntry* entry = &table->entries[i];
+            if (!entry->key || !entry->value) continue;
+            *find_entry(entries, capacity, entry->key, entry->hash) = *entry;
+            count++;
+        }
+        free(table->entries);
+        table->entries = entries;
+        table->count = count;
+        table->capacity = capacity;
+    }
+    uint32_t hash = hashString(key, (int)strlen(key));
+    NameEntry* entry = find_entry(table->entries, table->capacity, key, hash);
+    if (!entry->key) table->count++;
+    entry->key = key;
+    entry->hash = hash;
+    entry->value = value;
+    return true;
+}
+
+static void name_table_remove(NameTable* table, const char* key) {
+    if (table->count == 0) return;
+    uint32_t hash = hashString(key, (int)strlen(key));
+    NameEntry* entry = find_entry(table->entries, table->capacity, key, hash);
+    if (entry->key) entry->value = NULL;
+}
+
+#define FNV64_OFFSET 14695981039346656037ULL
+#define FNV64_PRIME 1099511628211ULL
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Find the paths of the modules a source uses from its tokens alone: a
+ * `use` starting a line, followed by `a::b::c`, names "a/b/c.orus", as
+ * useStatement builds it. Far cheaper than parsing the module.
+ *
+ * @param source Module source.
+ * @param count  Set to the number of paths found.
+ * @return       Newly allocated array of newly allocated paths, or NULL if
+ *               there are none or memory ran out.
+ */
+static char** scan_use_paths(const char* source, int* count) {
+    char** paths = NULL;
+    int capacity = 0;
+    *count = 0;
+
+    Scanner scanner;
+    init_scanner(&scanner, source);
+    bool lineStart = true;
+    for (Token token = scan_token(&scanner); token.type != TOKEN_EOF;
+         token = scan_token(&scanner)) {
+        bool isUse = lineStart && token.type == TOKEN_USE;
+        lineStart = token.type == TOKEN_NEWLINE;
+        if (!isUse) continue;
+
+        char path[PATH_MAX];
+        size_t length = 0;
+        token = scan_token(&scanner);
+        while (token.type == TOKEN_IDENTIFIER &&
+               length + (size_t)token.length + sizeof("/.orus") <= sizeof(path)) {
+            memcpy(path + length, token.start, (size_t)token.length);
+            length += (size_t)token.length;
+            token = scan_token(&scanner);
+            if (token.type != TOKEN_DOUBLE_COLON) break;
+            path[length++] = '/';
+            token = scan_token(&scanner);
+        }
+        lineStart = token.type == TOKEN_NEWLINE;
+        if (length == 0 || path[length - 1] == '/') continue;
+        memcpy(path + length, ".orus", sizeof(".orus"));
+
+        if (*count == capacity) {
+            capacity = capacity < 8 ? 8 : capacity * 2;
+            char** grown = realloc(paths, sizeof(char*) * (size_t)capacity);
+            if (!grown) break;
+            paths = grown;
+        }
+        paths[*count] = strdup(path);
+        if (paths[*count]) (*count)++;
+    }
+    return paths;
+}
+
+/**
+ * Hash a module's source together with the content keys of the modules it
+ * uses, so that changing any module changes the key of every importer.
+ * Imports are found by scan_use_paths; the module is not parsed.
+ *
+ * @param path  Module path as written in `use`.
+ * @param depth Import nesting, to stop on cycles.
+ * @return      Content key, or 0 if the module or an import is missing.
+ */
+static uint64_t module_content_key(const char* path, int depth) {
+    ContentKey* known = name_table_get(&content_key_table, path);
+    if (known) return known->key;
+    if (depth >= UINT8_COUNT) return 0;
+
+    char* source = load_module_with_fallback(path, NULL, NULL, NULL);
+    if (!source) return 0;
+    uint64_t key = hash_bytes(FNV64_OFFSET, source, strlen(source));
+
+    int use_count;
+    char** uses = scan_use_paths(source, &use_count);
+    free(source);
+    for (int i = 0; i < use_count; i++) {
+        uint64_t import_key = key ? module_content_key(uses[i], depth + 1) : 0;
+        key = import_key ? hash_bytes(key, &import_key, sizeof(import_key)) : 0;
+        free(uses[i]);
+    }
+    free(uses);
+
+    ContentKey* entry = key ? malloc(sizeof(ContentKey)) : NULL;
+    if (entry) {
+        entry->path = strdup(path);
+        entry->key = key;
+        if (!entry->path || !name_table_set(&content_key_table, entry->path, entry)) {
+            free(entry->path);
+            free(entry);
+        }
+    }
+    return key;
+}
+
+/**
+ * Path of the cached register chunk for a module.
+ *
+ * The file name carries a hash of everything the compiled code depends on:
+ * the module and its imports (module_content_key), the compiler and image
+ * versions, the optimization level and the first global slot of the module,
+ * since its code addresses globals by absolute index. A stale entry is thus
+ * never found rather than detected.
+ *
+ * @param module_path  Module path as written in `use`.
+ * @param first_global Global slot the module's declarations start at.
+ * @return             Newly allocated path, or NULL without a cache.
+ */
+static char* cache_path_for(const char* module_path, int first_global) {
     if (!vm.cachePath) return NULL;
+    uint64_t key = module_content_key(module_path, 0);
+    if (!key) return NULL;
+    uint32_t image_version = ORBC_IMAGE_VERSION;
+    key = hash_bytes(key, ORUS_VERSION, strlen(ORUS_VERSION));
+    key = hash_bytes(key, &image_version, sizeof(image_version));
+    key = hash_bytes(key, &moduleOptimizationLevel, sizeof(moduleOptimizationLevel));
+    key = hash_bytes(key, &first_global, sizeof(first_global));
+
     const char* base = strrchr(module_path, '/');
     base = base ? base + 1 : module_path;
     char buf[512];
-    snprintf(buf, sizeof(buf), "%s/%s.obc", vm.cachePath, base);
+    snprintf(buf, sizeof(buf), "%s/%s-%016llx.orbc", vm.cachePath, base,
+             (unsigned long long)key);
     return strdup(buf);
 }
 
+/**
+ * Write a module's register chunk to the cache. The image goes to a file
+ * private to this process first and is renamed into place, so concurrent
+ * compiles never see a partly written entry.
+ *
+ * @param chunk      Compiled and optimized chunk.
+ * @param cache_file Path from cache_path_for.
+ * @return           True if the entry was written.
+ */
+static bool write_cache_file(const RegisterChunk* chunk, const char* cache_file) {
+    char temp[560];
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", cache_file, (long)getpid());
+    if (!register_chunk_write_file(chunk, temp)) {
+        unlink(temp);
+        return false;
+    }
+    if (rename(temp, cache_file) != 0) {
+        unlink(temp);
+        return false;
+    }
+    return true;
+}
+
 /**
  * Read a module's source code from disk.
  *
@@ -128,24 +369,17 @@ Chunk* compile_module_ast(ASTNode* ast, const char* module_name) {
  * @return            Newly allocated register chunk or NULL on error.
  */
 RegisterChunk* compile_module_ast_to_register(ASTNode* ast, const char* module_name) {
-    // First compile to stack VM bytecode
-    Chunk* stackChunk = compile_module_ast(ast, module_name);
-    if (!stackChunk) return NULL;
-    
-    // Then convert to register IR
     RegisterChunk* regChunk = malloc(sizeof(RegisterChunk));
-    if (!regChunk) {
-        freeChunk(stackChunk);
-        free(stackChunk);
+    if (!regChunk) return NULL;
+    if (!register_chunk_init(regChunk, module_name)) {
+        free(regChunk);
+        return NULL;
+    }
+    if (!compileToRegisterDirect(ast, regChunk, module_name, NULL, false)) {
+        register_chunk_free(regChunk);
+        free(regChunk);
         return NULL;
     }
-    
-    chunkToRegisterIR(stackChunk, regChunk);
-    
-    // Clean up stack chunk
-    freeChunk(stackChunk);
-    free(stackChunk);
-    
     return regChunk;
 }
 
@@ -156,11 +390,264 @@ RegisterChunk* compile_module_ast_to_register(ASTNode* ast, const char* module_n
  * @return       True on success.
  */
 bool register_module(Module* module) {
-    if (module_cache_count == UINT8_MAX) return false;
-    module_cache[module_cache_count++] = *module;
+    if (module_count == module_capacity) {
+        int capacity = GROW_CAPACITY(module_capacity);
+        Module** grown = realloc(modules, sizeof(Module*) * (size_t)capacity);
+        if (!grown) return false;
+        modules = grown;
+        module_capacity = capacity;
+    }
+    Module* entry = malloc(sizeof(Module));
+    if (!entry) return false;
+    *entry = *module;
+    if (!name_table_set(&module_table, entry->module_name, entry)) {
+        free(entry);
+        return false;
+    }
+    modules[module_count++] = entry;
+    return true;
+}
+
+// Bytes read from a build process
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+} BuildOutput;
+
+// A module compiled in a child process. The child writes the module's
+// image to `image_fd` and its diagnostics to `error_fd`.
+typedef struct {
+    char* module_name;
+    pid_t pid;             // 0 once the child has been waited for
+    int image_fd;
+    int error_fd;
+    BuildOutput image;
+    BuildOutput errors;
+    int global_count;      // Globals after the parent type-checked the module
+    bool succeeded;
+    bool discarded;        // The parent rejected the module itself
+} ModuleBuild;
+
+static ModuleBuild* builds = NULL;
+static int build_count = 0;
+static int build_capacity = 0;
+// Builds before this one have been waited for
+static int builds_waited = 0;
+
+/**
+ * Read what is available on a build's pipe.
+ *
+ * @return False at end of file, on error or when memory runs out.
+ */
+static bool read_build_output(int fd, BuildOutput* output) {
+    if (output->length == output->capacity) {
+        size_t capacity = output->capacity < 4096 ? 4096 : output->capacity * 2;
+        uint8_t* grown = realloc(output->data, capacity);
+        if (!grown) return false;
+        output->data = grown;
+        output->capacity = capacity;
+    }
+    ssize_t count = read(fd, output->data + output->length, output->capacity - output->length);
+    if (count < 0 && errno == EINTR) return true;
+    if (count <= 0) return false;
+    output->length += (size_t)count;
+    return true;
+}
+
+/**
+ * Read a build's image and diagnostics until the child closes both
+ * pipes, then reap it. Both pipes are read together so that a child
+ * blocked on one never stalls the other.
+ */
+static void wait_for_build(ModuleBuild* build) {
+    struct pollfd fds[2] = {
+        { build->image_fd, POLLIN, 0 },
+        { build->error_fd, POLLIN, 0 },
+    };
+    BuildOutput* outputs[2] = { &build->image, &build->errors };
+    while (fds[0].fd >= 0 || fds[1].fd >= 0) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < 2; i++) {
+            // poll skips negative descriptors
+            if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+            if (!read_build_output(fds[i].fd, outputs[i])) {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+            }
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        if (fds[i].fd >= 0) close(fds[i].fd);
+    }
+    int status;
+    build->succeeded = waitpid(build->pid, &status, 0) == build->pid &&
+                       WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    build->pid = 0;
+}
+
+static bool write_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = write(fd, data, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        data += count;
+        size -= (size_t)count;
+    }
     return true;
 }
 
+/**
+ * Body of a build process: compile and optimize the module, add it to the
+ * cache and send its image to the parent. Never returns.
+ */
+static void run_module_build(ASTNode* ast, const char* path, const char* cache_file,
+                             int image_fd) {
+    // Imports the parent has not loaded are compiled here rather than in
+    // further processes
+    moduleBuildJobs = 1;
+    RegisterChunk* chunk = compile_module_ast_to_register(ast, path);
+    bool ok = chunk != NULL;
+    if (ok) {
+        register_chunk_optimize(chunk, moduleOptimizationLevel);
+        if (cache_file) write_cache_file(chunk, cache_file);
+        uint8_t* image;
+        size_t size;
+        ok = register_chunk_serialize(chunk, &image, &size) && write_all(image_fd, image, size);
+    }
+    fflush(stderr);
+    _exit(ok ? 0 : 1);
+}
+
+/**
+ * Start compiling a module in a child process, waiting for the oldest
+ * build first when moduleBuildJobs are already running.
+ *
+ * @return Index of the build, or -1 if no process could be started.
+ */
+static int start_module_build(ASTNode* ast, const char* path, const char* cache_file) {
+    if (build_count == build_capacity) {
+        int capacity = GROW_CAPACITY(build_capacity);
+        ModuleBuild* grown = realloc(builds, sizeof(ModuleBuild) * (size_t)capacity);
+        if (!grown) return -1;
+        builds = grown;
+        build_capacity = capacity;
+    }
+    while (build_count - builds_waited >= moduleBuildJobs) {
+        wait_for_build(&builds[builds_waited++]);
+    }
+
+    char* module_name = strdup(path);
+    int image_pipe[2];
+    int error_pipe[2];
+    if (!module_name) return -1;
+    if (pipe(image_pipe) != 0) {
+        free(module_name);
+        return -1;
+    }
+    if (pipe(error_pipe) != 0) {
+        close(image_pipe[0]);
+        close(image_pipe[1]);
+        free(module_name);
+        return -1;
+    }
+
+    // The child must not flush output buffered before the fork
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(image_pipe[0]);
+        close(error_pipe[0]);
+        dup2(error_pipe[1], STDERR_FILENO);
+        close(error_pipe[1]);
+        run_module_build(ast, path, cache_file, image_pipe[1]);
+    }
+    close(image_pipe[1]);
+    close(error_pipe[1]);
+    if (pid < 0) {
+        close(image_pipe[0]);
+        close(error_pipe[0]);
+        free(module_name);
+        return -1;
+    }
+
+    ModuleBuild* build = &builds[build_count];
+    memset(build, 0, sizeof(ModuleBuild));
+    build->module_name = module_name;
+    build->pid = pid;
+    build->image_fd = image_pipe[0];
+    build->error_fd = error_pipe[0];
+    return build_count++;
+}
+
+/**
+ * Collect the modules built in child processes.
+ *
+ * Each module's image replaces its missing chunk. A child's diagnostics
+ * are printed only if it failed; when the parent rejected the module
+ * itself, it has already reported why and the child's output is dropped.
+ */
+bool finish_module_builds(void) {
+    bool ok = true;
+    for (int i = 0; i < build_count; i++) {
+        ModuleBuild* build = &builds[i];
+        if (build->pid > 0) wait_for_build(build);
+        Module* module = build->discarded ? NULL : get_module(build->module_name);
+        if (module) {
+            RegisterChunk* chunk = build->succeeded ? malloc(sizeof(RegisterChunk)) : NULL;
+            bool loaded = chunk && register_chunk_deserialize(build->image.data,
+                                                              build->image.length, chunk);
+            if (loaded && chunk->global_count != build->global_count) {
+                fprintf(stderr, "Error in module %s: compiled code does not match its globals\n",
+                        build->module_name);
+                register_chunk_free(chunk);
+                loaded = false;
+            }
+            if (loaded) {
+                module->regBytecode = chunk;
+            } else {
+                free(chunk);
+                fwrite(build->errors.data, 1, build->errors.length, stderr);
+                if (build->errors.length == 0) {
+                    fprintf(stderr, "Error in module %s: compilation failed\n",
+                            build->module_name);
+                }
+                ok = false;
+            }
+            module->unfinished = false;
+        }
+        free(build->module_name);
+        free(build->image.data);
+        free(build->errors.data);
+    }
+    build_count = 0;
+    builds_waited = 0;
+    return ok;
+}
+
+/**
+ * Load the modules a module imports before the module itself, so that a
+ * build process compiling it finds them all loaded.
+ *
+ * @param source Module source.
+ * @return       Result of the first import that failed, or INTERPRET_OK.
+ */
+static InterpretResult load_imports(const char* source) {
+    int count;
+    char** paths = scan_use_paths(source, &count);
+    InterpretResult result = INTERPRET_OK;
+    for (int i = 0; i < count; i++) {
+        if (result == INTERPRET_OK) result = compile_module_only(paths[i]);
+        free(paths[i]);
+    }
+    free(paths);
+    return result;
+}
+
 /**
  * Retrieve a loaded module by name.
  *
@@ -168,12 +655,27 @@ bool register_module(Module* module) {
  * @return     Pointer to cached module or NULL.
  */
 Module* get_module(const char* name) {
-    for (int i = 0; i < module_cache_count; i++) {
-        if (strcmp(module_cache[i].module_name, name) == 0) {
-            return &module_cache[i];
-        }
-    }
-    return NULL;
+    return name_table_get(&module_table, name);
+}
+
+/**
+ * Number of loaded modules.
+ *
+ * @return Module count.
+ */
+int get_module_count(void) {
+    return module_count;
+}
+
+/**
+ * Retrieve a loaded module by load order. A module is registered once it
+ * is compiled, so it comes after every module it imports.
+ *
+ * @param index Position in load order.
+ * @return      Pointer to cached module or NULL.
+ */
+Module* get_module_at(int index) {
+    return index >= 0 && index < module_count ? modules[index] : NULL;
 }
 
 /**
@@ -184,12 +686,7 @@ Module* get_module(const char* name) {
  * @return       Pointer to export entry or NULL.
  */
 Export* get_export(Module* module, const char* name) {
-    for (int i = 0; i < module->export_count; i++) {
-        if (strcmp(module->exports[i].name, name) == 0) {
-            return &module->exports[i];
-        }
-    }
-    return NULL;
+    return name_table_get(&module->export_table, name);
 }
 
 /**
@@ -201,22 +698,19 @@ Export* get_export(Module* module, const char* name) {
 InterpretResult compile_module_only(const char* path) {
     moduleError = NULL;
     if (traceImports) fprintf(stderr, "[import] loading %s\n", path);
-    for (int i = 0; i < loading_stack_count; i++) {
-        if (strcmp(loading_stack[i], path) == 0) {
-            snprintf(module_error_buffer, sizeof(module_error_buffer),
-                     "Import cycle detected for module `%s`", path);
-            moduleError = module_error_buffer;
-            return INTERPRET_COMPILE_ERROR;
-        }
+    if (name_table_get(&loading_table, path)) {
+        snprintf(module_error_buffer, sizeof(module_error_buffer),
+                 "Import cycle detected for module `%s`", path);
+        moduleError = module_error_buffer;
+        return INTERPRET_COMPILE_ERROR;
     }
 
-    if (loading_stack_count < UINT8_MAX)
-        loading_stack[loading_stack_count++] = path;
-
     if (get_module(path)) {
-        loading_stack_count--;
         return INTERPRET_OK;
     }
+    if (!name_table_set(&loading_table, path, (void*)path)) {
+        return INTERPRET_COMPILE_ERROR;
+    }
 
     char* diskPath = NULL;
     long mtime = 0;
@@ -226,52 +720,85 @@ InterpretResult compile_module_only(const char* path) {
         snprintf(module_error_buffer, sizeof(module_error_buffer),
                  "Module `%s` not found", path);
         moduleError = module_error_buffer;
-        loading_stack_count--;
+        name_table_remove(&loading_table, path);
         return INTERPRET_RUNTIME_ERROR;
     }
 
-    int startGlobals = vm.variableCount;
-    char* cacheFile = cache_path_for(path);
-    Chunk* chunk = NULL;
-    if (cacheFile) {
-        long cached_mtime;
-        chunk = readChunkFromFile(cacheFile, &cached_mtime);
-        if (chunk && cached_mtime != mtime) { freeChunk(chunk); free(chunk); chunk = NULL; }
-    }
-    ASTNode* ast = NULL;
-    if (!chunk) {
-        ast = parse_module_source(source, path);
-        if (!ast) {
+    // Imports come first when modules are built in child processes
+    if (moduleBuildJobs > 1) {
+        InterpretResult imported = load_imports(source);
+        if (imported != INTERPRET_OK) {
             free(source);
-            loading_stack_count--;
-            if (cacheFile) free(cacheFile);
-            return INTERPRET_COMPILE_ERROR;
+            free(diskPath);
+            name_table_remove(&loading_table, path);
+            return imported;
         }
+    }
 
-        chunk = compile_module_ast(ast, path);
-        if (!chunk) {
-            free(source);
-            loading_stack_count--;
-            if (cacheFile) free(cacheFile);
-            return INTERPRET_COMPILE_ERROR;
+    int startGlobals = vm.variableCount;
+    char* cacheFile = cache_path_for(path, startGlobals);
+
+    // A cached register chunk replaces code generation, register allocation
+    // and optimization. The module is still parsed and type-checked: its
+    // declarations and their types live in the compiler's global tables,
+    // which importers resolve exports against, and are not part of the image.
+    RegisterChunk* regChunk = NULL;
+    if (cacheFile) {
+        regChunk = malloc(sizeof(RegisterChunk));
+        if (regChunk && !register_chunk_map_file(cacheFile, regChunk)) {
+            free(regChunk);
+            regChunk = NULL;
         }
-        if (cacheFile) writeChunkToFile(chunk, cacheFile, mtime);
+        if (traceImports && regChunk) fprintf(stderr, "[import] cached %s\n", cacheFile);
     }
 
-    // Compile to register IR as well
-    RegisterChunk* regChunk = NULL;
-    if (ast) {
+    // The module's AST lives until it is compiled; when imported from
+    // another compile it shares that compile's arena
+    beginCompileArena();
+    ASTNode* ast = parse_module_source(source, path);
+    bool compiled = ast != NULL;
+    // Without a cached chunk, a child process compiles the module from the
+    // parsed AST while this process type-checks it as for a cached one
+    int build = -1;
+    if (ast && !regChunk && moduleBuildJobs > 1) {
+        build = start_module_build(ast, path, cacheFile);
+    }
+    if (ast && (regChunk || build >= 0)) {
+        compiled = typeCheckModule(ast, path, source);
+        // Compiling reserves at least one global
+        int globalCount = vm.variableCount > 0 ? vm.variableCount : 1;
+        if (build >= 0 && !compiled) {
+            if (builds[build].pid > 0) kill(builds[build].pid, SIGKILL);
+            builds[build].discarded = true;
+        } else if (build >= 0) {
+            builds[build].global_count = globalCount;
+        } else if (compiled && regChunk->global_count != globalCount) {
+            // The key covers everything the slots depend on; a mismatch
+            // means the entry is unusable, so drop it for the next run
+            fprintf(stderr, "Warning: Cached register chunk for module %s does not match its globals, discarding it\n", path);
+            register_chunk_free(regChunk);
+            free(regChunk);
+            regChunk = NULL;
+            unlink(cacheFile);
+        }
+    } else if (ast) {
         regChunk = compile_module_ast_to_register(ast, path);
-        // If register compilation fails, we can still use stack VM
-        if (!regChunk) {
-            fprintf(stderr, "Warning: Register VM compilation failed for module %s, falling back to stack VM\n", path);
+        compiled = regChunk != NULL;
+        if (regChunk) {
+            register_chunk_optimize(regChunk, moduleOptimizationLevel);
+            if (cacheFile) write_cache_file(regChunk, cacheFile);
         }
-    } else if (chunk) {
-        // If we loaded from cache, convert stack VM to register VM
-        regChunk = malloc(sizeof(RegisterChunk));
+    }
+    endCompileArena();
+    if (!compiled) {
         if (regChunk) {
-            chunkToRegisterIR(chunk, regChunk);
+            register_chunk_free(regChunk);
+            free(regChunk);
         }
+        free(source);
+        name_table_remove(&loading_table, path);
+        if (cacheFile) free(cacheFile);
+        return INTERPRET_COMPILE_ERROR;
     }
 
     Module mod;
@@ -283,27 +810,37 @@ InterpretResult compile_module_only(const char* path) {
     mod.name = (char*)malloc(len + 1);
     memcpy(mod.name, base, len);
     mod.name[len] = '\0';
-    mod.bytecode = chunk;
+    mod.bytecode = NULL;         // Modules are compiled to register code only
     mod.regBytecode = regChunk;  // Register VM bytecode
-    mod.export_count = 0;
     mod.executed = false;
     mod.disk_path = diskPath;
     mod.mtime = mtime;
     mod.from_embedded = fromEmbedded;
+    mod.unfinished = build >= 0;
 
-    for (int i = startGlobals; i < vm.variableCount && mod.export_count < UINT8_MAX; i++) {
+    // Exports are counted first so the table can point into their array
+    int exportCount = 0;
+    for (int i = startGlobals; i < vm.variableCount; i++) {
+        if (vm.variableNames[i].name && vm.publicGlobals[i]) exportCount++;
+    }
+    mod.exports = exportCount > 0 ? malloc(sizeof(Export) * (size_t)exportCount) : NULL;
+    mod.export_count = 0;
+    mod.export_table = (NameTable){NULL, 0, 0};
+    for (int i = startGlobals; i < vm.variableCount && mod.exports; i++) {
         Export ex;
         ex.name = vm.variableNames[i].name ? vm.variableNames[i].name->chars : NULL;
         if (ex.name && vm.publicGlobals[i]) {
             ex.name = strdup(ex.name);
             ex.value = vm.globals[i];
             ex.index = i;
-            mod.exports[mod.export_count++] = ex;
+            mod.exports[mod.export_count] = ex;
+            name_table_set(&mod.export_table, ex.name, &mod.exports[mod.export_count]);
+            mod.export_count++;
         }
     }
 
     register_module(&mod);
-    loading_stack_count--;
+    name_table_remove(&loading_table, path);
     free(source);
     if (cacheFile) free(cacheFile);
     return INTERPRET_OK;
@@ -16,9 +16,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "../../include/register_chunk.h"
 #include "../../include/register_opcodes.h"
+#include "../../include/register_vm.h"
 #include "../../include/memory.h"
 #include "../../include/value.h"
 
@@ -35,6 +40,9 @@
 /** CRC32 polynomial for checksum calculation */
 #define CRC32_POLYNOMIAL 0xEDB88320
 
+/** Verifier register state for registers whose type is not statically known */
+#define VERIFY_TYPE_UNKNOWN 0xFF
+
 // =============================================================================
 // PRIVATE FUNCTION DECLARATIONS
 // =============================================================================
@@ -44,10 +52,17 @@ static bool grow_constant_array(RegisterChunk* chunk);
 static bool grow_global_array(RegisterChunk* chunk);
 static bool grow_function_array(RegisterChunk* chunk);
 static bool grow_source_file_array(DebugInfo* debug);
+static bool grow_field_name_array(RegisterChunk* chunk);
+static bool grow_shape_array(RegisterChunk* chunk);
 static uint32_t calculate_crc32(const uint8_t* data, size_t length);
-static void free_function_info(FunctionInfo* func);
-static void free_module_info(ModuleInfo* module);
-static void free_debug_info(DebugInfo* debug);
+static bool owns_buffer(const RegisterChunk* chunk, const void* pointer);
+static void* resize_buffer(RegisterChunk* chunk, void* pointer,
+                           size_t old_size, size_t new_size);
+static void free_function_info(RegisterChunk* chunk, FunctionInfo* func);
+static void free_module_info(RegisterChunk* chunk, ModuleInfo* module);
+static void free_debug_info(RegisterChunk* chunk, DebugInfo* debug);
+static bool verify_instruction(const RegisterChunk* chunk, uint32_t address,
+                               uint8_t* types, uint32_t* targets, int* target_count);
 
 // =============================================================================
 // CHUNK LIFECYCLE FUNCTIONS
@@ -126,6 +141,7 @@ bool register_chunk_init(RegisterChunk* chunk, const char* module_name) {
     chunk->ref_count = 1;
     chunk->is_optimized = false;
     chunk->optimization_level = 0;
+    chunk->is_verified = false;
     chunk->checksum = 0;
     
     return true;
@@ -144,32 +160,51 @@ void register_chunk_free(RegisterChunk* chunk) {
     
     // Free arrays if we own the memory
     if (chunk->owns_memory) {
-        free(chunk->code);
+        register_chunk_release(chunk, chunk->code);
         free(chunk->constants);
         free(chunk->globals);
         
         // Free function info
         if (chunk->functions) {
             for (uint16_t i = 0; i < chunk->function_count; i++) {
-                free_function_info(&chunk->functions[i]);
+                free_function_info(chunk, &chunk->functions[i]);
             }
             free(chunk->functions);
         }
         
         // Free module info
         if (chunk->module) {
-            free_module_info(chunk->module);
+            free_module_info(chunk, chunk->module);
             free(chunk->module);
         }
         
         // Free debug info
         if (chunk->debug) {
-            free_debug_info(chunk->debug);
+            free_debug_info(chunk, chunk->debug);
             free(chunk->debug);
         }
         
         // Free register types
         free(chunk->register_types);
+        
+        // Free struct shapes and field names
+        for (uint16_t i = 0; i < chunk->field_name_count; i++) {
+            register_chunk_release(chunk, chunk->field_names[i]);
+        }
+        free(chunk->field_names);
+        for (uint16_t i = 0; i < chunk->shape_count; i++) {
+            register_chunk_release(chunk, chunk->shapes[i].name);
+            register_chunk_release(chunk, chunk->shapes[i].field_names);
+        }
+        free(chunk->shapes);
+        free(chunk->inline_caches);
+        
+        // The image goes last; everything above may point into it
+        if (chunk->image_mapped) {
+            munmap(chunk->image, chunk->image_size);
+        } else {
+            free(chunk->image);
+        }
     }
     
     // Clear the chunk
@@ -260,24 +295,34 @@ uint32_t register_chunk_add_instruction(RegisterChunk* chunk, uint32_t instructi
     // Add instruction
     uint32_t address = chunk->code_count;
     chunk->code[chunk->code_count++] = instruction;
+    chunk->is_verified = false;
+    chunk->checksum = 0; // A stored checksum no longer applies
     
     // Add debug info if enabled
-    if (chunk->debug) {
-        if (chunk->debug->location_count < chunk->code_count) {
-            // Grow location array
-            size_t new_capacity = chunk->code_count * 2;
-            SourceLocation* new_locations = realloc(chunk->debug->locations,
-                                                   new_capacity * sizeof(SourceLocation));
+    DebugInfo* debug = chunk->debug;
+    if (debug) {
+        if (debug->location_capacity < chunk->code_count) {
+            // Grow location array alongside the code
+            uint32_t new_capacity = chunk->code_capacity;
+            SourceLocation* new_locations = resize_buffer(chunk, debug->locations,
+                                                          debug->location_count * sizeof(SourceLocation),
+                                                          new_capacity * sizeof(SourceLocation));
             if (new_locations) {
-                chunk->debug->locations = new_locations;
+                debug->locations = new_locations;
+                debug->location_capacity = new_capacity;
             }
         }
         
-        if (chunk->debug->locations && chunk->debug->location_count < chunk->code_count) {
-            chunk->debug->locations[address].line = line;
-            chunk->debug->locations[address].column = column;
-            chunk->debug->locations[address].file_index = 0; // Default to first file
-            chunk->debug->location_count = chunk->code_count;
+        if (debug->locations && debug->location_capacity >= chunk->code_count) {
+            // Instructions added before debug info was enabled have none
+            if (debug->location_count < address) {
+                memset(debug->locations + debug->location_count, 0,
+                       (address - debug->location_count) * sizeof(SourceLocation));
+            }
+            debug->locations[address].line = line;
+            debug->locations[address].column = column;
+            debug->locations[address].file_index = 0; // Default to first file
+            debug->location_count = chunk->code_count;
         }
     }
     
@@ -297,9 +342,27 @@ bool register_chunk_set_instruction(RegisterChunk* chunk, uint32_t address,
         return false;
     }
     chunk->code[address] = instruction;
+    chunk->is_verified = false;
+    chunk->checksum = 0;
     return true;
 }
 
+void register_chunk_truncate(RegisterChunk* chunk, uint32_t count) {
+    if (!chunk || count >= chunk->code_count) {
+        return;
+    }
+    chunk->code_count = count;
+    if (chunk->debug && chunk->debug->location_count > count) {
+        chunk->debug->location_count = count;
+    }
+    while (chunk->function_count > 0 &&
+           chunk->functions[chunk->function_count - 1].start_address >= count) {
+        free_function_info(chunk, &chunk->functions[--chunk->function_count]);
+    }
+    chunk->is_verified = false;
+    chunk->checksum = 0;
+}
+
 uint32_t register_chunk_instruction_count(const RegisterChunk* chunk) {
     return chunk ? chunk->code_count : 0;
 }
@@ -313,6 +376,11 @@ uint32_t register_chunk_add_constant(RegisterChunk* chunk, Value value) {
         return UINT32_MAX;
     }
     
+    // Pending string constants would compare as nil
+    if (!register_chunk_materialize_strings(chunk)) {
+        return UINT32_MAX;
+    }
+    
     // Check if constant already exists
     uint32_t existing = register_chunk_find_constant(chunk, value);
     if (existing != UINT32_MAX) {
@@ -386,6 +454,7 @@ uint16_t register_chunk_add_function(RegisterChunk* chunk, const char* name,
     func->return_type = return_type;
     func->is_generic = false;
     func->is_exported = false;
+    func->global_index = UINT16_MAX;
     
     return index;
 }
@@ -463,6 +532,121 @@ bool register_chunk_set_global(RegisterChunk* chunk, uint16_t index, Value value
     return true;
 }
 
+// =============================================================================
+// STRUCT SHAPE MANAGEMENT
+// =============================================================================
+
+uint16_t register_chunk_add_field_name(RegisterChunk* chunk, const char* name) {
+    if (!chunk || !name) {
+        return UINT16_MAX;
+    }
+    
+    for (uint16_t i = 0; i < chunk->field_name_count; i++) {
+        if (strcmp(chunk->field_names[i], name) == 0) {
+            return i;
+        }
+    }
+    
+    if (chunk->field_name_count >= MAX_FIELD_NAMES) {
+        return UINT16_MAX;
+    }
+    if (chunk->field_name_count >= chunk->field_name_capacity) {
+        if (!grow_field_name_array(chunk)) {
+            return UINT16_MAX;
+        }
+    }
+    
+    char* copy = malloc(strlen(name) + 1);
+    if (!copy) {
+        return UINT16_MAX;
+    }
+    strcpy(copy, name);
+    chunk->field_names[chunk->field_name_count] = copy;
+    return chunk->field_name_count++;
+}
+
+uint16_t register_chunk_add_shape(RegisterChunk* chunk, const char* name,
+                                  const char* const* field_names, uint8_t field_count) {
+    if (!chunk || !name) {
+        return 0;
+    }
+    
+    for (uint16_t i = 0; i < chunk->shape_count; i++) {
+        if (strcmp(chunk->shapes[i].name, name) == 0) {
+            return (uint16_t)(i + 1);
+        }
+    }
+    
+    if (chunk->shape_count >= MAX_STRUCT_SHAPES) {
+        return 0;
+    }
+    if (chunk->shape_count >= chunk->shape_capacity) {
+        if (!grow_shape_array(chunk)) {
+            return 0;
+        }
+    }
+    
+    StructShape shape;
+    shape.name = malloc(strlen(name) + 1);
+    shape.field_names = malloc(field_count > 0 ? field_count : 1);
+    shape.field_count = field_count;
+    if (!shape.name || !shape.field_names) {
+        free(shape.name);
+        free(shape.field_names);
+        return 0;
+    }
+    strcpy(shape.name, name);
+    
+    for (uint8_t i = 0; i < field_count; i++) {
+        uint16_t field = register_chunk_add_field_name(chunk, field_names[i]);
+        if (field == UINT16_MAX) {
+            free(shape.name);
+            free(shape.field_names);
+            return 0;
+        }
+        shape.field_names[i] = (uint8_t)field;
+    }
+    
+    chunk->shapes[chunk->shape_count] = shape;
+    return ++chunk->shape_count;
+}
+
+int register_chunk_shape_slot(const RegisterChunk* chunk, uint16_t shape, uint8_t field) {
+    if (!chunk || shape == 0 || shape > chunk->shape_count) {
+        return -1;
+    }
+    
+    const StructShape* info = &chunk->shapes[shape - 1];
+    for (uint8_t i = 0; i < info->field_count; i++) {
+        if (info->field_names[i] == field) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool register_chunk_reset_inline_caches(RegisterChunk* chunk) {
+    if (!chunk) {
+        return false;
+    }
+    
+    free(chunk->inline_caches);
+    chunk->inline_caches = NULL;
+    chunk->inline_cache_count = 0;
+    
+    // Only field accesses use caches
+    if (chunk->field_name_count == 0 || chunk->code_count == 0) {
+        return true;
+    }
+    
+    chunk->inline_caches = calloc(chunk->code_count, sizeof(InlineCache));
+    if (!chunk->inline_caches) {
+        return false;
+    }
+    chunk->inline_cache_count = chunk->code_count;
+    return true;
+}
+
 // =============================================================================
 // DEBUG INFORMATION
 // =============================================================================
@@ -484,12 +668,13 @@ bool register_chunk_enable_debug(RegisterChunk* chunk) {
         chunk->debug->source_files = malloc(INITIAL_CAPACITY * sizeof(char*));
         
         if (!chunk->debug->locations || !chunk->debug->source_files) {
-            free_debug_info(chunk->debug);
+            free_debug_info(chunk, chunk->debug);
             free(chunk->debug);
             chunk->debug = NULL;
             return false;
         }
         
+        chunk->debug->location_capacity = INITIAL_CAPACITY;
         chunk->debug->source_file_capacity = INITIAL_CAPACITY;
     }
     
@@ -542,6 +727,1164 @@ const char* register_chunk_get_source_file(const RegisterChunk* chunk, uint16_t
     return chunk->debug->source_files[file_index];
 }
 
+// =============================================================================
+// MODULE MANAGEMENT
+// =============================================================================
+
+/**
+ * @brief Make room for one more entry in a module table
+ */
+static bool grow_module_table(void** table, uint16_t count, uint16_t* capacity, size_t size) {
+    if (count < *capacity) {
+        return true;
+    }
+    if (count == UINT16_MAX) {
+        return false;
+    }
+    uint32_t new_capacity = *capacity < INITIAL_CAPACITY ? INITIAL_CAPACITY : *capacity * GROWTH_FACTOR;
+    if (new_capacity > UINT16_MAX) {
+        new_capacity = UINT16_MAX;
+    }
+    void* grown = realloc(*table, new_capacity * size);
+    if (!grown) {
+        return false;
+    }
+    *table = grown;
+    *capacity = (uint16_t)new_capacity;
+    return true;
+}
+
+bool register_chunk_add_export(RegisterChunk* chunk, const char* name, uint32_t address,
+                              ValueType type, bool is_function) {
+    if (!chunk || !chunk->module || !name) {
+        return false;
+    }
+    ModuleInfo* module = chunk->module;
+    
+    // Re-exporting a name updates its entry
+    for (uint16_t i = 0; i < module->export_count; i++) {
+        if (strcmp(module->exports[i].name, name) == 0) {
+            module->exports[i].address = address;
+            module->exports[i].type = type;
+            module->exports[i].is_function = is_function;
+            return true;
+        }
+    }
+    
+    if (!grow_module_table((void**)&module->exports, module->export_count,
+                           &module->export_capacity, sizeof(ExportEntry))) {
+        return false;
+    }
+    char* copy = malloc(strlen(name) + 1);
+    if (!copy) {
+        return false;
+    }
+    strcpy(copy, name);
+    
+    ExportEntry* entry = &module->exports[module->export_count++];
+    entry->name = copy;
+    entry->address = address;
+    entry->type = type;
+    entry->is_function = is_function;
+    return true;
+}
+
+const ExportEntry* register_chunk_find_export(const RegisterChunk* chunk, const char* name) {
+    if (!chunk || !chunk->module || !name) {
+        return NULL;
+    }
+    
+    for (uint16_t i = 0; i < chunk->module->export_count; i++) {
+        if (strcmp(chunk->module->exports[i].name, name) == 0) {
+            return &chunk->module->exports[i];
+        }
+    }
+    return NULL;
+}
+
+bool register_chunk_add_import(RegisterChunk* chunk, const char* module_name,
+                              const char* symbol_name, uint32_t local_address,
+                              ValueType expected_type) {
+    if (!chunk || !chunk->module || !module_name || !symbol_name) {
+        return false;
+    }
+    ModuleInfo* module = chunk->module;
+    
+    for (uint16_t i = 0; i < module->import_count; i++) {
+        const ImportEntry* entry = &module->imports[i];
+        if (strcmp(entry->module_name, module_name) == 0 &&
+            strcmp(entry->symbol_name, symbol_name) == 0) {
+            return true;
+        }
+    }
+    
+    // Every imported module is also a dependency
+    bool known = false;
+    for (uint16_t i = 0; i < module->dependency_count && !known; i++) {
+        known = strcmp(module->dependencies[i], module_name) == 0;
+    }
+    if (!known) {
+        // Dependencies have no capacity field; the table grows by one
+        if (module->dependency_count == UINT16_MAX) {
+            return false;
+        }
+        char** dependencies = realloc(module->dependencies,
+                                      (module->dependency_count + 1) * sizeof(char*));
+        if (!dependencies) {
+            return false;
+        }
+        module->dependencies = dependencies;
+        char* copy = malloc(strlen(module_name) + 1);
+        if (!copy) {
+            return false;
+        }
+        strcpy(copy, module_name);
+        module->dependencies[module->dependency_count++] = copy;
+    }
+    
+    if (!grow_module_table((void**)&module->imports, module->import_count,
+                           &module->import_capacity, sizeof(ImportEntry))) {
+        return false;
+    }
+    ImportEntry entry;
+    entry.module_name = malloc(strlen(module_name) + 1);
+    entry.symbol_name = malloc(strlen(symbol_name) + 1);
+    if (!entry.module_name || !entry.symbol_name) {
+        free(entry.module_name);
+        free(entry.symbol_name);
+        return false;
+    }
+    strcpy(entry.module_name, module_name);
+    strcpy(entry.symbol_name, symbol_name);
+    entry.local_address = local_address;
+    entry.expected_type = expected_type;
+    module->imports[module->import_count++] = entry;
+    return true;
+}
+
+// =============================================================================
+// SERIALIZATION
+// =============================================================================
+
+/** Image header layout (see register_chunk.h) */
+#define ORBC_HEADER_SIZE 48
+#define ORBC_SECTION_ENTRY_SIZE 16
+#define ORBC_FLAG_DEBUG 0x1
+#define ORBC_NO_STRING UINT32_MAX
+
+/** Section ids; sections missing from an image are empty */
+typedef enum {
+    ORBC_SECTION_STRINGS = 1,      /**< NUL-terminated names and string constants */
+    ORBC_SECTION_CODE,             /**< Instructions */
+    ORBC_SECTION_CONSTANTS,        /**< Value records */
+    ORBC_SECTION_GLOBALS,          /**< Value records with the initial globals */
+    ORBC_SECTION_FUNCTIONS,        /**< Function records */
+    ORBC_SECTION_FIELD_NAMES,      /**< Name offsets */
+    ORBC_SECTION_SHAPES,           /**< Shape records */
+    ORBC_SECTION_SHAPE_FIELDS,     /**< Field name index per shape slot */
+    ORBC_SECTION_MODULE,           /**< One module record */
+    ORBC_SECTION_EXPORTS,          /**< Export records */
+    ORBC_SECTION_IMPORTS,          /**< Import records */
+    ORBC_SECTION_DEPENDENCIES,     /**< Name offsets */
+    ORBC_SECTION_LOCATIONS,        /**< SourceLocation records */
+    ORBC_SECTION_SOURCE_FILES,     /**< Name offsets */
+    ORBC_SECTION_COUNT
+} OrbcSection;
+
+/** Record size of each section, indexed by id */
+static const uint32_t orbc_record_sizes[ORBC_SECTION_COUNT] = {
+    [ORBC_SECTION_STRINGS] = 1,
+    [ORBC_SECTION_CODE] = 4,
+    [ORBC_SECTION_CONSTANTS] = 16,
+    [ORBC_SECTION_GLOBALS] = 16,
+    [ORBC_SECTION_FUNCTIONS] = 24,
+    [ORBC_SECTION_FIELD_NAMES] = 4,
+    [ORBC_SECTION_SHAPES] = 12,
+    [ORBC_SECTION_SHAPE_FIELDS] = 1,
+    [ORBC_SECTION_MODULE] = 24,
+    [ORBC_SECTION_EXPORTS] = 12,
+    [ORBC_SECTION_IMPORTS] = 16,
+    [ORBC_SECTION_DEPENDENCIES] = 4,
+    [ORBC_SECTION_LOCATIONS] = 8,
+    [ORBC_SECTION_SOURCE_FILES] = 4,
+};
+
+/** Value record tags: {u8 tag, u8 pad[3], u32 length, u64 payload} */
+typedef enum {
+    ORBC_VALUE_NIL,
+    ORBC_VALUE_BOOL,
+    ORBC_VALUE_I32,
+    ORBC_VALUE_I64,
+    ORBC_VALUE_U32,
+    ORBC_VALUE_U64,
+    ORBC_VALUE_F64,
+    ORBC_VALUE_STRING,  /**< Payload is the string's offset, length its size */
+} OrbcValueTag;
+
+typedef struct {
+    uint8_t* data;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} ImageBuffer;
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t count;
+} ImageSection;
+
+static bool host_is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+static uint16_t read_u16(const uint8_t* bytes) {
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t* bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+           ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static uint64_t read_u64(const uint8_t* bytes) {
+    return (uint64_t)read_u32(bytes) | ((uint64_t)read_u32(bytes + 4) << 32);
+}
+
+static void write_u16(uint8_t* bytes, uint16_t value) {
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+static void write_u32(uint8_t* bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void write_u64(uint8_t* bytes, uint64_t value) {
+    write_u32(bytes, (uint32_t)value);
+    write_u32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+static size_t align_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Append `size` zeroed bytes to a buffer
+ * 
+ * @return Pointer to them, or NULL (and the buffer marked failed)
+ */
+static uint8_t* image_append(ImageBuffer* buffer, size_t size) {
+    if (buffer->failed) {
+        return NULL;
+    }
+    if (buffer->count + size > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 256;
+        while (capacity < buffer->count + size) {
+            capacity *= GROWTH_FACTOR;
+        }
+        uint8_t* data = realloc(buffer->data, capacity);
+        if (!data) {
+            buffer->failed = true;
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    uint8_t* bytes = buffer->data + buffer->count;
+    memset(bytes, 0, size);
+    buffer->count += size;
+    return bytes;
+}
+
+/**
+ * @brief Add `length` bytes and a terminator to the string section
+ * 
+ * @return Offset of the string, or ORBC_NO_STRING for NULL
+ */
+static uint32_t image_add_string(ImageBuffer* strings, const char* chars, size_t length) {
+    if (!chars) {
+        return ORBC_NO_STRING;
+    }
+    if (strings->count + length + 1 >= ORBC_NO_STRING) {
+        strings->failed = true;
+        return ORBC_NO_STRING;
+    }
+    uint32_t offset = (uint32_t)strings->count;
+    uint8_t* bytes = image_append(strings, length + 1);
+    if (bytes) {
+        memcpy(bytes, chars, length);
+    }
+    return offset;
+}
+
+static uint32_t image_add_name(ImageBuffer* strings, const char* name) {
+    return image_add_string(strings, name, name ? strlen(name) : 0);
+}
+
+static void image_add_name_offset(ImageBuffer* section, ImageBuffer* strings,
+                                  const char* name) {
+    uint8_t* record = image_append(section, 4);
+    if (record) {
+        write_u32(record, image_add_name(strings, name));
+    }
+}
+
+/**
+ * @brief Locate a section of a validated image
+ * 
+ * @return false if the image has no such section
+ */
+static bool image_section(const uint8_t* image, OrbcSection id, ImageSection* section) {
+    uint32_t section_count = read_u32(image + 12);
+    const uint8_t* entry = image + ORBC_HEADER_SIZE;
+    for (uint32_t i = 0; i < section_count; i++, entry += ORBC_SECTION_ENTRY_SIZE) {
+        if (read_u32(entry) == (uint32_t)id) {
+            section->data = image + read_u32(entry + 8);
+            section->count = read_u32(entry + 4);
+            return true;
+        }
+    }
+    section->data = NULL;
+    section->count = 0;
+    return false;
+}
+
+/**
+ * @brief String stored by a string value record of a loaded image
+ */
+static bool image_record_string(const RegisterChunk* chunk, const uint8_t* record,
+                                const char** chars, uint32_t* length) {
+    ImageSection strings;
+    image_section(chunk->image, ORBC_SECTION_STRINGS, &strings);
+    uint32_t size = read_u32(record + 4);
+    uint64_t offset = read_u64(record + 8);
+    if (offset >= strings.count || size >= strings.count - offset) {
+        return false;
+    }
+    *chars = (const char*)strings.data + offset;
+    *length = size;
+    return true;
+}
+
+/**
+ * @brief Encode a constant or global as a value record
+ * 
+ * `pending` is the record of a string not materialized yet, or NULL.
+ */
+static bool image_add_value(const RegisterChunk* chunk, ImageBuffer* section,
+                            ImageBuffer* strings, Value value, const uint8_t* pending) {
+    uint8_t* record = image_append(section, 16);
+    if (!record) {
+        return false;
+    }
+    
+    uint8_t tag;
+    uint64_t payload = 0;
+    uint32_t length = 0;
+    if (pending) {
+        const char* chars;
+        if (!image_record_string(chunk, pending, &chars, &length)) {
+            return false;
+        }
+        tag = ORBC_VALUE_STRING;
+        payload = image_add_string(strings, chars, length);
+    } else if (IS_NIL(value)) {
+        tag = ORBC_VALUE_NIL;
+    } else if (IS_BOOL(value)) {
+        tag = ORBC_VALUE_BOOL;
+        payload = AS_BOOL(value) ? 1 : 0;
+    } else if (IS_I32(value)) {
+        tag = ORBC_VALUE_I32;
+        payload = (uint32_t)AS_I32(value);
+    } else if (IS_I64(value)) {
+        tag = ORBC_VALUE_I64;
+        payload = (uint64_t)AS_I64(value);
+    } else if (IS_U32(value)) {
+        tag = ORBC_VALUE_U32;
+        payload = AS_U32(value);
+    } else if (IS_U64(value)) {
+        tag = ORBC_VALUE_U64;
+        payload = AS_U64(value);
+    } else if (IS_F64(value)) {
+        double number = AS_F64(value);
+        tag = ORBC_VALUE_F64;
+        memcpy(&payload, &number, sizeof(double));
+    } else if (IS_STRING(value)) {
+        ObjString* string = AS_STRING(value);
+        tag = ORBC_VALUE_STRING;
+        length = (uint32_t)string->length;
+        payload = image_add_string(strings, string->chars, (size_t)string->length);
+    } else {
+        return false;  // Heap objects other than strings have no image form
+    }
+    
+    record[0] = tag;
+    write_u32(record + 4, length);
+    write_u64(record + 8, payload);
+    return !strings->failed;
+}
+
+/**
+ * @brief Decode a value record; strings decode as nil
+ */
+static bool image_read_value(const uint8_t* record, Value* value) {
+    uint64_t payload = read_u64(record + 8);
+    switch (record[0]) {
+        case ORBC_VALUE_NIL:
+        case ORBC_VALUE_STRING:
+            *value = NIL_VAL;
+            return true;
+        case ORBC_VALUE_BOOL:
+            *value = BOOL_VAL(payload != 0);
+            return true;
+        case ORBC_VALUE_I32:
+            *value = I32_VAL((int32_t)(uint32_t)payload);
+            return true;
+        case ORBC_VALUE_I64:
+            *value = I64_VAL((int64_t)payload);
+            return true;
+        case ORBC_VALUE_U32:
+            *value = U32_VAL((uint32_t)payload);
+            return true;
+        case ORBC_VALUE_U64:
+            *value = U64_VAL(payload);
+            return true;
+        case ORBC_VALUE_F64: {
+            double number;
+            memcpy(&number, &payload, sizeof(double));
+            *value = F64_VAL(number);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool register_chunk_serialize(const RegisterChunk* chunk, uint8_t** buffer, size_t* size) {
+    if (!chunk || !buffer || !size || !register_chunk_validate(chunk)) {
+        return false;
+    }
+    
+    ImageBuffer sections[ORBC_SECTION_COUNT];
+    uint32_t counts[ORBC_SECTION_COUNT] = {0};
+    memset(sections, 0, sizeof(sections));
+    ImageBuffer* strings = &sections[ORBC_SECTION_STRINGS];
+    bool ok = true;
+    
+    // Code and locations are stored as they are laid out in memory on a
+    // little-endian host
+    ImageBuffer* code = &sections[ORBC_SECTION_CODE];
+    for (uint32_t i = 0; i < chunk->code_count; i++) {
+        uint8_t* record = image_append(code, 4);
+        if (record) {
+            write_u32(record, chunk->code[i]);
+        }
+    }
+    counts[ORBC_SECTION_CODE] = chunk->code_count;
+    
+    // Constants and globals; a loaded chunk may still have strings pending
+    ImageSection pending_constants = {0};
+    ImageSection pending_globals = {0};
+    if (chunk->strings_pending) {
+        image_section(chunk->image, ORBC_SECTION_CONSTANTS, &pending_constants);
+        image_section(chunk->image, ORBC_SECTION_GLOBALS, &pending_globals);
+    }
+    for (uint32_t i = 0; i < chunk->constant_count && ok; i++) {
+        const uint8_t* pending = NULL;
+        if (i < pending_constants.count &&
+            pending_constants.data[i * 16] == ORBC_VALUE_STRING) {
+            pending = pending_constants.data + i * 16;
+        }
+        ok = image_add_value(chunk, &sections[ORBC_SECTION_CONSTANTS], strings,
+                             chunk->constants[i], pending);
+    }
+    counts[ORBC_SECTION_CONSTANTS] = chunk->constant_count;
+    for (uint16_t i = 0; i < chunk->global_count && ok; i++) {
+        const uint8_t* pending = NULL;
+        if (i < pending_globals.count &&
+            pending_globals.data[i * 16] == ORBC_VALUE_STRING) {
+            pending = pending_globals.data + i * 16;
+        }
+        ok = image_add_value(chunk, &sections[ORBC_SECTION_GLOBALS], strings,
+                             chunk->globals[i], pending);
+    }
+    counts[ORBC_SECTION_GLOBALS] = chunk->global_count;
+    
+    // Functions
+    for (uint16_t i = 0; i < chunk->function_count; i++) {
+        const FunctionInfo* func = &chunk->functions[i];
+        uint8_t* record = image_append(&sections[ORBC_SECTION_FUNCTIONS], 24);
+        if (!record) {
+            break;
+        }
+        write_u32(record, image_add_name(strings, func->name));
+        write_u32(record + 4, func->start_address);
+        write_u32(record + 8, func->end_address);
+        record[12] = func->parameter_count;
+        record[13] = func->local_count;
+        record[14] = func->register_count;
+        record[15] = (uint8_t)func->return_type;
+        record[16] = func->is_generic;
+        record[17] = func->is_exported;
+        write_u16(record + 18, func->generic_param_count);
+        write_u16(record + 20, func->global_index);
+    }
+    counts[ORBC_SECTION_FUNCTIONS] = chunk->function_count;
+    
+    // Struct layouts
+    for (uint16_t i = 0; i < chunk->field_name_count; i++) {
+        image_add_name_offset(&sections[ORBC_SECTION_FIELD_NAMES], strings,
+                              chunk->field_names[i]);
+    }
+    counts[ORBC_SECTION_FIELD_NAMES] = chunk->field_name_count;
+    for (uint16_t i = 0; i < chunk->shape_count; i++) {
+        const StructShape* shape = &chunk->shapes[i];
+        ImageBuffer* fields = &sections[ORBC_SECTION_SHAPE_FIELDS];
+        uint32_t first = (uint32_t)fields->count;
+        uint8_t* slots = image_append(fields, shape->field_count);
+        if (slots && shape->field_count > 0) {
+            memcpy(slots, shape->field_names, shape->field_count);
+        }
+        uint8_t* record = image_append(&sections[ORBC_SECTION_SHAPES], 12);
+        if (!record) {
+            break;
+        }
+        write_u32(record, image_add_name(strings, shape->name));
+        write_u32(record + 4, first);
+        record[8] = shape->field_count;
+    }
+    counts[ORBC_SECTION_SHAPES] = chunk->shape_count;
+    counts[ORBC_SECTION_SHAPE_FIELDS] = (uint32_t)sections[ORBC_SECTION_SHAPE_FIELDS].count;
+    
+    // Module metadata
+    const ModuleInfo* module = chunk->module;
+    if (module) {
+        uint8_t* record = image_append(&sections[ORBC_SECTION_MODULE], 24);
+        if (record) {
+            write_u32(record, image_add_name(strings, module->name));
+            write_u32(record + 4, image_add_name(strings, module->file_path));
+            write_u32(record + 8, module->version);
+            write_u64(record + 16, module->compile_time);
+        }
+        counts[ORBC_SECTION_MODULE] = 1;
+        
+        for (uint16_t i = 0; i < module->export_count; i++) {
+            const ExportEntry* entry = &module->exports[i];
+            uint8_t* export = image_append(&sections[ORBC_SECTION_EXPORTS], 12);
+            if (!export) {
+                break;
+            }
+            write_u32(export, image_add_name(strings, entry->name));
+            write_u32(export + 4, entry->address);
+            export[8] = (uint8_t)entry->type;
+            export[9] = entry->is_function;
+        }
+        counts[ORBC_SECTION_EXPORTS] = module->export_count;
+        for (uint16_t i = 0; i < module->import_count; i++) {
+            const ImportEntry* entry = &module->imports[i];
+            uint8_t* import = image_append(&sections[ORBC_SECTION_IMPORTS], 16);
+            if (!import) {
+                break;
+            }
+            write_u32(import, image_add_name(strings, entry->module_name));
+            write_u32(import + 4, image_add_name(strings, entry->symbol_name));
+            write_u32(import + 8, entry->local_address);
+            import[12] = (uint8_t)entry->expected_type;
+        }
+        counts[ORBC_SECTION_IMPORTS] = module->import_count;
+        for (uint16_t i = 0; i < module->dependency_count; i++) {
+            image_add_name_offset(&sections[ORBC_SECTION_DEPENDENCIES], strings,
+                                  module->dependencies[i]);
+        }
+        counts[ORBC_SECTION_DEPENDENCIES] = module->dependency_count;
+    }
+    
+    // Debug information
+    const DebugInfo* debug = chunk->debug;
+    if (debug) {
+        for (uint32_t i = 0; i < debug->location_count; i++) {
+            uint8_t* record = image_append(&sections[ORBC_SECTION_LOCATIONS], 8);
+            if (!record) {
+                break;
+            }
+            write_u32(record, debug->locations[i].line);
+            write_u16(record + 4, debug->locations[i].column);
+            write_u16(record + 6, debug->locations[i].file_index);
+        }
+        counts[ORBC_SECTION_LOCATIONS] = debug->location_count;
+        for (uint16_t i = 0; i < debug->source_file_count; i++) {
+            image_add_name_offset(&sections[ORBC_SECTION_SOURCE_FILES], strings,
+                                  debug->source_files[i]);
+        }
+        counts[ORBC_SECTION_SOURCE_FILES] = debug->source_file_count;
+    }
+    counts[ORBC_SECTION_STRINGS] = (uint32_t)strings->count;
+    
+    // Lay out the header, the section table and the aligned sections
+    uint32_t section_count = 0;
+    for (int id = 1; id < ORBC_SECTION_COUNT; id++) {
+        ok = ok && !sections[id].failed;
+        if (sections[id].count > 0) {
+            section_count++;
+        }
+    }
+    uint8_t* image = NULL;
+    size_t image_size = align_up(ORBC_HEADER_SIZE + section_count * ORBC_SECTION_ENTRY_SIZE,
+                                 ORBC_SECTION_ALIGN);
+    for (int id = 1; id < ORBC_SECTION_COUNT; id++) {
+        image_size += align_up(sections[id].count, ORBC_SECTION_ALIGN);
+    }
+    if (ok && image_size <= UINT32_MAX) {
+        image = calloc(1, image_size);
+    }
+    if (image) {
+        write_u32(image, ORBC_IMAGE_MAGIC);
+        write_u32(image + 4, ORBC_IMAGE_VERSION);
+        write_u32(image + 8, ORBC_HEADER_SIZE);
+        write_u32(image + 12, section_count);
+        write_u64(image + 16, image_size);
+        write_u32(image + 24, register_chunk_checksum(chunk));
+        write_u32(image + 28, chunk->optimization_level);
+        image[32] = chunk->max_registers;
+        image[33] = chunk->is_optimized;
+        image[34] = debug ? ORBC_FLAG_DEBUG : 0;
+        
+        uint8_t* entry = image + ORBC_HEADER_SIZE;
+        size_t offset = align_up(ORBC_HEADER_SIZE + section_count * ORBC_SECTION_ENTRY_SIZE,
+                                 ORBC_SECTION_ALIGN);
+        for (int id = 1; id < ORBC_SECTION_COUNT; id++) {
+            if (sections[id].count == 0) {
+                continue;
+            }
+            write_u32(entry, (uint32_t)id);
+            write_u32(entry + 4, counts[id]);
+            write_u32(entry + 8, (uint32_t)offset);
+            write_u32(entry + 12, (uint32_t)sections[id].count);
+            memcpy(image + offset, sections[id].data, sections[id].count);
+            offset += align_up(sections[id].count, ORBC_SECTION_ALIGN);
+            entry += ORBC_SECTION_ENTRY_SIZE;
+        }
+    }
+    
+    for (int id = 1; id < ORBC_SECTION_COUNT; id++) {
+        free(sections[id].data);
+    }
+    if (!image) {
+        return false;
+    }
+    *buffer = image;
+    *size = image_size;
+    return true;
+}
+
+/**
+ * @brief Check the header and section table of an image
+ */
+static bool validate_image(const uint8_t* image, size_t size) {
+    if (size < ORBC_HEADER_SIZE ||
+        read_u32(image) != ORBC_IMAGE_MAGIC ||
+        read_u32(image + 4) != ORBC_IMAGE_VERSION ||
+        read_u32(image + 8) != ORBC_HEADER_SIZE ||
+        read_u64(image + 16) != size) {
+        return false;
+    }
+    
+    uint32_t section_count = read_u32(image + 12);
+    if (section_count > (size - ORBC_HEADER_SIZE) / ORBC_SECTION_ENTRY_SIZE) {
+        return false;
+    }
+    const uint8_t* entry = image + ORBC_HEADER_SIZE;
+    for (uint32_t i = 0; i < section_count; i++, entry += ORBC_SECTION_ENTRY_SIZE) {
+        uint32_t id = read_u32(entry);
+        uint32_t count = read_u32(entry + 4);
+        uint32_t offset = read_u32(entry + 8);
+        uint32_t length = read_u32(entry + 12);
+        if (id == 0 || id >= ORBC_SECTION_COUNT ||
+            offset % ORBC_SECTION_ALIGN != 0 ||
+            offset > size || length > size - offset ||
+            (uint64_t)count * orbc_record_sizes[id] != length) {
+            return false;
+        }
+    }
+    
+    // Every name offset below then ends at a terminator
+    ImageSection strings;
+    if (image_section(image, ORBC_SECTION_STRINGS, &strings) &&
+        strings.data[strings.count - 1] != '\0') {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Resolve a name offset of a validated image
+ * 
+ * @return false if the offset is out of range
+ */
+static bool image_name(const ImageSection* strings, uint32_t offset, char** name) {
+    if (offset == ORBC_NO_STRING) {
+        *name = NULL;
+        return true;
+    }
+    if (offset >= strings->count) {
+        return false;
+    }
+    *name = (char*)strings->data + offset;
+    return true;
+}
+
+/**
+ * @brief Array of `count` records, never NULL, with room for `count`
+ */
+static void* load_table(uint32_t count, size_t record_size, uint32_t* capacity) {
+    uint32_t room = count > INITIAL_CAPACITY ? count : INITIAL_CAPACITY;
+    if (capacity) {
+        *capacity = room;
+    }
+    return calloc(room, record_size);
+}
+
+/**
+ * @brief Build a chunk over an image it takes ownership of
+ * 
+ * On failure the chunk is freed along with the image.
+ */
+static bool load_image(RegisterChunk* chunk, uint8_t* image, size_t size, bool mapped) {
+    memset(chunk, 0, sizeof(RegisterChunk));
+    chunk->owns_memory = true;
+    chunk->ref_count = 1;
+    chunk->image = image;
+    chunk->image_size = size;
+    chunk->image_mapped = mapped;
+    
+    if (!validate_image(image, size)) {
+        register_chunk_free(chunk);
+        return false;
+    }
+    bool in_place = host_is_little_endian();
+    ImageSection strings, section;
+    image_section(image, ORBC_SECTION_STRINGS, &strings);
+    uint32_t capacity;
+    
+    chunk->checksum = read_u32(image + 24);
+    chunk->optimization_level = read_u32(image + 28);
+    chunk->max_registers = image[32];
+    chunk->is_optimized = image[33] != 0;
+    
+    // Code runs in place
+    image_section(image, ORBC_SECTION_CODE, &section);
+    if (in_place && section.count > 0) {
+        chunk->code = (uint32_t*)section.data;
+        chunk->code_capacity = section.count;
+    } else {
+        chunk->code = load_table(section.count, sizeof(uint32_t), &chunk->code_capacity);
+        if (!chunk->code) goto fail;
+        for (uint32_t i = 0; i < section.count; i++) {
+            chunk->code[i] = read_u32(section.data + i * 4);
+        }
+    }
+    chunk->code_count = section.count;
+    
+    // Constants and globals; strings wait for register_chunk_materialize_strings
+    image_section(image, ORBC_SECTION_CONSTANTS, &section);
+    chunk->constants = load_table(section.count, sizeof(Value), &chunk->constant_capacity);
+    if (!chunk->constants) goto fail;
+    for (uint32_t i = 0; i < section.count; i++) {
+        const uint8_t* record = section.data + i * 16;
+        if (!image_read_value(record, &chunk->constants[i])) goto fail;
+        chunk->strings_pending |= record[0] == ORBC_VALUE_STRING;
+    }
+    chunk->constant_count = section.count;
+    
+    image_section(image, ORBC_SECTION_GLOBALS, &section);
+    if (section.count > UINT16_MAX) goto fail;
+    chunk->globals = load_table(section.count, sizeof(Value), &capacity);
+    if (!chunk->globals) goto fail;
+    chunk->global_capacity = (uint16_t)(capacity > UINT16_MAX ? UINT16_MAX : capacity);
+    for (uint32_t i = 0; i < section.count; i++) {
+        const uint8_t* record = section.data + i * 16;
+        if (!image_read_value(record, &chunk->globals[i])) goto fail;
+        chunk->strings_pending |= record[0] == ORBC_VALUE_STRING;
+    }
+    chunk->global_count = (uint16_t)section.count;
+    
+    // Functions
+    image_section(image, ORBC_SECTION_FUNCTIONS, &section);
+    if (section.count > UINT16_MAX) goto fail;
+    chunk->functions = load_table(section.count, sizeof(FunctionInfo), &capacity);
+    if (!chunk->functions) goto fail;
+    chunk->function_capacity = (uint16_t)(capacity > UINT16_MAX ? UINT16_MAX : capacity);
+    for (uint32_t i = 0; i < section.count; i++) {
+        const uint8_t* record = section.data + i * 24;
+        FunctionInfo* func = &chunk->functions[i];
+        if (!image_name(&strings, read_u32(record), &func->name)) goto fail;
+        func->start_address = read_u32(record + 4);
+        func->end_address = read_u32(record + 8);
+        func->parameter_count = record[12];
+        func->local_count = record[13];
+        func->register_count = record[14];
+        func->return_type = (ValueType)record[15];
+        func->is_generic = record[16] != 0;
+        func->is_exported = record[17] != 0;
+        func->generic_param_count = read_u16(record + 18);
+        func->global_index = read_u16(record + 20);
+        chunk->function_count = (uint16_t)(i + 1);
+    }
+    
+    // Struct layouts
+    image_section(image, ORBC_SECTION_FIELD_NAMES, &section);
+    if (section.count > MAX_FIELD_NAMES) goto fail;
+    if (section.count > 0) {
+        chunk->field_names = load_table(section.count, sizeof(char*), &capacity);
+        if (!chunk->field_names) goto fail;
+        chunk->field_name_capacity = (uint16_t)capacity;
+        for (uint32_t i = 0; i < section.count; i++) {
+            if (!image_name(&strings, read_u32(section.data + i * 4), &chunk->field_names[i]) ||
+                !chunk->field_names[i]) goto fail;
+            chunk->field_name_count = (uint16_t)(i + 1);
+        }
+    }
+    
+    ImageSection fields;
+    image_section(image, ORBC_SECTION_SHAPE_FIELDS, &fields);
+    image_section(image, ORBC_SECTION_SHAPES, &section);
+    if (section.count > MAX_STRUCT_SHAPES) goto fail;
+    if (section.count > 0) {
+        chunk->shapes = load_table(section.count, sizeof(StructShape), &capacity);
+        if (!chunk->shapes) goto fail;
+        chunk->shape_capacity = (uint16_t)capacity;
+        for (uint32_t i = 0; i < section.count; i++) {
+            const uint8_t* record = section.data + i * 12;
+            StructShape* shape = &chunk->shapes[i];
+            uint32_t first = read_u32(record + 4);
+            shape->field_count = record[8];
+            if (!image_name(&strings, read_u32(record), &shape->name) || !shape->name ||
+                first > fields.count || shape->field_count > fields.count - first) goto fail;
+            shape->field_names = shape->field_count > 0 ? (uint8_t*)fields.data + first : NULL;
+            for (uint8_t f = 0; f < shape->field_count; f++) {
+                if (shape->field_names[f] >= chunk->field_name_count) goto fail;
+            }
+            chunk->shape_count = (uint16_t)(i + 1);
+        }
+    }
+    
+    // Module metadata
+    chunk->module = calloc(1, sizeof(ModuleInfo));
+    if (!chunk->module) goto fail;
+    ModuleInfo* module = chunk->module;
+    if (image_section(image, ORBC_SECTION_MODULE, &section) && section.count > 0) {
+        if (!image_name(&strings, read_u32(section.data), &module->name) ||
+            !image_name(&strings, read_u32(section.data + 4), &module->file_path)) goto fail;
+        module->version = read_u32(section.data + 8);
+        module->compile_time = read_u64(section.data + 16);
+    }
+    
+    image_section(image, ORBC_SECTION_EXPORTS, &section);
+    if (section.count > UINT16_MAX) goto fail;
+    if (section.count > 0) {
+        module->exports = load_table(section.count, sizeof(ExportEntry), &capacity);
+        if (!module->exports) goto fail;
+        module->export_capacity = (uint16_t)(capacity > UINT16_MAX ? UINT16_MAX : capacity);
+        for (uint32_t i = 0; i < section.count; i++) {
+            const uint8_t* record = section.data + i * 12;
+            ExportEntry* entry = &module->exports[i];
+            if (!image_name(&strings, read_u32(record), &entry->name)) goto fail;
+            entry->address = read_u32(record + 4);
+            entry->type = (ValueType)record[8];
+            entry->is_function = record[9] != 0;
+            module->export_count = (uint16_t)(i + 1);
+        }
+    }
+    
+    image_section(image, ORBC_SECTION_IMPORTS, &section);
+    if (section.count > UINT16_MAX) goto fail;
+    if (section.count > 0) {
+        module->imports = load_table(section.count, sizeof(ImportEntry), &capacity);
+        if (!module->imports) goto fail;
+        module->import_capacity = (uint16_t)(capacity > UINT16_MAX ? UINT16_MAX : capacity);
+        for (uint32_t i = 0; i < section.count; i++) {
+            const uint8_t* record = section.data + i * 16;
+            ImportEntry* entry = &module->imports[i];
+            if (!image_name(&strings, read_u32(record), &entry->module_name) ||
+                !image_name(&strings, read_u32(record + 4), &entry->symbol_name)) goto fail;
+            entry->local_address = read_u32(record + 8);
+            entry->expected_type = (ValueType)record[12];
+            module->import_count = (uint16_t)(i + 1);
+        }
+    }
+    
+    image_section(image, ORBC_SECTION_DEPENDENCIES, &section);
+    if (section.count > UINT16_MAX) goto fail;
+    if (section.count > 0) {
+        module->dependencies = load_table(section.count, sizeof(char*), NULL);
+        if (!module->dependencies) goto fail;
+        for (uint32_t i = 0; i < section.count; i++) {
+            if (!image_name(&strings, read_u32(section.data + i * 4),
+                            &module->dependencies[i])) goto fail;
+            module->dependency_count = (uint16_t)(i + 1);
+        }
+    }
+    
+    // Debug information; locations are used in place
+    if (image[34] & ORBC_FLAG_DEBUG) {
+        chunk->debug = calloc(1, sizeof(DebugInfo));
+        if (!chunk->debug) goto fail;
+        DebugInfo* debug = chunk->debug;
+        
+        image_section(image, ORBC_SECTION_LOCATIONS, &section);
+        if (in_place && sizeof(SourceLocation) == 8 && section.count > 0) {
+            debug->locations = (SourceLocation*)section.data;
+        } else {
+            debug->locations = load_table(section.count, sizeof(SourceLocation), NULL);
+            if (!debug->locations) goto fail;
+            for (uint32_t i = 0; i < section.count; i++) {
+                const uint8_t* record = section.data + i * 8;
+                debug->locations[i].line = read_u32(record);
+                debug->locations[i].column = read_u16(record + 4);
+                debug->locations[i].file_index = read_u16(record + 6);
+            }
+        }
+        debug->location_count = section.count;
+        debug->location_capacity = section.count;
+        
+        image_section(image, ORBC_SECTION_SOURCE_FILES, &section);
+        if (section.count > UINT16_MAX) goto fail;
+        debug->source_files = load_table(section.count, sizeof(char*), &capacity);
+        if (!debug->source_files) goto fail;
+        debug->source_file_capacity = (uint16_t)(capacity > UINT16_MAX ? UINT16_MAX : capacity);
+        for (uint32_t i = 0; i < section.count; i++) {
+            if (!image_name(&strings, read_u32(section.data + i * 4),
+                            &debug->source_files[i])) goto fail;
+            debug->source_file_count = (uint16_t)(i + 1);
+        }
+    }
+    
+    if (!register_chunk_validate(chunk)) goto fail;
+    return true;
+    
+fail:
+    register_chunk_free(chunk);
+    return false;
+}
+
+bool register_chunk_deserialize(const uint8_t* buffer, size_t size, RegisterChunk* chunk) {
+    if (!buffer || !chunk || size == 0) {
+        return false;
+    }
+    
+    // Keep a private copy so the chunk can borrow from it
+    uint8_t* image = malloc(size);
+    if (!image) {
+        return false;
+    }
+    memcpy(image, buffer, size);
+    return load_image(chunk, image, size, false);
+}
+
+bool register_chunk_write_file(const RegisterChunk* chunk, const char* path) {
+    if (!path) {
+        return false;
+    }
+    
+    uint8_t* image;
+    size_t size;
+    if (!register_chunk_serialize(chunk, &image, &size)) {
+        return false;
+    }
+    
+    FILE* file = fopen(path, "wb");
+    bool ok = file && fwrite(image, 1, size, file) == size;
+    if (file && fclose(file) != 0) {
+        ok = false;
+    }
+    free(image);
+    return ok;
+}
+
+bool register_chunk_map_file(const char* path, RegisterChunk* chunk) {
+    if (!path || !chunk) {
+        return false;
+    }
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)info.st_size;
+    
+    // Private and writable: patched instructions stay out of the file
+    void* image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        return false;
+    }
+    return load_image(chunk, image, size, true);
+}
+
+/**
+ * @brief Create the strings of one value section of a loaded image
+ * 
+ * Record i still describes slot i: code that adds constants materializes
+ * first.
+ */
+static bool materialize_section(RegisterChunk* chunk, OrbcSection id, Value* values) {
+    ImageSection section;
+    image_section(chunk->image, id, &section);
+    for (uint32_t i = 0; i < section.count; i++) {
+        const uint8_t* record = section.data + i * 16;
+        const char* chars;
+        uint32_t length;
+        if (record[0] != ORBC_VALUE_STRING) {
+            continue;
+        }
+        if (!image_record_string(chunk, record, &chars, &length) || length > INT32_MAX) {
+            return false;
+        }
+        values[i] = STRING_VAL(allocateString(chars, (int)length));
+    }
+    return true;
+}
+
+bool register_chunk_materialize_strings(RegisterChunk* chunk) {
+    if (!chunk) {
+        return false;
+    }
+    if (!chunk->strings_pending) {
+        return true;
+    }
+    
+    if (!materialize_section(chunk, ORBC_SECTION_CONSTANTS, chunk->constants) ||
+        !materialize_section(chunk, ORBC_SECTION_GLOBALS, chunk->globals)) {
+        return false;
+    }
+    chunk->strings_pending = false;
+    return true;
+}
+
+void register_chunk_release(RegisterChunk* chunk, void* pointer) {
+    if (chunk && owns_buffer(chunk, pointer)) {
+        free(pointer);
+    }
+}
+
+// =============================================================================
+// INTEGRITY AND VERIFICATION
+// =============================================================================
+
+uint32_t register_chunk_checksum(const RegisterChunk* chunk) {
+    if (!chunk || !chunk->code) {
+        return 0;
+    }
+    return calculate_crc32((const uint8_t*)chunk->code,
+                           chunk->code_count * sizeof(uint32_t));
+}
+
+bool register_chunk_verify(const RegisterChunk* chunk) {
+    if (!register_chunk_validate(chunk)) {
+        return false;
+    }
+    
+    // LOAD_CONST types are unknown while string constants read as nil
+    if (chunk->strings_pending) {
+        return false;
+    }
+    
+    if (chunk->checksum != 0 && chunk->checksum != register_chunk_checksum(chunk)) {
+        return false;
+    }
+    
+    if (chunk->code_count == 0) {
+        return true;
+    }
+    
+    // Abstract interpretation over register type tags: one state per
+    // instruction, joined at control-flow merges until a fixed point.
+    uint8_t* states = malloc((size_t)chunk->code_count * TOTAL_REGISTER_COUNT);
+    bool* reached = calloc(chunk->code_count, sizeof(bool));
+    bool* pending = calloc(chunk->code_count, sizeof(bool));
+    if (!states || !reached || !pending) {
+        free(states);
+        free(reached);
+        free(pending);
+        return false;
+    }
+    
+    // Registers may hold anything on entry
+    memset(states, VERIFY_TYPE_UNKNOWN, TOTAL_REGISTER_COUNT);
+    reached[0] = true;
+    pending[0] = true;
+    
+    bool ok = true;
+    bool changed = true;
+    while (ok && changed) {
+        changed = false;
+        for (uint32_t address = 0; address < chunk->code_count && ok; address++) {
+            if (!pending[address]) {
+                continue;
+            }
+            pending[address] = false;
+            
+            uint8_t types[TOTAL_REGISTER_COUNT];
+            memcpy(types, &states[(size_t)address * TOTAL_REGISTER_COUNT], TOTAL_REGISTER_COUNT);
+            
+            uint32_t targets[2];
+            int target_count = 0;
+            if (!verify_instruction(chunk, address, types, targets, &target_count)) {
+                ok = false;
+                break;
+            }
+            
+            // Propagate the output state to every successor
+            for (int t = 0; t < target_count; t++) {
+                uint32_t target = targets[t];
+                if (target >= chunk->code_count) {
+                    continue; // Falling off the end halts execution
+                }
+                uint8_t* in = &states[(size_t)target * TOTAL_REGISTER_COUNT];
+                if (!reached[target]) {
+                    memcpy(in, types, TOTAL_REGISTER_COUNT);
+                    reached[target] = true;
+                    pending[target] = true;
+                    changed = true;
+                    continue;
+                }
+                for (int r = 0; r < TOTAL_REGISTER_COUNT; r++) {
+                    if (in[r] != types[r] && in[r] != VERIFY_TYPE_UNKNOWN) {
+                        in[r] = VERIFY_TYPE_UNKNOWN;
+                        pending[target] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+    
+    free(states);
+    free(reached);
+    free(pending);
+    return ok;
+}
+
+bool register_chunk_mark_verified(RegisterChunk* chunk) {
+    if (!chunk) {
+        return false;
+    }
+    if (!register_chunk_materialize_strings(chunk)) {
+        chunk->is_verified = false;
+        return false;
+    }
+    chunk->is_verified = register_chunk_verify(chunk);
+    return chunk->is_verified;
+}
+
 // =============================================================================
 // UTILITY FUNCTIONS
 // =============================================================================
@@ -612,9 +1955,250 @@ bool register_chunk_validate(const RegisterChunk* chunk) {
 // PRIVATE HELPER FUNCTIONS
 // =============================================================================
 
+static uint32_t calculate_crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (CRC32_POLYNOMIAL & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Verify one instruction and apply its effect on register types
+ * 
+ * @param chunk Chunk being verified
+ * @param address Instruction address
+ * @param types Register types before the instruction; updated in place
+ * @param targets Output successor addresses
+ * @param target_count Output number of successors
+ * @return false if an operand cannot be proven valid
+ */
+static bool verify_instruction(const RegisterChunk* chunk, uint32_t address,
+                               uint8_t* types, uint32_t* targets, int* target_count) {
+    uint32_t instruction = chunk->code[address];
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    uint8_t dst = GET_DST(instruction);
+    uint8_t src1 = GET_SRC1(instruction);
+    uint8_t src2 = GET_SRC2(instruction);
+    uint16_t imm = GET_IMM(instruction);
+    
+    if (!get_instruction_metadata(opcode)) {
+        return false;
+    }
+    
+    // A superinstruction behaves as its first opcode followed by the words
+    // after it, which are verified on their own; the threaded loop relies on
+    // those words still being the fused sequence.
+    const SuperinstructionInfo* fused = get_superinstruction_info(opcode);
+    if (fused) {
+        if (address + fused->length > chunk->code_count) return false;
+        for (uint8_t k = 1; k < fused->length; k++) {
+            if (GET_OPCODE(chunk->code[address + k]) != fused->pattern[k]) return false;
+        }
+        opcode = fused->pattern[0];
+    }
+    
+    // Most instructions fall through to the next one
+    targets[0] = address + 1;
+    *target_count = 1;
+    
+    switch (opcode) {
+        case ROP_NOP:
+        case ROP_HALT: // Execution may resume after a halt
+            return true;
+            
+        case ROP_JMP:
+            if (imm >= chunk->code_count) return false;
+            targets[0] = imm;
+            return true;
+            
+        case ROP_JZ:
+        case ROP_JNZ:
+            if (dst >= TOTAL_REGISTER_COUNT || imm >= chunk->code_count) return false;
+            targets[1] = imm;
+            *target_count = 2;
+            return true;
+            
+        case ROP_JMP_REG:
+        case ROP_CALL_REG:
+            // Dynamic targets cannot be proven
+            return false;
+            
+        case ROP_TRY_BEGIN:
+            // The handler is entered from wherever the try body fails, with
+            // register types that cannot be proven
+            return false;
+            
+        case ROP_IMPORT:
+        case ROP_EXPORT:
+        case ROP_MODULE_CALL:
+        case ROP_MODULE_GET:
+        case ROP_MODULE_SET:
+            // Only the linker resolves these; the VM does not execute them
+            return false;
+            
+        case ROP_JEQ:
+        case ROP_JNE:
+        case ROP_JLT:
+        case ROP_JLE:
+        case ROP_JGT:
+        case ROP_JGE:
+            if (imm >= chunk->code_count) return false;
+            targets[1] = imm;
+            *target_count = 2;
+            return true;
+            
+        case ROP_CALL:
+            // The callee and the continuation see an unknown register file
+            if (dst >= TOTAL_REGISTER_COUNT || imm >= chunk->code_count) return false;
+            memset(types, VERIFY_TYPE_UNKNOWN, TOTAL_REGISTER_COUNT);
+            targets[1] = imm;
+            *target_count = 2;
+            return true;
+            
+        case ROP_RET_VAL:
+            if (dst >= TOTAL_REGISTER_COUNT) return false;
+            *target_count = 0;
+            return true;
+            
+        case ROP_RET:
+            *target_count = 0;
+            return true;
+            
+        case ROP_MOVE:
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= TOTAL_REGISTER_COUNT) return false;
+            types[dst] = types[src1];
+            return true;
+            
+        case ROP_LOAD_IMM:
+            if (dst >= TOTAL_REGISTER_COUNT) return false;
+            types[dst] = VAL_I32;
+            return true;
+            
+        case ROP_LOAD_CONST:
+            if (dst >= TOTAL_REGISTER_COUNT || imm >= chunk->constant_count) return false;
+            types[dst] = (uint8_t)VALUE_TYPE(chunk->constants[imm]);
+            return true;
+            
+        case ROP_LOAD_GLOBAL:
+            if (dst >= TOTAL_REGISTER_COUNT || imm >= chunk->global_count) return false;
+            types[dst] = VERIFY_TYPE_UNKNOWN;
+            return true;
+            
+        case ROP_STORE_GLOBAL:
+            return dst < TOTAL_REGISTER_COUNT && imm < chunk->global_count;
+            
+        case ROP_ADD_I32:
+        case ROP_SUB_I32:
+        case ROP_MUL_I32:
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= TOTAL_REGISTER_COUNT ||
+                src2 >= TOTAL_REGISTER_COUNT) return false;
+            if (types[src1] != VAL_I32 || types[src2] != VAL_I32) return false;
+            types[dst] = VAL_I32;
+            return true;
+            
+        case ROP_ADD_F64:
+        case ROP_SUB_F64:
+        case ROP_MUL_F64:
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= TOTAL_REGISTER_COUNT ||
+                src2 >= TOTAL_REGISTER_COUNT) return false;
+            if (types[src1] != VAL_F64 || types[src2] != VAL_F64) return false;
+            types[dst] = VAL_F64;
+            return true;
+            
+        case ROP_EQ_I32:
+        case ROP_NE_I32:
+        case ROP_LT_I32:
+        case ROP_LE_I32:
+        case ROP_GT_I32:
+        case ROP_GE_I32:
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= TOTAL_REGISTER_COUNT ||
+                src2 >= TOTAL_REGISTER_COUNT) return false;
+            types[dst] = VAL_BOOL;
+            return true;
+            
+        case ROP_UNBOX_I64:
+        case ROP_UNBOX_F64:
+            // The source tag is still checked at runtime; only bounds are proven
+            return dst < LANE_REGISTER_COUNT && src1 < TOTAL_REGISTER_COUNT;
+            
+        case ROP_BOX_I64:
+        case ROP_BOX_F64:
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= LANE_REGISTER_COUNT) return false;
+            types[dst] = opcode == ROP_BOX_I64 ? VAL_I64 : VAL_F64;
+            return true;
+            
+        case ROP_LANE_ADD_I64:
+        case ROP_LANE_SUB_I64:
+        case ROP_LANE_MUL_I64:
+        case ROP_LANE_ADD_F64:
+        case ROP_LANE_SUB_F64:
+        case ROP_LANE_MUL_F64:
+        case ROP_LANE_DIV_F64:
+            // Lanes are untagged, so bounds are the only thing to prove
+            return dst < LANE_REGISTER_COUNT && src1 < LANE_REGISTER_COUNT &&
+                   src2 < LANE_REGISTER_COUNT;
+            
+        case ROP_LANE_LT_I64:
+            if (dst >= LANE_REGISTER_COUNT || src1 >= LANE_REGISTER_COUNT ||
+                src2 >= LANE_REGISTER_COUNT) return false;
+            types[dst] = VAL_BOOL;
+            return true;
+            
+        case ROP_NEW_STRUCT:
+            // Fields are read from the run of registers starting at src1
+            if (src2 >= chunk->shape_count || dst >= TOTAL_REGISTER_COUNT ||
+                src1 + chunk->shapes[src2].field_count > TOTAL_REGISTER_COUNT) return false;
+            types[dst] = VAL_ARRAY;
+            return true;
+            
+        case ROP_GET_FIELD:
+            // The object's shape is still checked at runtime
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= TOTAL_REGISTER_COUNT ||
+                src2 >= chunk->field_name_count) return false;
+            types[dst] = VERIFY_TYPE_UNKNOWN;
+            return true;
+            
+        case ROP_SET_FIELD:
+            return dst < TOTAL_REGISTER_COUNT && src1 < chunk->field_name_count &&
+                   src2 < TOTAL_REGISTER_COUNT;
+            
+        case ROP_NEW_ARRAY:
+        case ROP_NEW_PACKED_ARRAY:
+            // Elements are read from the run of registers starting at src1
+            if (dst >= TOTAL_REGISTER_COUNT || src1 + src2 > TOTAL_REGISTER_COUNT) return false;
+            types[dst] = VAL_ARRAY;
+            return true;
+            
+        case ROP_GET_INDEX:
+            // The array and index are still checked at runtime
+            if (dst >= TOTAL_REGISTER_COUNT || src1 >= TOTAL_REGISTER_COUNT ||
+                src2 >= TOTAL_REGISTER_COUNT) return false;
+            types[dst] = VERIFY_TYPE_UNKNOWN;
+            return true;
+            
+        case ROP_SET_INDEX:
+            return dst < TOTAL_REGISTER_COUNT && src1 < TOTAL_REGISTER_COUNT &&
+                   src2 < TOTAL_REGISTER_COUNT;
+            
+        default:
+            // Remaining opcodes keep their runtime checks in the generic
+            // handler; only their effect on the destination is modelled.
+            if (dst < TOTAL_REGISTER_COUNT) {
+                types[dst] = VERIFY_TYPE_UNKNOWN;
+            }
+            return true;
+    }
+}
+
 static bool grow_code_array(RegisterChunk* chunk) {
     uint32_t new_capacity = chunk->code_capacity * GROWTH_FACTOR;
-    uint32_t* new_code = realloc(chunk->code, new_capacity * sizeof(uint32_t));
+    uint32_t* new_code = resize_buffer(chunk, chunk->code,
+                                       chunk->code_count * sizeof(uint32_t),
+                                       new_capacity * sizeof(uint32_t));
     if (!new_code) {
         return false;
     }
@@ -656,6 +2240,30 @@ static bool grow_function_array(RegisterChunk* chunk) {
     return true;
 }
 
+static bool grow_field_name_array(RegisterChunk* chunk) {
+    uint16_t new_capacity = chunk->field_name_capacity ?
+                            chunk->field_name_capacity * GROWTH_FACTOR : INITIAL_CAPACITY;
+    char** new_names = realloc(chunk->field_names, new_capacity * sizeof(char*));
+    if (!new_names) {
+        return false;
+    }
+    chunk->field_names = new_names;
+    chunk->field_name_capacity = new_capacity;
+    return true;
+}
+
+static bool grow_shape_array(RegisterChunk* chunk) {
+    uint16_t new_capacity = chunk->shape_capacity ?
+                            chunk->shape_capacity * GROWTH_FACTOR : INITIAL_CAPACITY;
+    StructShape* new_shapes = realloc(chunk->shapes, new_capacity * sizeof(StructShape));
+    if (!new_shapes) {
+        return false;
+    }
+    chunk->shapes = new_shapes;
+    chunk->shape_capacity = new_capacity;
+    return true;
+}
+
 static bool grow_source_file_array(DebugInfo* debug) {
     uint16_t new_capacity = debug->source_file_capacity * GROWTH_FACTOR;
     char** new_files = realloc(debug->source_files, new_capacity * sizeof(char*));
@@ -667,23 +2275,46 @@ static bool grow_source_file_array(DebugInfo* debug) {
     return true;
 }
 
-static void free_function_info(FunctionInfo* func) {
+static bool owns_buffer(const RegisterChunk* chunk, const void* pointer) {
+    const uint8_t* bytes = pointer;
+    return !chunk->image || bytes < chunk->image ||
+           bytes >= chunk->image + chunk->image_size;
+}
+
+/**
+ * @brief realloc for chunk buffers that may lie in the chunk's image
+ * 
+ * A borrowed buffer is copied out rather than resized in place.
+ */
+static void* resize_buffer(RegisterChunk* chunk, void* pointer,
+                           size_t old_size, size_t new_size) {
+    if (owns_buffer(chunk, pointer)) {
+        return realloc(pointer, new_size);
+    }
+    void* copy = malloc(new_size);
+    if (copy) {
+        memcpy(copy, pointer, old_size < new_size ? old_size : new_size);
+    }
+    return copy;
+}
+
+static void free_function_info(RegisterChunk* chunk, FunctionInfo* func) {
     if (func) {
-        free(func->name);
+        register_chunk_release(chunk, func->name);
         free(func->parameter_types);
         memset(func, 0, sizeof(FunctionInfo));
     }
 }
 
-static void free_module_info(ModuleInfo* module) {
+static void free_module_info(RegisterChunk* chunk, ModuleInfo* module) {
     if (module) {
-        free(module->name);
-        free(module->file_path);
+        register_chunk_release(chunk, module->name);
+        register_chunk_release(chunk, module->file_path);
         
         // Free exports
         if (module->exports) {
             for (uint16_t i = 0; i < module->export_count; i++) {
-                free(module->exports[i].name);
+                register_chunk_release(chunk, module->exports[i].name);
             }
             free(module->exports);
         }
@@ -691,8 +2322,8 @@ static void free_module_info(ModuleInfo* module) {
         // Free imports
         if (module->imports) {
             for (uint16_t i = 0; i < module->import_count; i++) {
-                free(module->imports[i].module_name);
-                free(module->imports[i].symbol_name);
+                register_chunk_release(chunk, module->imports[i].module_name);
+                register_chunk_release(chunk, module->imports[i].symbol_name);
             }
             free(module->imports);
         }
@@ -700,21 +2331,21 @@ static void free_module_info(ModuleInfo* module) {
         // Free dependencies
         if (module->dependencies) {
             for (uint16_t i = 0; i < module->dependency_count; i++) {
-                free(module->dependencies[i]);
+                register_chunk_release(chunk, module->dependencies[i]);
             }
             free(module->dependencies);
         }
     }
 }
 
-static void free_debug_info(DebugInfo* debug) {
+static void free_debug_info(RegisterChunk* chunk, DebugInfo* debug) {
     if (debug) {
-        free(debug->locations);
+        register_chunk_release(chunk, debug->locations);
         
         // Free source files
         if (debug->source_files) {
             for (uint16_t i = 0; i < debug->source_file_count; i++) {
-                free(debug->source_files[i]);
+                register_chunk_release(chunk, debug->source_files[i]);
             }
             free(debug->source_files);
         }
@@ -0,0 +1,778 @@
+/**
+ * @file register_linker.c
+ * @brief Orus Register VM Whole-Program Linker
+ *
+ * This file implements register_chunk_link(), which merges the register
+ * chunks of a program and every module it imports into one chunk:
+ *
+ * - Calls between modules (ROP_MODULE_CALL on a global slot) become direct
+ *   ROP_CALLs to the address the owning function is placed at
+ * - Functions no top-level code can reach are left out, together with the
+ *   jump that skips over their body
+ * - Constants, field names, struct shapes and source files are merged and
+ *   deduplicated; their operands are rewritten to the merged tables
+ * - ROP_IMPORT instructions are dropped, since every module is already in
+ *   the image, and module top levels run in order before the program's
+ *
+ * Globals are process-wide slots shared by all chunks, so slot operands are
+ * kept as they are. A function's slot is owned by the chunk whose
+ * FunctionInfo.global_index names it.
+ *
+ * @author Orus Development Team
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include "../../include/register_chunk.h"
+#include "../../include/register_opcodes.h"
+#include "../../include/memory.h"
+#include "../../include/value.h"
+
+// =============================================================================
+// PRIVATE CONSTANTS
+// =============================================================================
+
+/** Marker for an address that starts no function, or a slot without owner */
+#define NO_FUNCTION UINT16_MAX
+
+/** Marker for a constant not placed in the output yet */
+#define NO_CONSTANT UINT32_MAX
+
+// =============================================================================
+// PRIVATE TYPES
+// =============================================================================
+
+/**
+ * @brief Per-chunk linking state
+ */
+typedef struct {
+    RegisterChunk* chunk;         /**< Chunk being linked */
+    uint16_t* starts;             /**< Function starting at each address */
+    uint16_t* parents;            /**< Innermost enclosing function of each function */
+    bool* kept;                   /**< Functions reachable from top-level code */
+    uint16_t* functions;          /**< Output index of each kept function */
+    bool* dropped;                /**< Instructions left out of the output */
+    uint32_t* map;                /**< Output address of each instruction, plus the end */
+    uint32_t* constants;          /**< Output index of each constant, or NO_CONSTANT */
+    uint8_t* field_names;         /**< Output index of each field name */
+    uint8_t* shapes;              /**< Output id of each shape, by id - 1 */
+    uint16_t* files;              /**< Output index of each source file */
+} LinkUnit;
+
+/**
+ * @brief Function holding a global slot
+ */
+typedef struct {
+    uint16_t unit;                /**< Owning unit, or NO_FUNCTION */
+    uint16_t function;            /**< Function index within the unit */
+} SlotOwner;
+
+/**
+ * @brief Linker state
+ */
+typedef struct {
+    LinkUnit* units;              /**< One entry per input chunk */
+    uint16_t unit_count;          /**< Number of input chunks */
+    SlotOwner* owners;            /**< Owner of each global slot */
+    uint16_t global_count;        /**< Largest global count of any unit */
+    uint16_t* worklist;           /**< Pending (unit, function) pairs */
+    uint32_t worklist_count;      /**< Pairs on the worklist */
+    uint32_t* constant_table;     /**< Open-addressed output constant indices */
+    uint32_t constant_table_capacity; /**< Power of two, or zero */
+    RegisterChunk* output;        /**< Chunk being built */
+    char* message;                /**< Error message buffer */
+    size_t message_size;          /**< Size of the message buffer */
+} Linker;
+
+// =============================================================================
+// HELPERS
+// =============================================================================
+
+/**
+ * @brief Record an error message; always returns false
+ */
+static bool link_error(Linker* linker, const char* format, ...) {
+    if (linker->message && linker->message_size > 0) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(linker->message, linker->message_size, format, args);
+        va_end(args);
+    }
+    return false;
+}
+
+static const char* unit_name(const LinkUnit* unit) {
+    const RegisterChunk* chunk = unit->chunk;
+    return chunk->module && chunk->module->name ? chunk->module->name : "<chunk>";
+}
+
+/**
+ * @brief Replace the immediate field of an instruction
+ */
+static uint32_t with_imm(uint32_t instruction, uint32_t imm) {
+    return (instruction & 0xFFFFu) | (imm << 16);
+}
+
+/**
+ * @brief Replace the src1 (shift 16) or src2 (shift 24) byte of an instruction
+ */
+static uint32_t with_byte(uint32_t instruction, int shift, uint8_t value) {
+    return (instruction & ~(0xFFu << shift)) | ((uint32_t)value << shift);
+}
+
+static bool has_code_target(RegisterOpcode opcode) {
+    return opcode == ROP_JMP || opcode == ROP_CALL || opcode == ROP_TRY_BEGIN ||
+           (opcode >= ROP_JZ && opcode <= ROP_JGE);
+}
+
+/**
+ * @brief Whether an opcode needs module or address information a linked
+ * image no longer has
+ */
+static bool is_dynamic(RegisterOpcode opcode) {
+    return opcode == ROP_JMP_REG || opcode == ROP_CALL_REG || opcode == ROP_EXPORT ||
+           opcode == ROP_MODULE_GET || opcode == ROP_MODULE_SET;
+}
+
+static void free_unit(LinkUnit* unit) {
+    free(unit->starts);
+    free(unit->parents);
+    free(unit->kept);
+    free(unit->functions);
+    free(unit->dropped);
+    free(unit->map);
+    free(unit->constants);
+    free(unit->field_names);
+    free(unit->shapes);
+    free(unit->files);
+}
+
+// =============================================================================
+// FUNCTION OWNERSHIP
+// =============================================================================
+
+/**
+ * @brief Validate a unit and index its functions
+ */
+static bool prepare_unit(Linker* linker, uint16_t index) {
+    LinkUnit* unit = &linker->units[index];
+    RegisterChunk* chunk = unit->chunk;
+
+    if (!register_chunk_materialize_strings(chunk)) {
+        return link_error(linker, "Out of memory loading '%s'.", unit_name(unit));
+    }
+
+    uint32_t count = chunk->code_count;
+    uint16_t functions = chunk->function_count;
+    unit->starts = malloc(sizeof(uint16_t) * (count > 0 ? count : 1));
+    unit->parents = malloc(sizeof(uint16_t) * (functions > 0 ? functions : 1));
+    unit->kept = calloc(functions > 0 ? functions : 1, sizeof(bool));
+    unit->functions = malloc(sizeof(uint16_t) * (functions > 0 ? functions : 1));
+    unit->dropped = calloc(count > 0 ? count : 1, sizeof(bool));
+    unit->map = malloc(sizeof(uint32_t) * (count + 1));
+    unit->constants = malloc(sizeof(uint32_t) * (chunk->constant_count > 0 ? chunk->constant_count : 1));
+    if (!unit->starts || !unit->parents || !unit->kept || !unit->functions ||
+        !unit->dropped || !unit->map || !unit->constants) {
+        return link_error(linker, "Out of memory linking '%s'.", unit_name(unit));
+    }
+    for (uint32_t address = 0; address < count; address++) {
+        unit->starts[address] = NO_FUNCTION;
+    }
+    for (uint32_t i = 0; i < chunk->constant_count; i++) {
+        unit->constants[i] = NO_CONSTANT;
+    }
+
+    for (uint16_t f = 0; f < functions; f++) {
+        const FunctionInfo* function = &chunk->functions[f];
+        if (function->start_address > function->end_address ||
+            function->end_address >= count) {
+            return link_error(linker, "Function '%s' of '%s' has an invalid range.",
+                              function->name, unit_name(unit));
+        }
+        unit->starts[function->start_address] = f;
+
+        // Innermost function whose range contains this one
+        unit->parents[f] = NO_FUNCTION;
+        for (uint16_t g = 0; g < functions; g++) {
+            const FunctionInfo* outer = &chunk->functions[g];
+            if (g == f || outer->start_address > function->start_address ||
+                outer->end_address < function->end_address) {
+                continue;
+            }
+            if (unit->parents[f] == NO_FUNCTION ||
+                outer->start_address >= chunk->functions[unit->parents[f]].start_address) {
+                unit->parents[f] = g;
+            }
+        }
+
+        uint16_t slot = function->global_index;
+        if (slot == UINT16_MAX) {
+            continue;
+        }
+        if (slot >= linker->global_count) {
+            return link_error(linker, "Function '%s' of '%s' names global %u past the end of the globals.",
+                              function->name, unit_name(unit), slot);
+        }
+        SlotOwner* owner = &linker->owners[slot];
+        if (owner->unit != NO_FUNCTION) {
+            return link_error(linker, "Function '%s' is defined by both '%s' and '%s'.",
+                              function->name, unit_name(&linker->units[owner->unit]),
+                              unit_name(unit));
+        }
+        owner->unit = index;
+        owner->function = f;
+    }
+    return true;
+}
+
+// =============================================================================
+// REACHABILITY
+// =============================================================================
+
+/**
+ * @brief Keep a function and every function enclosing it
+ */
+static void keep_function(Linker* linker, uint16_t unit_index, uint16_t function) {
+    LinkUnit* unit = &linker->units[unit_index];
+    while (function != NO_FUNCTION && !unit->kept[function]) {
+        unit->kept[function] = true;
+        linker->worklist[linker->worklist_count * 2] = unit_index;
+        linker->worklist[linker->worklist_count * 2 + 1] = function;
+        linker->worklist_count++;
+        function = unit->parents[function];
+    }
+}
+
+/**
+ * @brief Name the import bound to a global slot, for error messages
+ */
+static const char* import_name(const LinkUnit* unit, uint16_t slot, const char** module) {
+    const ModuleInfo* info = unit->chunk->module;
+    for (uint16_t i = 0; info && i < info->import_count; i++) {
+        if (info->imports[i].local_address == slot) {
+            *module = info->imports[i].module_name;
+            return info->imports[i].symbol_name;
+        }
+    }
+    *module = NULL;
+    return NULL;
+}
+
+/**
+ * @brief Keep whatever one instruction refers to
+ */
+static bool scan_instruction(Linker* linker, uint16_t unit_index, uint32_t address) {
+    LinkUnit* unit = &linker->units[unit_index];
+    uint32_t instruction = unit->chunk->code[address];
+    RegisterOpcode opcode = get_base_opcode((RegisterOpcode)GET_OPCODE(instruction));
+    uint16_t imm = GET_IMM(instruction);
+
+    if (is_dynamic(opcode)) {
+        return link_error(linker, "'%s' uses %s at %u, which cannot be linked.",
+                          unit_name(unit), get_instruction_name(opcode), address);
+    }
+    if (opcode == ROP_CALL) {
+        if (imm >= unit->chunk->code_count || unit->starts[imm] == NO_FUNCTION) {
+            return link_error(linker, "'%s' calls %u at %u, which starts no function.",
+                              unit_name(unit), imm, address);
+        }
+        keep_function(linker, unit_index, unit->starts[imm]);
+    } else if (opcode == ROP_MODULE_CALL || opcode == ROP_LOAD_GLOBAL) {
+        const SlotOwner* owner = imm < linker->global_count ? &linker->owners[imm] : NULL;
+        if (owner && owner->unit != NO_FUNCTION) {
+            keep_function(linker, owner->unit, owner->function);
+        } else if (opcode == ROP_MODULE_CALL) {
+            const char* module;
+            const char* symbol = import_name(unit, imm, &module);
+            if (symbol) {
+                return link_error(linker, "'%s' imports '%s' from '%s', which no linked chunk defines.",
+                                  unit_name(unit), symbol, module);
+            }
+            return link_error(linker, "'%s' calls global %u, which no linked chunk defines.",
+                              unit_name(unit), imm);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Scan code from `start` to `end`, skipping nested functions
+ */
+static bool scan_range(Linker* linker, uint16_t unit_index, uint32_t start, uint32_t end,
+                       uint16_t function) {
+    LinkUnit* unit = &linker->units[unit_index];
+    for (uint32_t address = start; address < end; address++) {
+        uint16_t nested = unit->starts[address];
+        if (nested != NO_FUNCTION && nested != function) {
+            address = unit->chunk->functions[nested].end_address;
+            continue;
+        }
+        if (!scan_instruction(linker, unit_index, address)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Find every function reachable from top-level code
+ */
+static bool mark_reachable(Linker* linker) {
+    for (uint16_t u = 0; u < linker->unit_count; u++) {
+        RegisterChunk* chunk = linker->units[u].chunk;
+        if (!scan_range(linker, u, 0, chunk->code_count, NO_FUNCTION)) {
+            return false;
+        }
+    }
+    while (linker->worklist_count > 0) {
+        linker->worklist_count--;
+        uint16_t u = linker->worklist[linker->worklist_count * 2];
+        uint16_t f = linker->worklist[linker->worklist_count * 2 + 1];
+        const FunctionInfo* function = &linker->units[u].chunk->functions[f];
+        if (!scan_range(linker, u, function->start_address, function->end_address + 1, f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// LAYOUT
+// =============================================================================
+
+/**
+ * @brief Whether an address is a trailing word of a superinstruction
+ */
+static bool is_fused_tail(const RegisterChunk* chunk, uint32_t address) {
+    for (uint32_t back = 1; back < MAX_SUPERINSTRUCTION_LENGTH && back <= address; back++) {
+        const SuperinstructionInfo* info =
+            get_superinstruction_info((RegisterOpcode)GET_OPCODE(chunk->code[address - back]));
+        if (info && back < info->length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Drop unreachable functions and imports, then assign output addresses
+ */
+static bool layout_units(Linker* linker) {
+    uint32_t next = 0;
+    for (uint16_t u = 0; u < linker->unit_count; u++) {
+        LinkUnit* unit = &linker->units[u];
+        RegisterChunk* chunk = unit->chunk;
+
+        for (uint16_t f = 0; f < chunk->function_count; f++) {
+            if (unit->kept[f]) {
+                continue;
+            }
+            const FunctionInfo* function = &chunk->functions[f];
+            for (uint32_t a = function->start_address; a <= function->end_address; a++) {
+                unit->dropped[a] = true;
+            }
+            // The jump over the body has nothing left to skip
+            uint32_t before = function->start_address - 1;
+            if (function->start_address > 0 &&
+                GET_OPCODE(chunk->code[before]) == ROP_JMP &&
+                GET_IMM(chunk->code[before]) == function->end_address + 1 &&
+                !is_fused_tail(chunk, before)) {
+                unit->dropped[before] = true;
+            }
+        }
+        for (uint32_t a = 0; a < chunk->code_count; a++) {
+            if (GET_OPCODE(chunk->code[a]) == ROP_IMPORT) {
+                unit->dropped[a] = true;
+            }
+        }
+
+        for (uint32_t a = 0; a < chunk->code_count; a++) {
+            unit->map[a] = next;
+            if (!unit->dropped[a]) {
+                next++;
+            }
+        }
+        unit->map[chunk->code_count] = next;
+    }
+    if (next > UINT16_MAX) {
+        return link_error(linker, "Linked program has %u instructions; at most %u are addressable.",
+                          next, UINT16_MAX);
+    }
+    return true;
+}
+
+// =============================================================================
+// TABLES
+// =============================================================================
+
+static uint32_t hash_constant(Value value) {
+    uint64_t bits;
+    switch (VALUE_TYPE(value)) {
+        case VAL_I32:    bits = (uint64_t)(uint32_t)AS_I32(value); break;
+        case VAL_I64:    bits = (uint64_t)AS_I64(value); break;
+        case VAL_U32:    bits = AS_U32(value); break;
+        case VAL_U64:    bits = AS_U64(value); break;
+        case VAL_BOOL:   bits = AS_BOOL(value); break;
+        case VAL_STRING: bits = AS_STRING(value)->hash; break;
+        case VAL_F64: {
+            double number = AS_F64(value);
+            memcpy(&bits, &number, sizeof(bits));
+            break;
+        }
+        default:         bits = 0; break;
+    }
+    bits ^= (uint64_t)VALUE_TYPE(value) << 56;
+    bits *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(bits >> 32);
+}
+
+/**
+ * @brief Place a constant in the output, reusing an equal one
+ */
+static uint32_t link_constant(Linker* linker, Value value) {
+    RegisterChunk* output = linker->output;
+    uint32_t mask = linker->constant_table_capacity - 1;
+    uint32_t slot = hash_constant(value) & mask;
+    while (linker->constant_table[slot] != NO_CONSTANT) {
+        uint32_t index = linker->constant_table[slot];
+        if (valuesEqual(output->constants[index], value)) {
+            return index;
+        }
+        slot = (slot + 1) & mask;
+    }
+    uint32_t index = output->constant_count++;
+    output->constants[index] = value;
+    linker->constant_table[slot] = index;
+    return index;
+}
+
+/**
+ * @brief Size the output constant pool and its lookup table for every input constant
+ */
+static bool reserve_constants(Linker* linker) {
+    uint64_t total = 0;
+    for (uint16_t u = 0; u < linker->unit_count; u++) {
+        total += linker->units[u].chunk->constant_count;
+    }
+
+    RegisterChunk* output = linker->output;
+    if (total > output->constant_capacity) {
+        Value* constants = realloc(output->constants, sizeof(Value) * total);
+        if (!constants) {
+            return link_error(linker, "Out of memory merging constants.");
+        }
+        output->constants = constants;
+        output->constant_capacity = (uint32_t)total;
+    }
+
+    uint32_t capacity = 16;
+    while (capacity < total * 2) {
+        capacity *= 2;
+    }
+    linker->constant_table = malloc(sizeof(uint32_t) * capacity);
+    if (!linker->constant_table) {
+        return link_error(linker, "Out of memory merging constants.");
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        linker->constant_table[i] = NO_CONSTANT;
+    }
+    linker->constant_table_capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Merge the field names, shapes and source files of a unit
+ */
+static bool merge_tables(Linker* linker, LinkUnit* unit) {
+    RegisterChunk* chunk = unit->chunk;
+    RegisterChunk* output = linker->output;
+
+    unit->field_names = malloc(chunk->field_name_count > 0 ? chunk->field_name_count : 1);
+    unit->shapes = malloc(chunk->shape_count > 0 ? chunk->shape_count : 1);
+    if (!unit->field_names || !unit->shapes) {
+        return link_error(linker, "Out of memory linking '%s'.", unit_name(unit));
+    }
+    for (uint16_t i = 0; i < chunk->field_name_count; i++) {
+        uint16_t field = register_chunk_add_field_name(output, chunk->field_names[i]);
+        if (field == UINT16_MAX) {
+            return link_error(linker, "Linked program uses more than %d field names.", MAX_FIELD_NAMES);
+        }
+        unit->field_names[i] = (uint8_t)field;
+    }
+
+    for (uint16_t i = 0; i < chunk->shape_count; i++) {
+        const StructShape* shape = &chunk->shapes[i];
+        const char* names[UINT8_MAX];
+        for (uint8_t k = 0; k < shape->field_count; k++) {
+            names[k] = chunk->field_names[shape->field_names[k]];
+        }
+        uint16_t id = register_chunk_add_shape(output, shape->name, names, shape->field_count);
+        if (id == 0) {
+            return link_error(linker, "Linked program uses more than %d struct types.", MAX_STRUCT_SHAPES);
+        }
+        // Shapes are matched by name; the layouts must agree
+        const StructShape* merged = &output->shapes[id - 1];
+        bool same = merged->field_count == shape->field_count;
+        for (uint8_t k = 0; same && k < shape->field_count; k++) {
+            same = merged->field_names[k] == unit->field_names[shape->field_names[k]];
+        }
+        if (!same) {
+            return link_error(linker, "Struct '%s' of '%s' has a different layout in another chunk.",
+                              shape->name, unit_name(unit));
+        }
+        unit->shapes[i] = (uint8_t)id;
+    }
+
+    uint16_t file_count = chunk->debug ? chunk->debug->source_file_count : 0;
+    unit->files = malloc(sizeof(uint16_t) * (file_count > 0 ? file_count : 1));
+    if (!unit->files) {
+        return link_error(linker, "Out of memory linking '%s'.", unit_name(unit));
+    }
+    for (uint16_t i = 0; i < file_count; i++) {
+        unit->files[i] = register_chunk_add_source_file(output, chunk->debug->source_files[i]);
+        if (unit->files[i] == UINT16_MAX) {
+            return link_error(linker, "Out of memory linking '%s'.", unit_name(unit));
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// EMISSION
+// =============================================================================
+
+/**
+ * @brief Rewrite one kept instruction for the output
+ */
+static bool translate_instruction(Linker* linker, uint16_t unit_index, uint32_t address,
+                                  uint32_t* result) {
+    LinkUnit* unit = &linker->units[unit_index];
+    RegisterChunk* chunk = unit->chunk;
+    uint32_t instruction = chunk->code[address];
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    RegisterOpcode base = get_base_opcode(opcode);
+    uint16_t imm = GET_IMM(instruction);
+    bool last = unit_index == linker->unit_count - 1;
+
+    if (has_code_target(base)) {
+        if (imm > chunk->code_count) {
+            return link_error(linker, "'%s' jumps to %u at %u, past the end of its code.",
+                              unit_name(unit), imm, address);
+        }
+        instruction = with_imm(instruction, unit->map[imm]);
+    } else if (base == ROP_MODULE_CALL) {
+        const SlotOwner* owner = &linker->owners[imm];
+        const LinkUnit* callee = &linker->units[owner->unit];
+        uint32_t start = callee->chunk->functions[owner->function].start_address;
+        instruction = MAKE_IMM_INSTRUCTION(ROP_CALL, GET_DST(instruction), callee->map[start]);
+    } else if (base == ROP_HALT && !last) {
+        // Module top levels fall through to the next chunk
+        instruction = MAKE_IMM_INSTRUCTION(ROP_JMP, 0, unit->map[chunk->code_count]);
+    } else if (base == ROP_LOAD_CONST) {
+        if (imm >= chunk->constant_count) {
+            return link_error(linker, "'%s' loads missing constant %u at %u.",
+                              unit_name(unit), imm, address);
+        }
+        if (unit->constants[imm] == NO_CONSTANT) {
+            unit->constants[imm] = link_constant(linker, chunk->constants[imm]);
+        }
+        if (unit->constants[imm] > UINT16_MAX) {
+            return link_error(linker, "Linked program has too many constants.");
+        }
+        instruction = with_imm(instruction, unit->constants[imm]);
+    } else if (base == ROP_GET_FIELD || base == ROP_SET_FIELD) {
+        int shift = base == ROP_GET_FIELD ? 24 : 16;
+        uint8_t field = (uint8_t)(instruction >> shift);
+        if (field >= chunk->field_name_count) {
+            return link_error(linker, "'%s' uses missing field name %u at %u.",
+                              unit_name(unit), field, address);
+        }
+        instruction = with_byte(instruction, shift, unit->field_names[field]);
+    } else if (base == ROP_NEW_STRUCT) {
+        uint8_t shape = GET_SRC2(instruction);
+        if (shape >= chunk->shape_count) {
+            return link_error(linker, "'%s' builds missing struct shape %u at %u.",
+                              unit_name(unit), shape, address);
+        }
+        instruction = with_byte(instruction, 24, (uint8_t)(unit->shapes[shape] - 1));
+    }
+
+    *result = instruction;
+    return true;
+}
+
+static bool emit_code(Linker* linker) {
+    RegisterChunk* output = linker->output;
+    for (uint16_t u = 0; u < linker->unit_count; u++) {
+        LinkUnit* unit = &linker->units[u];
+        RegisterChunk* chunk = unit->chunk;
+        for (uint32_t a = 0; a < chunk->code_count; a++) {
+            if (unit->dropped[a]) {
+                continue;
+            }
+            uint32_t instruction;
+            if (!translate_instruction(linker, u, a, &instruction)) {
+                return false;
+            }
+            const SourceLocation* location = register_chunk_get_location(chunk, a);
+            uint32_t out = register_chunk_add_instruction(output, instruction,
+                                                          location ? location->line : 0,
+                                                          location ? location->column : 0);
+            if (out == UINT32_MAX) {
+                return link_error(linker, "Out of memory emitting code.");
+            }
+            if (output->debug && out < output->debug->location_count && location &&
+                location->file_index < chunk->debug->source_file_count) {
+                output->debug->locations[out].file_index = unit->files[location->file_index];
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Add the kept functions and the globals that refer to them
+ */
+static bool emit_functions(Linker* linker) {
+    RegisterChunk* output = linker->output;
+    for (uint16_t u = 0; u < linker->unit_count; u++) {
+        LinkUnit* unit = &linker->units[u];
+        RegisterChunk* chunk = unit->chunk;
+        for (uint16_t f = 0; f < chunk->function_count; f++) {
+            unit->functions[f] = NO_FUNCTION;
+            if (!unit->kept[f]) {
+                continue;
+            }
+            const FunctionInfo* function = &chunk->functions[f];
+            uint32_t start = unit->map[function->start_address];
+            uint32_t end = unit->map[function->end_address + 1] - 1;
+            uint16_t index = register_chunk_add_function(output, function->name, start, end,
+                                                         function->parameter_count,
+                                                         function->return_type);
+            if (index == UINT16_MAX) {
+                return link_error(linker, "Out of memory adding function '%s'.", function->name);
+            }
+            FunctionInfo* merged = &output->functions[index];
+            merged->local_count = function->local_count;
+            merged->register_count = function->register_count;
+            merged->is_generic = function->is_generic;
+            merged->is_exported = function->is_exported;
+            merged->generic_param_count = function->generic_param_count;
+            merged->global_index = function->global_index;
+            unit->functions[f] = index;
+        }
+    }
+
+    for (uint16_t slot = 0; slot < linker->global_count; slot++) {
+        const SlotOwner* owner = &linker->owners[slot];
+        Value value = NIL_VAL;
+        if (owner->unit != NO_FUNCTION) {
+            uint16_t index = linker->units[owner->unit].functions[owner->function];
+            if (index != NO_FUNCTION) {
+                value = I32_VAL(index);
+            }
+        } else {
+            for (uint16_t u = 0; u < linker->unit_count && IS_NIL(value); u++) {
+                const RegisterChunk* chunk = linker->units[u].chunk;
+                if (slot < chunk->global_count) {
+                    value = chunk->globals[slot];
+                }
+            }
+        }
+        if (register_chunk_add_global(output, value) == UINT16_MAX) {
+            return link_error(linker, "Out of memory adding globals.");
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// LINKING
+// =============================================================================
+
+bool register_chunk_link(RegisterChunk* const* units, uint16_t unit_count,
+                         RegisterChunk* output, char* message, size_t size) {
+    Linker linker;
+    memset(&linker, 0, sizeof(Linker));
+    linker.unit_count = unit_count;
+    linker.output = output;
+    linker.message = message;
+    linker.message_size = size;
+    if (message && size > 0) {
+        message[0] = '\0';
+    }
+
+    if (!units || unit_count == 0 || !output) {
+        return link_error(&linker, "Nothing to link.");
+    }
+    if (!register_chunk_init(output, units[unit_count - 1]->module ?
+                                     units[unit_count - 1]->module->name : NULL)) {
+        return link_error(&linker, "Out of memory creating the linked chunk.");
+    }
+
+    uint32_t worklist_size = 0;
+    linker.units = calloc(unit_count, sizeof(LinkUnit));
+    for (uint16_t u = 0; u < unit_count; u++) {
+        if (units[u]->global_count > linker.global_count) {
+            linker.global_count = units[u]->global_count;
+        }
+        worklist_size += units[u]->function_count;
+    }
+    linker.owners = malloc(sizeof(SlotOwner) * (linker.global_count > 0 ? linker.global_count : 1));
+    linker.worklist = malloc(sizeof(uint16_t) * 2 * (worklist_size > 0 ? worklist_size : 1));
+
+    bool ok = linker.units && linker.owners && linker.worklist;
+    if (!ok) {
+        link_error(&linker, "Out of memory linking.");
+    }
+    for (uint16_t slot = 0; ok && slot < linker.global_count; slot++) {
+        linker.owners[slot].unit = NO_FUNCTION;
+    }
+    for (uint16_t u = 0; ok && u < unit_count; u++) {
+        linker.units[u].chunk = units[u];
+        ok = prepare_unit(&linker, u);
+    }
+    ok = ok && mark_reachable(&linker) && layout_units(&linker) && reserve_constants(&linker);
+
+    bool debug = false;
+    uint32_t level = UINT32_MAX;
+    for (uint16_t u = 0; ok && u < unit_count; u++) {
+        const RegisterChunk* chunk = units[u];
+        debug = debug || chunk->debug;
+        if (chunk->max_registers > output->max_registers) {
+            output->max_registers = chunk->max_registers;
+        }
+        if (chunk->optimization_level < level) {
+            level = chunk->optimization_level;
+        }
+        output->is_optimized = u == 0 ? chunk->is_optimized
+                                      : output->is_optimized && chunk->is_optimized;
+    }
+    if (ok && debug && !register_chunk_enable_debug(output)) {
+        ok = link_error(&linker, "Out of memory creating the linked chunk.");
+    }
+    output->optimization_level = ok ? level : 0;
+    for (uint16_t u = 0; ok && u < unit_count; u++) {
+        ok = merge_tables(&linker, &linker.units[u]);
+    }
+    ok = ok && emit_code(&linker) && emit_functions(&linker);
+
+    for (uint16_t u = 0; linker.units && u < unit_count; u++) {
+        free_unit(&linker.units[u]);
+    }
+    free(linker.units);
+    free(linker.owners);
+    free(linker.worklist);
+    free(linker.constant_table);
+    if (!ok) {
+        register_chunk_free(output);
+    }
+    return ok;
+}
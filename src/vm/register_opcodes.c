@@ -80,6 +80,18 @@ static const InstructionMetadata instruction_table[] = {
     { ROP_ADD_U64,     "ADD_U64",     "Add 64-bit unsigned",             INST_CAT_ARITHMETIC, 3, false, true,  true },
     { ROP_MUL_U32,     "MUL_U32",     "Multiply 32-bit unsigned",        INST_CAT_ARITHMETIC, 3, false, true,  true },
     { ROP_MUL_U64,     "MUL_U64",     "Multiply 64-bit unsigned",        INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_SUB_U32,     "SUB_U32",     "Subtract 32-bit unsigned",        INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_SUB_U64,     "SUB_U64",     "Subtract 64-bit unsigned",        INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_DIV_U32,     "DIV_U32",     "Divide 32-bit unsigned",          INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_DIV_U64,     "DIV_U64",     "Divide 64-bit unsigned",          INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_MOD_U32,     "MOD_U32",     "Modulo 32-bit unsigned",          INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_MOD_U64,     "MOD_U64",     "Modulo 64-bit unsigned",          INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_ADD_ANY,     "ADD_ANY",     "Add numbers of any one type",     INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_SUB_ANY,     "SUB_ANY",     "Subtract numbers of any one type",INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_MUL_ANY,     "MUL_ANY",     "Multiply numbers of any one type",INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_DIV_ANY,     "DIV_ANY",     "Divide numbers of any one type",  INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_MOD_ANY,     "MOD_ANY",     "Modulo integers of any one type", INST_CAT_ARITHMETIC, 3, false, true,  true },
+    { ROP_NEG_ANY,     "NEG_ANY",     "Negate a signed number",          INST_CAT_ARITHMETIC, 2, false, true,  true },
     
     // Floating Point Instructions
     { ROP_ADD_F64,     "ADD_F64",     "Add 64-bit floats",               INST_CAT_ARITHMETIC, 3, false, false, true },
@@ -131,10 +143,12 @@ static const InstructionMetadata instruction_table[] = {
     { ROP_TYPE_OF,     "TYPE_OF",     "Get type of value",               INST_CAT_TYPE,       2, false, true,  false },
     { ROP_IS_TYPE,     "IS_TYPE",     "Check if value is specific type", INST_CAT_TYPE,       3, false, false, false },
     { ROP_TYPE_CHECK,  "TYPE_CHECK",  "Runtime type check",              INST_CAT_TYPE,       2, false, true,  false },
+    { ROP_GENERIC_CAST,"GENERIC_CAST","Cast to the type kind in src2",   INST_CAT_GENERIC,    3, false, true,  false },
     
     // Object Instructions
     { ROP_NEW_OBJECT,  "NEW_OBJECT",  "Create new object",               INST_CAT_OBJECT,     2, true,  true,  false },
     { ROP_NEW_ARRAY,   "NEW_ARRAY",   "Create new array",                INST_CAT_OBJECT,     2, true,  true,  false },
+    { ROP_NEW_PACKED_ARRAY,"NEW_PACKED_ARRAY","Create new packed array", INST_CAT_OBJECT,     2, true,  true,  false },
     { ROP_NEW_STRING,  "NEW_STRING",  "Create new string",               INST_CAT_OBJECT,     2, true,  true,  false },
     { ROP_NEW_STRUCT,  "NEW_STRUCT",  "Create new struct",               INST_CAT_OBJECT,     2, true,  true,  false },
     { ROP_NEW_ENUM,    "NEW_ENUM",    "Create new enum",                 INST_CAT_OBJECT,     2, true,  true,  false },
@@ -146,6 +160,32 @@ static const InstructionMetadata instruction_table[] = {
     { ROP_CALL_METHOD, "CALL_METHOD", "Call object method",              INST_CAT_OBJECT,     2, true,  true,  false },
     { ROP_CALL_STATIC, "CALL_STATIC", "Call static method",              INST_CAT_OBJECT,     2, true,  true,  false },
     
+    // Array Instructions
+    { ROP_ARRAY_PUSH,  "ARRAY_PUSH",  "Push element to array",           INST_CAT_ARRAY,      2, true,  true,  false },
+    { ROP_ARRAY_POP,   "ARRAY_POP",   "Pop element from array",          INST_CAT_ARRAY,      2, true,  true,  false },
+    { ROP_ARRAY_RESERVE,"ARRAY_RESERVE","Grow array capacity",           INST_CAT_ARRAY,      2, true,  true,  false },
+    { ROP_ARRAY_SLICE, "ARRAY_SLICE", "Create array slice",              INST_CAT_ARRAY,      3, false, true,  false },
+    
+    // String Instructions
+    { ROP_STR_CONCAT,  "STR_CONCAT",  "Concatenate strings",             INST_CAT_STRING,     3, false, true,  false },
+    { ROP_STR_BUILDER_NEW,"STR_BUILDER_NEW","Start a string builder",    INST_CAT_STRING,     2, false, true,  false },
+    { ROP_STR_BUILDER_APPEND,"STR_BUILDER_APPEND","Append to a string builder", INST_CAT_STRING, 2, true, true, false },
+    { ROP_STR_BUILDER_FINISH,"STR_BUILDER_FINISH","Finish a string builder", INST_CAT_STRING, 2, false, true, false },
+    
+    // Typed Register Lane Instructions
+    { ROP_UNBOX_I64,   "UNBOX_I64",   "Unbox register into I lane",      INST_CAT_LANE,       2, false, true,  false },
+    { ROP_UNBOX_F64,   "UNBOX_F64",   "Unbox register into F lane",      INST_CAT_LANE,       2, false, true,  false },
+    { ROP_BOX_I64,     "BOX_I64",     "Box I lane into register",        INST_CAT_LANE,       2, false, true,  false },
+    { ROP_BOX_F64,     "BOX_F64",     "Box F lane into register",        INST_CAT_LANE,       2, false, false, false },
+    { ROP_LANE_ADD_I64,"LANE_ADD_I64","Add I lanes",                     INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_SUB_I64,"LANE_SUB_I64","Subtract I lanes",                INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_MUL_I64,"LANE_MUL_I64","Multiply I lanes",                INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_ADD_F64,"LANE_ADD_F64","Add F lanes",                     INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_SUB_F64,"LANE_SUB_F64","Subtract F lanes",                INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_MUL_F64,"LANE_MUL_F64","Multiply F lanes",                INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_DIV_F64,"LANE_DIV_F64","Divide F lanes",                  INST_CAT_LANE,       3, false, false, false },
+    { ROP_LANE_LT_I64, "LANE_LT_I64", "Less than on I lanes",            INST_CAT_LANE,       3, false, false, false },
+    
     // Built-in Function Instructions
     { ROP_PRINT,       "PRINT",       "Print value",                     INST_CAT_BUILTIN,    1, true,  false, false },
     { ROP_INPUT,       "INPUT",       "Read input",                      INST_CAT_BUILTIN,    1, true,  true,  false },
@@ -157,8 +197,52 @@ static const InstructionMetadata instruction_table[] = {
     { ROP_SORTED,      "SORTED",      "Sort array (new copy)",           INST_CAT_BUILTIN,    2, true,  true,  false },
     { ROP_REVERSED,    "REVERSED",    "Reverse array (new copy)",        INST_CAT_BUILTIN,    2, true,  true,  false },
     { ROP_TIMESTAMP,   "TIMESTAMP",   "Get timestamp",                   INST_CAT_BUILTIN,    1, false, false, false },
+    
+    // Exception Handling Instructions
+    { ROP_TRY_BEGIN,   "TRY_BEGIN",   "Install exception handler",       INST_CAT_EXCEPTION,  2, true,  true,  false },
+    { ROP_TRY_END,     "TRY_END",     "Remove exception handler",        INST_CAT_EXCEPTION,  0, true,  false, false },
+    
+    // Module Instructions (resolved by the linker before execution)
+    { ROP_IMPORT,      "IMPORT",      "Import module",                   INST_CAT_MODULE,     1, true,  true,  false },
+    { ROP_EXPORT,      "EXPORT",      "Export symbol",                   INST_CAT_MODULE,     2, true,  true,  false },
+    { ROP_MODULE_CALL, "MODULE_CALL", "Call function in module",         INST_CAT_MODULE,     1, true,  true,  false },
+    { ROP_MODULE_GET,  "MODULE_GET",  "Get module symbol",               INST_CAT_MODULE,     2, false, true,  false },
+    { ROP_MODULE_SET,  "MODULE_SET",  "Set module symbol",               INST_CAT_MODULE,     2, true,  true,  false },
+    
+    // Superinstructions (operands are those of the first fused word)
+    { ROP_LT_I32_JZ,   "LT_I32_JZ",   "Less than, jump if false",        INST_CAT_SUPER,      3, true,  true,  false },
+    { ROP_LT_I32_JNZ,  "LT_I32_JNZ",  "Less than, jump if true",         INST_CAT_SUPER,      3, true,  true,  false },
+    { ROP_EQ_I32_JZ,   "EQ_I32_JZ",   "Equal, jump if false",            INST_CAT_SUPER,      3, true,  false, false },
+    { ROP_EQ_I32_JNZ,  "EQ_I32_JNZ",  "Equal, jump if true",             INST_CAT_SUPER,      3, true,  false, false },
+    { ROP_ADD_I32_JMP, "ADD_I32_JMP", "Add 32-bit integers, jump",       INST_CAT_SUPER,      3, true,  true,  true },
+    { ROP_INC_LT_I32_JNZ,"INC_LT_I32_JNZ","Increment, compare, loop",    INST_CAT_SUPER,      3, true,  true,  true },
+    { ROP_LOAD_CONST_ADD_I32,"LOAD_CONST_ADD_I32","Load constant, add i32", INST_CAT_SUPER,   2, false, true,  true },
+    { ROP_LOAD_CONST_ADD_F64,"LOAD_CONST_ADD_F64","Load constant, add f64", INST_CAT_SUPER,   2, false, true,  true },
+    { ROP_LOAD_CONST_MUL_F64,"LOAD_CONST_MUL_F64","Load constant, mul f64", INST_CAT_SUPER,   2, false, true,  true },
+};
+
+/**
+ * @brief Superinstruction table
+ * 
+ * Chosen from opcode pair/triple profiles of loop-heavy programs (see
+ * registervm_print_opcode_profile). Longer patterns come first so that
+ * match_superinstruction prefers them.
+ */
+static const SuperinstructionInfo superinstruction_table[] = {
+    { ROP_INC_LT_I32_JNZ,     3, { ROP_ADD_I32, ROP_LT_I32, ROP_JNZ } },
+    { ROP_LT_I32_JZ,          2, { ROP_LT_I32, ROP_JZ } },
+    { ROP_LT_I32_JNZ,         2, { ROP_LT_I32, ROP_JNZ } },
+    { ROP_EQ_I32_JZ,          2, { ROP_EQ_I32, ROP_JZ } },
+    { ROP_EQ_I32_JNZ,         2, { ROP_EQ_I32, ROP_JNZ } },
+    { ROP_ADD_I32_JMP,        2, { ROP_ADD_I32, ROP_JMP } },
+    { ROP_LOAD_CONST_ADD_I32, 2, { ROP_LOAD_CONST, ROP_ADD_I32 } },
+    { ROP_LOAD_CONST_ADD_F64, 2, { ROP_LOAD_CONST, ROP_ADD_F64 } },
+    { ROP_LOAD_CONST_MUL_F64, 2, { ROP_LOAD_CONST, ROP_MUL_F64 } },
 };
 
+/** Number of entries in the superinstruction table */
+#define SUPERINSTRUCTION_TABLE_SIZE (sizeof(superinstruction_table) / sizeof(SuperinstructionInfo))
+
 /** Number of entries in the instruction table */
 #define INSTRUCTION_TABLE_SIZE (sizeof(instruction_table) / sizeof(InstructionMetadata))
 
@@ -196,6 +280,52 @@ bool instruction_can_throw(RegisterOpcode opcode) {
     return meta ? meta->can_throw : true; // Conservative default
 }
 
+// =============================================================================
+// SUPERINSTRUCTIONS
+// =============================================================================
+
+const SuperinstructionInfo* get_superinstruction_info(RegisterOpcode opcode) {
+    for (size_t i = 0; i < SUPERINSTRUCTION_TABLE_SIZE; i++) {
+        if (superinstruction_table[i].opcode == opcode) {
+            return &superinstruction_table[i];
+        }
+    }
+    return NULL;
+}
+
+RegisterOpcode get_base_opcode(RegisterOpcode opcode) {
+    if (opcode < ROP_LT_I32_JZ || opcode > ROP_LOAD_CONST_MUL_F64) {
+        return opcode; // Fast path: not in the superinstruction range
+    }
+    const SuperinstructionInfo* info = get_superinstruction_info(opcode);
+    return info ? info->pattern[0] : opcode;
+}
+
+const SuperinstructionInfo* match_superinstruction(const uint32_t* code, uint32_t remaining) {
+    if (!code) {
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < SUPERINSTRUCTION_TABLE_SIZE; i++) {
+        const SuperinstructionInfo* info = &superinstruction_table[i];
+        if (info->length > remaining) {
+            continue;
+        }
+        
+        bool matches = true;
+        for (uint8_t k = 0; k < info->length; k++) {
+            if (GET_OPCODE(code[k]) != info->pattern[k]) {
+                matches = false;
+                break;
+            }
+        }
+        if (matches) {
+            return info;
+        }
+    }
+    return NULL;
+}
+
 // =============================================================================
 // INSTRUCTION VALIDATION
 // =============================================================================
@@ -251,6 +381,14 @@ bool validate_instruction(uint32_t instruction) {
             }
             break;
             
+        case INST_CAT_LANE:
+            // Lane operands index the untagged banks, which have no special registers
+            if (dst >= LANE_REGISTER_COUNT || src1 >= LANE_REGISTER_COUNT ||
+                (meta->operand_count == 3 && src2 >= LANE_REGISTER_COUNT)) {
+                return false;
+            }
+            break;
+            
         default:
             // Other categories pass basic validation
             break;
@@ -282,6 +420,44 @@ int disassemble_instruction(uint32_t instruction, char* buffer, size_t buffer_si
                        opcode, dst, src1, src2);
     }
     
+    // Lane operands are printed with their lane prefix (I/F) instead of R
+    if (meta->category == INST_CAT_LANE) {
+        switch (opcode) {
+            case ROP_UNBOX_I64:
+                return snprintf(buffer, buffer_size, "%s I%d, R%d", name, dst, src1);
+            case ROP_UNBOX_F64:
+                return snprintf(buffer, buffer_size, "%s F%d, R%d", name, dst, src1);
+            case ROP_BOX_I64:
+                return snprintf(buffer, buffer_size, "%s R%d, I%d", name, dst, src1);
+            case ROP_BOX_F64:
+                return snprintf(buffer, buffer_size, "%s R%d, F%d", name, dst, src1);
+            case ROP_LANE_LT_I64:
+                return snprintf(buffer, buffer_size, "%s R%d, I%d, I%d", name, dst, src1, src2);
+            case ROP_LANE_ADD_F64:
+            case ROP_LANE_SUB_F64:
+            case ROP_LANE_MUL_F64:
+            case ROP_LANE_DIV_F64:
+                return snprintf(buffer, buffer_size, "%s F%d, F%d, F%d", name, dst, src1, src2);
+            default:
+                return snprintf(buffer, buffer_size, "%s I%d, I%d, I%d", name, dst, src1, src2);
+        }
+    }
+    
+    // Operands that are neither registers nor the usual immediate
+    switch (opcode) {
+        case ROP_PRINT:
+            // A nonzero src2 suppresses the newline
+            return snprintf(buffer, buffer_size, "%s R%d, #%d", name, src1, src2);
+        case ROP_TRY_BEGIN:
+            return snprintf(buffer, buffer_size, "%s G%d, #%d", name, dst, imm);
+        case ROP_IMPORT:
+            return snprintf(buffer, buffer_size, "%s #%d", name, imm);
+        case ROP_GENERIC_CAST:
+            return snprintf(buffer, buffer_size, "%s R%d, R%d, kind %d", name, dst, src1, src2);
+        default:
+            break;
+    }
+    
     // Format instruction based on operand count and type
     switch (meta->operand_count) {
         case 0:
@@ -289,7 +465,7 @@ int disassemble_instruction(uint32_t instruction, char* buffer, size_t buffer_si
             
         case 1:
             // Check if it's an immediate instruction
-            if (opcode == ROP_JMP || opcode == ROP_CALL || 
+            if (opcode == ROP_JMP || opcode == ROP_CALL || opcode == ROP_MODULE_CALL ||
                 opcode == ROP_LOAD_IMM || opcode == ROP_LOAD_CONST ||
                 opcode == ROP_LOAD_GLOBAL || opcode == ROP_STORE_GLOBAL) {
                 return snprintf(buffer, buffer_size, "%s R%d, #%d", name, dst, imm);
@@ -299,12 +475,12 @@ int disassemble_instruction(uint32_t instruction, char* buffer, size_t buffer_si
             
         case 2:
             // Check for immediate operands
-            if (opcode == ROP_LOAD_IMM || opcode == ROP_LOAD_CONST ||
+            if (opcode == ROP_LOAD_IMM || get_base_opcode(opcode) == ROP_LOAD_CONST ||
                 opcode == ROP_LOAD_GLOBAL || opcode == ROP_STORE_GLOBAL ||
                 opcode == ROP_LOAD_LOCAL || opcode == ROP_STORE_LOCAL) {
                 return snprintf(buffer, buffer_size, "%s R%d, #%d", name, dst, imm);
             } else if (opcode == ROP_JZ || opcode == ROP_JNZ) {
-                return snprintf(buffer, buffer_size, "%s R%d, #%d", name, src1, imm);
+                return snprintf(buffer, buffer_size, "%s R%d, #%d", name, dst, imm);
             } else {
                 return snprintf(buffer, buffer_size, "%s R%d, R%d", name, dst, src1);
             }
@@ -327,7 +503,7 @@ int disassemble_instruction(uint32_t instruction, char* buffer, size_t buffer_si
  * @brief Check if instruction modifies a register
  */
 bool instruction_modifies_register(uint32_t instruction, uint8_t reg) {
-    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    RegisterOpcode opcode = get_base_opcode((RegisterOpcode)GET_OPCODE(instruction));
     uint8_t dst = GET_DST(instruction);
     
     const InstructionMetadata* meta = get_instruction_metadata(opcode);
@@ -335,6 +511,12 @@ bool instruction_modifies_register(uint32_t instruction, uint8_t reg) {
         return false;
     }
     
+    // Lane arithmetic and unboxing write to the untagged lanes only
+    if (meta->category == INST_CAT_LANE && opcode != ROP_BOX_I64 &&
+        opcode != ROP_BOX_F64 && opcode != ROP_LANE_LT_I64) {
+        return false;
+    }
+    
     // Most instructions write to the destination register
     switch (opcode) {
         case ROP_NOP:
@@ -362,10 +544,21 @@ bool instruction_modifies_register(uint32_t instruction, uint8_t reg) {
         case ROP_CMP_F64:
         case ROP_SET_FIELD:
         case ROP_SET_INDEX:
+        case ROP_ARRAY_PUSH:
+        case ROP_ARRAY_RESERVE:
         case ROP_PRINT:
+        case ROP_TRY_BEGIN:
+        case ROP_TRY_END:
+        case ROP_IMPORT:
             // These instructions don't modify registers (except possibly special ones)
             return false;
             
+        case ROP_BOX_I64:
+        case ROP_BOX_F64:
+        case ROP_LANE_LT_I64:
+            // Lane instructions that materialize a tagged result
+            return (dst == reg);
+            
         case ROP_POP:
             // POP modifies the specified register
             return (dst == reg);
@@ -380,7 +573,7 @@ bool instruction_modifies_register(uint32_t instruction, uint8_t reg) {
  * @brief Check if instruction reads from a register
  */
 bool instruction_reads_register(uint32_t instruction, uint8_t reg) {
-    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    RegisterOpcode opcode = get_base_opcode((RegisterOpcode)GET_OPCODE(instruction));
     uint8_t dst = GET_DST(instruction);
     uint8_t src1 = GET_SRC1(instruction);
     uint8_t src2 = GET_SRC2(instruction);
@@ -390,6 +583,30 @@ bool instruction_reads_register(uint32_t instruction, uint8_t reg) {
         return false;
     }
     
+    // Only unboxing reads a tagged register; other lane operands are untagged
+    if (meta->category == INST_CAT_LANE) {
+        return opcode == ROP_UNBOX_I64 || opcode == ROP_UNBOX_F64 ? src1 == reg : false;
+    }
+    
+    // Immediate forms keep an index or target where src1 would be
+    switch (opcode) {
+        case ROP_JZ:
+        case ROP_JNZ:
+        case ROP_STORE_GLOBAL:
+            return dst == reg;
+        case ROP_PRINT:
+            return src1 == reg;
+        case ROP_LOAD_IMM:
+        case ROP_LOAD_CONST:
+        case ROP_LOAD_GLOBAL:
+        case ROP_TRY_BEGIN:
+        case ROP_IMPORT:
+        case ROP_MODULE_CALL:
+            return false;
+        default:
+            break;
+    }
+    
     // Check each operand
     switch (meta->operand_count) {
         case 3:
@@ -400,7 +617,7 @@ bool instruction_reads_register(uint32_t instruction, uint8_t reg) {
             // Fall through
         case 1:
             // Some single-operand instructions read from dst
-            if (opcode == ROP_PUSH || opcode == ROP_PRINT || opcode == ROP_RET_VAL) {
+            if (opcode == ROP_PUSH || opcode == ROP_RET_VAL) {
                 if (dst == reg) return true;
             }
             break;
@@ -422,9 +639,14 @@ uint32_t get_instruction_cost(RegisterOpcode opcode) {
             
         case INST_CAT_ARITHMETIC:
             if (opcode == ROP_DIV_I32 || opcode == ROP_DIV_I64 || 
-                opcode == ROP_DIV_F64 || opcode == ROP_MOD_I32 || opcode == ROP_MOD_I64) {
+                opcode == ROP_DIV_F64 || opcode == ROP_MOD_I32 || opcode == ROP_MOD_I64 ||
+                (opcode >= ROP_DIV_U32 && opcode <= ROP_MOD_U64) ||
+                opcode == ROP_DIV_ANY || opcode == ROP_MOD_ANY) {
                 return 10; // Division is expensive
             }
+            if (opcode >= ROP_ADD_ANY && opcode <= ROP_NEG_ANY) {
+                return 2; // Dispatch on the operand tags first
+            }
             if (opcode >= ROP_ADD_F64 && opcode <= ROP_ROUND_F64) {
                 return 2; // Floating point operations
             }
@@ -448,9 +670,18 @@ uint32_t get_instruction_cost(RegisterOpcode opcode) {
         case INST_CAT_ARRAY:
             return 3; // Array operations
             
+        case INST_CAT_LANE:
+            if (opcode == ROP_LANE_DIV_F64) {
+                return 10;
+            }
+            return 1; // Untagged arithmetic, no type checks
+            
         case INST_CAT_BUILTIN:
             return 10; // Built-in functions vary widely
             
+        case INST_CAT_SUPER:
+            return 2; // Several operations for a single dispatch
+            
         default:
             return 1; // Default cost
     }
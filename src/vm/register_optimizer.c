@@ -0,0 +1,1668 @@
+/**
+ * @file register_optimizer.c
+ * @brief Orus Register VM Bytecode Optimizer
+ *
+ * This file implements the pass pipeline behind register_chunk_optimize().
+ * Each level includes the passes of the levels below it:
+ *
+ * - Level 1: redundant move elimination, jump threading, NOP stripping and
+ *   superinstruction fusion
+ * - Level 2: constant folding and propagation, branch folding, unreachable
+ *   code removal and liveness-based dead code elimination
+ * - Level 3: loop-invariant code motion
+ *
+ * Passes that look at control flow only run on chunks whose every
+ * instruction is understood here and whose register operands are in range.
+ * Whenever instructions move, jump targets, function ranges, debug
+ * locations and exported addresses are remapped together.
+ *
+ * @author Orus Development Team
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../include/register_chunk.h"
+#include "../../include/register_opcodes.h"
+#include "../../include/register_vm.h"
+#include "../../include/value.h"
+
+// =============================================================================
+// PRIVATE CONSTANTS
+// =============================================================================
+
+/** Highest level accepted by register_chunk_optimize */
+#define MAX_OPTIMIZATION_LEVEL 3
+
+/** Marker for an instruction that writes no register */
+#define NO_REGISTER (-1)
+
+#if TOTAL_REGISTER_COUNT > 64
+#error "register_optimizer.c keeps register sets in a 64-bit mask"
+#endif
+
+/** Set of registers, one bit per register */
+typedef uint64_t RegisterSet;
+
+/** Every register of the register file */
+#define ALL_REGISTERS                                                      \
+    (TOTAL_REGISTER_COUNT == 64 ? ~(RegisterSet)0                          \
+                                : (((RegisterSet)1 << TOTAL_REGISTER_COUNT) - 1))
+
+#define REGISTER_BIT(reg) ((RegisterSet)1 << (reg))
+
+// =============================================================================
+// PRIVATE TYPES
+// =============================================================================
+
+/**
+ * @brief Registers read and written by one instruction
+ */
+typedef struct {
+    int dst;                      /**< Register written, or NO_REGISTER */
+    int uses[2];                  /**< Registers read */
+    int use_count;                /**< Number of registers read */
+    bool sets_flags;              /**< Whether the comparison flags change */
+} InstructionEffect;
+
+/**
+ * @brief Constant propagation lattice
+ */
+typedef enum {
+    FACT_UNDEF,                   /**< No path reaches here yet */
+    FACT_CONST,                   /**< Known value */
+    FACT_TYPED,                   /**< Known type, unknown value */
+    FACT_ANY                      /**< Nothing known */
+} FactKind;
+
+/**
+ * @brief What constant propagation knows about one register
+ */
+typedef struct {
+    uint8_t kind;                 /**< FactKind */
+    uint8_t type;                 /**< ValueType for FACT_CONST and FACT_TYPED */
+    Value value;                  /**< Value for FACT_CONST */
+} RegisterFact;
+
+/**
+ * @brief Basic block partition of a chunk
+ */
+typedef struct {
+    uint32_t* block_of;           /**< Block index of each instruction */
+    uint32_t* starts;             /**< First address of each block */
+    uint32_t count;               /**< Number of blocks */
+} BlockMap;
+
+/**
+ * @brief A natural loop given by a backward branch
+ */
+typedef struct {
+    uint32_t header;              /**< Branch target, first instruction of the loop */
+    uint32_t tail;                /**< Address of the backward branch */
+} LoopRange;
+
+// =============================================================================
+// PRIVATE FUNCTION DECLARATIONS
+// =============================================================================
+
+static void defuse_superinstructions(RegisterChunk* chunk);
+static uint32_t fuse_superinstructions(RegisterChunk* chunk);
+static bool chunk_is_analyzable(const RegisterChunk* chunk);
+static bool chunk_reads_flags(const RegisterChunk* chunk);
+static uint32_t eliminate_redundant_moves(RegisterChunk* chunk);
+static uint32_t thread_jumps(RegisterChunk* chunk);
+static bool strip_nops(RegisterChunk* chunk);
+static bool propagate_constants(RegisterChunk* chunk);
+static bool eliminate_dead_code(RegisterChunk* chunk);
+static bool hoist_loop_invariants(RegisterChunk* chunk);
+
+// =============================================================================
+// OPTIMIZATION
+// =============================================================================
+
+bool register_chunk_optimize(RegisterChunk* chunk, uint32_t level) {
+    if (!chunk || !chunk->code || level > MAX_OPTIMIZATION_LEVEL) {
+        return false;
+    }
+
+    bool ok = true;
+
+    // Work on plain opcodes; fusion runs again at the end
+    defuse_superinstructions(chunk);
+
+    if (level >= 1 && chunk_is_analyzable(chunk)) {
+        eliminate_redundant_moves(chunk);
+        thread_jumps(chunk);
+
+        if (level >= 2) {
+            ok = propagate_constants(chunk) && ok;
+            thread_jumps(chunk);
+            ok = eliminate_dead_code(chunk) && ok;
+        }
+
+        ok = strip_nops(chunk) && ok;
+
+        if (level >= 3) {
+            ok = hoist_loop_invariants(chunk) && ok;
+        }
+    }
+
+    if (level >= 1) {
+        fuse_superinstructions(chunk);
+    }
+
+    // Code changed: re-verify on next load and keep a stored checksum valid
+    chunk->is_verified = false;
+    if (chunk->checksum != 0) {
+        chunk->checksum = register_chunk_checksum(chunk);
+    }
+
+    chunk->is_optimized = level > 0;
+    chunk->optimization_level = level;
+    return ok;
+}
+
+bool register_chunk_is_optimized(const RegisterChunk* chunk) {
+    return chunk && chunk->is_optimized;
+}
+
+// =============================================================================
+// INSTRUCTION HELPERS
+// =============================================================================
+
+/**
+ * @brief Whether the immediate of an opcode is a code address
+ */
+static bool has_code_target(RegisterOpcode opcode) {
+    return opcode == ROP_JMP || opcode == ROP_CALL ||
+           (opcode >= ROP_JZ && opcode <= ROP_JGE);
+}
+
+/**
+ * @brief Whether an opcode is a jump (calls excluded)
+ */
+static bool is_jump(RegisterOpcode opcode) {
+    return opcode == ROP_JMP || (opcode >= ROP_JZ && opcode <= ROP_JGE);
+}
+
+/**
+ * @brief Whether an opcode ends a basic block
+ */
+static bool ends_block(RegisterOpcode opcode) {
+    return has_code_target(opcode) || opcode == ROP_HALT ||
+           opcode == ROP_RET || opcode == ROP_RET_VAL;
+}
+
+/**
+ * @brief Replace the immediate field of an instruction
+ */
+static uint32_t with_imm(uint32_t instruction, uint32_t imm) {
+    return (instruction & 0xFFFFu) | (imm << 16);
+}
+
+/**
+ * @brief Control-flow successors of an instruction
+ *
+ * @param chunk Chunk being analyzed
+ * @param address Instruction address
+ * @param successors Output addresses (at most two, branch target first)
+ * @return Number of successors
+ */
+static int get_successors(const RegisterChunk* chunk, uint32_t address, uint32_t* successors) {
+    uint32_t instruction = chunk->code[address];
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    int count = 0;
+
+    if (opcode == ROP_HALT || opcode == ROP_RET || opcode == ROP_RET_VAL) {
+        return 0;
+    }
+    if (has_code_target(opcode)) {
+        successors[count++] = GET_IMM(instruction);
+    }
+    if (opcode != ROP_JMP && address + 1 < chunk->code_count) {
+        successors[count++] = address + 1;
+    }
+    return count;
+}
+
+/**
+ * @brief Describe the register operands of an instruction
+ *
+ * Only opcodes the register VM implements are described; anything else
+ * (or an operand outside the register file) makes the chunk unanalyzable.
+ *
+ * @param instruction Instruction word
+ * @param effect Output operands
+ * @return false if the instruction is not understood
+ */
+static bool describe_instruction(uint32_t instruction, InstructionEffect* effect) {
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    int dst = GET_DST(instruction);
+    int src1 = GET_SRC1(instruction);
+    int src2 = GET_SRC2(instruction);
+
+    effect->dst = NO_REGISTER;
+    effect->use_count = 0;
+    effect->sets_flags = false;
+
+    switch (opcode) {
+        case ROP_NOP:
+        case ROP_HALT:
+        case ROP_JMP:
+        case ROP_JEQ:
+        case ROP_JNE:
+        case ROP_JLT:
+        case ROP_JLE:
+        case ROP_JGT:
+        case ROP_JGE:
+        case ROP_CALL:
+        case ROP_RET:
+        case ROP_LANE_ADD_I64:
+        case ROP_LANE_SUB_I64:
+        case ROP_LANE_MUL_I64:
+        case ROP_LANE_ADD_F64:
+        case ROP_LANE_SUB_F64:
+        case ROP_LANE_MUL_F64:
+        case ROP_LANE_DIV_F64:
+            break;
+
+        case ROP_JZ:
+        case ROP_JNZ:
+        case ROP_STORE_GLOBAL:
+        case ROP_RET_VAL:
+            effect->uses[effect->use_count++] = dst;
+            break;
+
+        case ROP_PRINT:
+        case ROP_UNBOX_I64:
+        case ROP_UNBOX_F64:
+            effect->uses[effect->use_count++] = src1;
+            break;
+
+        case ROP_STR_BUILDER_APPEND:
+            effect->uses[effect->use_count++] = dst;
+            effect->uses[effect->use_count++] = src1;
+            break;
+
+        case ROP_LOAD_IMM:
+        case ROP_LOAD_CONST:
+        case ROP_LOAD_GLOBAL:
+        case ROP_BOX_I64:
+        case ROP_BOX_F64:
+        case ROP_LANE_LT_I64:
+            effect->dst = dst;
+            break;
+
+        case ROP_MOVE:
+        case ROP_TYPE_OF:
+        case ROP_STR_BUILDER_NEW:
+        case ROP_STR_BUILDER_FINISH:
+            effect->dst = dst;
+            effect->uses[effect->use_count++] = src1;
+            break;
+
+        case ROP_NEG_I32:
+            effect->dst = dst;
+            effect->uses[effect->use_count++] = src1;
+            effect->sets_flags = true;
+            break;
+
+        case ROP_ADD_I32:
+        case ROP_SUB_I32:
+        case ROP_MUL_I32:
+        case ROP_DIV_I32:
+        case ROP_MOD_I32:
+        case ROP_ADD_I64:
+        case ROP_SUB_I64:
+        case ROP_MUL_I64:
+        case ROP_DIV_I64:
+        case ROP_MOD_I64:
+        case ROP_ADD_F64:
+        case ROP_SUB_F64:
+        case ROP_MUL_F64:
+        case ROP_DIV_F64:
+        case ROP_ADD_U32:
+        case ROP_SUB_U32:
+        case ROP_MUL_U32:
+        case ROP_DIV_U32:
+        case ROP_MOD_U32:
+        case ROP_ADD_U64:
+        case ROP_SUB_U64:
+        case ROP_MUL_U64:
+        case ROP_DIV_U64:
+        case ROP_MOD_U64:
+        case ROP_ADD_ANY:
+        case ROP_SUB_ANY:
+        case ROP_MUL_ANY:
+        case ROP_DIV_ANY:
+        case ROP_MOD_ANY:
+            effect->dst = dst;
+            effect->uses[effect->use_count++] = src1;
+            effect->uses[effect->use_count++] = src2;
+            effect->sets_flags = true;
+            break;
+
+        case ROP_CMP_I32:
+        case ROP_CMP_I64:
+        case ROP_CMP_F64:
+            effect->uses[effect->use_count++] = src1;
+            effect->uses[effect->use_count++] = src2;
+            effect->sets_flags = true;
+            break;
+
+        case ROP_EQ_I32:
+        case ROP_EQ_STR:
+        case ROP_EQ_OBJ:
+        case ROP_NE_I32:
+        case ROP_LT_I32:
+        case ROP_LE_I32:
+        case ROP_GT_I32:
+        case ROP_GE_I32:
+        case ROP_STR_CONCAT:
+            effect->dst = dst;
+            effect->uses[effect->use_count++] = src1;
+            effect->uses[effect->use_count++] = src2;
+            break;
+
+        default:
+            return false;
+    }
+
+    // Lane operands are checked against the lane file
+    if (get_instruction_category(opcode) == INST_CAT_LANE) {
+        bool writes_lane = opcode != ROP_BOX_I64 && opcode != ROP_BOX_F64 &&
+                           opcode != ROP_LANE_LT_I64;
+        bool reads_lanes = opcode != ROP_UNBOX_I64 && opcode != ROP_UNBOX_F64;
+        if (writes_lane && dst >= LANE_REGISTER_COUNT) return false;
+        if (reads_lanes && src1 >= LANE_REGISTER_COUNT) return false;
+        if (opcode >= ROP_LANE_ADD_I64 && src2 >= LANE_REGISTER_COUNT) return false;
+    }
+
+    if (effect->dst >= TOTAL_REGISTER_COUNT) {
+        return false;
+    }
+    for (int i = 0; i < effect->use_count; i++) {
+        if (effect->uses[i] >= TOTAL_REGISTER_COUNT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Whether an instruction can be deleted when its result is unused
+ *
+ * These never fault once their operands are in range and leave the flags
+ * alone.
+ */
+static bool is_removable(const RegisterChunk* chunk, uint32_t instruction) {
+    switch (GET_OPCODE(instruction)) {
+        case ROP_MOVE:
+        case ROP_LOAD_IMM:
+        case ROP_EQ_I32:
+            return true;
+        case ROP_LOAD_CONST:
+            return GET_IMM(instruction) < chunk->constant_count;
+        case ROP_LOAD_GLOBAL:
+            return GET_IMM(instruction) < chunk->global_count;
+        default:
+            return false;
+    }
+}
+
+// =============================================================================
+// CHUNK ANALYSIS
+// =============================================================================
+
+static void defuse_superinstructions(RegisterChunk* chunk) {
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[address]);
+        RegisterOpcode base = get_base_opcode(opcode);
+        if (base != opcode) {
+            chunk->code[address] = (chunk->code[address] & ~0xFFu) | (uint32_t)base;
+        }
+    }
+}
+
+/**
+ * @brief Check that control flow and register use are fully known
+ */
+static bool chunk_is_analyzable(const RegisterChunk* chunk) {
+    if (chunk->code_count == 0 || chunk->code_count > UINT16_MAX) {
+        return false;
+    }
+
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        uint32_t instruction = chunk->code[address];
+        InstructionEffect effect;
+        if (!describe_instruction(instruction, &effect)) {
+            return false;
+        }
+        if (has_code_target((RegisterOpcode)GET_OPCODE(instruction)) &&
+            GET_IMM(instruction) >= chunk->code_count) {
+            return false;
+        }
+    }
+
+    for (uint16_t i = 0; i < chunk->function_count; i++) {
+        if (chunk->functions[i].start_address >= chunk->code_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Whether any instruction branches on the comparison flags
+ *
+ * Arithmetic updates the flags, so it may only be folded or moved when
+ * nothing observes them.
+ */
+static bool chunk_reads_flags(const RegisterChunk* chunk) {
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[address]);
+        if (opcode >= ROP_JEQ && opcode <= ROP_JGE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Mark the first instruction of every basic block
+ *
+ * @param chunk Chunk to analyze
+ * @return Array of code_count flags, or NULL on allocation failure
+ */
+static bool* find_leaders(const RegisterChunk* chunk) {
+    bool* leaders = calloc(chunk->code_count, sizeof(bool));
+    if (!leaders) {
+        return NULL;
+    }
+
+    leaders[0] = true;
+    for (uint16_t i = 0; i < chunk->function_count; i++) {
+        leaders[chunk->functions[i].start_address] = true;
+    }
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[address]);
+        if (has_code_target(opcode)) {
+            leaders[GET_IMM(chunk->code[address])] = true;
+        }
+        if (ends_block(opcode) && address + 1 < chunk->code_count) {
+            leaders[address + 1] = true;
+        }
+    }
+    return leaders;
+}
+
+static bool build_blocks(const RegisterChunk* chunk, BlockMap* blocks) {
+    blocks->block_of = NULL;
+    blocks->starts = NULL;
+    blocks->count = 0;
+
+    bool* leaders = find_leaders(chunk);
+    blocks->block_of = malloc(chunk->code_count * sizeof(uint32_t));
+    blocks->starts = malloc(chunk->code_count * sizeof(uint32_t));
+    if (!leaders || !blocks->block_of || !blocks->starts) {
+        free(leaders);
+        free(blocks->block_of);
+        free(blocks->starts);
+        blocks->block_of = NULL;
+        blocks->starts = NULL;
+        return false;
+    }
+
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        if (leaders[address]) {
+            blocks->starts[blocks->count++] = address;
+        }
+        blocks->block_of[address] = blocks->count - 1;
+    }
+
+    free(leaders);
+    return true;
+}
+
+static void free_blocks(BlockMap* blocks) {
+    free(blocks->block_of);
+    free(blocks->starts);
+    blocks->block_of = NULL;
+    blocks->starts = NULL;
+    blocks->count = 0;
+}
+
+/** One past the last address of a block */
+static uint32_t block_end(const RegisterChunk* chunk, const BlockMap* blocks, uint32_t block) {
+    return block + 1 < blocks->count ? blocks->starts[block + 1] : chunk->code_count;
+}
+
+/**
+ * @brief Mark blocks entered from outside the code: address 0 and functions
+ */
+static void mark_entry_blocks(const RegisterChunk* chunk, const BlockMap* blocks, bool* entries) {
+    entries[blocks->block_of[0]] = true;
+    for (uint16_t i = 0; i < chunk->function_count; i++) {
+        entries[blocks->block_of[chunk->functions[i].start_address]] = true;
+    }
+}
+
+// =============================================================================
+// CODE LAYOUT
+// =============================================================================
+
+/**
+ * @brief Rebuild the code array in a new order and remap all code addresses
+ *
+ * Jump and call targets, function ranges, debug locations, line starts,
+ * variable scopes and exported function addresses follow their instruction.
+ * Nothing is modified if an allocation fails.
+ *
+ * @param chunk Chunk to rewrite
+ * @param order Old address of each new instruction
+ * @param new_count Number of instructions in the new layout
+ * @param map New address for each old address, plus one entry for the end;
+ *            anything that referred to an old address is redirected here
+ * @return true on success
+ */
+static bool relayout_code(RegisterChunk* chunk, const uint32_t* order, uint32_t new_count,
+                          const uint32_t* map) {
+    uint32_t old_count = chunk->code_count;
+    DebugInfo* debug = chunk->debug;
+
+    if (new_count == 0 || new_count > UINT16_MAX) {
+        return false;
+    }
+
+    uint32_t* code = malloc(new_count * sizeof(uint32_t));
+    SourceLocation* locations = NULL;
+    bool remap_locations = debug && debug->locations && debug->location_count > 0;
+    if (remap_locations) {
+        locations = calloc(new_count, sizeof(SourceLocation));
+    }
+    if (!code || (remap_locations && !locations)) {
+        free(code);
+        free(locations);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < new_count; i++) {
+        uint32_t instruction = chunk->code[order[i]];
+        if (has_code_target((RegisterOpcode)GET_OPCODE(instruction))) {
+            instruction = with_imm(instruction, map[GET_IMM(instruction)]);
+        }
+        code[i] = instruction;
+
+        if (remap_locations && order[i] < debug->location_count) {
+            locations[i] = debug->locations[order[i]];
+        }
+    }
+
+    register_chunk_release(chunk, chunk->code);
+    chunk->code = code;
+    chunk->code_count = new_count;
+    chunk->code_capacity = new_count;
+
+    if (remap_locations) {
+        register_chunk_release(chunk, debug->locations);
+        debug->locations = locations;
+        debug->location_count = new_count;
+        debug->location_capacity = new_count;
+    }
+
+    if (debug) {
+        for (uint32_t i = 0; debug->line_starts && i < debug->line_start_count; i++) {
+            if (debug->line_starts[i] <= old_count) {
+                debug->line_starts[i] = map[debug->line_starts[i]];
+            }
+        }
+        for (uint16_t i = 0; debug->variable_scopes && i < debug->variable_count; i++) {
+            if (debug->variable_scopes[i] <= old_count) {
+                debug->variable_scopes[i] = map[debug->variable_scopes[i]];
+            }
+        }
+    }
+
+    for (uint16_t i = 0; i < chunk->function_count; i++) {
+        FunctionInfo* func = &chunk->functions[i];
+        uint32_t start = map[func->start_address];
+        uint32_t end = func->end_address < old_count ? map[func->end_address + 1] : new_count;
+
+        // The range ends just before whatever now follows the old last instruction
+        end = end > start ? end - 1 : start;
+        func->start_address = start < new_count ? start : new_count - 1;
+        func->end_address = end < new_count ? end : new_count - 1;
+    }
+
+    if (chunk->module) {
+        for (uint16_t i = 0; i < chunk->module->export_count; i++) {
+            ExportEntry* entry = &chunk->module->exports[i];
+            if (entry->is_function && entry->address <= old_count) {
+                entry->address = map[entry->address];
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Remove NOPs, retargeting jumps to the next kept instruction
+ */
+static bool strip_nops(RegisterChunk* chunk) {
+    uint32_t old_count = chunk->code_count;
+    uint32_t* order = malloc(old_count * sizeof(uint32_t));
+    uint32_t* map = malloc((old_count + 1) * sizeof(uint32_t));
+    if (!order || !map) {
+        free(order);
+        free(map);
+        return false;
+    }
+
+    uint32_t new_count = 0;
+    for (uint32_t address = 0; address < old_count; address++) {
+        map[address] = new_count;
+
+        // A trailing NOP stays so jumps to the end remain in bounds
+        if (GET_OPCODE(chunk->code[address]) != ROP_NOP || address + 1 == old_count) {
+            order[new_count++] = address;
+        }
+    }
+    map[old_count] = new_count;
+
+    bool ok = new_count == old_count || relayout_code(chunk, order, new_count, map);
+
+    free(order);
+    free(map);
+    return ok;
+}
+
+// =============================================================================
+// LEVEL 1: PEEPHOLE CLEANUP
+// =============================================================================
+
+/**
+ * @brief Remove self moves and the second half of MOVE a,b / MOVE b,a pairs
+ *
+ * @return Number of moves removed
+ */
+static uint32_t eliminate_redundant_moves(RegisterChunk* chunk) {
+    bool* leaders = find_leaders(chunk);
+    if (!leaders) {
+        return 0;
+    }
+
+    uint32_t removed = 0;
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        uint32_t instruction = chunk->code[address];
+        if (GET_OPCODE(instruction) != ROP_MOVE) {
+            continue;
+        }
+
+        if (GET_DST(instruction) == GET_SRC1(instruction)) {
+            chunk->code[address] = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+            removed++;
+            continue;
+        }
+
+        // After MOVE a,b both registers hold the same value
+        if (address + 1 < chunk->code_count && !leaders[address + 1]) {
+            uint32_t next = chunk->code[address + 1];
+            if (GET_OPCODE(next) == ROP_MOVE &&
+                GET_DST(next) == GET_SRC1(instruction) &&
+                GET_SRC1(next) == GET_DST(instruction)) {
+                chunk->code[address + 1] = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+                removed++;
+            }
+        }
+    }
+
+    free(leaders);
+    return removed;
+}
+
+/**
+ * @brief Follow NOP runs and unconditional jumps from an address
+ *
+ * @return Address of the first instruction that does real work
+ */
+static uint32_t resolve_jump_target(const RegisterChunk* chunk, uint32_t target) {
+    uint32_t resolved = target;
+
+    // The hop limit stops on jump cycles such as "L: JMP L"
+    for (uint32_t hops = 0; hops < chunk->code_count; hops++) {
+        uint32_t instruction = chunk->code[resolved];
+        uint32_t next;
+        if (GET_OPCODE(instruction) == ROP_NOP) {
+            next = resolved + 1;
+        } else if (GET_OPCODE(instruction) == ROP_JMP) {
+            next = GET_IMM(instruction);
+        } else {
+            break;
+        }
+        if (next >= chunk->code_count) {
+            break;
+        }
+        resolved = next;
+    }
+    return resolved;
+}
+
+/**
+ * @brief Thread jump chains and drop jumps to the following instruction
+ *
+ * @return Number of jumps changed
+ */
+static uint32_t thread_jumps(RegisterChunk* chunk) {
+    uint32_t changed = 0;
+
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        uint32_t instruction = chunk->code[address];
+        if (!is_jump((RegisterOpcode)GET_OPCODE(instruction))) {
+            continue;
+        }
+
+        uint32_t target = resolve_jump_target(chunk, GET_IMM(instruction));
+        if (target != GET_IMM(instruction)) {
+            chunk->code[address] = with_imm(instruction, target);
+            changed++;
+        }
+
+        // Both edges land on the same instruction: the jump does nothing
+        if (address + 1 < chunk->code_count &&
+            resolve_jump_target(chunk, address + 1) == target) {
+            chunk->code[address] = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+            changed++;
+        }
+    }
+
+    return changed;
+}
+
+// =============================================================================
+// LEVEL 2: CONSTANT PROPAGATION AND DEAD CODE
+// =============================================================================
+
+static RegisterFact fact_of_kind(FactKind kind, ValueType type) {
+    RegisterFact fact;
+    memset(&fact, 0, sizeof(fact));
+    fact.kind = (uint8_t)kind;
+    fact.type = (uint8_t)type;
+    return fact;
+}
+
+static RegisterFact fact_from_value(Value value) {
+    ValueType type = VALUE_TYPE(value);
+    switch (type) {
+        case VAL_I32:
+        case VAL_I64:
+        case VAL_U32:
+        case VAL_U64:
+        case VAL_F64:
+        case VAL_BOOL:
+        case VAL_NIL: {
+            RegisterFact fact = fact_of_kind(FACT_CONST, type);
+            fact.value = value;
+            return fact;
+        }
+        default:
+            return fact_of_kind(FACT_TYPED, type);
+    }
+}
+
+/**
+ * @brief Exact equality of two tracked constants
+ *
+ * Unlike valuesEqual this tells 0.0 from -0.0 and matches NaN with itself.
+ */
+static bool same_constant(Value a, Value b) {
+    if (VALUE_TYPE(a) != VALUE_TYPE(b)) {
+        return false;
+    }
+    switch (VALUE_TYPE(a)) {
+        case VAL_I32: return AS_I32(a) == AS_I32(b);
+        case VAL_I64: return AS_I64(a) == AS_I64(b);
+        case VAL_U32: return AS_U32(a) == AS_U32(b);
+        case VAL_U64: return AS_U64(a) == AS_U64(b);
+        case VAL_BOOL: return AS_BOOL(a) == AS_BOOL(b);
+        case VAL_NIL: return true;
+        case VAL_F64: {
+            double x = AS_F64(a);
+            double y = AS_F64(b);
+            return memcmp(&x, &y, sizeof(double)) == 0;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Merge an incoming fact into a register's fact
+ *
+ * @return true if the merged fact changed
+ */
+static bool meet_fact(RegisterFact* into, const RegisterFact* incoming) {
+    RegisterFact merged = *into;
+
+    if (incoming->kind == FACT_UNDEF || into->kind == FACT_ANY) {
+        return false;
+    }
+    if (into->kind == FACT_UNDEF || incoming->kind == FACT_ANY) {
+        merged = *incoming;
+    } else if (into->type != incoming->type) {
+        merged = fact_of_kind(FACT_ANY, VAL_NIL);
+    } else if (into->kind == FACT_CONST && incoming->kind == FACT_CONST &&
+               same_constant(into->value, incoming->value)) {
+        return false;
+    } else {
+        merged = fact_of_kind(FACT_TYPED, (ValueType)into->type);
+    }
+
+    if (merged.kind == into->kind && merged.type == into->type) {
+        return false;
+    }
+    *into = merged;
+    return true;
+}
+
+static bool fact_is_const(const RegisterFact* fact, ValueType type) {
+    return fact->kind == FACT_CONST && fact->type == type;
+}
+
+static bool fact_has_type(const RegisterFact* fact, ValueType type) {
+    return (fact->kind == FACT_CONST || fact->kind == FACT_TYPED) && fact->type == type;
+}
+
+/**
+ * @brief Compute the fact for an instruction's destination register
+ *
+ * Folds the operation when its operands are known and the result is
+ * exactly what the VM would produce without faulting.
+ *
+ * @param chunk Chunk being analyzed
+ * @param instruction Instruction word
+ * @param facts Register facts before the instruction
+ * @return Fact for the destination register
+ */
+static RegisterFact evaluate_instruction(const RegisterChunk* chunk, uint32_t instruction,
+                                         const RegisterFact* facts) {
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    const RegisterFact* a = &facts[GET_SRC1(instruction) % TOTAL_REGISTER_COUNT];
+    const RegisterFact* b = &facts[GET_SRC2(instruction) % TOTAL_REGISTER_COUNT];
+
+    switch (opcode) {
+        case ROP_MOVE:
+            return *a;
+
+        case ROP_LOAD_IMM:
+            return fact_from_value(I32_VAL((int32_t)GET_IMM(instruction)));
+
+        case ROP_LOAD_CONST:
+            if (GET_IMM(instruction) < chunk->constant_count) {
+                return fact_from_value(chunk->constants[GET_IMM(instruction)]);
+            }
+            return fact_of_kind(FACT_ANY, VAL_NIL);
+
+        case ROP_ADD_I32:
+        case ROP_SUB_I32:
+        case ROP_MUL_I32:
+        case ROP_DIV_I32:
+            if (fact_is_const(a, VAL_I32) && fact_is_const(b, VAL_I32)) {
+                int32_t x = AS_I32(a->value);
+                int32_t y = AS_I32(b->value);
+                uint32_t ux = (uint32_t)x;
+                uint32_t uy = (uint32_t)y;
+                switch (opcode) {
+                    case ROP_ADD_I32: return fact_from_value(I32_VAL((int32_t)(ux + uy)));
+                    case ROP_SUB_I32: return fact_from_value(I32_VAL((int32_t)(ux - uy)));
+                    case ROP_MUL_I32: return fact_from_value(I32_VAL((int32_t)(ux * uy)));
+                    default:
+                        if (y != 0 && !(x == INT32_MIN && y == -1)) {
+                            return fact_from_value(I32_VAL(x / y));
+                        }
+                        break;
+                }
+            }
+            // Any other operand types stop execution
+            return fact_of_kind(FACT_TYPED, VAL_I32);
+
+        case ROP_ADD_F64:
+        case ROP_SUB_F64:
+        case ROP_MUL_F64:
+        case ROP_DIV_F64:
+            if (fact_is_const(a, VAL_F64) && fact_is_const(b, VAL_F64)) {
+                double x = AS_F64(a->value);
+                double y = AS_F64(b->value);
+                switch (opcode) {
+                    case ROP_ADD_F64: return fact_from_value(F64_VAL(x + y));
+                    case ROP_SUB_F64: return fact_from_value(F64_VAL(x - y));
+                    case ROP_MUL_F64: return fact_from_value(F64_VAL(x * y));
+                    default:
+                        if (y != 0.0) {
+                            return fact_from_value(F64_VAL(x / y));
+                        }
+                        break;
+                }
+            }
+            return fact_of_kind(FACT_TYPED, VAL_F64);
+
+        case ROP_NEG_I32:
+            return fact_of_kind(FACT_TYPED, VAL_I32);
+
+        case ROP_EQ_I32:
+            if (a->kind == FACT_CONST && b->kind == FACT_CONST) {
+                return fact_from_value(BOOL_VAL(valuesEqual(a->value, b->value)));
+            }
+            return fact_of_kind(FACT_TYPED, VAL_BOOL);
+
+        case ROP_NE_I32:
+        case ROP_LT_I32:
+        case ROP_LE_I32:
+        case ROP_GT_I32:
+        case ROP_GE_I32:
+            if (fact_is_const(a, VAL_I32) && fact_is_const(b, VAL_I32)) {
+                int32_t x = AS_I32(a->value);
+                int32_t y = AS_I32(b->value);
+                bool result = opcode == ROP_NE_I32 ? x != y :
+                              opcode == ROP_LT_I32 ? x < y :
+                              opcode == ROP_LE_I32 ? x <= y :
+                              opcode == ROP_GT_I32 ? x > y : x >= y;
+                return fact_from_value(BOOL_VAL(result));
+            }
+            return fact_of_kind(FACT_TYPED, VAL_BOOL);
+
+        case ROP_EQ_STR:
+        case ROP_EQ_OBJ:
+        case ROP_LANE_LT_I64:
+            return fact_of_kind(FACT_TYPED, VAL_BOOL);
+
+        case ROP_BOX_I64:
+            return fact_of_kind(FACT_TYPED, VAL_I64);
+
+        case ROP_BOX_F64:
+            return fact_of_kind(FACT_TYPED, VAL_F64);
+
+        default:
+            return fact_of_kind(FACT_ANY, VAL_NIL);
+    }
+}
+
+/**
+ * @brief Decide a JZ/JNZ from what is known about its condition
+ *
+ * Mirrors the VM's branch predicates: JZ takes false, i32 zero and nil;
+ * JNZ takes true, nonzero i32 and every value that is neither bool nor nil.
+ *
+ * @return 1 if always taken, 0 if never taken, -1 if unknown
+ */
+static int decide_branch(RegisterOpcode opcode, const RegisterFact* fact) {
+    if (fact->kind == FACT_CONST) {
+        Value v = fact->value;
+        bool taken;
+        if (opcode == ROP_JZ) {
+            taken = (IS_BOOL(v) && !AS_BOOL(v)) || (IS_I32(v) && AS_I32(v) == 0) || IS_NIL(v);
+        } else {
+            taken = (IS_BOOL(v) && AS_BOOL(v)) || (IS_I32(v) && AS_I32(v) != 0) ||
+                    (!IS_NIL(v) && !IS_BOOL(v));
+        }
+        return taken ? 1 : 0;
+    }
+
+    if (fact->kind == FACT_TYPED && fact->type != VAL_BOOL &&
+        fact->type != VAL_I32 && fact->type != VAL_NIL) {
+        return opcode == ROP_JZ ? 0 : 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Apply one instruction to the register facts
+ */
+static void transfer_facts(const RegisterChunk* chunk, uint32_t instruction, RegisterFact* facts) {
+    InstructionEffect effect;
+    describe_instruction(instruction, &effect);
+
+    if (GET_OPCODE(instruction) == ROP_CALL) {
+        // The callee may change any register
+        for (int reg = 0; reg < TOTAL_REGISTER_COUNT; reg++) {
+            facts[reg] = fact_of_kind(FACT_ANY, VAL_NIL);
+        }
+    } else if (effect.dst != NO_REGISTER) {
+        facts[effect.dst] = evaluate_instruction(chunk, instruction, facts);
+    }
+}
+
+/**
+ * @brief Encode a load of a constant into a register
+ *
+ * @param chunk Chunk whose constant pool may grow
+ * @param dst Destination register
+ * @param value Constant to load
+ * @param instruction Output instruction word
+ * @return false if the constant cannot be addressed
+ */
+static bool make_constant_load(RegisterChunk* chunk, uint8_t dst, Value value,
+                               uint32_t* instruction) {
+    if (IS_I32(value) && AS_I32(value) >= 0 && AS_I32(value) <= UINT16_MAX) {
+        *instruction = MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, dst, (uint16_t)AS_I32(value));
+        return true;
+    }
+
+    uint32_t index = UINT32_MAX;
+    for (uint32_t i = 0; i < chunk->constant_count; i++) {
+        if (same_constant(chunk->constants[i], value)) {
+            index = i;
+            break;
+        }
+    }
+    if (index == UINT32_MAX) {
+        index = register_chunk_add_constant(chunk, value);
+    }
+    if (index > UINT16_MAX) {
+        return false;
+    }
+
+    *instruction = MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, dst, (uint16_t)index);
+    return true;
+}
+
+/**
+ * @brief Sparse conditional constant propagation over basic blocks
+ *
+ * Computes register facts at every block entry, following only the edges
+ * a decided branch can take.
+ *
+ * @param chunk Chunk to analyze
+ * @param blocks Block partition of the chunk
+ * @param block_in Output facts, TOTAL_REGISTER_COUNT per block
+ * @param reachable Output flag per block
+ * @return false on allocation failure
+ */
+static bool analyze_constants(const RegisterChunk* chunk, const BlockMap* blocks,
+                              RegisterFact* block_in, bool* reachable) {
+    bool* entries = calloc(blocks->count, sizeof(bool));
+    bool* queued = calloc(blocks->count, sizeof(bool));
+    uint32_t* worklist = malloc(blocks->count * sizeof(uint32_t));
+    if (!entries || !queued || !worklist) {
+        free(entries);
+        free(queued);
+        free(worklist);
+        return false;
+    }
+
+    RegisterFact facts[TOTAL_REGISTER_COUNT];
+    RegisterFact any[TOTAL_REGISTER_COUNT];
+    for (int reg = 0; reg < TOTAL_REGISTER_COUNT; reg++) {
+        any[reg] = fact_of_kind(FACT_ANY, VAL_NIL);
+    }
+    memset(block_in, 0, (size_t)blocks->count * TOTAL_REGISTER_COUNT * sizeof(RegisterFact));
+    memset(reachable, 0, blocks->count * sizeof(bool));
+
+    // Entry blocks start with an unknown register file
+    uint32_t pending = 0;
+    mark_entry_blocks(chunk, blocks, entries);
+    for (uint32_t block = 0; block < blocks->count; block++) {
+        if (entries[block]) {
+            memcpy(&block_in[(size_t)block * TOTAL_REGISTER_COUNT], any, sizeof(any));
+            reachable[block] = true;
+            queued[block] = true;
+            worklist[pending++] = block;
+        }
+    }
+
+    while (pending > 0) {
+        uint32_t block = worklist[--pending];
+        queued[block] = false;
+
+        memcpy(facts, &block_in[(size_t)block * TOTAL_REGISTER_COUNT], sizeof(facts));
+        uint32_t last = block_end(chunk, blocks, block) - 1;
+        for (uint32_t address = blocks->starts[block]; address < last; address++) {
+            transfer_facts(chunk, chunk->code[address], facts);
+        }
+
+        uint32_t instruction = chunk->code[last];
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+        int decision = -1;
+        if (opcode == ROP_JZ || opcode == ROP_JNZ) {
+            decision = decide_branch(opcode, &facts[GET_DST(instruction)]);
+        }
+        transfer_facts(chunk, instruction, facts);
+
+        uint32_t successors[2];
+        int successor_count = get_successors(chunk, last, successors);
+        for (int i = 0; i < successor_count; i++) {
+            bool is_target = has_code_target(opcode) && i == 0;
+            if ((decision == 1 && !is_target) || (decision == 0 && is_target)) {
+                continue;
+            }
+
+            uint32_t next = blocks->block_of[successors[i]];
+            RegisterFact* in = &block_in[(size_t)next * TOTAL_REGISTER_COUNT];
+            bool changed = !reachable[next];
+            reachable[next] = true;
+            for (int reg = 0; reg < TOTAL_REGISTER_COUNT; reg++) {
+                changed = meet_fact(&in[reg], &facts[reg]) || changed;
+            }
+            if (changed && !queued[next]) {
+                queued[next] = true;
+                worklist[pending++] = next;
+            }
+        }
+    }
+
+    free(entries);
+    free(queued);
+    free(worklist);
+    return true;
+}
+
+/**
+ * @brief Fold constants and branches using analyze_constants
+ *
+ * Results that are known become constant loads, decided branches become
+ * JMP or NOP, and blocks no path reaches become NOPs.
+ */
+static bool propagate_constants(RegisterChunk* chunk) {
+    BlockMap blocks;
+    if (!build_blocks(chunk, &blocks)) {
+        return false;
+    }
+
+    RegisterFact* block_in = malloc((size_t)blocks.count * TOTAL_REGISTER_COUNT *
+                                    sizeof(RegisterFact));
+    bool* reachable = malloc(blocks.count * sizeof(bool));
+    if (!block_in || !reachable || !analyze_constants(chunk, &blocks, block_in, reachable)) {
+        free(block_in);
+        free(reachable);
+        free_blocks(&blocks);
+        return false;
+    }
+
+    RegisterFact facts[TOTAL_REGISTER_COUNT];
+    bool ok = true;
+    bool flags_observed = chunk_reads_flags(chunk);
+    for (uint32_t block = 0; block < blocks.count; block++) {
+        uint32_t end = block_end(chunk, &blocks, block);
+
+        if (!reachable[block]) {
+            for (uint32_t address = blocks.starts[block]; address < end; address++) {
+                chunk->code[address] = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+            }
+            continue;
+        }
+
+        memcpy(facts, &block_in[(size_t)block * TOTAL_REGISTER_COUNT], sizeof(facts));
+        for (uint32_t address = blocks.starts[block]; address < end; address++) {
+            uint32_t instruction = chunk->code[address];
+            RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+            InstructionEffect effect;
+            describe_instruction(instruction, &effect);
+
+            if (opcode == ROP_JZ || opcode == ROP_JNZ) {
+                int decision = decide_branch(opcode, &facts[GET_DST(instruction)]);
+                if (decision == 1) {
+                    chunk->code[address] = MAKE_IMM_INSTRUCTION(ROP_JMP, 0, GET_IMM(instruction));
+                } else if (decision == 0) {
+                    chunk->code[address] = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+                }
+            } else if (effect.dst != NO_REGISTER && opcode != ROP_LOAD_IMM &&
+                       opcode != ROP_LOAD_CONST && (!effect.sets_flags || !flags_observed)) {
+                RegisterFact result = evaluate_instruction(chunk, instruction, facts);
+                uint32_t load;
+                if (result.kind == FACT_CONST) {
+                    if (make_constant_load(chunk, (uint8_t)effect.dst, result.value, &load)) {
+                        chunk->code[address] = load;
+                    } else {
+                        ok = false;
+                    }
+                }
+            }
+
+            transfer_facts(chunk, instruction, facts);
+        }
+    }
+
+    free(block_in);
+    free(reachable);
+    free_blocks(&blocks);
+    return ok;
+}
+
+/**
+ * @brief Apply one instruction backwards to a live register set
+ */
+static RegisterSet transfer_liveness(uint32_t instruction, RegisterSet live) {
+    if (GET_OPCODE(instruction) == ROP_CALL) {
+        return ALL_REGISTERS;
+    }
+
+    InstructionEffect effect;
+    describe_instruction(instruction, &effect);
+    if (effect.dst != NO_REGISTER) {
+        live &= ~REGISTER_BIT(effect.dst);
+    }
+    for (int i = 0; i < effect.use_count; i++) {
+        live |= REGISTER_BIT(effect.uses[i]);
+    }
+    return live;
+}
+
+/**
+ * @brief Registers live at the end of a block
+ *
+ * Returns keep every register live because a frame's register window
+ * overlaps its caller's; nothing is live once the program halts.
+ */
+static RegisterSet block_live_out(const RegisterChunk* chunk, const BlockMap* blocks,
+                                  const RegisterSet* live_in, uint32_t block) {
+    uint32_t last = block_end(chunk, blocks, block) - 1;
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[last]);
+    uint32_t successors[2];
+    int successor_count = get_successors(chunk, last, successors);
+
+    if (opcode == ROP_RET || opcode == ROP_RET_VAL) {
+        return ALL_REGISTERS;
+    }
+
+    RegisterSet live = 0;
+    for (int i = 0; i < successor_count; i++) {
+        live |= live_in[blocks->block_of[successors[i]]];
+    }
+    return live;
+}
+
+/**
+ * @brief Compute the registers live on entry to every block
+ *
+ * @return Array of blocks->count sets, or NULL on allocation failure
+ */
+static RegisterSet* compute_liveness(const RegisterChunk* chunk, const BlockMap* blocks) {
+    RegisterSet* live_in = calloc(blocks->count, sizeof(RegisterSet));
+    if (!live_in) {
+        return NULL;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t block = blocks->count; block-- > 0;) {
+            RegisterSet live = block_live_out(chunk, blocks, live_in, block);
+            uint32_t end = block_end(chunk, blocks, block);
+            for (uint32_t address = end; address-- > blocks->starts[block];) {
+                live = transfer_liveness(chunk->code[address], live);
+            }
+            if (live != live_in[block]) {
+                live_in[block] = live;
+                changed = true;
+            }
+        }
+    }
+    return live_in;
+}
+
+/**
+ * @brief Remove side-effect-free instructions whose result is never read
+ */
+static bool eliminate_dead_code(RegisterChunk* chunk) {
+    bool removed = true;
+
+    while (removed) {
+        removed = false;
+
+        BlockMap blocks;
+        if (!build_blocks(chunk, &blocks)) {
+            return false;
+        }
+        RegisterSet* live_in = compute_liveness(chunk, &blocks);
+        if (!live_in) {
+            free_blocks(&blocks);
+            return false;
+        }
+
+        for (uint32_t block = 0; block < blocks.count; block++) {
+            RegisterSet live = block_live_out(chunk, &blocks, live_in, block);
+            uint32_t end = block_end(chunk, &blocks, block);
+            for (uint32_t address = end; address-- > blocks.starts[block];) {
+                uint32_t instruction = chunk->code[address];
+                InstructionEffect effect;
+                describe_instruction(instruction, &effect);
+
+                if (effect.dst != NO_REGISTER && !(live & REGISTER_BIT(effect.dst)) &&
+                    is_removable(chunk, instruction)) {
+                    chunk->code[address] = MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0);
+                    removed = true;
+                    continue;
+                }
+                live = transfer_liveness(instruction, live);
+            }
+        }
+
+        free(live_in);
+        free_blocks(&blocks);
+    }
+
+    return true;
+}
+
+// =============================================================================
+// LEVEL 3: LOOP-INVARIANT CODE MOTION
+// =============================================================================
+
+static int compare_loops(const void* a, const void* b) {
+    const LoopRange* x = (const LoopRange*)a;
+    const LoopRange* y = (const LoopRange*)b;
+    uint32_t size_x = x->tail - x->header;
+    uint32_t size_y = y->tail - y->header;
+    return size_x < size_y ? -1 : size_x > size_y ? 1 : 0;
+}
+
+/**
+ * @brief Whether a backward branch encloses a loop LICM can work on
+ *
+ * The loop must be entered only through its header and must not call out,
+ * since a callee could change any register or global.
+ */
+static bool is_simple_loop(const RegisterChunk* chunk, const LoopRange* loop) {
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        uint32_t instruction = chunk->code[address];
+        RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+        bool inside = address >= loop->header && address <= loop->tail;
+
+        if (inside && opcode == ROP_CALL) {
+            return false;
+        }
+        if (!inside && has_code_target(opcode) && GET_IMM(instruction) > loop->header &&
+            GET_IMM(instruction) <= loop->tail) {
+            return false;
+        }
+    }
+
+    for (uint16_t i = 0; i < chunk->function_count; i++) {
+        uint32_t start = chunk->functions[i].start_address;
+        if (start > loop->header && start <= loop->tail) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Whether an instruction in a loop computes the same value every iteration
+ *
+ * Operands must not be written in the loop, and executing the instruction
+ * ahead of the loop must not fault or disturb observable flags.
+ *
+ * @param header_facts Register facts on entry to the loop header
+ * @param defs Number of writes to each register inside the loop
+ */
+static bool is_invariant(const RegisterChunk* chunk, const LoopRange* loop, uint32_t instruction,
+                         const RegisterFact* header_facts, const uint32_t* defs,
+                         bool flags_observed) {
+    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    const RegisterFact* a = &header_facts[GET_SRC1(instruction) % TOTAL_REGISTER_COUNT];
+    const RegisterFact* b = &header_facts[GET_SRC2(instruction) % TOTAL_REGISTER_COUNT];
+    InstructionEffect effect;
+    describe_instruction(instruction, &effect);
+
+    for (int i = 0; i < effect.use_count; i++) {
+        if (defs[effect.uses[i]] != 0) {
+            return false;
+        }
+    }
+
+    switch (opcode) {
+        case ROP_MOVE:
+        case ROP_LOAD_IMM:
+        case ROP_EQ_I32:
+            return true;
+
+        case ROP_LOAD_CONST:
+            return GET_IMM(instruction) < chunk->constant_count;
+
+        case ROP_LOAD_GLOBAL:
+            if (GET_IMM(instruction) >= chunk->global_count) {
+                return false;
+            }
+            for (uint32_t address = loop->header; address <= loop->tail; address++) {
+                uint32_t other = chunk->code[address];
+                if (GET_OPCODE(other) == ROP_STORE_GLOBAL &&
+                    GET_IMM(other) == GET_IMM(instruction)) {
+                    return false;
+                }
+            }
+            return true;
+
+        case ROP_ADD_I32:
+        case ROP_SUB_I32:
+        case ROP_MUL_I32:
+            return !flags_observed && fact_has_type(a, VAL_I32) && fact_has_type(b, VAL_I32);
+
+        case ROP_ADD_F64:
+        case ROP_SUB_F64:
+        case ROP_MUL_F64:
+            return !flags_observed && fact_has_type(a, VAL_F64) && fact_has_type(b, VAL_F64);
+
+        case ROP_NE_I32:
+        case ROP_LT_I32:
+        case ROP_LE_I32:
+        case ROP_GT_I32:
+        case ROP_GE_I32:
+            return fact_has_type(a, VAL_I32) && fact_has_type(b, VAL_I32);
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Move one instruction from a loop to just before its header
+ *
+ * Jumps from outside the loop to the header now enter at the hoisted
+ * instruction; jumps inside the loop still go to the original header.
+ */
+static bool hoist_instruction(RegisterChunk* chunk, const LoopRange* loop, uint32_t from) {
+    uint32_t count = chunk->code_count;
+    uint32_t header = loop->header;
+    uint32_t* order = malloc(count * sizeof(uint32_t));
+    uint32_t* map = malloc((count + 1) * sizeof(uint32_t));
+    if (!order || !map) {
+        free(order);
+        free(map);
+        return false;
+    }
+
+    uint32_t n = 0;
+    for (uint32_t address = 0; address < header; address++) {
+        order[n++] = address;
+    }
+    order[n++] = from;
+    for (uint32_t address = header; address < count; address++) {
+        if (address != from) {
+            order[n++] = address;
+        }
+    }
+
+    for (uint32_t address = 0; address <= count; address++) {
+        if (address <= header || address > from) {
+            map[address] = address;
+        } else {
+            // Shifted by the hoisted instruction; the old slot maps to its successor
+            map[address] = address + 1;
+        }
+    }
+
+    bool ok = relayout_code(chunk, order, n, map);
+    if (ok) {
+        // Loop body now spans header + 1 .. tail; its back edges skip the preheader
+        for (uint32_t address = header + 1; address <= loop->tail; address++) {
+            uint32_t instruction = chunk->code[address];
+            if (has_code_target((RegisterOpcode)GET_OPCODE(instruction)) &&
+                GET_IMM(instruction) == header) {
+                chunk->code[address] = with_imm(instruction, header + 1);
+            }
+        }
+    }
+
+    free(order);
+    free(map);
+    return ok;
+}
+
+/**
+ * @brief Find and hoist one loop-invariant instruction, innermost loops first
+ *
+ * @param hoisted Set to true if the code changed
+ * @return false on allocation failure
+ */
+static bool hoist_one_invariant(RegisterChunk* chunk, bool flags_observed, bool* hoisted) {
+    *hoisted = false;
+
+    uint32_t loop_count = 0;
+    LoopRange* loops = malloc(chunk->code_count * sizeof(LoopRange));
+    if (!loops) {
+        return false;
+    }
+    for (uint32_t address = 0; address < chunk->code_count; address++) {
+        uint32_t instruction = chunk->code[address];
+        if (is_jump((RegisterOpcode)GET_OPCODE(instruction)) && GET_IMM(instruction) <= address) {
+            loops[loop_count].header = GET_IMM(instruction);
+            loops[loop_count].tail = address;
+            loop_count++;
+        }
+    }
+    if (loop_count == 0) {
+        free(loops);
+        return true;
+    }
+    qsort(loops, loop_count, sizeof(LoopRange), compare_loops);
+
+    BlockMap blocks;
+    if (!build_blocks(chunk, &blocks)) {
+        free(loops);
+        return false;
+    }
+    RegisterSet* live_in = compute_liveness(chunk, &blocks);
+    RegisterFact* block_in = malloc((size_t)blocks.count * TOTAL_REGISTER_COUNT *
+                                    sizeof(RegisterFact));
+    bool* reachable = malloc(blocks.count * sizeof(bool));
+    bool ok = live_in && block_in && reachable &&
+              analyze_constants(chunk, &blocks, block_in, reachable);
+
+    for (uint32_t i = 0; i < loop_count && !*hoisted && ok; i++) {
+        const LoopRange* loop = &loops[i];
+        if (!is_simple_loop(chunk, loop)) {
+            continue;
+        }
+
+        uint32_t header_block = blocks.block_of[loop->header];
+        if (!reachable[header_block]) {
+            continue;
+        }
+        const RegisterFact* header_facts = &block_in[(size_t)header_block * TOTAL_REGISTER_COUNT];
+
+        uint32_t defs[TOTAL_REGISTER_COUNT] = {0};
+        RegisterSet exit_live = 0;
+        for (uint32_t address = loop->header; address <= loop->tail; address++) {
+            InstructionEffect effect;
+            describe_instruction(chunk->code[address], &effect);
+            if (effect.dst != NO_REGISTER) {
+                defs[effect.dst]++;
+            }
+
+            RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(chunk->code[address]);
+            if (opcode == ROP_RET || opcode == ROP_RET_VAL) {
+                exit_live = ALL_REGISTERS;
+            }
+            uint32_t successors[2];
+            int successor_count = get_successors(chunk, address, successors);
+            for (int s = 0; s < successor_count; s++) {
+                if (successors[s] < loop->header || successors[s] > loop->tail) {
+                    exit_live |= live_in[blocks.block_of[successors[s]]];
+                }
+            }
+        }
+        RegisterSet header_live = live_in[header_block];
+
+        for (uint32_t address = loop->header; address <= loop->tail; address++) {
+            uint32_t instruction = chunk->code[address];
+            InstructionEffect effect;
+            describe_instruction(instruction, &effect);
+            if (effect.dst == NO_REGISTER || defs[effect.dst] != 1 ||
+                (header_live & REGISTER_BIT(effect.dst)) ||
+                (exit_live & REGISTER_BIT(effect.dst))) {
+                continue;
+            }
+            if (is_invariant(chunk, loop, instruction, header_facts, defs, flags_observed)) {
+                ok = hoist_instruction(chunk, loop, address);
+                *hoisted = ok;
+                break;
+            }
+        }
+    }
+
+    free(live_in);
+    free(block_in);
+    free(reachable);
+    free_blocks(&blocks);
+    free(loops);
+    return ok;
+}
+
+static bool hoist_loop_invariants(RegisterChunk* chunk) {
+    bool flags_observed = chunk_reads_flags(chunk);
+
+    // Every hoist moves one instruction out of one loop level, so this bound
+    // is never reached in practice; it only guards against a pass bug
+    uint32_t max_rounds = chunk->code_count * 4;
+    for (uint32_t round = 0; round < max_rounds; round++) {
+        bool hoisted;
+        if (!hoist_one_invariant(chunk, flags_observed, &hoisted)) {
+            return false;
+        }
+        if (!hoisted) {
+            break;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// SUPERINSTRUCTION FUSION
+// =============================================================================
+
+/**
+ * @brief Peephole pass rewriting hot opcode sequences into superinstructions
+ *
+ * Only the opcode byte of the first word changes; operands and the remaining
+ * words stay as they are, so no jump target or debug location moves.
+ *
+ * @param chunk Chunk to rewrite
+ * @return Number of sequences fused
+ */
+static uint32_t fuse_superinstructions(RegisterChunk* chunk) {
+    uint32_t fused_count = 0;
+    uint32_t address = 0;
+
+    while (address < chunk->code_count) {
+        const SuperinstructionInfo* info = match_superinstruction(
+            &chunk->code[address], chunk->code_count - address);
+        if (!info) {
+            address++;
+            continue;
+        }
+
+        chunk->code[address] = (chunk->code[address] & ~0xFFu) | (uint32_t)info->opcode;
+        fused_count++;
+
+        // Partner words are never fused themselves: the fused handler
+        // expects to find their original opcodes
+        address += info->length;
+    }
+
+    return fused_count;
+}
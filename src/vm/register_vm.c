@@ -17,12 +17,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <time.h>
 
 #include "../../include/register_vm.h"
 #include "../../include/register_opcodes.h"
 #include "../../include/register_chunk.h"
 #include "../../include/memory.h"
 #include "../../include/value.h"
+#include "../../include/type.h"
+#include "../../include/vm.h"
 
 // =============================================================================
 // PRIVATE CONSTANTS
@@ -31,6 +34,9 @@
 /** Initial call stack capacity */
 #define INITIAL_CALL_STACK_SIZE 64
 
+/** Initial register stack capacity (slots) */
+#define INITIAL_REGISTER_STACK_SIZE 256
+
 /** Initial exception stack capacity */
 #define INITIAL_EXCEPTION_STACK_SIZE 16
 
@@ -40,20 +46,50 @@
 /** Default next GC threshold */
 #define DEFAULT_GC_THRESHOLD (1024 * 1024) // 1MB
 
+/** Nursery size; new objects are bump-allocated here until it fills up */
+#define NURSERY_SIZE (256 * 1024)
+
+/** Old-space allocation between two steps of an incremental cycle */
+#define GC_STEP_BYTES (64 * 1024)
+
+/** Use labels-as-values threaded dispatch where the compiler supports it */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(ORUS_NO_COMPUTED_GOTO)
+#define USE_COMPUTED_GOTO 1
+#else
+#define USE_COMPUTED_GOTO 0
+#endif
+
 // =============================================================================
 // PRIVATE FUNCTION DECLARATIONS
 // =============================================================================
 
 static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction);
-static bool setup_call_frame(RegisterVM* vm, uint32_t function_address, uint8_t param_count);
+static ExecutionResult execute_instrumented(RegisterVM* vm);
+static ExecutionResult execute_threaded(RegisterVM* vm);
+static ExecutionResult execute_threaded_unchecked(RegisterVM* vm);
+static bool ensure_register_stack(RegisterVM* vm, size_t needed);
+static bool ensure_call_stack(RegisterVM* vm);
+static bool setup_call_frame(RegisterVM* vm, uint32_t function_address, uint8_t window);
 static void cleanup_call_frame(RegisterVM* vm);
+static inline int resolve_field_slot(RegisterVM* vm, uint32_t address, Value object,
+                                     uint8_t field);
 static bool check_register_bounds(uint8_t reg);
+static bool check_lane_bounds(uint8_t reg);
+static bool resolve_array_slot(RegisterVM* vm, Value index, int length, int* slot);
+static ArrayKind packed_literal_kind(const Value* elements, int count);
 static void update_flags_arithmetic(RegisterVM* vm, Value result);
 static void update_flags_comparison(RegisterVM* vm, int comparison_result);
-static Value perform_arithmetic_operation(RegisterOpcode op, Value a, Value b, bool* error);
+static Value perform_arithmetic_operation(RegisterOpcode op, Value a, Value b, const char** error);
 static Value perform_comparison_operation(RegisterOpcode op, Value a, Value b, bool* error);
+static bool compare_ordered(Value a, Value b, int* comparison);
+static bool flag_jump_taken(RegisterOpcode op, uint8_t flags);
+static bool is_falsey(Value value);
+static bool cast_value(Value value, TypeKind kind, Value* result);
+static Value slice_value(Value source, Value start, Value end, const char** error);
 static bool handle_exception(RegisterVM* vm, Value exception);
+static void locate_error(RegisterVM* vm);
 static void trace_instruction(const RegisterVM* vm, uint32_t instruction);
+static void record_opcode(OpcodeProfile* profile, uint8_t opcode);
 
 // =============================================================================
 // VM LIFECYCLE FUNCTIONS
@@ -67,9 +103,10 @@ bool registervm_init(RegisterVM* vm, RegisterChunk* chunk) {
     // Initialize all fields to zero/NULL
     memset(vm, 0, sizeof(RegisterVM));
     
-    // Initialize registers with NIL values
-    for (int i = 0; i < TOTAL_REGISTER_COUNT; i++) {
-        vm->registers[i] = NIL_VAL;
+    // Initialize the register stack with NIL values; top-level code runs
+    // in the window at its bottom
+    if (!ensure_register_stack(vm, INITIAL_REGISTER_STACK_SIZE)) {
+        return false;
     }
     
     // Set initial execution state
@@ -79,6 +116,22 @@ bool registervm_init(RegisterVM* vm, RegisterChunk* chunk) {
     vm->chunk = chunk;
     vm->objects = NULL;
     
+    // Loaded images keep their string constants in the image until now
+    if (chunk) {
+        register_chunk_materialize_strings(chunk);
+    }
+    
+    // Verify at load time so proven chunks can skip runtime operand checks
+    if (chunk && !chunk->is_verified) {
+        register_chunk_mark_verified(chunk);
+    }
+    
+    // Field accesses start with empty inline caches; without them (out of
+    // memory) every access takes the shape lookup
+    if (chunk) {
+        register_chunk_reset_inline_caches(chunk);
+    }
+    
     // Initialize call stack
     vm->current_frame = NULL;
     vm->call_depth = 0;
@@ -92,9 +145,30 @@ bool registervm_init(RegisterVM* vm, RegisterChunk* chunk) {
     vm->bytes_allocated = 0;
     vm->next_gc = DEFAULT_GC_THRESHOLD;
     vm->gc_running = false;
+    vm->gc_stress = getenv("ORUS_GC_STRESS") != NULL;
+    // ORUS_GC_INCREMENTAL may give the objects traced per step
+    const char* incremental = getenv("ORUS_GC_INCREMENTAL");
+    registervm_set_gc_incremental(vm, incremental != NULL,
+                                  incremental ? strtoul(incremental, NULL, 10) : 0);
+    vm->gc_phase = GC_PHASE_IDLE;
+    
+    // Common short strings are shared rather than allocated at runtime
+    initSmallStrings();
     
-    // Initialize performance monitoring (disabled by default)
+    // Without a nursery every object is allocated straight into the old space
+    vm->nursery = malloc(NURSERY_SIZE);
+    vm->nursery_top = vm->nursery;
+    vm->nursery_end = vm->nursery ? vm->nursery + NURSERY_SIZE : NULL;
+    
+    // Initialize performance monitoring (disabled by default); GC pauses
+    // are only timed while it is on
     vm->perf = NULL;
+    if (getenv("ORUS_GC_PAUSES")) {
+        registervm_enable_profiling(vm);
+    }
+    if (getenv("ORUS_OPCODE_PROFILE")) {
+        registervm_enable_opcode_profiling(vm);
+    }
     
     // Initialize debug settings
     vm->debug_mode = false;
@@ -124,14 +198,38 @@ void registervm_free(RegisterVM* vm) {
         vm->perf = NULL;
     }
     
+    // Free opcode profile if enabled
+    if (vm->opcode_profile) {
+        free(vm->opcode_profile);
+        vm->opcode_profile = NULL;
+    }
+    
+    // Free allocation profile if enabled
+    registervm_disable_allocation_profiling(vm);
+    
     // Free loaded modules array
     if (vm->loaded_modules) {
         free(vm->loaded_modules);
         vm->loaded_modules = NULL;
     }
     
+    // Free register stack
+    free(vm->register_stack);
+    vm->register_stack = NULL;
+    vm->registers = NULL;
+    
+    // Free call stack
+    free(vm->call_stack);
+    vm->call_stack = NULL;
+    vm->call_stack_capacity = 0;
+    vm->current_frame = NULL;
+    
     // Free all objects in the heap
+    setGCHeap(vm);
     freeObjects();
+    setGCHeap(NULL);
+    free(vm->nursery);
+    free(vm->remembered_set);
     
     // Clear all state
     memset(vm, 0, sizeof(RegisterVM));
@@ -148,6 +246,22 @@ void registervm_reset(RegisterVM* vm, RegisterChunk* chunk) {
     vm->running = false;
     vm->chunk = chunk;
     
+    // Loaded images keep their string constants in the image until now
+    if (chunk) {
+        register_chunk_materialize_strings(chunk);
+    }
+    
+    // Verify at load time so proven chunks can skip runtime operand checks
+    if (chunk && !chunk->is_verified) {
+        register_chunk_mark_verified(chunk);
+    }
+    
+    // Field accesses start with empty inline caches; without them (out of
+    // memory) every access takes the shape lookup
+    if (chunk) {
+        register_chunk_reset_inline_caches(chunk);
+    }
+    
     // Reset call stack
     vm->current_frame = NULL;
     vm->call_depth = 0;
@@ -161,10 +275,14 @@ void registervm_reset(RegisterVM* vm, RegisterChunk* chunk) {
     vm->last_error = NIL_VAL;
     vm->has_error = false;
     
-    // Clear registers (keep NIL values)
-    for (int i = 0; i < REGISTER_COUNT; i++) {
-        vm->registers[i] = NIL_VAL;
+    // Clear the whole register stack and return to the bottom window
+    for (size_t i = 0; i < vm->register_stack_capacity; i++) {
+        vm->register_stack[i] = NIL_VAL;
     }
+    vm->register_base = 0;
+    vm->registers = vm->register_stack;
+    memset(vm->int_lanes, 0, sizeof(vm->int_lanes));
+    memset(vm->float_lanes, 0, sizeof(vm->float_lanes));
     
     // Reset performance counters if enabled
     if (vm->perf) {
@@ -181,9 +299,55 @@ ExecutionResult registervm_execute(RegisterVM* vm) {
         return EXEC_ERROR;
     }
     
+    // Check for errors left over from a previous run
+    if (vm->has_error) {
+        return EXEC_ERROR;
+    }
+    
+    // Objects allocated from here on belong to this VM's heap
+    setGCHeap(vm);
+    
+    // A runtime error inside a try block resumes at its handler
+    ExecutionResult result;
+    do {
+        // Tracing and profiling need per-instruction hooks, so they run
+        // through the instrumented loop; everything else takes the threaded
+        // fast path. Verified chunks skip operand bounds and type-tag checks.
+        if (vm->trace_execution || vm->perf || vm->opcode_profile) {
+            result = execute_instrumented(vm);
+        } else if (vm->chunk->is_verified) {
+            result = execute_threaded_unchecked(vm);
+        } else {
+            result = execute_threaded(vm);
+        }
+    } while (result == EXEC_ERROR && handle_exception(vm, vm->last_error));
+    
+    if (result != EXEC_OK) {
+        locate_error(vm);
+    }
+    return result;
+}
+
+// =============================================================================
+// DISPATCH LOOPS
+// =============================================================================
+
+/**
+ * @brief Instrumented dispatch loop
+ *
+ * Executes one instruction at a time through execute_instruction, checking
+ * error state, tracing, profiling and GC pacing after every instruction.
+ */
+static ExecutionResult execute_instrumented(RegisterVM* vm) {
     vm->running = true;
     ExecutionResult result = EXEC_OK;
     
+    // Sequences never span separate runs
+    if (vm->opcode_profile) {
+        vm->opcode_profile->previous[0] = -1;
+        vm->opcode_profile->previous[1] = -1;
+    }
+    
     while (vm->running && vm->ip < vm->chunk->code_count) {
         // Check for errors
         if (vm->has_error) {
@@ -204,6 +368,12 @@ ExecutionResult registervm_execute(RegisterVM* vm) {
             vm->perf->instructions_executed++;
         }
         
+        // Superinstructions run unfused here, so record what actually executes
+        if (vm->opcode_profile) {
+            record_opcode(vm->opcode_profile,
+                          get_base_opcode((RegisterOpcode)GET_OPCODE(instruction)));
+        }
+        
         // Execute instruction
         result = execute_instruction(vm, instruction);
         
@@ -213,7 +383,7 @@ ExecutionResult registervm_execute(RegisterVM* vm) {
         
         // Check for garbage collection
         if (vm->bytes_allocated > vm->next_gc && !vm->gc_running) {
-            registervm_gc_collect(vm);
+            registervm_gc_step(vm);
         }
     }
     
@@ -221,6 +391,22 @@ ExecutionResult registervm_execute(RegisterVM* vm) {
     return result;
 }
 
+/**
+ * @brief Threaded dispatch loops
+ *
+ * register_vm_dispatch.h is instantiated twice: a checked loop for chunks
+ * that have not been verified, and an unchecked loop for chunks whose
+ * register, constant, global and jump operands and arithmetic operand types
+ * were proven by register_chunk_verify.
+ */
+#define DISPATCH_FUNCTION execute_threaded
+#define DISPATCH_CHECKED 1
+#include "register_vm_dispatch.h"
+
+#define DISPATCH_FUNCTION execute_threaded_unchecked
+#define DISPATCH_CHECKED 0
+#include "register_vm_dispatch.h"
+
 ExecutionResult registervm_step(RegisterVM* vm) {
     if (!vm || !vm->chunk || vm->ip >= vm->chunk->code_count) {
         return EXEC_ERROR;
@@ -266,7 +452,9 @@ ExecutionResult registervm_step_over(RegisterVM* vm) {
 // =============================================================================
 
 static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction) {
-    RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
+    // A superinstruction executes as its first opcode; the rest of the fused
+    // sequence is still in place and runs as the following instructions.
+    RegisterOpcode opcode = get_base_opcode((RegisterOpcode)GET_OPCODE(instruction));
     uint8_t dst = GET_DST(instruction);
     uint8_t src1 = GET_SRC1(instruction);
     uint8_t src2 = GET_SRC2(instruction);
@@ -317,35 +505,117 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
             break;
             
         case ROP_JZ:
-            if (!check_register_bounds(src1)) {
+            if (!check_register_bounds(dst)) {
                 registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
                     "Invalid register for conditional jump", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
-            if (IS_BOOL(vm->registers[src1]) && !AS_BOOL(vm->registers[src1])) {
+            if (IS_BOOL(vm->registers[dst]) && !AS_BOOL(vm->registers[dst])) {
                 vm->ip = imm;
-            } else if (IS_I32(vm->registers[src1]) && AS_I32(vm->registers[src1]) == 0) {
+            } else if (IS_I32(vm->registers[dst]) && AS_I32(vm->registers[dst]) == 0) {
                 vm->ip = imm;
-            } else if (IS_NIL(vm->registers[src1])) {
+            } else if (IS_NIL(vm->registers[dst])) {
                 vm->ip = imm;
             }
             break;
             
         case ROP_JNZ:
-            if (!check_register_bounds(src1)) {
+            if (!check_register_bounds(dst)) {
                 registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
                     "Invalid register for conditional jump", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
-            if (IS_BOOL(vm->registers[src1]) && AS_BOOL(vm->registers[src1])) {
+            if (IS_BOOL(vm->registers[dst]) && AS_BOOL(vm->registers[dst])) {
+                vm->ip = imm;
+            } else if (IS_I32(vm->registers[dst]) && AS_I32(vm->registers[dst]) != 0) {
                 vm->ip = imm;
-            } else if (IS_I32(vm->registers[src1]) && AS_I32(vm->registers[src1]) != 0) {
+            } else if (!IS_NIL(vm->registers[dst]) && !IS_BOOL(vm->registers[dst])) {
                 vm->ip = imm;
-            } else if (!IS_NIL(vm->registers[src1]) && !IS_BOOL(vm->registers[src1])) {
+            }
+            break;
+            
+        case ROP_JEQ:
+        case ROP_JNE:
+        case ROP_JLT:
+        case ROP_JLE:
+        case ROP_JGT:
+        case ROP_JGE:
+            // Branch on the flags set by the last CMP_*
+            if (imm >= vm->chunk->code_count) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Jump target out of bounds", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (flag_jump_taken(opcode, vm->flags)) {
                 vm->ip = imm;
             }
             break;
             
+        case ROP_TRY_BEGIN: {
+            // TRY_BEGIN error, handler: errors raised until the matching
+            // TRY_END are stored in global `error` and resume at `handler`
+            if (dst >= vm->chunk->global_count || imm >= vm->chunk->code_count) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid exception handler", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (vm->exception_depth >= MAX_EXCEPTION_HANDLERS) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Too many nested try blocks", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            ExceptionHandler* handler = &vm->exception_stack[vm->exception_depth++];
+            handler->try_start = vm->ip - 1;
+            handler->try_end = imm;
+            handler->catch_address = imm;
+            handler->catch_register = dst;
+            handler->call_depth = vm->call_depth;
+            handler->previous = vm->current_handler;
+            vm->current_handler = handler;
+            break;
+        }
+            
+        case ROP_TRY_END:
+            if (vm->exception_depth > 0) {
+                vm->exception_depth--;
+                vm->current_handler = vm->exception_stack[vm->exception_depth].previous;
+            }
+            break;
+            
+        case ROP_CALL:
+            // The callee's window starts at dst, where the arguments already are
+            if (!check_register_bounds(dst)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for call", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (imm >= vm->chunk->code_count) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Call target out of bounds", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!setup_call_frame(vm, imm, dst)) {
+                return EXEC_STACK_OVERFLOW;
+            }
+            break;
+            
+        case ROP_RET:
+        case ROP_RET_VAL:
+            if (opcode == ROP_RET_VAL && !check_register_bounds(dst)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for return", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            // The callee's R0 is the caller's call register
+            vm->registers[0] = opcode == ROP_RET_VAL ? vm->registers[dst] : NIL_VAL;
+            if (vm->call_depth == 0) {
+                // Returning from top-level code ends the program
+                vm->running = false;
+                break;
+            }
+            cleanup_call_frame(vm);
+            break;
+            
         // =================================================================
         // DATA MOVEMENT
         // =================================================================
@@ -398,7 +668,7 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
             break;
             
         case ROP_STORE_GLOBAL:
-            if (!check_register_bounds(src1)) {
+            if (!check_register_bounds(dst)) {
                 registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
                     "Invalid source register", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
@@ -408,7 +678,7 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
                     "Global variable index out of bounds", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
-            vm->chunk->globals[imm] = vm->registers[src1];
+            vm->chunk->globals[imm] = vm->registers[dst];
             break;
             
         // =================================================================
@@ -428,17 +698,40 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
         case ROP_ADD_F64:
         case ROP_SUB_F64:
         case ROP_MUL_F64:
-        case ROP_DIV_F64: {
+        case ROP_DIV_F64:
+        case ROP_ADD_U32:
+        case ROP_SUB_U32:
+        case ROP_MUL_U32:
+        case ROP_DIV_U32:
+        case ROP_MOD_U32:
+        case ROP_ADD_U64:
+        case ROP_SUB_U64:
+        case ROP_MUL_U64:
+        case ROP_DIV_U64:
+        case ROP_MOD_U64:
+        case ROP_ADD_ANY:
+        case ROP_SUB_ANY:
+        case ROP_MUL_ANY:
+        case ROP_DIV_ANY:
+        case ROP_MOD_ANY:
+        case ROP_AND:
+        case ROP_OR:
+        case ROP_XOR:
+        case ROP_SHL:
+        case ROP_SHR:
+        case ROP_SAR: {
             if (!check_register_bounds(dst) || !check_register_bounds(src1) || !check_register_bounds(src2)) {
                 registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
                     "Invalid register for arithmetic", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
             
-            bool error = false;
+            const char* error = NULL;
             Value result = perform_arithmetic_operation(opcode, vm->registers[src1], vm->registers[src2], &error);
             
             if (error) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    error, (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
             
@@ -462,31 +755,88 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
             update_flags_arithmetic(vm, vm->registers[dst]);
             break;
             
+        case ROP_NEG_I64:
+        case ROP_NEG_F64:
+        case ROP_NEG_ANY:
+        case ROP_NOT: {
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for negation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            Value operand = vm->registers[src1];
+            if (opcode == ROP_NEG_ANY && IS_I32(operand)) {
+                vm->registers[dst] = I32_VAL((int32_t)(0 - (uint32_t)AS_I32(operand)));
+            } else if ((opcode == ROP_NEG_I64 || opcode == ROP_NEG_ANY) && IS_I64(operand)) {
+                vm->registers[dst] = I64_VAL((int64_t)(0 - (uint64_t)AS_I64(operand)));
+            } else if ((opcode == ROP_NEG_F64 || opcode == ROP_NEG_ANY) && IS_F64(operand)) {
+                vm->registers[dst] = F64_VAL(-AS_F64(operand));
+            } else if (opcode == ROP_NOT && IS_I32(operand)) {
+                vm->registers[dst] = I32_VAL(~AS_I32(operand));
+            } else if (opcode == ROP_NOT && IS_I64(operand)) {
+                vm->registers[dst] = I64_VAL(~AS_I64(operand));
+            } else if (opcode == ROP_NOT && IS_U32(operand)) {
+                vm->registers[dst] = U32_VAL(~AS_U32(operand));
+            } else {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    opcode == ROP_NOT ? "Operand must be an integer" : "Operand has the wrong type for negation",
+                    (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            break;
+        }
+            
+        // =================================================================
+        // LOGICAL OPERATIONS
+        // =================================================================
+        
+        case ROP_BOOL_NOT:
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for logical operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = BOOL_VAL(is_falsey(vm->registers[src1]));
+            break;
+            
+        case ROP_BOOL_AND:
+        case ROP_BOOL_OR: {
+            if (!check_register_bounds(dst) || !check_register_bounds(src1) || !check_register_bounds(src2)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for logical operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            bool a = !is_falsey(vm->registers[src1]);
+            bool b = !is_falsey(vm->registers[src2]);
+            vm->registers[dst] = BOOL_VAL(opcode == ROP_BOOL_AND ? a && b : a || b);
+            break;
+        }
+            
         // =================================================================
         // COMPARISON OPERATIONS
         // =================================================================
         
         case ROP_CMP_I32:
         case ROP_CMP_I64:
-        case ROP_CMP_F64:
+        case ROP_CMP_U32:
+        case ROP_CMP_U64:
+        case ROP_CMP_F64: {
             if (!check_register_bounds(src1) || !check_register_bounds(src2)) {
                 registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
                     "Invalid register for comparison", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
             
-            // Perform comparison and set flags
-            if (valuesEqual(vm->registers[src1], vm->registers[src2])) {
-                vm->flags |= FLAG_ZERO;
-                update_flags_comparison(vm, 0);
-            } else {
-                vm->flags &= ~FLAG_ZERO;
-                // Set other flags based on comparison result
-                // This is a simplified implementation
-                update_flags_comparison(vm, IS_I32(vm->registers[src1]) ? 
-                    AS_I32(vm->registers[src1]) - AS_I32(vm->registers[src2]) : -1);
+            // The flags are read by the JLT..JGE that follows
+            int comparison;
+            if (!compare_ordered(vm->registers[src1], vm->registers[src2], &comparison)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operands must be numbers", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
+            update_flags_comparison(vm, comparison);
             break;
+        }
             
         case ROP_EQ_I32:
         case ROP_EQ_STR:
@@ -502,6 +852,30 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
             break;
         }
         
+        case ROP_NE_I32:
+        case ROP_LT_I32:
+        case ROP_LE_I32:
+        case ROP_GT_I32:
+        case ROP_GE_I32: {
+            if (!check_register_bounds(dst) || !check_register_bounds(src1) || !check_register_bounds(src2)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for comparison", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            
+            bool error = false;
+            Value result = perform_comparison_operation(opcode, vm->registers[src1], vm->registers[src2], &error);
+            
+            if (error) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operands must be 32-bit integers", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            
+            vm->registers[dst] = result;
+            break;
+        }
+        
         // =================================================================
         // TYPE OPERATIONS
         // =================================================================
@@ -515,7 +889,7 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
             
             // Create string representation of type
             const char* type_name = "unknown";
-            switch (vm->registers[src1].type) {
+            switch (VALUE_TYPE(vm->registers[src1])) {
                 case VAL_I32: type_name = "i32"; break;
                 case VAL_I64: type_name = "i64"; break;
                 case VAL_U32: type_name = "u32"; break;
@@ -533,135 +907,1282 @@ static ExecutionResult execute_instruction(RegisterVM* vm, uint32_t instruction)
             vm->registers[dst] = STRING_VAL(allocateString(type_name, strlen(type_name)));
             break;
             
-        // =================================================================
-        // BUILT-IN FUNCTIONS
-        // =================================================================
-        
-        case ROP_PRINT:
-            if (!check_register_bounds(src1)) {
+        case ROP_CAST_I32_I64:
+        case ROP_CAST_I32_U32:
+        case ROP_CAST_I32_F64:
+        case ROP_CAST_I64_I32:
+        case ROP_CAST_F64_I32:
+        case ROP_CAST_TO_BOOL:
+        case ROP_CAST_TO_STR:
+        case ROP_GENERIC_CAST: {
+            // GENERIC_CAST names the target TypeKind in src2
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
                 registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
-                    "Invalid register for print", (SrcLocation){0, 0, 0})));
+                    "Invalid register for cast", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            TypeKind target;
+            switch (opcode) {
+                case ROP_CAST_I32_I64: target = TYPE_I64; break;
+                case ROP_CAST_I32_U32: target = TYPE_U32; break;
+                case ROP_CAST_I32_F64: target = TYPE_F64; break;
+                case ROP_CAST_I64_I32:
+                case ROP_CAST_F64_I32: target = TYPE_I32; break;
+                case ROP_CAST_TO_BOOL: target = TYPE_BOOL; break;
+                case ROP_CAST_TO_STR: target = TYPE_STRING; break;
+                default: target = (TypeKind)src2; break;
+            }
+            Value result;
+            if (!cast_value(vm->registers[src1], target, &result)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid cast", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = result;
+            break;
+        }
+            
+        case ROP_LEN:
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for length", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (IS_ARRAY(vm->registers[src1])) {
+                vm->registers[dst] = I32_VAL(AS_ARRAY(vm->registers[src1])->length);
+            } else if (IS_STRING(vm->registers[src1])) {
+                vm->registers[dst] = I32_VAL(AS_STRING(vm->registers[src1])->length);
+            } else {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be an array or a string", (SrcLocation){0, 0, 0})));
                 return EXEC_ERROR;
             }
-            printValue(vm->registers[src1]);
-            printf("\n");
             break;
             
         // =================================================================
-        // DEFAULT CASE
+        // STRING OPERATIONS
         // =================================================================
         
-        default:
-            registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
-                "Unknown opcode", (SrcLocation){0, 0, 0})));
-            return EXEC_INVALID_OPCODE;
-    }
-    
-    return EXEC_OK;
-}
-
-// =============================================================================
-// HELPER FUNCTIONS
-// =============================================================================
-
-static bool check_register_bounds(uint8_t reg) {
-    return reg < TOTAL_REGISTER_COUNT;
-}
-
-static void update_flags_arithmetic(RegisterVM* vm, Value result) {
-    vm->flags &= ~(FLAG_ZERO | FLAG_NEGATIVE);
-    
-    if (IS_I32(result) && AS_I32(result) == 0) {
-        vm->flags |= FLAG_ZERO;
-    } else if (IS_I32(result) && AS_I32(result) < 0) {
-        vm->flags |= FLAG_NEGATIVE;
-    }
-}
-
-static void update_flags_comparison(RegisterVM* vm, int comparison_result) {
-    vm->flags &= ~(FLAG_ZERO | FLAG_NEGATIVE);
-    
-    if (comparison_result == 0) {
-        vm->flags |= FLAG_ZERO;
-    } else if (comparison_result < 0) {
-        vm->flags |= FLAG_NEGATIVE;
-    }
-}
-
-static Value perform_arithmetic_operation(RegisterOpcode op, Value a, Value b, bool* error) {
-    *error = false;
-    
-    switch (op) {
-        case ROP_ADD_I32:
-            if (!IS_I32(a) || !IS_I32(b)) {
-                *error = true;
-                return NIL_VAL;
+        case ROP_STR_CONCAT:
+            if (!check_register_bounds(dst) || !check_register_bounds(src1) || !check_register_bounds(src2)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for string operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
-            return I32_VAL(AS_I32(a) + AS_I32(b));
-            
-        case ROP_SUB_I32:
-            if (!IS_I32(a) || !IS_I32(b)) {
-                *error = true;
-                return NIL_VAL;
+            if (!IS_STRING(vm->registers[src1]) || !IS_STRING(vm->registers[src2])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operands must be strings", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
-            return I32_VAL(AS_I32(a) - AS_I32(b));
+            vm->registers[dst] = STRING_VAL(concatenateStrings(
+                AS_STRING(vm->registers[src1]), AS_STRING(vm->registers[src2])));
+            break;
             
-        case ROP_MUL_I32:
-            if (!IS_I32(a) || !IS_I32(b)) {
-                *error = true;
-                return NIL_VAL;
+        case ROP_STR_BUILDER_NEW:
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for string operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_STRING(vm->registers[src1])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be a string", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
-            return I32_VAL(AS_I32(a) * AS_I32(b));
+            vm->registers[dst] = STRING_BUILDER_VAL(
+                allocateStringBuilder(AS_STRING(vm->registers[src1])));
+            break;
             
-        case ROP_DIV_I32:
-            if (!IS_I32(a) || !IS_I32(b)) {
-                *error = true;
-                return NIL_VAL;
+        case ROP_STR_BUILDER_APPEND: {
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for string operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
-            if (AS_I32(b) == 0) {
-                *error = true;
-                return NIL_VAL;
+            if (!IS_STRING_BUILDER(vm->registers[dst]) || !IS_STRING(vm->registers[src1])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operands must be a string builder and a string", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
-            return I32_VAL(AS_I32(a) / AS_I32(b));
-            
-        case ROP_ADD_F64:
-            if (!IS_F64(a) || !IS_F64(b)) {
-                *error = true;
-                return NIL_VAL;
+            ObjString* piece = AS_STRING(vm->registers[src1]);
+            if (!appendStringBuilder(AS_STRING_BUILDER(vm->registers[dst]), piece->chars, piece->length)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Out of memory growing string", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
             }
-            return F64_VAL(AS_F64(a) + AS_F64(b));
+            break;
+        }
             
-        case ROP_SUB_F64:
-            if (!IS_F64(a) || !IS_F64(b)) {
-                *error = true;
+        case ROP_STR_BUILDER_FINISH:
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for string operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_STRING_BUILDER(vm->registers[src1])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be a string builder", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = STRING_VAL(finishStringBuilder(AS_STRING_BUILDER(vm->registers[src1])));
+            break;
+            
+        // =================================================================
+        // TYPED REGISTER LANES
+        // =================================================================
+        
+        case ROP_UNBOX_I64:
+            if (!check_lane_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for unbox", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (IS_I64(vm->registers[src1])) {
+                vm->int_lanes[dst] = AS_I64(vm->registers[src1]);
+            } else if (IS_I32(vm->registers[src1])) {
+                vm->int_lanes[dst] = AS_I32(vm->registers[src1]);
+            } else {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Cannot unbox non-integer value", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            break;
+            
+        case ROP_UNBOX_F64:
+            if (!check_lane_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for unbox", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (IS_F64(vm->registers[src1])) {
+                vm->float_lanes[dst] = AS_F64(vm->registers[src1]);
+            } else if (IS_I32(vm->registers[src1])) {
+                vm->float_lanes[dst] = AS_I32(vm->registers[src1]);
+            } else {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Cannot unbox non-numeric value", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            break;
+            
+        case ROP_BOX_I64:
+            if (!check_register_bounds(dst) || !check_lane_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for box", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = I64_VAL(vm->int_lanes[src1]);
+            break;
+            
+        case ROP_BOX_F64:
+            if (!check_register_bounds(dst) || !check_lane_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for box", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = F64_VAL(vm->float_lanes[src1]);
+            break;
+            
+        case ROP_LANE_ADD_I64:
+        case ROP_LANE_SUB_I64:
+        case ROP_LANE_MUL_I64:
+        case ROP_LANE_ADD_F64:
+        case ROP_LANE_SUB_F64:
+        case ROP_LANE_MUL_F64:
+        case ROP_LANE_DIV_F64:
+        case ROP_LANE_LT_I64:
+            if (!check_lane_bounds(dst) || !check_lane_bounds(src1) || !check_lane_bounds(src2)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for lane arithmetic", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            switch (opcode) {
+                case ROP_LANE_ADD_I64:
+                    vm->int_lanes[dst] = (int64_t)((uint64_t)vm->int_lanes[src1] + (uint64_t)vm->int_lanes[src2]);
+                    break;
+                case ROP_LANE_SUB_I64:
+                    vm->int_lanes[dst] = (int64_t)((uint64_t)vm->int_lanes[src1] - (uint64_t)vm->int_lanes[src2]);
+                    break;
+                case ROP_LANE_MUL_I64:
+                    vm->int_lanes[dst] = (int64_t)((uint64_t)vm->int_lanes[src1] * (uint64_t)vm->int_lanes[src2]);
+                    break;
+                case ROP_LANE_ADD_F64:
+                    vm->float_lanes[dst] = vm->float_lanes[src1] + vm->float_lanes[src2];
+                    break;
+                case ROP_LANE_SUB_F64:
+                    vm->float_lanes[dst] = vm->float_lanes[src1] - vm->float_lanes[src2];
+                    break;
+                case ROP_LANE_MUL_F64:
+                    vm->float_lanes[dst] = vm->float_lanes[src1] * vm->float_lanes[src2];
+                    break;
+                case ROP_LANE_DIV_F64:
+                    vm->float_lanes[dst] = vm->float_lanes[src1] / vm->float_lanes[src2];
+                    break;
+                default: // ROP_LANE_LT_I64 writes a tagged bool
+                    vm->registers[dst] = BOOL_VAL(vm->int_lanes[src1] < vm->int_lanes[src2]);
+                    break;
+            }
+            break;
+            
+        // =================================================================
+        // BUILT-IN FUNCTIONS
+        // =================================================================
+        
+        case ROP_CALL_STATIC: {
+            // CALL_STATIC base, native, n: arguments in base.., result in base
+            if (!check_register_bounds(dst) || dst + src2 > TOTAL_REGISTER_COUNT) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for native call", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            Value result;
+            if (!callNative(src1, src2, &vm->registers[dst], &result)) {
+                registervm_set_error(vm, result);
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = result;
+            break;
+        }
+        
+        // =================================================================
+        // ARRAY OPERATIONS
+        // =================================================================
+        
+        case ROP_NEW_ARRAY:
+        case ROP_NEW_PACKED_ARRAY: {
+            // Elements in registers src1..src1+src2-1
+            if (!check_register_bounds(dst) || src1 + src2 > TOTAL_REGISTER_COUNT) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for array elements", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            ArrayKind kind = opcode == ROP_NEW_PACKED_ARRAY ?
+                             packed_literal_kind(&vm->registers[src1], src2) : ARRAY_VALUES;
+            ObjArray* array = allocateArrayOfKind(kind, src2);
+            // The elements already have the array's kind, so no store converts
+            for (uint8_t i = 0; i < src2; i++) {
+                arraySet(array, i, vm->registers[src1 + i]);
+            }
+            vm->registers[dst] = ARRAY_VAL(array);
+            break;
+        }
+        
+        case ROP_GET_INDEX: {
+            if (!check_register_bounds(dst) || !check_register_bounds(src1) || !check_register_bounds(src2)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for array access", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_ARRAY(vm->registers[src1])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be an array", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            ObjArray* array = AS_ARRAY(vm->registers[src1]);
+            int slot;
+            if (!resolve_array_slot(vm, vm->registers[src2], array->length, &slot)) {
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = arrayGet(array, slot);
+            break;
+        }
+        
+        case ROP_SET_INDEX: {
+            // SET_INDEX array, index, value
+            if (!check_register_bounds(dst) || !check_register_bounds(src1) || !check_register_bounds(src2)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for array access", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_ARRAY(vm->registers[dst])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be an array", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            int slot;
+            if (!resolve_array_slot(vm, vm->registers[src1], AS_ARRAY(vm->registers[dst])->length, &slot)) {
+                return EXEC_ERROR;
+            }
+            // A store that converts a packed nursery array may not fit in
+            // the nursery; a minor collection promotes the array out of it
+            if (!arraySet(AS_ARRAY(vm->registers[dst]), slot, vm->registers[src2])) {
+                registervm_gc_minor(vm);
+                if (!arraySet(AS_ARRAY(vm->registers[dst]), slot, vm->registers[src2])) {
+                    registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                        "Out of memory converting array", (SrcLocation){0, 0, 0})));
+                    return EXEC_ERROR;
+                }
+            }
+            break;
+        }
+        
+        case ROP_ARRAY_PUSH:
+            // ARRAY_PUSH array, value
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for array operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_ARRAY(vm->registers[dst])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be an array", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!arrayPush(AS_ARRAY(vm->registers[dst]), vm->registers[src1])) {
+                registervm_gc_minor(vm);
+                if (!arrayPush(AS_ARRAY(vm->registers[dst]), vm->registers[src1])) {
+                    registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                        "Out of memory growing array", (SrcLocation){0, 0, 0})));
+                    return EXEC_ERROR;
+                }
+            }
+            break;
+            
+        case ROP_ARRAY_POP:
+            // ARRAY_POP dst, array
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for array operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_ARRAY(vm->registers[src1])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operand must be an array", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (AS_ARRAY(vm->registers[src1])->length == 0) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Cannot pop from an empty array", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = arrayPop(AS_ARRAY(vm->registers[src1]));
+            break;
+            
+        case ROP_ARRAY_RESERVE: {
+            // ARRAY_RESERVE array, capacity
+            if (!check_register_bounds(dst) || !check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for array operation", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            Value capacity = vm->registers[src1];
+            if (!IS_ARRAY(vm->registers[dst]) ||
+                !(IS_I32(capacity) || IS_I64(capacity) || IS_U32(capacity) || IS_U64(capacity))) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Operands must be an array and an integer", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            int64_t wanted = IS_I32(capacity) ? AS_I32(capacity) :
+                             IS_I64(capacity) ? AS_I64(capacity) :
+                             IS_U32(capacity) ? (int64_t)AS_U32(capacity) :
+                             (int64_t)(AS_U64(capacity) > INT32_MAX ? INT32_MAX : AS_U64(capacity));
+            if (wanted > INT32_MAX) {
+                wanted = INT32_MAX;
+            }
+            // Only a hint, so a capacity that cannot be had is not an error
+            if (wanted > 0 && !reserveArray(AS_ARRAY(vm->registers[dst]), (int)wanted)) {
+                registervm_gc_minor(vm);
+                reserveArray(AS_ARRAY(vm->registers[dst]), (int)wanted);
+            }
+            break;
+        }
+        
+        case ROP_ARRAY_SLICE: {
+            // ARRAY_SLICE dst, source, s: bounds in s and s+1, nil when omitted
+            if (!check_register_bounds(dst) || !check_register_bounds(src1) ||
+                src2 + 2 > TOTAL_REGISTER_COUNT) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for slice", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            const char* error = NULL;
+            Value result = slice_value(vm->registers[src1], vm->registers[src2],
+                                       vm->registers[src2 + 1], &error);
+            if (error) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    error, (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            vm->registers[dst] = result;
+            break;
+        }
+        
+        // =================================================================
+        // STRUCT OPERATIONS
+        // =================================================================
+        
+        case ROP_NEW_STRUCT: {
+            if (src2 >= vm->chunk->shape_count) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid struct shape", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            uint8_t field_count = vm->chunk->shapes[src2].field_count;
+            if (!check_register_bounds(dst) || src1 + field_count > TOTAL_REGISTER_COUNT) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for struct fields", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            ObjArray* instance = allocateArray(field_count);
+            instance->shape = (uint16_t)(src2 + 1);
+            for (uint8_t i = 0; i < field_count; i++) {
+                instance->elements[i] = vm->registers[src1 + i];
+            }
+            vm->registers[dst] = ARRAY_VAL(instance);
+            break;
+        }
+        
+        case ROP_NEW_ENUM: {
+            // NEW_ENUM dst, first, n: type name, variant index, then n payloads
+            if (!check_register_bounds(dst) || src1 + 2 + src2 > TOTAL_REGISTER_COUNT) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for enum", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (!IS_STRING(vm->registers[src1]) || !IS_I32(vm->registers[src1 + 1])) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid enum variant", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            // The type name is passed by pointer, so it must not move
+            pauseGC();
+            ObjEnum* value = allocateEnum(AS_I32(vm->registers[src1 + 1]),
+                                          src2 > 0 ? &vm->registers[src1 + 2] : NULL, src2,
+                                          AS_STRING(vm->registers[src1]));
+            resumeGC();
+            vm->registers[dst] = ENUM_VAL(value);
+            break;
+        }
+        
+        case ROP_GET_FIELD:
+        case ROP_SET_FIELD: {
+            // GET_FIELD dst, object, field; SET_FIELD object, field, value
+            uint8_t object = opcode == ROP_GET_FIELD ? src1 : dst;
+            uint8_t field = opcode == ROP_GET_FIELD ? src2 : src1;
+            uint8_t value = opcode == ROP_GET_FIELD ? dst : src2;
+            if (!check_register_bounds(object) || !check_register_bounds(value)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for field access", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (field >= vm->chunk->field_name_count) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid field name", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            Value target = vm->registers[object];
+            int slot = resolve_field_slot(vm, vm->ip - 1, target, field);
+            if (slot < 0 || slot >= AS_ARRAY(target)->length) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Value has no such field", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            if (opcode == ROP_GET_FIELD) {
+                vm->registers[value] = AS_ARRAY(target)->elements[slot];
+            } else {
+                AS_ARRAY(target)->elements[slot] = vm->registers[value];
+                WRITE_BARRIER(&AS_ARRAY(target)->obj, vm->registers[value]);
+            }
+            break;
+        }
+        
+        case ROP_PRINT:
+            if (!check_register_bounds(src1)) {
+                registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                    "Invalid register for print", (SrcLocation){0, 0, 0})));
+                return EXEC_ERROR;
+            }
+            printValue(vm->registers[src1]);
+            // A nonzero src2 suppresses the newline (print without `ln`)
+            if (src2 == 0) {
+                printf("\n");
+            }
+            break;
+            
+        // =================================================================
+        // DEFAULT CASE
+        // =================================================================
+        
+        default:
+            registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+                "Unknown opcode", (SrcLocation){0, 0, 0})));
+            return EXEC_INVALID_OPCODE;
+    }
+    
+    return EXEC_OK;
+}
+
+// =============================================================================
+// CALL FRAMES
+// =============================================================================
+
+/**
+ * @brief Grow the register stack to at least `needed` slots
+ *
+ * New slots are NIL so the GC can scan the stack. Moves the current window
+ * along with the stack.
+ */
+static bool ensure_register_stack(RegisterVM* vm, size_t needed) {
+    if (needed <= vm->register_stack_capacity) {
+        return true;
+    }
+    
+    size_t capacity = vm->register_stack_capacity ? vm->register_stack_capacity
+                                                  : INITIAL_REGISTER_STACK_SIZE;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    
+    Value* stack = realloc(vm->register_stack, capacity * sizeof(Value));
+    if (!stack) {
+        return false;
+    }
+    for (size_t i = vm->register_stack_capacity; i < capacity; i++) {
+        stack[i] = NIL_VAL;
+    }
+    
+    vm->register_stack = stack;
+    vm->register_stack_capacity = capacity;
+    vm->registers = stack + vm->register_base;
+    return true;
+}
+
+/**
+ * @brief Make room for one more call frame
+ *
+ * Frames link to their callers by pointer, so the links and the current
+ * frame move along with the stack.
+ */
+static bool ensure_call_stack(RegisterVM* vm) {
+    if (vm->call_depth < vm->call_stack_capacity) {
+        return true;
+    }
+    
+    uint32_t capacity = vm->call_stack_capacity ? vm->call_stack_capacity * 2
+                                                : INITIAL_CALL_STACK_SIZE;
+    if (capacity > MAX_CALL_STACK_DEPTH) {
+        capacity = MAX_CALL_STACK_DEPTH;
+    }
+    
+    CallFrame* stack = realloc(vm->call_stack, capacity * sizeof(CallFrame));
+    if (!stack) {
+        return false;
+    }
+    for (uint32_t i = 0; i < vm->call_depth; i++) {
+        stack[i].previous = i > 0 ? &stack[i - 1] : NULL;
+    }
+    
+    vm->call_stack = stack;
+    vm->call_stack_capacity = capacity;
+    vm->current_frame = vm->call_depth > 0 ? &stack[vm->call_depth - 1] : NULL;
+    return true;
+}
+
+/**
+ * @brief Enter a function whose window starts at the caller's R(window)
+ *
+ * Nothing is copied: the arguments the caller left in R(window).. become the
+ * callee's R0... Must be called with vm->ip already past the CALL.
+ */
+static bool setup_call_frame(RegisterVM* vm, uint32_t function_address, uint8_t window) {
+    if (vm->call_depth >= MAX_CALL_STACK_DEPTH) {
+        registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+            "Stack overflow", (SrcLocation){0, 0, 0})));
+        return false;
+    }
+    
+    size_t base = vm->register_base + window;
+    if (!ensure_call_stack(vm) || !ensure_register_stack(vm, base + TOTAL_REGISTER_COUNT)) {
+        registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+            "Out of memory for call stack", (SrcLocation){0, 0, 0})));
+        return false;
+    }
+    
+    CallFrame* frame = &vm->call_stack[vm->call_depth++];
+    frame->return_address = vm->ip;
+    frame->register_base = base;
+    frame->register_count = REGISTER_COUNT;
+    frame->locals = NULL;
+    frame->local_count = 0;
+    frame->previous = vm->current_frame;
+    
+    vm->current_frame = frame;
+    vm->register_base = base;
+    vm->registers = vm->register_stack + base;
+    vm->ip = function_address;
+    
+    if (vm->perf) {
+        vm->perf->function_calls++;
+    }
+    return true;
+}
+
+/**
+ * @brief Leave the current function and slide back to the caller's window
+ */
+static void cleanup_call_frame(RegisterVM* vm) {
+    CallFrame* frame = vm->current_frame;
+    
+    vm->ip = frame->return_address;
+    vm->current_frame = frame->previous;
+    vm->call_depth--;
+    vm->register_base = frame->previous ? frame->previous->register_base : 0;
+    vm->registers = vm->register_stack + vm->register_base;
+    
+    // A return from inside a try block leaves its handler behind
+    while (vm->exception_depth > 0 &&
+           vm->exception_stack[vm->exception_depth - 1].call_depth > vm->call_depth) {
+        vm->exception_depth--;
+        vm->current_handler = vm->exception_stack[vm->exception_depth].previous;
+    }
+}
+
+/**
+ * @brief Resume at the innermost try handler after a runtime error
+ *
+ * Unwinds the frames called from inside the try block, stores the error in
+ * the handler's global and clears the error state.
+ *
+ * @return false if the error is not caught
+ */
+static bool handle_exception(RegisterVM* vm, Value exception) {
+    if (vm->exception_depth == 0 || !IS_ERROR(exception)) {
+        return false;
+    }
+    ExceptionHandler* handler = &vm->exception_stack[--vm->exception_depth];
+    vm->current_handler = handler->previous;
+    while (vm->call_depth > handler->call_depth) {
+        cleanup_call_frame(vm);
+    }
+    // The catch variable is typed as a string: it receives the message
+    vm->chunk->globals[handler->catch_register] = STRING_VAL(AS_ERROR(exception)->message);
+    vm->ip = handler->catch_address;
+    registervm_clear_error(vm);
+    return true;
+}
+
+/**
+ * @brief Give an uncaught error the source position of the faulting instruction
+ *
+ * Errors are raised without one; vm->ip is just past the instruction that
+ * raised it when execution stops.
+ */
+static void locate_error(RegisterVM* vm) {
+    if (!IS_ERROR(vm->last_error) || vm->ip == 0) {
+        return;
+    }
+    ObjError* error = AS_ERROR(vm->last_error);
+    const SourceLocation* location = register_chunk_get_location(vm->chunk, vm->ip - 1);
+    if (error->location.line != 0 || !location || location->line == 0) {
+        return;
+    }
+    error->location.file = register_chunk_get_source_file(vm->chunk, location->file_index);
+    error->location.line = (int)location->line;
+    error->location.column = location->column;
+}
+
+// =============================================================================
+// INLINE CACHES
+// =============================================================================
+
+/**
+ * @brief Resolve the slot of a field for the field access at `address`
+ *
+ * Hits in the instruction's inline cache return the cached slot; misses look
+ * the field up in the object's shape and cache the result while the cache
+ * has a free way. Hits and misses are counted when profiling.
+ *
+ * @return Slot index, or -1 if the object is not a struct with the field
+ */
+static inline int resolve_field_slot(RegisterVM* vm, uint32_t address, Value object,
+                                     uint8_t field) {
+    if (!IS_ARRAY(object) || AS_ARRAY(object)->shape == 0) {
+        return -1;
+    }
+    uint16_t shape = AS_ARRAY(object)->shape;
+    
+    RegisterChunk* chunk = vm->chunk;
+    InlineCache* cache = address < chunk->inline_cache_count ?
+                         &chunk->inline_caches[address] : NULL;
+    if (cache) {
+        for (uint8_t i = 0; i < cache->count; i++) {
+            if (cache->shapes[i] == shape) {
+                if (vm->perf) {
+                    vm->perf->cache_hits++;
+                }
+                return cache->slots[i];
+            }
+        }
+    }
+    
+    if (vm->perf) {
+        vm->perf->cache_misses++;
+    }
+    int slot = register_chunk_shape_slot(chunk, shape, field);
+    if (slot >= 0 && cache && cache->count < INLINE_CACHE_WAYS) {
+        cache->shapes[cache->count] = shape;
+        cache->slots[cache->count] = (uint8_t)slot;
+        cache->count++;
+    }
+    return slot;
+}
+
+// =============================================================================
+// HELPER FUNCTIONS
+// =============================================================================
+
+static bool check_register_bounds(uint8_t reg) {
+    return reg < TOTAL_REGISTER_COUNT;
+}
+
+static bool check_lane_bounds(uint8_t reg) {
+    return reg < LANE_REGISTER_COUNT;
+}
+
+/**
+ * @brief Check an index against an array's length
+ *
+ * Any integer type indexes an array. On failure the runtime error is set.
+ *
+ * @return true with the element's slot in `slot`, false if out of range
+ */
+static bool resolve_array_slot(RegisterVM* vm, Value index, int length, int* slot) {
+    int64_t i;
+    if (IS_I32(index)) {
+        i = AS_I32(index);
+    } else if (IS_I64(index)) {
+        i = AS_I64(index);
+    } else if (IS_U32(index)) {
+        i = AS_U32(index);
+    } else if (IS_U64(index)) {
+        i = AS_U64(index) > (uint64_t)INT32_MAX ? -1 : (int64_t)AS_U64(index);
+    } else {
+        registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+            "Array index must be an integer", (SrcLocation){0, 0, 0})));
+        return false;
+    }
+    if (i < 0 || i >= length) {
+        registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+            "Array index out of bounds", (SrcLocation){0, 0, 0})));
+        return false;
+    }
+    *slot = (int)i;
+    return true;
+}
+
+/**
+ * @brief Storage kind for a packed array literal
+ *
+ * The compiler only knows the elements share a primitive type; the values
+ * decide which. An empty literal stays ARRAY_PACKED until its first push.
+ */
+static ArrayKind packed_literal_kind(const Value* elements, int count) {
+    if (count == 0) {
+        return ARRAY_PACKED;
+    }
+    ArrayKind kind = arrayKindOf(elements[0]);
+    for (int i = 1; i < count; i++) {
+        if (arrayKindOf(elements[i]) != kind) {
+            return ARRAY_VALUES;
+        }
+    }
+    return kind;
+}
+
+static void update_flags_arithmetic(RegisterVM* vm, Value result) {
+    vm->flags &= ~(FLAG_ZERO | FLAG_NEGATIVE);
+    
+    if (IS_I32(result) && AS_I32(result) == 0) {
+        vm->flags |= FLAG_ZERO;
+    } else if (IS_I32(result) && AS_I32(result) < 0) {
+        vm->flags |= FLAG_NEGATIVE;
+    }
+}
+
+static void update_flags_comparison(RegisterVM* vm, int comparison_result) {
+    vm->flags &= ~(FLAG_ZERO | FLAG_NEGATIVE);
+    
+    if (comparison_result == 0) {
+        vm->flags |= FLAG_ZERO;
+    } else if (comparison_result < 0) {
+        vm->flags |= FLAG_NEGATIVE;
+    }
+}
+
+/**
+ * @brief Shared body of the generic arithmetic and bitwise handlers
+ *
+ * Integer arithmetic wraps. On failure `error` is set to the message and
+ * NIL_VAL is returned.
+ */
+static Value perform_arithmetic_operation(RegisterOpcode op, Value a, Value b, const char** error) {
+    *error = NULL;
+    
+    switch (op) {
+        case ROP_ADD_I32:
+        case ROP_SUB_I32:
+        case ROP_MUL_I32:
+        case ROP_DIV_I32:
+        case ROP_MOD_I32: {
+            if (!IS_I32(a) || !IS_I32(b)) {
+                *error = "Operands must be 32-bit integers";
                 return NIL_VAL;
             }
-            return F64_VAL(AS_F64(a) - AS_F64(b));
+            uint32_t x = (uint32_t)AS_I32(a);
+            uint32_t y = (uint32_t)AS_I32(b);
+            switch (op) {
+                case ROP_ADD_I32: return I32_VAL((int32_t)(x + y));
+                case ROP_SUB_I32: return I32_VAL((int32_t)(x - y));
+                case ROP_MUL_I32: return I32_VAL((int32_t)(x * y));
+                default: break;
+            }
+            if (y == 0) {
+                *error = "Division by zero";
+                return NIL_VAL;
+            }
+            // INT32_MIN / -1 overflows; it wraps like the other operations
+            if (AS_I32(b) == -1) {
+                return I32_VAL(op == ROP_DIV_I32 ? (int32_t)(0 - x) : 0);
+            }
+            return I32_VAL(op == ROP_DIV_I32 ? AS_I32(a) / AS_I32(b) : AS_I32(a) % AS_I32(b));
+        }
             
-        case ROP_MUL_F64:
-            if (!IS_F64(a) || !IS_F64(b)) {
-                *error = true;
+        case ROP_ADD_I64:
+        case ROP_SUB_I64:
+        case ROP_MUL_I64:
+        case ROP_DIV_I64:
+        case ROP_MOD_I64: {
+            if (!IS_I64(a) || !IS_I64(b)) {
+                *error = "Operands must be 64-bit integers";
+                return NIL_VAL;
+            }
+            uint64_t x = (uint64_t)AS_I64(a);
+            uint64_t y = (uint64_t)AS_I64(b);
+            switch (op) {
+                case ROP_ADD_I64: return I64_VAL((int64_t)(x + y));
+                case ROP_SUB_I64: return I64_VAL((int64_t)(x - y));
+                case ROP_MUL_I64: return I64_VAL((int64_t)(x * y));
+                default: break;
+            }
+            if (y == 0) {
+                *error = "Division by zero";
                 return NIL_VAL;
             }
-            return F64_VAL(AS_F64(a) * AS_F64(b));
+            if (AS_I64(b) == -1) {
+                return I64_VAL(op == ROP_DIV_I64 ? (int64_t)(0 - x) : 0);
+            }
+            return I64_VAL(op == ROP_DIV_I64 ? AS_I64(a) / AS_I64(b) : AS_I64(a) % AS_I64(b));
+        }
+            
+        case ROP_ADD_U32:
+        case ROP_SUB_U32:
+        case ROP_MUL_U32:
+        case ROP_DIV_U32:
+        case ROP_MOD_U32: {
+            if (!IS_U32(a) || !IS_U32(b)) {
+                *error = "Operands must be unsigned 32-bit integers";
+                return NIL_VAL;
+            }
+            uint32_t x = AS_U32(a);
+            uint32_t y = AS_U32(b);
+            switch (op) {
+                case ROP_ADD_U32: return U32_VAL(x + y);
+                case ROP_SUB_U32: return U32_VAL(x - y);
+                case ROP_MUL_U32: return U32_VAL(x * y);
+                default: break;
+            }
+            if (y == 0) {
+                *error = "Division by zero";
+                return NIL_VAL;
+            }
+            return U32_VAL(op == ROP_DIV_U32 ? x / y : x % y);
+        }
             
+        case ROP_ADD_U64:
+        case ROP_SUB_U64:
+        case ROP_MUL_U64:
+        case ROP_DIV_U64:
+        case ROP_MOD_U64: {
+            if (!IS_U64(a) || !IS_U64(b)) {
+                *error = "Operands must be unsigned 64-bit integers";
+                return NIL_VAL;
+            }
+            uint64_t x = AS_U64(a);
+            uint64_t y = AS_U64(b);
+            switch (op) {
+                case ROP_ADD_U64: return U64_VAL(x + y);
+                case ROP_SUB_U64: return U64_VAL(x - y);
+                case ROP_MUL_U64: return U64_VAL(x * y);
+                default: break;
+            }
+            if (y == 0) {
+                *error = "Division by zero";
+                return NIL_VAL;
+            }
+            return U64_VAL(op == ROP_DIV_U64 ? x / y : x % y);
+        }
+            
+        case ROP_ADD_ANY:
+        case ROP_SUB_ANY:
+        case ROP_MUL_ANY:
+        case ROP_DIV_ANY:
+        case ROP_MOD_ANY: {
+            // Generic code: both operands have the type the function was
+            // called with, so the tag of the first picks the typed operation
+            static const RegisterOpcode typed[][5] = {
+                { ROP_ADD_I32, ROP_SUB_I32, ROP_MUL_I32, ROP_DIV_I32, ROP_MOD_I32 },
+                { ROP_ADD_I64, ROP_SUB_I64, ROP_MUL_I64, ROP_DIV_I64, ROP_MOD_I64 },
+                { ROP_ADD_U32, ROP_SUB_U32, ROP_MUL_U32, ROP_DIV_U32, ROP_MOD_U32 },
+                { ROP_ADD_U64, ROP_SUB_U64, ROP_MUL_U64, ROP_DIV_U64, ROP_MOD_U64 },
+                { ROP_ADD_F64, ROP_SUB_F64, ROP_MUL_F64, ROP_DIV_F64, ROP_NOP },
+            };
+            int row = IS_I32(a) ? 0 : IS_I64(a) ? 1 : IS_U32(a) ? 2 : IS_U64(a) ? 3 :
+                      IS_F64(a) ? 4 : -1;
+            RegisterOpcode typed_op = row < 0 ? ROP_NOP : typed[row][op - ROP_ADD_ANY];
+            if (typed_op == ROP_NOP) {
+                *error = op == ROP_MOD_ANY ? "Operands must be integers"
+                                           : "Operands must be numbers";
+                return NIL_VAL;
+            }
+            return perform_arithmetic_operation(typed_op, a, b, error);
+        }
+            
+        case ROP_ADD_F64:
+        case ROP_SUB_F64:
+        case ROP_MUL_F64:
         case ROP_DIV_F64:
             if (!IS_F64(a) || !IS_F64(b)) {
-                *error = true;
+                *error = "Operands must be floating point numbers";
                 return NIL_VAL;
             }
+            switch (op) {
+                case ROP_ADD_F64: return F64_VAL(AS_F64(a) + AS_F64(b));
+                case ROP_SUB_F64: return F64_VAL(AS_F64(a) - AS_F64(b));
+                case ROP_MUL_F64: return F64_VAL(AS_F64(a) * AS_F64(b));
+                default: break;
+            }
             if (AS_F64(b) == 0.0) {
-                *error = true;
+                *error = "Division by zero";
                 return NIL_VAL;
             }
             return F64_VAL(AS_F64(a) / AS_F64(b));
             
+        case ROP_AND:
+        case ROP_OR:
+        case ROP_XOR:
+        case ROP_SHL:
+        case ROP_SHR:
+        case ROP_SAR: {
+            // Both operands have the same integer type; shift counts wrap
+            // at the operand width
+            if (IS_I32(a) && IS_I32(b)) {
+                uint32_t x = (uint32_t)AS_I32(a);
+                uint32_t y = (uint32_t)AS_I32(b);
+                switch (op) {
+                    case ROP_AND: return I32_VAL((int32_t)(x & y));
+                    case ROP_OR:  return I32_VAL((int32_t)(x | y));
+                    case ROP_XOR: return I32_VAL((int32_t)(x ^ y));
+                    case ROP_SHL: return I32_VAL((int32_t)(x << (y & 31)));
+                    case ROP_SHR: return I32_VAL((int32_t)(x >> (y & 31)));
+                    default:      return I32_VAL(AS_I32(a) >> (y & 31));
+                }
+            }
+            if (IS_I64(a) && IS_I64(b)) {
+                uint64_t x = (uint64_t)AS_I64(a);
+                uint64_t y = (uint64_t)AS_I64(b);
+                switch (op) {
+                    case ROP_AND: return I64_VAL((int64_t)(x & y));
+                    case ROP_OR:  return I64_VAL((int64_t)(x | y));
+                    case ROP_XOR: return I64_VAL((int64_t)(x ^ y));
+                    case ROP_SHL: return I64_VAL((int64_t)(x << (y & 63)));
+                    case ROP_SHR: return I64_VAL((int64_t)(x >> (y & 63)));
+                    default:      return I64_VAL(AS_I64(a) >> (y & 63));
+                }
+            }
+            if (IS_U32(a) && IS_U32(b)) {
+                uint32_t x = AS_U32(a);
+                uint32_t y = AS_U32(b);
+                switch (op) {
+                    case ROP_AND: return U32_VAL(x & y);
+                    case ROP_OR:  return U32_VAL(x | y);
+                    case ROP_XOR: return U32_VAL(x ^ y);
+                    case ROP_SHL: return U32_VAL(x << (y & 31));
+                    default:      return U32_VAL(x >> (y & 31));
+                }
+            }
+            *error = "Operands must be integers of the same type";
+            return NIL_VAL;
+        }
+            
+        default:
+            *error = "Unsupported arithmetic operation";
+            return NIL_VAL;
+    }
+}
+
+static Value perform_comparison_operation(RegisterOpcode op, Value a, Value b, bool* error) {
+    *error = false;
+    
+    if (!IS_I32(a) || !IS_I32(b)) {
+        *error = true;
+        return NIL_VAL;
+    }
+    
+    switch (op) {
+        case ROP_NE_I32: return BOOL_VAL(AS_I32(a) != AS_I32(b));
+        case ROP_LT_I32: return BOOL_VAL(AS_I32(a) < AS_I32(b));
+        case ROP_LE_I32: return BOOL_VAL(AS_I32(a) <= AS_I32(b));
+        case ROP_GT_I32: return BOOL_VAL(AS_I32(a) > AS_I32(b));
+        case ROP_GE_I32: return BOOL_VAL(AS_I32(a) >= AS_I32(b));
         default:
             *error = true;
             return NIL_VAL;
     }
 }
 
+/**
+ * @brief Order two numbers for CMP_*
+ *
+ * Values of the same type compare directly; mixed numeric types compare as
+ * doubles. NaN compares greater than everything.
+ *
+ * @return false if either operand is not a number
+ */
+static bool compare_ordered(Value a, Value b, int* comparison) {
+    if (IS_I32(a) && IS_I32(b)) {
+        *comparison = (AS_I32(a) > AS_I32(b)) - (AS_I32(a) < AS_I32(b));
+    } else if (IS_I64(a) && IS_I64(b)) {
+        *comparison = (AS_I64(a) > AS_I64(b)) - (AS_I64(a) < AS_I64(b));
+    } else if (IS_U32(a) && IS_U32(b)) {
+        *comparison = (AS_U32(a) > AS_U32(b)) - (AS_U32(a) < AS_U32(b));
+    } else if (IS_U64(a) && IS_U64(b)) {
+        *comparison = (AS_U64(a) > AS_U64(b)) - (AS_U64(a) < AS_U64(b));
+    } else {
+        Value x, y;
+        if (!cast_value(a, TYPE_F64, &x) || !cast_value(b, TYPE_F64, &y) ||
+            IS_BOOL(a) || IS_BOOL(b)) {
+            return false;
+        }
+        *comparison = AS_F64(x) < AS_F64(y) ? -1 : AS_F64(x) == AS_F64(y) ? 0 : 1;
+    }
+    return true;
+}
+
+static bool flag_jump_taken(RegisterOpcode op, uint8_t flags) {
+    bool zero = (flags & FLAG_ZERO) != 0;
+    bool negative = (flags & FLAG_NEGATIVE) != 0;
+    switch (op) {
+        case ROP_JEQ: return zero;
+        case ROP_JNE: return !zero;
+        case ROP_JLT: return negative;
+        case ROP_JLE: return negative || zero;
+        case ROP_JGT: return !negative && !zero;
+        default:      return !negative; // ROP_JGE
+    }
+}
+
+/** Falsey values are false, nil and zero, as for JZ */
+static bool is_falsey(Value value) {
+    return (IS_BOOL(value) && !AS_BOOL(value)) || IS_NIL(value) ||
+           (IS_I32(value) && AS_I32(value) == 0);
+}
+
+/**
+ * @brief Convert a value to a primitive type
+ *
+ * Numbers convert to any numeric type (floats truncate, saturating at the
+ * target's range), to bool (nonzero) and to string. Values already of the
+ * target type are returned as they are.
+ *
+ * @return false if the value has no conversion to `kind`
+ */
+static bool cast_value(Value value, TypeKind kind, Value* result) {
+    bool numeric = IS_I32(value) || IS_I64(value) || IS_U32(value) ||
+                   IS_U64(value) || IS_F64(value);
+    
+    if (kind == TYPE_STRING) {
+        char buffer[64];
+        int length;
+        if (IS_STRING(value)) {
+            *result = value;
+            return true;
+        } else if (IS_I32(value)) {
+            length = snprintf(buffer, sizeof(buffer), "%d", AS_I32(value));
+        } else if (IS_I64(value)) {
+            length = snprintf(buffer, sizeof(buffer), "%lld", (long long)AS_I64(value));
+        } else if (IS_U32(value)) {
+            length = snprintf(buffer, sizeof(buffer), "%u", AS_U32(value));
+        } else if (IS_U64(value)) {
+            length = snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)AS_U64(value));
+        } else if (IS_F64(value)) {
+            length = snprintf(buffer, sizeof(buffer), "%g", AS_F64(value));
+        } else if (IS_BOOL(value)) {
+            length = snprintf(buffer, sizeof(buffer), "%s", AS_BOOL(value) ? "true" : "false");
+        } else if (IS_NIL(value)) {
+            length = snprintf(buffer, sizeof(buffer), "nil");
+        } else {
+            return false;
+        }
+        *result = STRING_VAL(allocateString(buffer, length));
+        return true;
+    }
+    
+    if (kind == TYPE_BOOL) {
+        if (IS_BOOL(value)) {
+            *result = value;
+        } else if (numeric) {
+            Value number;
+            cast_value(value, TYPE_F64, &number);
+            *result = BOOL_VAL(AS_F64(number) != 0.0);
+        } else if (IS_NIL(value)) {
+            *result = BOOL_VAL(false);
+        } else if (IS_STRING(value)) {
+            *result = BOOL_VAL(AS_STRING(value)->length > 0);
+        } else {
+            *result = BOOL_VAL(true);
+        }
+        return true;
+    }
+    
+    if (IS_BOOL(value)) {
+        value = I32_VAL(AS_BOOL(value) ? 1 : 0);
+    } else if (!numeric) {
+        return false;
+    }
+    
+    // Integers convert exactly through 64 bits; floats saturate
+    double f = 0.0;
+    int64_t i = 0;
+    uint64_t u = 0;
+    bool is_float = IS_F64(value);
+    if (IS_I32(value)) {
+        i = AS_I32(value);
+    } else if (IS_I64(value)) {
+        i = AS_I64(value);
+    } else if (IS_U32(value)) {
+        i = AS_U32(value);
+    } else if (IS_U64(value)) {
+        u = AS_U64(value);
+        i = (int64_t)u;
+    } else {
+        f = AS_F64(value);
+    }
+    if (!IS_U64(value) && !is_float) {
+        u = (uint64_t)i;
+    }
+    
+    switch (kind) {
+        case TYPE_I32:
+            *result = I32_VAL(is_float ? (f != f ? 0 : f <= INT32_MIN ? INT32_MIN :
+                                          f >= INT32_MAX ? INT32_MAX : (int32_t)f)
+                                       : (int32_t)(uint32_t)u);
+            return true;
+        case TYPE_I64:
+            *result = I64_VAL(is_float ? (f != f ? 0 : f <= (double)INT64_MIN ? INT64_MIN :
+                                          f >= (double)INT64_MAX ? INT64_MAX : (int64_t)f)
+                                       : (int64_t)u);
+            return true;
+        case TYPE_U32:
+            *result = U32_VAL(is_float ? (f != f || f <= 0 ? 0 : f >= UINT32_MAX ? UINT32_MAX :
+                                          (uint32_t)f)
+                                       : (uint32_t)u);
+            return true;
+        case TYPE_U64:
+            *result = U64_VAL(is_float ? (f != f || f <= 0 ? 0 : f >= (double)UINT64_MAX ?
+                                          UINT64_MAX : (uint64_t)f)
+                                       : u);
+            return true;
+        case TYPE_F64:
+            *result = F64_VAL(is_float ? f : IS_U64(value) ? (double)u : (double)i);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Slice an array or string for ARRAY_SLICE
+ *
+ * Omitted (nil) bounds default to the whole value; bounds are clamped to
+ * its length and an inverted range is empty.
+ */
+static Value slice_value(Value source, Value start, Value end, const char** error) {
+    *error = NULL;
+    int length;
+    if (IS_ARRAY(source)) {
+        length = AS_ARRAY(source)->length;
+    } else if (IS_STRING(source)) {
+        length = AS_STRING(source)->length;
+    } else {
+        *error = "Only arrays and strings can be sliced";
+        return NIL_VAL;
+    }
+    
+    int64_t bounds[2] = {0, length};
+    Value given[2] = {start, end};
+    for (int k = 0; k < 2; k++) {
+        Value bound;
+        if (IS_NIL(given[k])) {
+            continue;
+        }
+        if (IS_F64(given[k]) || !cast_value(given[k], TYPE_I64, &bound)) {
+            *error = "Slice bounds must be integers";
+            return NIL_VAL;
+        }
+        bounds[k] = AS_I64(bound) < 0 ? 0 : AS_I64(bound) > length ? length : AS_I64(bound);
+    }
+    int from = (int)bounds[0];
+    int count = bounds[1] > bounds[0] ? (int)(bounds[1] - bounds[0]) : 0;
+    
+    // The source is read while the slice is allocated, and copying may box
+    // packed elements; nothing may move until it is done
+    pauseGC();
+    Value slice;
+    if (IS_STRING(source)) {
+        slice = STRING_VAL(allocateString(AS_STRING(source)->chars + from, count));
+    } else {
+        ObjArray* array = AS_ARRAY(source);
+        ObjArray* elements = allocateArrayOfKind((ArrayKind)array->kind, count);
+        for (int i = 0; i < count; i++) {
+            arraySet(elements, i, arrayGet(array, from + i));
+        }
+        slice = ARRAY_VAL(elements);
+    }
+    resumeGC();
+    return slice;
+}
+
+static void record_opcode(OpcodeProfile* profile, uint8_t opcode) {
+    profile->singles[opcode]++;
+    
+    if (profile->previous[1] >= 0) {
+        profile->pairs[profile->previous[1]][opcode]++;
+    }
+    
+    if (profile->previous[0] >= 0) {
+        uint32_t key = (((uint32_t)profile->previous[0] << 16) |
+                        ((uint32_t)profile->previous[1] << 8) | opcode) + 1;
+        uint32_t slot = (key * 2654435761u) % OPCODE_TRIPLE_SLOTS;
+        
+        // Linear probing; give up after a full sweep
+        uint32_t probes = 0;
+        while (profile->triples[slot].key != key && profile->triples[slot].key != 0 &&
+               probes < OPCODE_TRIPLE_SLOTS) {
+            slot = (slot + 1) % OPCODE_TRIPLE_SLOTS;
+            probes++;
+        }
+        if (probes == OPCODE_TRIPLE_SLOTS) {
+            profile->dropped_triples++;
+        } else {
+            profile->triples[slot].key = key;
+            profile->triples[slot].count++;
+        }
+    }
+    
+    profile->previous[0] = profile->previous[1];
+    profile->previous[1] = opcode;
+}
+
 static void trace_instruction(const RegisterVM* vm, uint32_t instruction) {
     RegisterOpcode opcode = (RegisterOpcode)GET_OPCODE(instruction);
     uint8_t dst = GET_DST(instruction);
@@ -679,29 +2200,190 @@ static void trace_instruction(const RegisterVM* vm, uint32_t instruction) {
 // MEMORY MANAGEMENT INTEGRATION
 // =============================================================================
 
-void registervm_gc_collect(RegisterVM* vm) {
-    if (!vm || vm->gc_running) {
+/**
+ * @brief Visit every root slot
+ *
+ * Shared by marking, which reads the slots, and minor collections, which
+ * rewrite them to point at promoted objects.
+ */
+static void visit_roots(RegisterVM* vm, void (*visit)(Value* slot)) {
+    // The register stack up to the top of the current window; every
+    // caller's registers lie below it
+    size_t top = vm->register_base + TOTAL_REGISTER_COUNT;
+    for (size_t i = 0; i < top && i < vm->register_stack_capacity; i++) {
+        visit(&vm->register_stack[i]);
+    }
+    
+    // Current exception and last error
+    visit(&vm->current_exception);
+    visit(&vm->last_error);
+    
+    // Globals in chunk; STORE_GLOBAL needs no write barrier since they are
+    // visited by every minor collection and again when marking finishes
+    if (vm->chunk && vm->chunk->globals) {
+        for (uint16_t i = 0; i < vm->chunk->global_count; i++) {
+            visit(&vm->chunk->globals[i]);
+        }
+    }
+    
+    // Constants in chunk
+    if (vm->chunk && vm->chunk->constants) {
+        for (uint32_t i = 0; i < vm->chunk->constant_count; i++) {
+            visit(&vm->chunk->constants[i]);
+        }
+    }
+    
+    // Call frame locals
+    CallFrame* frame = vm->current_frame;
+    while (frame) {
+        if (frame->locals) {
+            for (uint16_t i = 0; i < frame->local_count; i++) {
+                visit(&frame->locals[i]);
+            }
+        }
+        frame = frame->previous;
+    }
+}
+
+static void mark_root(Value* slot) {
+    markValue(*slot);
+}
+
+void registervm_gc_mark_roots(RegisterVM* vm) {
+    if (!vm) {
         return;
     }
     
-    vm->gc_running = true;
+    visit_roots(vm, mark_root);
     
-    size_t before = vm->bytes_allocated;
+    // Mark the types the compiler registered
+    markTypeRoots();
+}
+
+/** Start of a collector pause, or 0 when pauses are not recorded */
+static uint64_t gc_pause_begin(RegisterVM* vm) {
+    if (!vm->perf) {
+        return 0;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/** Add a pause that started at `start` to the gc_time histogram */
+static void gc_pause_end(RegisterVM* vm, uint64_t start) {
+    if (!vm->perf) {
+        return;
+    }
+    uint64_t elapsed = gc_pause_begin(vm) - start;
+    GCPauseHistogram* pauses = &vm->perf->gc_time;
+    pauses->total += elapsed;
+    pauses->pauses++;
+    if (elapsed > pauses->max) {
+        pauses->max = elapsed;
+    }
     
-    // Mark all reachable objects
-    registervm_gc_mark_roots(vm);
+    int bucket = 0;
+    for (uint64_t us = elapsed / 1000; us > 0 && bucket < GC_PAUSE_BUCKETS - 1; us >>= 1) {
+        bucket++;
+    }
+    pauses->buckets[bucket]++;
+}
+
+/** Promote the nursery's survivors; the caller holds gc_running */
+static void collect_nursery(RegisterVM* vm) {
+    if (!vm->nursery) {
+        return;
+    }
+    
+    // Types only reference compile-time objects, so they are not roots here
+    visit_roots(vm, forwardValue);
+    collectNursery();
+    
+    if (vm->perf) {
+        vm->perf->gc_minor_collections++;
+    }
+    
+    // Filling the nursery also pays for a step of an incremental cycle
+    if (vm->gc_phase != GC_PHASE_IDLE) {
+        vm->next_gc = 0;
+    }
+}
+
+void registervm_gc_minor(RegisterVM* vm) {
+    if (!vm || !vm->nursery || vm->gc_running || isGCPaused()) {
+        return;
+    }
+    
+    uint64_t start = gc_pause_begin(vm);
+    vm->gc_running = true;
+    setGCHeap(vm);
     
-    // Collect garbage
-    collectGarbage();
+    collect_nursery(vm);
     
-    // Update GC threshold
+    vm->gc_running = false;
+    gc_pause_end(vm, start);
+}
+
+/** Start a cycle: empty the nursery, then gray the roots */
+static void gc_begin_cycle(RegisterVM* vm) {
+    collect_nursery(vm);
+    beginMarking();
+    registervm_gc_mark_roots(vm);
+}
+
+/**
+ * Finish marking. Roots are not write-barriered and the nursery is never
+ * marked, so both are scanned once more before anything is swept.
+ */
+static void gc_finish_marking(RegisterVM* vm) {
+    collect_nursery(vm);
+    registervm_gc_mark_roots(vm);
+    traceGray(SIZE_MAX);
+    beginSweep();
+}
+
+/** Account for a finished cycle and set the threshold for the next one */
+static void gc_finish_cycle(RegisterVM* vm) {
+    // Never drop below the initial threshold so a small live heap does not
+    // collect every few allocations
     vm->next_gc = vm->bytes_allocated * GC_HEAP_GROW_FACTOR;
+    if (vm->next_gc < DEFAULT_GC_THRESHOLD) {
+        vm->next_gc = DEFAULT_GC_THRESHOLD;
+    }
     
     if (vm->perf) {
         vm->perf->gc_collections++;
     }
+}
+
+void registervm_gc_collect(RegisterVM* vm) {
+    if (!vm || vm->gc_running || isGCPaused()) {
+        return;
+    }
+    
+    uint64_t start = gc_pause_begin(vm);
+    vm->gc_running = true;
+    setGCHeap(vm);
+    
+    size_t before = vm->bytes_allocated;
+    
+    // Finish the sweep of an incremental cycle; one that is still marking
+    // simply runs to completion below
+    if (vm->gc_phase == GC_PHASE_SWEEP) {
+        sweepHeap(SIZE_MAX);
+        gc_finish_cycle(vm);
+    }
+    
+    if (vm->gc_phase == GC_PHASE_IDLE) {
+        gc_begin_cycle(vm);
+    }
+    gc_finish_marking(vm);
+    sweepHeap(SIZE_MAX);
+    gc_finish_cycle(vm);
     
     vm->gc_running = false;
+    gc_pause_end(vm, start);
     
     if (vm->trace_memory) {
         printf("GC: collected %zu bytes (%zu -> %zu)\n", 
@@ -709,46 +2391,56 @@ void registervm_gc_collect(RegisterVM* vm) {
     }
 }
 
-void registervm_gc_mark_roots(RegisterVM* vm) {
-    if (!vm) {
+void registervm_gc_step(RegisterVM* vm) {
+    if (!vm || vm->gc_running || isGCPaused()) {
         return;
     }
-    
-    // Mark all register values
-    for (int i = 0; i < TOTAL_REGISTER_COUNT; i++) {
-        markValue(vm->registers[i]);
+    if (!vm->gc_incremental) {
+        registervm_gc_collect(vm);
+        return;
     }
     
-    // Mark current exception
-    markValue(vm->current_exception);
-    
-    // Mark last error
-    markValue(vm->last_error);
+    uint64_t start = gc_pause_begin(vm);
+    vm->gc_running = true;
+    setGCHeap(vm);
     
-    // Mark globals in chunk
-    if (vm->chunk && vm->chunk->globals) {
-        for (uint16_t i = 0; i < vm->chunk->global_count; i++) {
-            markValue(vm->chunk->globals[i]);
-        }
+    switch ((GCPhase)vm->gc_phase) {
+        case GC_PHASE_IDLE:
+            gc_begin_cycle(vm);
+            break;
+        case GC_PHASE_MARK:
+            if (traceGray(vm->gc_step_work)) {
+                gc_finish_marking(vm);
+            }
+            break;
+        case GC_PHASE_SWEEP:
+            if (sweepHeap(vm->gc_step_work)) {
+                gc_finish_cycle(vm);
+            }
+            break;
     }
     
-    // Mark constants in chunk
-    if (vm->chunk && vm->chunk->constants) {
-        for (uint32_t i = 0; i < vm->chunk->constant_count; i++) {
-            markValue(vm->chunk->constants[i]);
-        }
+    // Keep stepping while the cycle lasts
+    if (vm->gc_phase != GC_PHASE_IDLE) {
+        vm->next_gc = vm->bytes_allocated + GC_STEP_BYTES;
     }
     
-    // Mark call frame locals
-    CallFrame* frame = vm->current_frame;
-    while (frame) {
-        if (frame->locals) {
-            for (uint16_t i = 0; i < frame->local_count; i++) {
-                markValue(frame->locals[i]);
-            }
-        }
-        frame = frame->previous;
+    vm->gc_running = false;
+    gc_pause_end(vm, start);
+}
+
+void registervm_set_gc_stress(RegisterVM* vm, bool enabled) {
+    if (vm) {
+        vm->gc_stress = enabled;
+    }
+}
+
+void registervm_set_gc_incremental(RegisterVM* vm, bool enabled, size_t step_work) {
+    if (!vm) {
+        return;
     }
+    vm->gc_incremental = enabled;
+    vm->gc_step_work = step_work > 0 ? step_work : GC_DEFAULT_STEP_WORK;
 }
 
 // =============================================================================
@@ -804,6 +2496,350 @@ const PerformanceCounters* registervm_get_performance(const RegisterVM* vm) {
     return vm ? vm->perf : NULL;
 }
 
+bool registervm_enable_opcode_profiling(RegisterVM* vm) {
+    if (!vm) {
+        return false;
+    }
+    
+    if (!vm->opcode_profile) {
+        vm->opcode_profile = malloc(sizeof(OpcodeProfile));
+        if (!vm->opcode_profile) {
+            return false;
+        }
+    }
+    
+    memset(vm->opcode_profile, 0, sizeof(OpcodeProfile));
+    vm->opcode_profile->previous[0] = -1;
+    vm->opcode_profile->previous[1] = -1;
+    return true;
+}
+
+void registervm_disable_opcode_profiling(RegisterVM* vm) {
+    if (vm && vm->opcode_profile) {
+        free(vm->opcode_profile);
+        vm->opcode_profile = NULL;
+    }
+}
+
+const OpcodeProfile* registervm_get_opcode_profile(const RegisterVM* vm) {
+    return vm ? vm->opcode_profile : NULL;
+}
+
+/** Opcode sequence and its count, for sorting profile entries */
+typedef struct {
+    uint32_t sequence;
+    uint64_t count;
+} ProfileEntry;
+
+static int compare_profile_entries(const void* a, const void* b) {
+    uint64_t ca = ((const ProfileEntry*)a)->count;
+    uint64_t cb = ((const ProfileEntry*)b)->count;
+    return ca < cb ? 1 : (ca > cb ? -1 : 0);
+}
+
+void registervm_print_opcode_profile(const RegisterVM* vm, int top_n) {
+    if (!vm || !vm->opcode_profile) {
+        printf("Opcode profile: disabled\n");
+        return;
+    }
+    
+    const OpcodeProfile* profile = vm->opcode_profile;
+    ProfileEntry* entries = malloc(sizeof(ProfileEntry) * 256 * 256);
+    if (!entries) {
+        return;
+    }
+    
+    size_t count = 0;
+    for (int a = 0; a < 256; a++) {
+        for (int b = 0; b < 256; b++) {
+            if (profile->pairs[a][b] > 0) {
+                entries[count++] = (ProfileEntry){ (uint32_t)(a << 8 | b), profile->pairs[a][b] };
+            }
+        }
+    }
+    qsort(entries, count, sizeof(ProfileEntry), compare_profile_entries);
+    
+    printf("=== Opcode Pairs ===\n");
+    for (size_t i = 0; i < count && i < (size_t)top_n; i++) {
+        printf("%12llu  %s %s\n", (unsigned long long)entries[i].count,
+               get_instruction_name((RegisterOpcode)(entries[i].sequence >> 8)),
+               get_instruction_name((RegisterOpcode)(entries[i].sequence & 0xFF)));
+    }
+    
+    count = 0;
+    for (int i = 0; i < OPCODE_TRIPLE_SLOTS; i++) {
+        if (profile->triples[i].key != 0) {
+            entries[count++] = (ProfileEntry){ profile->triples[i].key - 1, profile->triples[i].count };
+        }
+    }
+    qsort(entries, count, sizeof(ProfileEntry), compare_profile_entries);
+    
+    printf("=== Opcode Triples ===\n");
+    for (size_t i = 0; i < count && i < (size_t)top_n; i++) {
+        printf("%12llu  %s %s %s\n", (unsigned long long)entries[i].count,
+               get_instruction_name((RegisterOpcode)(entries[i].sequence >> 16)),
+               get_instruction_name((RegisterOpcode)((entries[i].sequence >> 8) & 0xFF)),
+               get_instruction_name((RegisterOpcode)(entries[i].sequence & 0xFF)));
+    }
+    if (profile->dropped_triples > 0) {
+        printf("(%llu triples dropped, table full)\n",
+               (unsigned long long)profile->dropped_triples);
+    }
+    printf("====================\n");
+    
+    free(entries);
+}
+
+void registervm_print_gc_pauses(const RegisterVM* vm) {
+    if (!vm || !vm->perf) {
+        printf("GC pauses: profiling disabled\n");
+        return;
+    }
+    
+    const GCPauseHistogram* pauses = &vm->perf->gc_time;
+    printf("=== GC Pauses ===\n");
+    printf("%llu pauses, %.3f ms total, %.3f ms max\n",
+           (unsigned long long)pauses->pauses, pauses->total / 1e6, pauses->max / 1e6);
+    for (int i = 0; i < GC_PAUSE_BUCKETS; i++) {
+        if (pauses->buckets[i] == 0) {
+            continue;
+        }
+        unsigned long long low = i == 0 ? 0 : 1ULL << (i - 1);
+        if (i == GC_PAUSE_BUCKETS - 1) {
+            printf("  >= %6llu us        %12llu\n", low,
+                   (unsigned long long)pauses->buckets[i]);
+        } else {
+            printf("  %6llu - %6llu us  %12llu\n", low, 1ULL << i,
+                   (unsigned long long)pauses->buckets[i]);
+        }
+    }
+}
+
+bool registervm_enable_allocation_profiling(RegisterVM* vm) {
+    if (!vm) {
+        return false;
+    }
+    registervm_disable_allocation_profiling(vm);
+    
+    uint32_t address_count = vm->chunk ? vm->chunk->code_count : 0;
+    AllocationProfile* profile = calloc(1, sizeof(AllocationProfile));
+    if (!profile) {
+        return false;
+    }
+    profile->capacity = 16;
+    profile->sites = calloc(profile->capacity, sizeof(AllocationSite));
+    profile->site_of = calloc(address_count > 0 ? address_count : 1, sizeof(uint16_t));
+    if (!profile->sites || !profile->site_of) {
+        free(profile->sites);
+        free(profile->site_of);
+        free(profile);
+        return false;
+    }
+    profile->address_count = address_count;
+    
+    // Site 0 stands for allocations not made by an instruction
+    profile->sites[0].address = UINT32_MAX;
+    profile->count = 1;
+    
+    vm->alloc_profile = profile;
+    return true;
+}
+
+void registervm_disable_allocation_profiling(RegisterVM* vm) {
+    if (vm && vm->alloc_profile) {
+        free(vm->alloc_profile->sites);
+        free(vm->alloc_profile->site_of);
+        free(vm->alloc_profile);
+        vm->alloc_profile = NULL;
+    }
+}
+
+const AllocationProfile* registervm_get_allocation_profile(const RegisterVM* vm) {
+    return vm ? vm->alloc_profile : NULL;
+}
+
+void registervm_record_allocation(RegisterVM* vm, Obj* object, size_t size) {
+    AllocationProfile* profile = vm->alloc_profile;
+    uint16_t site = 0;
+    
+    // execute_instruction has already advanced ip past the instruction
+    uint32_t address = vm->ip - 1;
+    if (vm->running && vm->ip > 0 && address < profile->address_count) {
+        site = profile->site_of[address];
+        if (site == 0 && profile->count < ALLOCATION_SITE_LIMIT) {
+            if (profile->count >= profile->capacity) {
+                uint32_t capacity = profile->capacity * 2;
+                AllocationSite* sites = realloc(profile->sites, sizeof(AllocationSite) * capacity);
+                if (sites) {
+                    profile->sites = sites;
+                    profile->capacity = capacity;
+                }
+            }
+            if (profile->count < profile->capacity) {
+                site = (uint16_t)profile->count++;
+                profile->sites[site] = (AllocationSite){ .address = address };
+                profile->site_of[address] = site;
+            }
+        }
+    }
+    
+    object->site = site;
+    profile->sites[site].allocations++;
+    profile->sites[site].bytes += size;
+}
+
+/** Describe where a site is, as file:line when debug info has it */
+static void format_site_location(const RegisterVM* vm, const AllocationSite* site,
+                                 char* buffer, size_t size) {
+    if (site->address == UINT32_MAX) {
+        snprintf(buffer, size, "<untracked>");
+        return;
+    }
+    const SourceLocation* location = register_chunk_get_location(vm->chunk, site->address);
+    if (!location || location->line == 0) {
+        snprintf(buffer, size, "@%04X", site->address);
+        return;
+    }
+    const char* file = register_chunk_get_source_file(vm->chunk, location->file_index);
+    snprintf(buffer, size, "%s:%u", file ? file : "?", location->line);
+}
+
+void registervm_print_allocation_profile(const RegisterVM* vm, int top_n) {
+    if (!vm || !vm->alloc_profile) {
+        printf("Allocation profile: disabled\n");
+        return;
+    }
+    
+    const AllocationProfile* profile = vm->alloc_profile;
+    ProfileEntry* entries = malloc(sizeof(ProfileEntry) * profile->count);
+    if (!entries) {
+        return;
+    }
+    
+    size_t count = 0;
+    for (uint32_t i = 0; i < profile->count; i++) {
+        if (profile->sites[i].allocations > 0) {
+            entries[count++] = (ProfileEntry){ i, profile->sites[i].bytes };
+        }
+    }
+    qsort(entries, count, sizeof(ProfileEntry), compare_profile_entries);
+    
+    printf("=== Allocation Sites ===\n");
+    printf("%12s %10s %10s %12s %12s  %s\n",
+           "bytes", "objects", "live", "live bytes", "retained", "site");
+    for (size_t i = 0; i < count && i < (size_t)top_n; i++) {
+        const AllocationSite* site = &profile->sites[entries[i].sequence];
+        char location[256];
+        format_site_location(vm, site, location, sizeof(location));
+        printf("%12llu %10llu %10llu %12llu %12llu  %s\n",
+               (unsigned long long)site->bytes,
+               (unsigned long long)site->allocations,
+               (unsigned long long)site->live_objects,
+               (unsigned long long)site->live_bytes,
+               (unsigned long long)site->retained_bytes, location);
+    }
+    if (profile->count >= ALLOCATION_SITE_LIMIT) {
+        printf("(site table full, later sites counted as untracked)\n");
+    }
+    printf("========================\n");
+    
+    free(entries);
+}
+
+static const char* object_type_name(ObjType type) {
+    switch (type) {
+        case OBJ_STRING: return "string";
+        case OBJ_ARRAY: return "array";
+        case OBJ_INT_ARRAY: return "int_array";
+        case OBJ_ERROR: return "error";
+        case OBJ_RANGE_ITERATOR: return "range_iterator";
+        case OBJ_ENUM: return "enum";
+        case OBJ_BOXED_INT: return "boxed_int";
+        case OBJ_STRING_BUILDER: return "string_builder";
+        case OBJ_AST: return "ast";
+        case OBJ_TYPE: return "type";
+    }
+    return "unknown";
+}
+
+/** Write a marked heap and fold it into the profile's live figures */
+static void write_heap_snapshot(RegisterVM* vm, const HeapSnapshot* snapshot, FILE* out) {
+    AllocationProfile* profile = vm->alloc_profile;
+    if (profile) {
+        for (uint32_t i = 0; i < profile->count; i++) {
+            profile->sites[i].live_objects = 0;
+            profile->sites[i].live_bytes = 0;
+            profile->sites[i].retained_bytes = 0;
+        }
+    }
+    
+    fprintf(out, "orus-heap-snapshot 1\n");
+    fprintf(out, "objects %d\n", snapshot->count);
+    for (int i = 0; i < snapshot->count; i++) {
+        const HeapSnapshotEntry* entry = &snapshot->entries[i];
+        uint16_t site = entry->object->site;
+        fprintf(out, "%d %s %u %zu %zu %d\n", i, object_type_name(entry->object->type),
+                (unsigned)site, entry->size, entry->retained, (int)entry->parent);
+        
+        if (!profile || site >= profile->count) {
+            continue;
+        }
+        AllocationSite* stats = &profile->sites[site];
+        stats->live_objects++;
+        stats->live_bytes += entry->size;
+        // A subtree below an object of the same site is already counted
+        if (entry->parent < 0 || snapshot->entries[entry->parent].object->site != site) {
+            stats->retained_bytes += entry->retained;
+        }
+    }
+    
+    uint32_t site_count = profile ? profile->count : 0;
+    fprintf(out, "sites %u\n", site_count);
+    for (uint32_t i = 0; i < site_count; i++) {
+        const AllocationSite* site = &profile->sites[i];
+        char location[256];
+        format_site_location(vm, site, location, sizeof(location));
+        fprintf(out, "%u %llu %llu %llu %llu %llu %s\n", i,
+                (unsigned long long)site->allocations,
+                (unsigned long long)site->bytes,
+                (unsigned long long)site->live_objects,
+                (unsigned long long)site->live_bytes,
+                (unsigned long long)site->retained_bytes, location);
+    }
+}
+
+bool registervm_heap_snapshot(RegisterVM* vm, FILE* out) {
+    if (!vm || !out || vm->gc_running || isGCPaused()) {
+        return false;
+    }
+    
+    // Snapshots start from a heap with no cycle in progress
+    if (vm->gc_phase != GC_PHASE_IDLE) {
+        registervm_gc_collect(vm);
+    }
+    
+    uint64_t start = gc_pause_begin(vm);
+    vm->gc_running = true;
+    setGCHeap(vm);
+    
+    // Record the mark graph of a full cycle and write it out before the
+    // sweep clears the marks
+    HeapSnapshot snapshot;
+    beginHeapSnapshot(&snapshot);
+    gc_begin_cycle(vm);
+    gc_finish_marking(vm);
+    endHeapSnapshot();
+    write_heap_snapshot(vm, &snapshot, out);
+    sweepHeap(SIZE_MAX);
+    gc_finish_cycle(vm);
+    
+    vm->gc_running = false;
+    gc_pause_end(vm, start);
+    
+    freeHeapSnapshot(&snapshot);
+    return true;
+}
+
 void registervm_debug_print_state(const RegisterVM* vm, bool include_registers) {
     if (!vm) {
         printf("VM: NULL\n");
@@ -814,7 +2850,8 @@ void registervm_debug_print_state(const RegisterVM* vm, bool include_registers)
     printf("IP: %04X\n", vm->ip);
     printf("Flags: %02X\n", vm->flags);
     printf("Running: %s\n", vm->running ? "true" : "false");
-    printf("Call Depth: %d\n", vm->call_depth);
+    printf("Call Depth: %u\n", vm->call_depth);
+    printf("Register Base: %zu\n", vm->register_base);
     printf("Exception Depth: %d\n", vm->exception_depth);
     printf("Has Error: %s\n", vm->has_error ? "true" : "false");
     
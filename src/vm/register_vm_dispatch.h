@@ -0,0 +1,745 @@
+/**
+ * @file register_vm_dispatch.h
+ * @brief Threaded dispatch loop template for the register VM
+ *
+ * Private to register_vm.c, which includes this file once per dispatch
+ * variant. Before each inclusion define:
+ * - DISPATCH_FUNCTION: name of the static function to generate
+ * - DISPATCH_CHECKED:  1 to keep operand bounds and type-tag checks,
+ *                      0 for chunks that passed register_chunk_verify
+ *
+ * Hot opcodes are handled inline and decode only the operands they use;
+ * everything else falls back to execute_instruction. Error state and GC
+ * pacing are only checked after instructions that can change them.
+ *
+ * @author Orus Development Team
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#if !defined(DISPATCH_FUNCTION) || !defined(DISPATCH_CHECKED)
+#error "Define DISPATCH_FUNCTION and DISPATCH_CHECKED before including register_vm_dispatch.h"
+#endif
+
+static ExecutionResult DISPATCH_FUNCTION(RegisterVM* vm) {
+    const uint32_t* code = vm->chunk->code;
+    const uint32_t* code_end = code + vm->chunk->code_count;
+    const uint32_t* ip = code + vm->ip;
+    Value* registers = vm->registers;
+    int64_t* int_lanes = vm->int_lanes;
+    double* float_lanes = vm->float_lanes;
+    uint32_t instruction;
+    ExecutionResult result = EXEC_OK;
+    const char* error_message = NULL;
+
+#if USE_COMPUTED_GOTO
+    // Handled opcodes override the op_slow default set by the range
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+    static void* dispatch_table[256] = {
+        [0 ... 255] = &&op_slow,
+        [ROP_NOP] = &&op_ROP_NOP,
+        [ROP_HALT] = &&op_ROP_HALT,
+        [ROP_JMP] = &&op_ROP_JMP,
+        [ROP_JZ] = &&op_ROP_JZ,
+        [ROP_JNZ] = &&op_ROP_JNZ,
+        [ROP_CALL] = &&op_ROP_CALL,
+        [ROP_RET] = &&op_ROP_RET,
+        [ROP_RET_VAL] = &&op_ROP_RET_VAL,
+        [ROP_MOVE] = &&op_ROP_MOVE,
+        [ROP_LOAD_IMM] = &&op_ROP_LOAD_IMM,
+        [ROP_LOAD_CONST] = &&op_ROP_LOAD_CONST,
+        [ROP_LOAD_GLOBAL] = &&op_ROP_LOAD_GLOBAL,
+        [ROP_STORE_GLOBAL] = &&op_ROP_STORE_GLOBAL,
+        [ROP_ADD_I32] = &&op_ROP_ADD_I32,
+        [ROP_SUB_I32] = &&op_ROP_SUB_I32,
+        [ROP_MUL_I32] = &&op_ROP_MUL_I32,
+        [ROP_ADD_F64] = &&op_ROP_ADD_F64,
+        [ROP_SUB_F64] = &&op_ROP_SUB_F64,
+        [ROP_MUL_F64] = &&op_ROP_MUL_F64,
+        [ROP_EQ_I32] = &&op_ROP_EQ_I32,
+        [ROP_EQ_STR] = &&op_ROP_EQ_STR,
+        [ROP_UNBOX_I64] = &&op_ROP_UNBOX_I64,
+        [ROP_UNBOX_F64] = &&op_ROP_UNBOX_F64,
+        [ROP_BOX_I64] = &&op_ROP_BOX_I64,
+        [ROP_BOX_F64] = &&op_ROP_BOX_F64,
+        [ROP_LANE_ADD_I64] = &&op_ROP_LANE_ADD_I64,
+        [ROP_LANE_SUB_I64] = &&op_ROP_LANE_SUB_I64,
+        [ROP_LANE_MUL_I64] = &&op_ROP_LANE_MUL_I64,
+        [ROP_LANE_ADD_F64] = &&op_ROP_LANE_ADD_F64,
+        [ROP_LANE_SUB_F64] = &&op_ROP_LANE_SUB_F64,
+        [ROP_LANE_MUL_F64] = &&op_ROP_LANE_MUL_F64,
+        [ROP_LANE_DIV_F64] = &&op_ROP_LANE_DIV_F64,
+        [ROP_LANE_LT_I64] = &&op_ROP_LANE_LT_I64,
+        [ROP_GET_FIELD] = &&op_ROP_GET_FIELD,
+        [ROP_SET_FIELD] = &&op_ROP_SET_FIELD,
+        [ROP_GET_INDEX] = &&op_ROP_GET_INDEX,
+        [ROP_SET_INDEX] = &&op_ROP_SET_INDEX,
+        [ROP_LT_I32] = &&op_ROP_LT_I32,
+        [ROP_LT_I32_JZ] = &&op_ROP_LT_I32_JZ,
+        [ROP_LT_I32_JNZ] = &&op_ROP_LT_I32_JNZ,
+        [ROP_EQ_I32_JZ] = &&op_ROP_EQ_I32_JZ,
+        [ROP_EQ_I32_JNZ] = &&op_ROP_EQ_I32_JNZ,
+        [ROP_ADD_I32_JMP] = &&op_ROP_ADD_I32_JMP,
+        [ROP_INC_LT_I32_JNZ] = &&op_ROP_INC_LT_I32_JNZ,
+        [ROP_LOAD_CONST_ADD_I32] = &&op_ROP_LOAD_CONST_ADD_I32,
+        [ROP_LOAD_CONST_ADD_F64] = &&op_ROP_LOAD_CONST_ADD_F64,
+        [ROP_LOAD_CONST_MUL_F64] = &&op_ROP_LOAD_CONST_MUL_F64,
+    };
+#pragma GCC diagnostic pop
+#define VM_CASE(op) op_##op:
+#define VM_DEFAULT op_slow:
+#define VM_DISPATCH()                                   \
+    do {                                                \
+        if (ip >= code_end) goto done;                  \
+        instruction = *ip++;                            \
+        goto *dispatch_table[GET_OPCODE(instruction)];  \
+    } while (0)
+#else
+#define VM_CASE(op) case op:
+#define VM_DEFAULT default:
+#define VM_DISPATCH() continue
+#endif
+
+/** Fail with a runtime error raised by an inline handler */
+#define VM_FAIL(message)                                \
+    do {                                                \
+        error_message = (message);                      \
+        goto runtime_error;                             \
+    } while (0)
+
+#if DISPATCH_CHECKED
+/** Runtime check of a condition the verifier would otherwise have proven */
+#define VM_CHECK(condition, message)                    \
+    do {                                                \
+        if (!(condition)) VM_FAIL(message);             \
+    } while (0)
+
+/** Operand type check; a mismatch aborts without setting an error value */
+#define VM_CHECK_TYPES(is_type, a, b)                   \
+    do {                                                \
+        if (!is_type(a) || !is_type(b)) {               \
+            result = EXEC_ERROR;                        \
+            goto done;                                  \
+        }                                               \
+    } while (0)
+#else
+#define VM_CHECK(condition, message) ((void)0)
+#define VM_CHECK_TYPES(is_type, a, b) ((void)0)
+#endif
+
+/** Register bounds check for operand fields */
+#define VM_CHECK_REG(reg, message) VM_CHECK(check_register_bounds(reg), message)
+
+/** Lane bounds check for operand fields naming an untagged register */
+#define VM_CHECK_LANE(reg, message) VM_CHECK(check_lane_bounds(reg), message)
+
+/** Branch conditions of JZ and JNZ (JNZ also takes any non-bool, non-nil value) */
+#define VM_JZ_TAKEN(v)                                                     \
+    ((IS_BOOL(v) && !AS_BOOL(v)) || (IS_I32(v) && AS_I32(v) == 0) || IS_NIL(v))
+#define VM_JNZ_TAKEN(v)                                                    \
+    ((IS_BOOL(v) && AS_BOOL(v)) || (IS_I32(v) && AS_I32(v) != 0) ||       \
+     (!IS_NIL(v) && !IS_BOOL(v)))
+
+/**
+ * True if the next word is not the expected partner of a superinstruction.
+ * Verified chunks are proven to keep their fused sequences intact; unverified
+ * ones may have been patched, so the handler then runs only its first opcode.
+ */
+#if DISPATCH_CHECKED
+#define VM_PARTNER_MISSING(op) (ip >= code_end || GET_OPCODE(*ip) != (op))
+#else
+#define VM_PARTNER_MISSING(op) 0
+#endif
+
+/** Shared body of the untagged lane arithmetic handlers */
+#define VM_LANE_OP(lanes, expr)                                            \
+    do {                                                                   \
+        uint8_t dst = GET_DST(instruction);                                \
+        uint8_t src1 = GET_SRC1(instruction);                              \
+        uint8_t src2 = GET_SRC2(instruction);                              \
+        VM_CHECK_LANE(dst, "Invalid register for lane arithmetic");        \
+        VM_CHECK_LANE(src1, "Invalid register for lane arithmetic");       \
+        VM_CHECK_LANE(src2, "Invalid register for lane arithmetic");       \
+        lanes[dst] = (expr);                                               \
+    } while (0)
+
+/** Shared body of the inline i32/f64 binary arithmetic handlers */
+#define VM_BINARY_OP(is_type, as_type, make_value, op)                     \
+    do {                                                                   \
+        uint8_t dst = GET_DST(instruction);                                \
+        uint8_t src1 = GET_SRC1(instruction);                              \
+        uint8_t src2 = GET_SRC2(instruction);                              \
+        VM_CHECK_REG(dst, "Invalid register for arithmetic");              \
+        VM_CHECK_REG(src1, "Invalid register for arithmetic");             \
+        VM_CHECK_REG(src2, "Invalid register for arithmetic");             \
+        Value a = registers[src1];                                         \
+        Value b = registers[src2];                                         \
+        VM_CHECK_TYPES(is_type, a, b);                                     \
+        registers[dst] = make_value(as_type(a) op as_type(b));             \
+        update_flags_arithmetic(vm, registers[dst]);                       \
+    } while (0)
+
+    vm->running = true;
+
+#if USE_COMPUTED_GOTO
+    VM_DISPATCH();
+#else
+    for (;;) {
+        if (ip >= code_end) goto done;
+        instruction = *ip++;
+        switch ((RegisterOpcode)GET_OPCODE(instruction)) {
+#endif
+
+    VM_CASE(ROP_NOP)
+        VM_DISPATCH();
+
+    VM_CASE(ROP_HALT)
+        goto done;
+
+    VM_CASE(ROP_JMP) {
+        uint16_t target = GET_IMM(instruction);
+        VM_CHECK(target < vm->chunk->code_count, "Jump target out of bounds");
+        ip = code + target;
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_JZ) {
+        uint8_t src = GET_DST(instruction);
+        VM_CHECK_REG(src, "Invalid register for conditional jump");
+        Value condition = registers[src];
+        if (VM_JZ_TAKEN(condition)) {
+            ip = code + GET_IMM(instruction);
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_JNZ) {
+        uint8_t src = GET_DST(instruction);
+        VM_CHECK_REG(src, "Invalid register for conditional jump");
+        Value condition = registers[src];
+        if (VM_JNZ_TAKEN(condition)) {
+            ip = code + GET_IMM(instruction);
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_CALL) {
+        // Slide the window to the call register; arguments stay where they are
+        uint8_t window = GET_DST(instruction);
+        uint16_t target = GET_IMM(instruction);
+        VM_CHECK_REG(window, "Invalid register for call");
+        VM_CHECK(target < vm->chunk->code_count, "Call target out of bounds");
+        vm->ip = (uint32_t)(ip - code);
+        if (!setup_call_frame(vm, target, window)) {
+            result = EXEC_STACK_OVERFLOW;
+            goto exit;
+        }
+        ip = code + vm->ip;
+        registers = vm->registers;
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_RET_VAL) {
+        uint8_t src = GET_DST(instruction);
+        VM_CHECK_REG(src, "Invalid register for return");
+        registers[0] = registers[src];
+        goto return_to_caller;
+    }
+
+    VM_CASE(ROP_RET) {
+        registers[0] = NIL_VAL;
+    return_to_caller:
+        if (vm->call_depth == 0) {
+            goto done;
+        }
+        cleanup_call_frame(vm);
+        ip = code + vm->ip;
+        registers = vm->registers;
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_MOVE) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        VM_CHECK_REG(dst, "Invalid register for move");
+        VM_CHECK_REG(src1, "Invalid register for move");
+        registers[dst] = registers[src1];
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_LOAD_IMM) {
+        uint8_t dst = GET_DST(instruction);
+        VM_CHECK_REG(dst, "Invalid destination register");
+        registers[dst] = I32_VAL((int32_t)GET_IMM(instruction));
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_LOAD_CONST) {
+        uint8_t dst = GET_DST(instruction);
+        uint16_t index = GET_IMM(instruction);
+        VM_CHECK_REG(dst, "Invalid destination register");
+        VM_CHECK(index < vm->chunk->constant_count, "Constant index out of bounds");
+        registers[dst] = vm->chunk->constants[index];
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_LOAD_GLOBAL) {
+        uint8_t dst = GET_DST(instruction);
+        uint16_t index = GET_IMM(instruction);
+        VM_CHECK_REG(dst, "Invalid destination register");
+        VM_CHECK(index < vm->chunk->global_count, "Global variable index out of bounds");
+        registers[dst] = vm->chunk->globals[index];
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_STORE_GLOBAL) {
+        uint8_t src = GET_DST(instruction);
+        uint16_t index = GET_IMM(instruction);
+        VM_CHECK_REG(src, "Invalid source register");
+        VM_CHECK(index < vm->chunk->global_count, "Global variable index out of bounds");
+        vm->chunk->globals[index] = registers[src];
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_ADD_I32)
+        VM_BINARY_OP(IS_I32, AS_I32, I32_VAL, +);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_SUB_I32)
+        VM_BINARY_OP(IS_I32, AS_I32, I32_VAL, -);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_MUL_I32)
+        VM_BINARY_OP(IS_I32, AS_I32, I32_VAL, *);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_ADD_F64)
+        VM_BINARY_OP(IS_F64, AS_F64, F64_VAL, +);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_SUB_F64)
+        VM_BINARY_OP(IS_F64, AS_F64, F64_VAL, -);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_MUL_F64)
+        VM_BINARY_OP(IS_F64, AS_F64, F64_VAL, *);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_EQ_I32) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_REG(dst, "Invalid register for equality");
+        VM_CHECK_REG(src1, "Invalid register for equality");
+        VM_CHECK_REG(src2, "Invalid register for equality");
+        registers[dst] = BOOL_VAL(valuesEqual(registers[src1], registers[src2]));
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_EQ_STR) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_REG(dst, "Invalid register for equality");
+        VM_CHECK_REG(src1, "Invalid register for equality");
+        VM_CHECK_REG(src2, "Invalid register for equality");
+        Value a = registers[src1];
+        Value b = registers[src2];
+        if (IS_STRING(a) && IS_STRING(b) &&
+            (AS_STRING(a) == AS_STRING(b) ||
+             (AS_STRING(a)->interned && AS_STRING(b)->interned))) {
+            registers[dst] = BOOL_VAL(AS_STRING(a) == AS_STRING(b));
+        } else {
+            registers[dst] = BOOL_VAL(valuesEqual(a, b));
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_LT_I32) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_REG(dst, "Invalid register for comparison");
+        VM_CHECK_REG(src1, "Invalid register for comparison");
+        VM_CHECK_REG(src2, "Invalid register for comparison");
+        Value a = registers[src1];
+        Value b = registers[src2];
+        if (!IS_I32(a) || !IS_I32(b)) {
+            goto slow_path; // Reports the type error
+        }
+        registers[dst] = BOOL_VAL(AS_I32(a) < AS_I32(b));
+        VM_DISPATCH();
+    }
+
+    // -------------------------------------------------------------------------
+    // Superinstructions: run the first opcode, then the partner words inline.
+    // If a partner cannot take the fast path, ip is left pointing at it and
+    // the regular handler runs it on the next dispatch.
+    // -------------------------------------------------------------------------
+
+    VM_CASE(ROP_LT_I32_JZ)
+    VM_CASE(ROP_LT_I32_JNZ)
+    VM_CASE(ROP_EQ_I32_JZ)
+    VM_CASE(ROP_EQ_I32_JNZ) {
+        uint8_t opcode = GET_OPCODE(instruction);
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_REG(dst, "Invalid register for comparison");
+        VM_CHECK_REG(src1, "Invalid register for comparison");
+        VM_CHECK_REG(src2, "Invalid register for comparison");
+        Value a = registers[src1];
+        Value b = registers[src2];
+        bool is_lt = opcode == ROP_LT_I32_JZ || opcode == ROP_LT_I32_JNZ;
+        if (IS_I32(a) && IS_I32(b)) {
+            registers[dst] = BOOL_VAL(is_lt ? AS_I32(a) < AS_I32(b) : AS_I32(a) == AS_I32(b));
+        } else if (!is_lt) {
+            registers[dst] = BOOL_VAL(valuesEqual(a, b));
+        } else {
+            goto slow_path;
+        }
+        
+        bool is_jz = opcode == ROP_LT_I32_JZ || opcode == ROP_EQ_I32_JZ;
+        if (VM_PARTNER_MISSING(is_jz ? ROP_JZ : ROP_JNZ)) {
+            VM_DISPATCH();
+        }
+        uint32_t branch = *ip;
+        uint8_t condition_reg = GET_DST(branch);
+        VM_CHECK_REG(condition_reg, "Invalid register for conditional jump");
+        Value condition = registers[condition_reg];
+        bool taken = is_jz ? VM_JZ_TAKEN(condition) : VM_JNZ_TAKEN(condition);
+        ip = taken ? code + GET_IMM(branch) : ip + 1;
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_ADD_I32_JMP) {
+        VM_BINARY_OP(IS_I32, AS_I32, I32_VAL, +);
+        if (VM_PARTNER_MISSING(ROP_JMP)) {
+            VM_DISPATCH();
+        }
+        uint16_t target = GET_IMM(*ip);
+        VM_CHECK(target < vm->chunk->code_count, "Jump target out of bounds");
+        ip = code + target;
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_INC_LT_I32_JNZ) {
+        VM_BINARY_OP(IS_I32, AS_I32, I32_VAL, +);
+        if (VM_PARTNER_MISSING(ROP_LT_I32)) {
+            VM_DISPATCH();
+        }
+        
+        uint32_t compare = *ip;
+        uint8_t dst = GET_DST(compare);
+        uint8_t src1 = GET_SRC1(compare);
+        uint8_t src2 = GET_SRC2(compare);
+        VM_CHECK_REG(dst, "Invalid register for comparison");
+        VM_CHECK_REG(src1, "Invalid register for comparison");
+        VM_CHECK_REG(src2, "Invalid register for comparison");
+        Value a = registers[src1];
+        Value b = registers[src2];
+        if (!IS_I32(a) || !IS_I32(b)) {
+            VM_DISPATCH(); // LT_I32 handler reports the type error
+        }
+        registers[dst] = BOOL_VAL(AS_I32(a) < AS_I32(b));
+        ip++;
+        
+        if (VM_PARTNER_MISSING(ROP_JNZ)) {
+            VM_DISPATCH();
+        }
+        uint32_t branch = *ip;
+        uint8_t condition_reg = GET_DST(branch);
+        VM_CHECK_REG(condition_reg, "Invalid register for conditional jump");
+        Value condition = registers[condition_reg];
+        ip = VM_JNZ_TAKEN(condition) ? code + GET_IMM(branch) : ip + 1;
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_LOAD_CONST_ADD_I32)
+    VM_CASE(ROP_LOAD_CONST_ADD_F64)
+    VM_CASE(ROP_LOAD_CONST_MUL_F64) {
+        uint8_t opcode = GET_OPCODE(instruction);
+        uint8_t dst = GET_DST(instruction);
+        uint16_t index = GET_IMM(instruction);
+        VM_CHECK_REG(dst, "Invalid destination register");
+        VM_CHECK(index < vm->chunk->constant_count, "Constant index out of bounds");
+        registers[dst] = vm->chunk->constants[index];
+        
+        RegisterOpcode partner = opcode == ROP_LOAD_CONST_ADD_I32 ? ROP_ADD_I32 :
+                                 opcode == ROP_LOAD_CONST_ADD_F64 ? ROP_ADD_F64 : ROP_MUL_F64;
+        if (VM_PARTNER_MISSING(partner)) {
+            VM_DISPATCH();
+        }
+        instruction = *ip++;
+        if (partner == ROP_ADD_I32) {
+            VM_BINARY_OP(IS_I32, AS_I32, I32_VAL, +);
+        } else if (partner == ROP_ADD_F64) {
+            VM_BINARY_OP(IS_F64, AS_F64, F64_VAL, +);
+        } else {
+            VM_BINARY_OP(IS_F64, AS_F64, F64_VAL, *);
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_UNBOX_I64) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        VM_CHECK_LANE(dst, "Invalid register for unbox");
+        VM_CHECK_REG(src1, "Invalid register for unbox");
+        Value value = registers[src1];
+        if (IS_I64(value)) {
+            int_lanes[dst] = AS_I64(value);
+        } else if (IS_I32(value)) {
+            int_lanes[dst] = AS_I32(value);
+        } else {
+            goto slow_path; // Reports the type error
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_UNBOX_F64) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        VM_CHECK_LANE(dst, "Invalid register for unbox");
+        VM_CHECK_REG(src1, "Invalid register for unbox");
+        Value value = registers[src1];
+        if (IS_F64(value)) {
+            float_lanes[dst] = AS_F64(value);
+        } else if (IS_I32(value)) {
+            float_lanes[dst] = AS_I32(value);
+        } else {
+            goto slow_path;
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_BOX_I64) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        VM_CHECK_REG(dst, "Invalid register for box");
+        VM_CHECK_LANE(src1, "Invalid register for box");
+        registers[dst] = I64_VAL(int_lanes[src1]);
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_BOX_F64) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        VM_CHECK_REG(dst, "Invalid register for box");
+        VM_CHECK_LANE(src1, "Invalid register for box");
+        registers[dst] = F64_VAL(float_lanes[src1]);
+        VM_DISPATCH();
+    }
+
+    // Integer lanes wrap on overflow like the hardware they model
+    VM_CASE(ROP_LANE_ADD_I64)
+        VM_LANE_OP(int_lanes, (int64_t)((uint64_t)int_lanes[src1] + (uint64_t)int_lanes[src2]));
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_SUB_I64)
+        VM_LANE_OP(int_lanes, (int64_t)((uint64_t)int_lanes[src1] - (uint64_t)int_lanes[src2]));
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_MUL_I64)
+        VM_LANE_OP(int_lanes, (int64_t)((uint64_t)int_lanes[src1] * (uint64_t)int_lanes[src2]));
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_ADD_F64)
+        VM_LANE_OP(float_lanes, float_lanes[src1] + float_lanes[src2]);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_SUB_F64)
+        VM_LANE_OP(float_lanes, float_lanes[src1] - float_lanes[src2]);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_MUL_F64)
+        VM_LANE_OP(float_lanes, float_lanes[src1] * float_lanes[src2]);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_DIV_F64)
+        VM_LANE_OP(float_lanes, float_lanes[src1] / float_lanes[src2]);
+        VM_DISPATCH();
+
+    VM_CASE(ROP_LANE_LT_I64) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_LANE(dst, "Invalid register for lane arithmetic");
+        VM_CHECK_LANE(src1, "Invalid register for lane arithmetic");
+        VM_CHECK_LANE(src2, "Invalid register for lane arithmetic");
+        registers[dst] = BOOL_VAL(int_lanes[src1] < int_lanes[src2]);
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_GET_FIELD) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t field = GET_SRC2(instruction);
+        VM_CHECK_REG(dst, "Invalid register for field access");
+        VM_CHECK_REG(src1, "Invalid register for field access");
+        VM_CHECK(field < vm->chunk->field_name_count, "Invalid field name");
+        Value object = registers[src1];
+        int slot = resolve_field_slot(vm, (uint32_t)(ip - 1 - code), object, field);
+        if (slot < 0 || slot >= AS_ARRAY(object)->length) {
+            goto slow_path; // Reports the missing field
+        }
+        registers[dst] = AS_ARRAY(object)->elements[slot];
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_SET_FIELD) {
+        uint8_t src = GET_DST(instruction);
+        uint8_t field = GET_SRC1(instruction);
+        uint8_t value = GET_SRC2(instruction);
+        VM_CHECK_REG(src, "Invalid register for field access");
+        VM_CHECK_REG(value, "Invalid register for field access");
+        VM_CHECK(field < vm->chunk->field_name_count, "Invalid field name");
+        Value object = registers[src];
+        int slot = resolve_field_slot(vm, (uint32_t)(ip - 1 - code), object, field);
+        if (slot < 0 || slot >= AS_ARRAY(object)->length) {
+            goto slow_path; // Reports the missing field
+        }
+        AS_ARRAY(object)->elements[slot] = registers[value];
+        WRITE_BARRIER(&AS_ARRAY(object)->obj, registers[value]);
+        VM_DISPATCH();
+    }
+
+    // Element access on every array kind. Indexes other than an in-range
+    // i32, and stores that would convert a packed array, take the generic
+    // handler.
+    VM_CASE(ROP_GET_INDEX) {
+        uint8_t dst = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_REG(dst, "Invalid register for array access");
+        VM_CHECK_REG(src1, "Invalid register for array access");
+        VM_CHECK_REG(src2, "Invalid register for array access");
+        Value object = registers[src1];
+        Value index = registers[src2];
+        if (!IS_ARRAY(object) || !IS_I32(index) ||
+            (uint32_t)AS_I32(index) >= (uint32_t)AS_ARRAY(object)->length) {
+            goto slow_path; // Reports the error
+        }
+        ObjArray* array = AS_ARRAY(object);
+        int32_t i = AS_I32(index);
+        switch ((ArrayKind)array->kind) {
+            case ARRAY_VALUES: registers[dst] = array->elements[i]; break;
+            case ARRAY_I32: registers[dst] = I32_VAL(ARRAY_DATA(array, int32_t)[i]); break;
+            case ARRAY_I64: registers[dst] = I64_VAL(ARRAY_DATA(array, int64_t)[i]); break;
+            case ARRAY_U32: registers[dst] = U32_VAL(ARRAY_DATA(array, uint32_t)[i]); break;
+            case ARRAY_U64: registers[dst] = U64_VAL(ARRAY_DATA(array, uint64_t)[i]); break;
+            case ARRAY_F64: registers[dst] = F64_VAL(ARRAY_DATA(array, double)[i]); break;
+            case ARRAY_BOOL: registers[dst] = BOOL_VAL(ARRAY_DATA(array, uint8_t)[i] != 0); break;
+            case ARRAY_PACKED: goto slow_path; // Empty, so never in range
+        }
+        VM_DISPATCH();
+    }
+
+    VM_CASE(ROP_SET_INDEX) {
+        uint8_t src = GET_DST(instruction);
+        uint8_t src1 = GET_SRC1(instruction);
+        uint8_t src2 = GET_SRC2(instruction);
+        VM_CHECK_REG(src, "Invalid register for array access");
+        VM_CHECK_REG(src1, "Invalid register for array access");
+        VM_CHECK_REG(src2, "Invalid register for array access");
+        Value object = registers[src];
+        Value index = registers[src1];
+        Value value = registers[src2];
+        if (!IS_ARRAY(object) || !IS_I32(index) ||
+            (uint32_t)AS_I32(index) >= (uint32_t)AS_ARRAY(object)->length) {
+            goto slow_path; // Reports the error
+        }
+        ObjArray* array = AS_ARRAY(object);
+        int32_t i = AS_I32(index);
+        bool stored = true;
+        switch ((ArrayKind)array->kind) {
+            case ARRAY_VALUES:
+                array->elements[i] = value;
+                WRITE_BARRIER(&array->obj, value);
+                break;
+            case ARRAY_I32:
+                if ((stored = IS_I32(value))) ARRAY_DATA(array, int32_t)[i] = AS_I32(value);
+                break;
+            case ARRAY_I64:
+                if ((stored = IS_I64(value))) ARRAY_DATA(array, int64_t)[i] = AS_I64(value);
+                break;
+            case ARRAY_U32:
+                if ((stored = IS_U32(value))) ARRAY_DATA(array, uint32_t)[i] = AS_U32(value);
+                break;
+            case ARRAY_U64:
+                if ((stored = IS_U64(value))) ARRAY_DATA(array, uint64_t)[i] = AS_U64(value);
+                break;
+            case ARRAY_F64:
+                if ((stored = IS_F64(value))) ARRAY_DATA(array, double)[i] = AS_F64(value);
+                break;
+            case ARRAY_BOOL:
+                if ((stored = IS_BOOL(value))) ARRAY_DATA(array, uint8_t)[i] = AS_BOOL(value);
+                break;
+            case ARRAY_PACKED:
+                stored = false;
+                break;
+        }
+        if (!stored) {
+            goto slow_path; // Converts the array to Values
+        }
+        VM_DISPATCH();
+    }
+
+    VM_DEFAULT {
+    slow_path:
+        // Cold opcodes share the generic handler; it advances vm->ip itself
+        vm->ip = (uint32_t)(ip - 1 - code);
+        result = execute_instruction(vm, instruction);
+        if (result != EXEC_OK || !vm->running) {
+            goto exit;
+        }
+        ip = code + vm->ip;
+        registers = vm->registers;
+
+        // Only the generic handler allocates, so GC pacing is checked here
+        if (vm->bytes_allocated > vm->next_gc && !vm->gc_running) {
+            registervm_gc_step(vm);
+        }
+        VM_DISPATCH();
+    }
+
+#if !USE_COMPUTED_GOTO
+        }
+    }
+#endif
+
+#if DISPATCH_CHECKED
+runtime_error:
+    vm->ip = (uint32_t)(ip - code);
+    registervm_set_error(vm, ERROR_VAL(allocateError(ERROR_RUNTIME,
+        error_message, (SrcLocation){0, 0, 0})));
+    vm->running = false;
+    return EXEC_ERROR;
+#else
+    (void)error_message;
+#endif
+
+done:
+    vm->ip = (uint32_t)(ip - code);
+exit:
+    vm->running = false;
+    return result;
+
+#undef VM_CASE
+#undef VM_DEFAULT
+#undef VM_DISPATCH
+#undef VM_FAIL
+#undef VM_CHECK
+#undef VM_CHECK_TYPES
+#undef VM_CHECK_REG
+#undef VM_CHECK_LANE
+#undef VM_JZ_TAKEN
+#undef VM_JNZ_TAKEN
+#undef VM_PARTNER_MISSING
+#undef VM_LANE_OP
+#undef VM_BINARY_OP
+}
+
+#undef DISPATCH_FUNCTION
+#undef DISPATCH_CHECKED
@@ -16,7 +16,7 @@
  * @param value Value to display.
  */
 void printValue(Value value) {
-    switch (value.type) {
+    switch (VALUE_TYPE(value)) {
         case VAL_I32:
             printf("%d", AS_I32(value));
             break;
@@ -41,13 +41,19 @@ void printValue(Value value) {
         case VAL_STRING:
             printf("%s", AS_STRING(value)->chars);
             break;
+        case VAL_STRING_BUILDER:
+            printf("%s", AS_STRING_BUILDER(value)->chars);
+            break;
         case VAL_ARRAY: {
             printf("[");
             ObjArray* arr = AS_ARRAY(value);
+            // Boxing a packed element may allocate; keep `arr` in place
+            pauseGC();
             for (int i = 0; i < arr->length; i++) {
-                printValue(arr->elements[i]);
+                printValue(arrayGet(arr, i));
                 if (i < arr->length - 1) printf(", ");
             }
+            resumeGC();
             printf("]");
             break;
         }
@@ -89,6 +95,37 @@ void printValue(Value value) {
     }
 }
 
+/**
+ * Compare two arrays element by element. Arrays packed the same way are
+ * compared without boxing their elements.
+ *
+ * @param x First array.
+ * @param y Second array.
+ * @return  True if the arrays hold equal elements.
+ */
+static bool arraysEqual(ObjArray* x, ObjArray* y) {
+    if (x->length != y->length) return false;
+    if (x->kind == y->kind && x->kind == ARRAY_F64) {
+        for (int i = 0; i < x->length; i++) {
+            if (ARRAY_DATA(x, double)[i] != ARRAY_DATA(y, double)[i]) return false;
+        }
+        return true;
+    }
+    if (x->kind == y->kind && x->kind != ARRAY_VALUES) {
+        return memcmp(x->elements, y->elements,
+                      arrayElementSize((ArrayKind)x->kind) * (size_t)x->length) == 0;
+    }
+
+    // Boxing a packed element may allocate; keep both arrays in place
+    bool equal = true;
+    pauseGC();
+    for (int i = 0; i < x->length && equal; i++) {
+        equal = valuesEqual(arrayGet(x, i), arrayGet(y, i));
+    }
+    resumeGC();
+    return equal;
+}
+
 /**
  * Determine whether two runtime values are equal.
  *
@@ -97,30 +134,32 @@ void printValue(Value value) {
  * @return  True if values are equal.
  */
 bool valuesEqual(Value a, Value b) {
-    if (a.type != b.type) return false;
+    ValueType type = VALUE_TYPE(a);
+    if (type != VALUE_TYPE(b)) return false;
     
-    switch (a.type) {
-        case VAL_I32: return a.as.i32 == b.as.i32;
-        case VAL_I64: return a.as.i64 == b.as.i64;
-        case VAL_U32: return a.as.u32 == b.as.u32;
-        case VAL_U64: return a.as.u64 == b.as.u64;
-        case VAL_F64: return a.as.f64 == b.as.f64;
-        case VAL_BOOL: return a.as.boolean == b.as.boolean;
+    switch (type) {
+        case VAL_I32: return AS_I32(a) == AS_I32(b);
+        case VAL_I64: return AS_I64(a) == AS_I64(b);
+        case VAL_U32: return AS_U32(a) == AS_U32(b);
+        case VAL_U64: return AS_U64(a) == AS_U64(b);
+        case VAL_F64: return AS_F64(a) == AS_F64(b);
+        case VAL_BOOL: return AS_BOOL(a) == AS_BOOL(b);
         case VAL_NIL: return true;
-        case VAL_STRING:
-            return a.as.string->length == b.as.string->length &&
-                   memcmp(a.as.string->chars, b.as.string->chars, a.as.string->length) == 0;
-        case VAL_ARRAY: {
-            if (a.as.array->length != b.as.array->length) return false;
-            for (int i = 0; i < a.as.array->length; i++) {
-                if (!valuesEqual(a.as.array->elements[i], b.as.array->elements[i])) return false;
-            }
-            return true;
+        case VAL_STRING: {
+            ObjString* x = AS_STRING(a);
+            ObjString* y = AS_STRING(b);
+            if (x == y) return true;
+            // Two interned strings are equal only if they are the same object
+            if (x->interned && y->interned) return false;
+            return x->length == y->length && x->hash == y->hash &&
+                   memcmp(x->chars, y->chars, x->length) == 0;
         }
+        case VAL_ARRAY:
+            return arraysEqual(AS_ARRAY(a), AS_ARRAY(b));
         case VAL_ERROR:
-            return a.as.error == b.as.error;
+            return AS_ERROR(a) == AS_ERROR(b);
         case VAL_RANGE_ITERATOR:
-            return a.as.rangeIter == b.as.rangeIter;
+            return AS_RANGE_ITERATOR(a) == AS_RANGE_ITERATOR(b);
         default: return false;
     }
 }
@@ -0,0 +1,150 @@
+/**
+ * @file vm.c
+ * @brief Process-wide compiler and driver state.
+ *
+ * The compiler resolves globals and natives against the tables in `vm`;
+ * programs themselves run on a RegisterVM.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/vm.h"
+#include "../../include/builtins.h"
+#include "../../include/error.h"
+#include "../../include/memory.h"
+
+VM vm;
+
+Type* variableTypes[UINT8_COUNT];
+
+// Error raised by the native currently running, NIL_VAL if none
+static Value nativeError;
+
+/**
+ * Reset the global tables, set up the type system and register the builtin
+ * natives.
+ * ORUS_PATH selects the standard library directory and ORUS_CACHE_PATH
+ * enables the module cache.
+ */
+void initVM(void) {
+    memset(&vm, 0, sizeof(VM));
+    memset(variableTypes, 0, sizeof(variableTypes));
+    for (int i = 0; i < UINT8_COUNT; i++) {
+        vm.globals[i] = NIL_VAL;
+    }
+    nativeError = NIL_VAL;
+
+    const char* stdPath = getenv("ORUS_PATH");
+    vm.stdPath = stdPath && stdPath[0] != '\0' ? stdPath : NULL;
+    const char* cachePath = getenv("ORUS_CACHE_PATH");
+    vm.cachePath = cachePath && cachePath[0] != '\0' ? cachePath : NULL;
+
+    initTypeSystem();
+    initBuiltins();
+}
+
+/**
+ * Release the global tables. Names and constants are permanent objects and
+ * stay allocated.
+ */
+void freeVM(void) {
+    memset(&vm, 0, sizeof(VM));
+    memset(variableTypes, 0, sizeof(variableTypes));
+    nativeError = NIL_VAL;
+}
+
+/**
+ * Register a native function.
+ *
+ * @param name       Name the program calls it by.
+ * @param function   Implementation.
+ * @param arity      Number of arguments, -1 for variadic.
+ * @param returnType Result type, NULL when it depends on the arguments.
+ */
+void defineNative(const char* name, NativeFn function, int arity, Type* returnType) {
+    if (vm.nativeFunctionCount >= UINT8_COUNT) {
+        fprintf(stderr, "Too many native functions.\n");
+        exit(1);
+    }
+    NativeFunction* native = &vm.nativeFunctions[vm.nativeFunctionCount++];
+    native->name = allocateString(name, (int)strlen(name));
+    native->arity = arity;
+    native->function = function;
+    native->returnType = returnType;
+}
+
+/**
+ * Look up a native function by name.
+ *
+ * @param name Name to look for.
+ * @return     Index into vm.nativeFunctions, or -1.
+ */
+int findNative(ObjString* name) {
+    for (int i = 0; i < vm.nativeFunctionCount; i++) {
+        ObjString* candidate = vm.nativeFunctions[i].name;
+        if (candidate->length == name->length &&
+            memcmp(candidate->chars, name->chars, (size_t)name->length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Record a runtime error raised by a native function. Only the first error
+ * of a call is kept.
+ *
+ * @param format printf-style message.
+ */
+void vmRuntimeError(const char* format, ...) {
+    if (!IS_NIL(nativeError)) return;
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    nativeError = ERROR_VAL(allocateError(ERROR_RUNTIME, message, (SrcLocation){NULL, 0, 0}));
+}
+
+/**
+ * Take the error raised by the last native call.
+ *
+ * @return The error value, or NIL_VAL.
+ */
+Value takeNativeError(void) {
+    Value error = nativeError;
+    nativeError = NIL_VAL;
+    return error;
+}
+
+/**
+ * Call a native function for ROP_CALL_STATIC.
+ *
+ * @param index    Index into vm.nativeFunctions.
+ * @param argCount Number of arguments.
+ * @param args     Argument values.
+ * @param result   Receives the return value, or the error on failure.
+ * @return         True if the native returned without an error.
+ */
+bool callNative(int index, int argCount, Value* args, Value* result) {
+    const char* message = NULL;
+    if (index >= vm.nativeFunctionCount) {
+        message = "Unknown native function";
+    } else if (vm.nativeFunctions[index].arity >= 0 &&
+               vm.nativeFunctions[index].arity != argCount) {
+        message = "Wrong number of arguments to native function";
+    }
+    if (message) {
+        *result = ERROR_VAL(allocateError(ERROR_RUNTIME, message, (SrcLocation){NULL, 0, 0}));
+        return false;
+    }
+
+    nativeError = NIL_VAL;
+    Value value = vm.nativeFunctions[index].function(argCount, args);
+    Value error = takeNativeError();
+    *result = IS_NIL(error) ? value : error;
+    return IS_NIL(error);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file test.h
+ * @brief Minimal assertion helpers shared by the C test programs
+ *
+ * Each tests/test_*.c file is a standalone program built and run by
+ * `make test`. A failed CHECK reports its location and the test keeps
+ * going; the program exits non-zero if any check failed.
+ */
+
+#ifndef ORUS_TEST_H
+#define ORUS_TEST_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+static int test_checks = 0;
+
+#define CHECK(condition)                                                    \
+    do {                                                                    \
+        test_checks++;                                                      \
+        if (!(condition)) {                                                 \
+            test_failures++;                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                    \
+                    __FILE__, __LINE__, #condition);                        \
+        }                                                                   \
+    } while (0)
+
+#define RUN_TEST(test)                                                      \
+    do {                                                                    \
+        int failures_before = test_failures;                                \
+        test();                                                             \
+        printf("%s %s\n", test_failures == failures_before ? "ok  " : "FAIL", \
+               #test);                                                      \
+    } while (0)
+
+// Print a summary line and return the program's exit status
+static inline int test_summary(const char* name) {
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+    return test_failures == 0 ? 0 : 1;
+}
+
+#endif
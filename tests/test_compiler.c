@@ -0,0 +1,258 @@
+/**
+ * @file test_compiler.c
+ * @brief Tests for register code generated from Orus source
+ *
+ * Each program stores what it computes in a global, which is read back
+ * from the chunk after it runs at every optimization level.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/compiler.h"
+#include "../include/memory.h"
+#include "../include/parser.h"
+#include "../include/register_chunk.h"
+#include "../include/register_vm.h"
+#include "../include/value.h"
+#include "../include/vm.h"
+#include "test.h"
+
+// Compile and run `source`, returning the final value of global `name`,
+// or NIL_VAL if the program fails
+static Value run_program(const char* source, uint32_t level, const char* name) {
+    initVM();
+    beginCompileArena();
+    Value result = NIL_VAL;
+    ASTNode* ast;
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    vm.filePath = "test";
+    vm.astRoot = NULL;
+    if (parse(source, "test", &ast)) {
+        vm.astRoot = ast;
+    }
+    bool compiled = vm.astRoot && compileToRegister(ast, &chunk, "test", source, true) &&
+                    register_chunk_optimize(&chunk, level);
+    vm.astRoot = NULL;
+    endCompileArena();
+
+    RegisterVM program;
+    if (compiled && registervm_init(&program, &chunk)) {
+        if (registervm_execute(&program) == EXEC_OK) {
+            for (int i = 0; i < vm.variableCount && i < chunk.global_count; i++) {
+                ObjString* global = vm.variableNames[i].name;
+                if (global && strcmp(global->chars, name) == 0) {
+                    result = chunk.globals[i];
+                }
+            }
+        }
+        registervm_free(&program);
+    }
+    register_chunk_free(&chunk);
+    freeVM();
+    return result;
+}
+
+static void lanes_survive_calls_in_operands(void) {
+    // f() uses lane arithmetic itself, in the middle of the caller's chain
+    const char* source =
+        "static mut RESULT: i64 = 0\n"
+        "static mut SCALED: f64 = 0.0\n"
+        "fn f(c: i64) -> i64 {\n"
+        "    return c * (2 as i64) + (1 as i64)\n"
+        "}\n"
+        "fn g(c: f64) -> f64 {\n"
+        "    return c * 2.0 - 1.0\n"
+        "}\n"
+        "fn main() {\n"
+        "    let a: i64 = 6\n"
+        "    let b: i64 = 7\n"
+        "    let c: i64 = 10\n"
+        "    RESULT = a * b + f(c) - f(a) * b\n"
+        "    let x = 1.5\n"
+        "    let y = 4.0\n"
+        "    SCALED = x * y + g(y) / 2.0\n"
+        "}\n";
+    for (uint32_t level = 0; level <= 3; level++) {
+        Value result = run_program(source, level, "RESULT");
+        CHECK(IS_I64(result) && AS_I64(result) == 42 + 21 - 13 * 7);
+        Value scaled = run_program(source, level, "SCALED");
+        CHECK(IS_F64(scaled) && AS_F64(scaled) == 6.0 + 3.5);
+    }
+}
+
+static void unsigned_and_generic_arithmetic(void) {
+    const char* source =
+        "static mut NARROW: u32 = 0u\n"
+        "static mut WIDE: u64 = 0u\n"
+        "static mut GENERIC: i64 = 0\n"
+        "static mut GENERIC_F: f64 = 0.0\n"
+        "fn distance<T: Numeric>(a: T, b: T) -> T {\n"
+        "    let d = a - b\n"
+        "    if d < a - a {\n"
+        "        return -d\n"
+        "    }\n"
+        "    return d\n"
+        "}\n"
+        "fn main() {\n"
+        "    let a: u32 = 10u\n"
+        "    NARROW = (a - 3u) * (a / 3u) + a % 4u\n"
+        "    let b: u64 = 100u\n"
+        "    let c: u64 = 7u\n"
+        "    WIDE = c - b + b / c + b % c\n"
+        "    GENERIC = distance(3 as i64, 10 as i64)\n"
+        "    GENERIC_F = distance(1.5, 0.5)\n"
+        "}\n";
+    for (uint32_t level = 0; level <= 3; level++) {
+        Value narrow = run_program(source, level, "NARROW");
+        CHECK(IS_U32(narrow) && AS_U32(narrow) == 7 * 3 + 2);
+        Value wide = run_program(source, level, "WIDE");
+        CHECK(IS_U64(wide) && AS_U64(wide) == (uint64_t)7 - 100 + 14 + 2);
+        Value generic = run_program(source, level, "GENERIC");
+        CHECK(IS_I64(generic) && AS_I64(generic) == 7);
+        Value generic_f = run_program(source, level, "GENERIC_F");
+        CHECK(IS_F64(generic_f) && AS_F64(generic_f) == 1.0);
+    }
+}
+
+static void catch_variable_holds_the_message(void) {
+    const char* source =
+        "static mut CAUGHT: string = \"\"\n"
+        "fn divide(a: i32, b: i32) -> i32 {\n"
+        "    return a / b\n"
+        "}\n"
+        "fn main() {\n"
+        "    try {\n"
+        "        divide(1, 0)\n"
+        "    } catch err {\n"
+        "        CAUGHT = err + \"!\"\n"
+        "    }\n"
+        "}\n";
+    for (uint32_t level = 0; level <= 3; level++) {
+        Value caught = run_program(source, level, "CAUGHT");
+        CHECK(IS_STRING(caught) && strcmp(AS_STRING(caught)->chars, "Division by zero!") == 0);
+    }
+}
+
+static void overflow_locals_fall_back_to_globals(void) {
+    // Forty locals live at once, more than the register file holds
+    char source[4096];
+    int length = snprintf(source, sizeof(source),
+                          "static mut RESULT: i32 = 0\nfn big(x: i32) -> i32 {\n");
+    for (int i = 0; i < 40; i++) {
+        length += snprintf(source + length, sizeof(source) - length,
+                           "    let a%d = x + %d\n", i, i);
+    }
+    length += snprintf(source + length, sizeof(source) - length, "    let mut s = 0\n");
+    for (int i = 0; i < 40; i++) {
+        length += snprintf(source + length, sizeof(source) - length,
+                           "    s = s + a%d * a%d\n", i, 39 - i);
+    }
+    snprintf(source + length, sizeof(source) - length,
+             "    return s\n}\nfn main() {\n    RESULT = big(1)\n}\n");
+
+    int expected = 0;
+    for (int i = 0; i < 40; i++) {
+        expected += (1 + i) * (40 - i);
+    }
+    for (uint32_t level = 0; level <= 3; level++) {
+        Value result = run_program(source, level, "RESULT");
+        CHECK(IS_I32(result) && AS_I32(result) == expected);
+    }
+}
+
+static void globals_stop_at_max_globals(void) {
+    // RESULT, the statics and main; one more static is one too many
+    static char source[MAX_GLOBALS * 40];
+    for (int statics = MAX_GLOBALS - 2; statics <= MAX_GLOBALS - 1; statics++) {
+        int length = snprintf(source, sizeof(source), "static mut RESULT: i32 = 0\n");
+        for (int i = 0; i < statics; i++) {
+            length += snprintf(source + length, sizeof(source) - length,
+                               "static mut a%d: i32 = %d\n", i, i);
+        }
+        snprintf(source + length, sizeof(source) - length,
+                 "fn main() {\n    RESULT = a%d\n}\n", statics - 1);
+        Value result = run_program(source, 0, "RESULT");
+        if (statics < MAX_GLOBALS - 1) {
+            CHECK(IS_I32(result) && AS_I32(result) == statics - 1);
+        } else {
+            CHECK(IS_NIL(result));
+        }
+    }
+}
+
+static void deep_recursion_grows_the_call_stack(void) {
+    const char* source =
+        "static mut RESULT: i32 = 0\n"
+        "fn depth(n: i32) -> i32 {\n"
+        "    if n == 0 {\n"
+        "        return 0\n"
+        "    }\n"
+        "    return depth(n - 1) + 1\n"
+        "}\n"
+        "fn main() {\n"
+        "    RESULT = depth(10000)\n"
+        "}\n";
+    Value result = run_program(source, 0, "RESULT");
+    CHECK(IS_I32(result) && AS_I32(result) == 10000);
+
+    // Unbounded recursion still stops with an error
+    const char* forever =
+        "static mut RESULT: i32 = 0\n"
+        "fn forever(n: i32) -> i32 {\n"
+        "    return forever(n + 1)\n"
+        "}\n"
+        "fn main() {\n"
+        "    RESULT = forever(0)\n"
+        "}\n";
+    CHECK(IS_NIL(run_program(forever, 0, "RESULT")));
+}
+
+static void runtime_errors_carry_the_line(void) {
+    const char* source =
+        "fn divide(a: i32, b: i32) -> i32 {\n"
+        "    return a / b\n"
+        "}\n"
+        "fn main() {\n"
+        "    divide(1, 0)\n"
+        "}\n";
+    for (uint32_t level = 0; level <= 3; level++) {
+        initVM();
+        beginCompileArena();
+        ASTNode* ast;
+        RegisterChunk chunk;
+        register_chunk_init(&chunk, "test");
+        vm.filePath = "test";
+        bool compiled = parse(source, "test", &ast) &&
+                        compileToRegister(ast, &chunk, "test.orus", source, true) &&
+                        register_chunk_optimize(&chunk, level);
+        endCompileArena();
+        CHECK(compiled);
+
+        RegisterVM program;
+        if (compiled && registervm_init(&program, &chunk)) {
+            CHECK(registervm_execute(&program) == EXEC_ERROR);
+            Value error = registervm_get_last_error(&program);
+            CHECK(IS_ERROR(error) && AS_ERROR(error)->location.line == 2);
+            CHECK(IS_ERROR(error) && AS_ERROR(error)->location.file &&
+                  strcmp(AS_ERROR(error)->location.file, "test.orus") == 0);
+            registervm_free(&program);
+        }
+        register_chunk_free(&chunk);
+        freeVM();
+    }
+}
+
+int main(void) {
+    RUN_TEST(lanes_survive_calls_in_operands);
+    RUN_TEST(unsigned_and_generic_arithmetic);
+    RUN_TEST(catch_variable_holds_the_message);
+    RUN_TEST(overflow_locals_fall_back_to_globals);
+    RUN_TEST(runtime_errors_carry_the_line);
+    RUN_TEST(deep_recursion_grows_the_call_stack);
+    RUN_TEST(globals_stop_at_max_globals);
+    return test_summary("test_compiler");
+}
@@ -0,0 +1,467 @@
+/**
+ * @file test_gc.c
+ * @brief Tests for the nursery and the old-space collector
+ *
+ * Runs with ORUS_GC_STRESS set, so every allocation a program makes first
+ * collects; a value that a handler holds without the collector knowing
+ * about it is freed or left behind by a move and the checks see garbage.
+ * `make test` also builds this file with -DNAN_BOXING, where large i64
+ * values are boxed on the heap.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/memory.h"
+#include "../include/register_chunk.h"
+#include "../include/register_opcodes.h"
+#include "../include/register_vm.h"
+#include "../include/value.h"
+#include "test.h"
+
+#define EMIT(chunk, instruction) register_chunk_add_instruction(&(chunk), (instruction), 1, 1)
+
+static bool is_string(Value value, const char* chars) {
+    return IS_STRING(value) && AS_STRING(value)->length == (int)strlen(chars) &&
+           memcmp(AS_STRING(value)->chars, chars, strlen(chars)) == 0;
+}
+
+static bool is_young_array(const RegisterVM* vm, Value value) {
+    uint8_t* object = (uint8_t*)AS_ARRAY(value);
+    return object >= vm->nursery && object < vm->nursery_end;
+}
+
+static uint32_t string_constant(RegisterChunk* chunk, const char* chars) {
+    return register_chunk_add_constant(chunk,
+        STRING_VAL(allocateString(chars, (int)strlen(chars))));
+}
+
+static void stress_concatenates_young_strings(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    uint32_t piece = string_constant(&chunk, "ab");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, piece));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 2, 1, 1));      // "abab"
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 3, 2, 1));      // "ababab"
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 2, 3, 2));      // young + young
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 4, 2, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    CHECK(vm.gc_stress);
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    CHECK(is_string(vm.registers[3], "ababab"));
+    CHECK(is_string(vm.registers[2], "ababababab"));
+    CHECK(is_string(vm.registers[4], "abababababababababab"));
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+// Short strings made at runtime are interned, so equal ones are one object
+// that survives collections while registers hold it
+static void stress_shares_short_strings(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    uint32_t piece = string_constant(&chunk, "ab");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, piece));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 2, 1, 1));      // "abab"
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 3, 2, 2));      // "abababab"
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 4, 1, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    CHECK(is_string(vm.registers[2], "abab") && is_string(vm.registers[4], "abab"));
+    CHECK(AS_STRING(vm.registers[2]) == AS_STRING(vm.registers[4]));
+    CHECK(AS_STRING(vm.registers[2])->interned);
+    CHECK(findInternedString("abababab", 8) == AS_STRING(vm.registers[3]));
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+static void stress_seeds_builder_with_young_string(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    uint32_t piece = string_constant(&chunk, "xy");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, piece));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 2, 1, 1));      // young seed
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_BUILDER_NEW, 3, 2, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 5, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 50));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 7, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 4, 1, 1));      // 6: young piece
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_BUILDER_APPEND, 3, 4, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 5, 5, 7));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LT_I32, 8, 5, 6));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JNZ, 8, 6));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_BUILDER_FINISH, 9, 3, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    CHECK(is_string(vm.registers[2], "xyxy"));
+    Value built = vm.registers[9];
+    CHECK(IS_STRING(built) && AS_STRING(built)->length == 4 + 50 * 4);
+    bool pieces = IS_STRING(built);
+    for (int i = 0; pieces && i < AS_STRING(built)->length; i += 2) {
+        pieces = memcmp(AS_STRING(built)->chars + i, "xy", 2) == 0;
+    }
+    CHECK(pieces);
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+static void stress_converts_packed_array_to_values(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    uint32_t piece = string_constant(&chunk, "s");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 10));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 20));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 30));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_PACKED_ARRAY, 10, 1, 3));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 4, piece));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 5, 4, 4));      // young "ss"
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_INDEX, 10, 6, 5));      // a[1] = "ss"
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ARRAY_PUSH, 10, 5, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 5, 0));       // drop the register root
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_STR_CONCAT, 7, 4, 4));      // collect again
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    CHECK(IS_ARRAY(vm.registers[10]));
+    ObjArray* array = AS_ARRAY(vm.registers[10]);
+    CHECK(array->kind == ARRAY_VALUES && array->length == 4);
+    CHECK(IS_I32(arrayGet(array, 0)) && AS_I32(arrayGet(array, 0)) == 10);
+    CHECK(is_string(arrayGet(array, 1), "ss"));
+    CHECK(IS_I32(arrayGet(array, 2)) && AS_I32(arrayGet(array, 2)) == 30);
+    CHECK(is_string(arrayGet(array, 3), "ss"));
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+static void stress_keeps_wide_i64_values(void) {
+    // Wider than the NaN-boxing payload, so boxed on the heap there
+    int64_t big = INT64_C(1) << 50;
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    uint32_t wide = register_chunk_add_constant(&chunk, I64_VAL(big));
+    uint32_t step = register_chunk_add_constant(&chunk, I64_VAL(INT64_C(3) << 40));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, wide));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 2, step));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_PACKED_ARRAY, 10, 0, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 5, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 20));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 7, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I64, 1, 1, 2));         // 6
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ARRAY_PUSH, 10, 1, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_GET_INDEX, 3, 10, 5));      // boxed on read
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 5, 5, 7));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LT_I32, 8, 5, 6));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JNZ, 8, 6));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    int64_t expected = big + 20 * (INT64_C(3) << 40);
+    CHECK(IS_I64(vm.registers[1]) && AS_I64(vm.registers[1]) == expected);
+    CHECK(IS_I64(vm.registers[3]) && AS_I64(vm.registers[3]) == expected);
+    ObjArray* array = AS_ARRAY(vm.registers[10]);
+    CHECK(array->kind == ARRAY_I64 && array->length == 20);
+    for (int i = 0; i < array->length; i++) {
+        Value element = arrayGet(array, i);
+        CHECK(IS_I64(element) && AS_I64(element) == big + (i + 1) * (INT64_C(3) << 40));
+    }
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+// A young packed array that has to change storage while the nursery is
+// full: the handler collects to promote it, then stores again
+static void array_store_retries_after_minor_collection(void) {
+    RegisterOpcode stores[] = { ROP_SET_INDEX, ROP_ARRAY_PUSH };
+    for (size_t i = 0; i < sizeof(stores) / sizeof(stores[0]); i++) {
+        RegisterChunk chunk;
+        register_chunk_init(&chunk, "test");
+        uint32_t piece = string_constant(&chunk, "v");
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 1));
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 2));
+        EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_PACKED_ARRAY, 10, 1, 2));
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 3, piece));
+        EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+        EMIT(chunk, stores[i] == ROP_SET_INDEX
+                        ? MAKE_INSTRUCTION(ROP_SET_INDEX, 10, 1, 3)
+                        : MAKE_INSTRUCTION(ROP_ARRAY_PUSH, 10, 3, 0));
+        EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+        RegisterVM vm;
+        CHECK(registervm_init(&vm, &chunk));
+        registervm_set_gc_stress(&vm, false);
+        CHECK(registervm_execute(&vm) == EXEC_OK);
+        CHECK(is_young_array(&vm, vm.registers[10]));
+
+        // Resume after the first HALT with no nursery space left
+        vm.nursery_top = vm.nursery_end;
+        CHECK(registervm_execute(&vm) == EXEC_OK);
+        CHECK(!is_young_array(&vm, vm.registers[10]));
+        ObjArray* array = AS_ARRAY(vm.registers[10]);
+        CHECK(array->kind == ARRAY_VALUES);
+        CHECK(IS_I32(arrayGet(array, 0)) && AS_I32(arrayGet(array, 0)) == 1);
+        if (stores[i] == ROP_SET_INDEX) {
+            CHECK(array->length == 2 && is_string(arrayGet(array, 1), "v"));
+        } else {
+            CHECK(array->length == 3 && is_string(arrayGet(array, 2), "v"));
+        }
+        registervm_free(&vm);
+        register_chunk_free(&chunk);
+    }
+}
+
+static bool is_point(Value value, int x, int y) {
+    if (!IS_ARRAY(value) || AS_ARRAY(value)->length != 2) {
+        return false;
+    }
+    Value* fields = AS_ARRAY(value)->elements;
+    return IS_I32(fields[0]) && AS_I32(fields[0]) == x &&
+           IS_I32(fields[1]) && AS_I32(fields[1]) == y;
+}
+
+static void stress_keeps_struct_fields(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    const char* fields[] = { "x", "y" };
+    CHECK(register_chunk_add_shape(&chunk, "P", fields, 2) == 1);
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 1));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 10, 1, 0));     // a = P{1, 2}
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 11, 1, 0));     // b, which collects
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_MOVE, 3, 10, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_MOVE, 4, 11, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 12, 3, 0));     // c = P{a, b}
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 13, 1, 0));     // young d
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_FIELD, 10, 0, 13));     // a.x = d
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 0));       // drop the register roots
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 4, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 13, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 14, 1, 0));     // collect again
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    CHECK(vm.gc_stress);
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    Value a = vm.registers[10];
+    CHECK(IS_ARRAY(a) && AS_ARRAY(a)->length == 2);
+    if (IS_ARRAY(a)) {
+        // d is reachable only through a, old or young
+        CHECK(is_point(AS_ARRAY(a)->elements[0], 1, 2));
+    }
+    CHECK(is_point(vm.registers[11], 1, 2));
+    Value c = vm.registers[12];
+    CHECK(IS_ARRAY(c) && AS_ARRAY(c)->length == 2);
+    if (IS_ARRAY(c)) {
+        CHECK(AS_ARRAY(AS_ARRAY(c)->elements[0]) == AS_ARRAY(a));
+        CHECK(AS_ARRAY(AS_ARRAY(c)->elements[1]) == AS_ARRAY(vm.registers[11]));
+    }
+    CHECK(is_point(vm.registers[14], 1, 2));
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+static bool is_live(const RegisterVM* vm, const Obj* object) {
+    for (Obj* live = vm->objects; live; live = live->next) {
+        if (live == object) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Halfway through marking, the program moves the only reference to a white
+// struct into a struct that is already black, and stores a fresh young
+// struct there too; the sweep must keep both
+static void incremental_marking_keeps_stores_into_black_struct(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    const char* triple[] = { "a", "b", "c" };
+    const char* link[] = { "next" };
+    const char* pair[] = { "x", "y" };
+    register_chunk_add_shape(&chunk, "W", triple, 3);
+    register_chunk_add_shape(&chunk, "L", link, 1);
+    register_chunk_add_shape(&chunk, "P", pair, 2);
+    uint8_t next = (uint8_t)register_chunk_add_field_name(&chunk, "next");
+    uint8_t x = (uint8_t)register_chunk_add_field_name(&chunk, "x");
+    uint8_t y = (uint8_t)register_chunk_add_field_name(&chunk, "y");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 1));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 4, 1, 0));      // w = W{1, 2, 3}
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 5, 4, 1));      // holder = L{w}
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 4, 0));
+    // A long chain of links keeps the collector busy between blackening
+    // the target and reaching the holder
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 10, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 11, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 12, 1000));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 13, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 10, 10, 1));    // 10: chain = L{chain}
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 11, 11, 13));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LT_I32, 14, 11, 12));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JNZ, 14, 10));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 15, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 16, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 20, 15, 2));    // target = P{0, 0}
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_GET_FIELD, 8, 5, next));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_FIELD, 20, x, 8));      // target.x = w
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_FIELD, 5, next, 6));    // holder.next = 0
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 8, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_STRUCT, 9, 1, 2));      // young P{1, 2}
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_FIELD, 20, y, 9));      // target.y = it
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 9, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    registervm_set_gc_stress(&vm, false);
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+
+    // Starting the cycle promotes everything, so the pointers stay put
+    registervm_set_gc_incremental(&vm, true, 1);
+    registervm_gc_step(&vm);
+    CHECK(vm.gc_phase == GC_PHASE_MARK);
+    ObjArray* target = AS_ARRAY(vm.registers[20]);
+    ObjArray* white = AS_ARRAY(AS_ARRAY(vm.registers[5])->elements[0]);
+    ObjArray* second = AS_ARRAY(AS_ARRAY(vm.registers[10])->elements[0]);
+
+    // The roots are grayed in register order and traced last first, so
+    // once the chain's second link is marked the target has been
+    // blackened, and the holder is still waiting behind the chain
+    for (int i = 0; i < 10000 && !second->obj.marked; i++) {
+        registervm_gc_step(&vm);
+    }
+    CHECK(second->obj.marked);
+    CHECK(target->obj.marked);
+    CHECK(!white->obj.marked);
+    CHECK(vm.gc_phase == GC_PHASE_MARK);
+
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    for (int i = 0; i < 100000 && vm.gc_phase != GC_PHASE_IDLE; i++) {
+        registervm_gc_step(&vm);
+    }
+    CHECK(vm.gc_phase == GC_PHASE_IDLE);
+
+    Value moved = target->elements[0];
+    CHECK(IS_ARRAY(moved) && AS_ARRAY(moved) == white);
+    CHECK(is_live(&vm, &white->obj));
+    CHECK(white->length == 3 && AS_I32(white->elements[2]) == 3);
+    Value fresh = target->elements[1];
+    CHECK(IS_ARRAY(fresh) && !is_young_array(&vm, fresh));
+    CHECK(IS_ARRAY(fresh) && is_live(&vm, &AS_ARRAY(fresh)->obj));
+    CHECK(is_point(fresh, 1, 2));
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+// Halfway through marking, the program moves the only reference to a white
+// array into an array that is already black, and stores a fresh young
+// array there too; the sweep must keep both
+static void incremental_marking_keeps_stores_into_black_array(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 1));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_ARRAY, 4, 1, 3));       // w = [1, 2, 3]
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_ARRAY, 5, 4, 1));       // holder = [w]
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 4, 0));
+    // A long chain of nested arrays keeps the collector busy between
+    // blackening the target and reaching the holder
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 10, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 11, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 12, 1000));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 13, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_ARRAY, 10, 10, 1));     // 10: chain = [chain]
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 11, 11, 13));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LT_I32, 14, 11, 12));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JNZ, 14, 10));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 15, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 16, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_ARRAY, 20, 15, 2));     // target = [0, 0]
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 7, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_GET_INDEX, 8, 5, 6));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_INDEX, 20, 6, 8));      // target[0] = w
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_INDEX, 5, 6, 6));       // holder[0] = 0
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 8, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_ARRAY, 9, 1, 2));       // young [1, 2]
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SET_INDEX, 20, 7, 9));      // target[1] = it
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 9, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &chunk));
+    registervm_set_gc_stress(&vm, false);
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+
+    // Starting the cycle promotes everything, so the pointers stay put
+    registervm_set_gc_incremental(&vm, true, 1);
+    registervm_gc_step(&vm);
+    CHECK(vm.gc_phase == GC_PHASE_MARK);
+    ObjArray* target = AS_ARRAY(vm.registers[20]);
+    ObjArray* white = AS_ARRAY(arrayGet(AS_ARRAY(vm.registers[5]), 0));
+    ObjArray* link = AS_ARRAY(arrayGet(AS_ARRAY(vm.registers[10]), 0));
+
+    // The roots are grayed in register order and traced last first, so
+    // once the chain's second link is marked the target has been
+    // blackened, and the holder is still waiting behind the chain
+    for (int i = 0; i < 10000 && !link->obj.marked; i++) {
+        registervm_gc_step(&vm);
+    }
+    CHECK(link->obj.marked);
+    CHECK(target->obj.marked);
+    CHECK(!white->obj.marked);
+    CHECK(vm.gc_phase == GC_PHASE_MARK);
+
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    for (int i = 0; i < 100000 && vm.gc_phase != GC_PHASE_IDLE; i++) {
+        registervm_gc_step(&vm);
+    }
+    CHECK(vm.gc_phase == GC_PHASE_IDLE);
+
+    Value moved = arrayGet(target, 0);
+    CHECK(IS_ARRAY(moved) && AS_ARRAY(moved) == white);
+    CHECK(is_live(&vm, &white->obj));
+    CHECK(white->length == 3 && AS_I32(arrayGet(white, 2)) == 3);
+    Value fresh = arrayGet(target, 1);
+    CHECK(IS_ARRAY(fresh) && !is_young_array(&vm, fresh));
+    CHECK(IS_ARRAY(fresh) && is_live(&vm, &AS_ARRAY(fresh)->obj));
+    CHECK(IS_ARRAY(fresh) && AS_ARRAY(fresh)->length == 2 &&
+          AS_I32(arrayGet(AS_ARRAY(fresh), 1)) == 2);
+    registervm_free(&vm);
+    register_chunk_free(&chunk);
+}
+
+int main(void) {
+    setenv("ORUS_GC_STRESS", "1", 1);
+    RUN_TEST(stress_concatenates_young_strings);
+    RUN_TEST(stress_shares_short_strings);
+    RUN_TEST(stress_seeds_builder_with_young_string);
+    RUN_TEST(stress_converts_packed_array_to_values);
+    RUN_TEST(stress_keeps_wide_i64_values);
+    RUN_TEST(array_store_retries_after_minor_collection);
+    RUN_TEST(stress_keeps_struct_fields);
+    RUN_TEST(incremental_marking_keeps_stores_into_black_struct);
+    RUN_TEST(incremental_marking_keeps_stores_into_black_array);
+    return test_summary("test_gc");
+}
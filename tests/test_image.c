@@ -0,0 +1,204 @@
+/**
+ * @file test_image.c
+ * @brief Tests for register bytecode images
+ *
+ * A chunk written out and loaded back, from a buffer or a mapped file,
+ * must run the same; a damaged image must be refused rather than loaded.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/memory.h"
+#include "../include/register_chunk.h"
+#include "../include/register_opcodes.h"
+#include "../include/register_vm.h"
+#include "../include/value.h"
+#include "test.h"
+
+// The first section table entry follows the 48-byte header; its offset
+// field is the third word
+#define FIRST_SECTION_OFFSET (48 + 8)
+
+static const uint32_t program[] = {
+    MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, 0),
+    MAKE_INSTRUCTION(ROP_STR_CONCAT, 2, 1, 1),
+    MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 2, 0),
+    MAKE_IMM_INSTRUCTION(ROP_CALL, 10, 7),
+    MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 10, 1),
+    MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 11, 1),
+    MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0),
+    // forty(): 7
+    MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 20),
+    MAKE_INSTRUCTION(ROP_ADD_I32, 1, 1, 1),
+    MAKE_INSTRUCTION(ROP_RET_VAL, 1, 0, 0),
+};
+#define PROGRAM_LENGTH (sizeof(program) / sizeof(program[0]))
+
+static void build_chunk(RegisterChunk* chunk) {
+    register_chunk_init(chunk, "image");
+    register_chunk_enable_debug(chunk);
+    register_chunk_add_source_file(chunk, "image.orus");
+    register_chunk_add_global(chunk, NIL_VAL);
+    register_chunk_add_global(chunk, NIL_VAL);
+    register_chunk_add_constant(chunk, STRING_VAL(allocateString("orus", 4)));
+    register_chunk_add_constant(chunk, I64_VAL(INT64_C(1) << 40));
+    register_chunk_add_constant(chunk, F64_VAL(2.5));
+    for (uint32_t i = 0; i < PROGRAM_LENGTH; i++) {
+        register_chunk_add_instruction(chunk, program[i], i + 1, 5);
+    }
+    register_chunk_add_function(chunk, "forty", 7, 9, 0, VAL_I32);
+    register_chunk_add_export(chunk, "forty", 7, VAL_I32, true);
+}
+
+static bool is_string(Value value, const char* chars) {
+    return IS_STRING(value) && AS_STRING(value)->length == (int)strlen(chars) &&
+           memcmp(AS_STRING(value)->chars, chars, strlen(chars)) == 0;
+}
+
+// Run the chunk and check what the program stores
+static void check_runs(RegisterChunk* chunk) {
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, chunk));
+    CHECK(chunk->is_verified);
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    CHECK(is_string(chunk->globals[0], "orusorus"));
+    CHECK(IS_I32(chunk->globals[1]) && AS_I32(chunk->globals[1]) == 40);
+    CHECK(IS_I64(vm.registers[11]) && AS_I64(vm.registers[11]) == INT64_C(1) << 40);
+    registervm_free(&vm);
+}
+
+// Check that a loaded chunk carries everything build_chunk put in
+static void check_loaded(const RegisterChunk* chunk) {
+    CHECK(chunk->code_count == PROGRAM_LENGTH);
+    CHECK(memcmp(chunk->code, program, sizeof(program)) == 0);
+    CHECK(chunk->constant_count == 3 && chunk->global_count == 2);
+    CHECK(IS_I64(chunk->constants[1]) && AS_I64(chunk->constants[1]) == INT64_C(1) << 40);
+    CHECK(IS_F64(chunk->constants[2]) && AS_F64(chunk->constants[2]) == 2.5);
+
+    const FunctionInfo* forty = register_chunk_get_function(chunk, 0);
+    CHECK(forty && strcmp(forty->name, "forty") == 0);
+    CHECK(forty && forty->start_address == 7 && forty->end_address == 9);
+    const ExportEntry* export = register_chunk_find_export(chunk, "forty");
+    CHECK(export && export->address == 7 && export->is_function);
+
+    const SourceLocation* location = register_chunk_get_location(chunk, 4);
+    CHECK(location && location->line == 5 && location->column == 5);
+    CHECK(location && strcmp(register_chunk_get_source_file(chunk, location->file_index),
+                             "image.orus") == 0);
+}
+
+static void serialize_round_trips(void) {
+    RegisterChunk original;
+    build_chunk(&original);
+    uint8_t* image;
+    size_t size;
+    CHECK(register_chunk_serialize(&original, &image, &size));
+    CHECK(size % ORBC_SECTION_ALIGN == 0);
+
+    RegisterChunk loaded;
+    CHECK(register_chunk_deserialize(image, size, &loaded));
+    check_loaded(&loaded);
+
+    // String constants wait for the VM, and write out the same either way
+    CHECK(loaded.strings_pending && IS_NIL(loaded.constants[0]));
+    uint8_t* again;
+    size_t again_size;
+    CHECK(register_chunk_serialize(&loaded, &again, &again_size));
+    CHECK(again_size == size && memcmp(again, image, size) == 0);
+    free(again);
+
+    check_runs(&loaded);
+    CHECK(is_string(loaded.constants[0], "orus"));
+    check_runs(&original);
+
+    register_chunk_free(&loaded);
+    register_chunk_free(&original);
+    free(image);
+}
+
+static void mapped_file_runs_in_place(void) {
+    RegisterChunk original;
+    build_chunk(&original);
+    char path[] = "/tmp/orus_image_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        register_chunk_free(&original);
+        return;
+    }
+    close(fd);
+    CHECK(register_chunk_write_file(&original, path));
+
+    RegisterChunk mapped;
+    CHECK(register_chunk_map_file(path, &mapped));
+    CHECK(mapped.image_mapped);
+    check_loaded(&mapped);
+    check_runs(&mapped);
+
+    register_chunk_free(&mapped);
+    register_chunk_free(&original);
+    unlink(path);
+}
+
+static void deserialize_rejects_damaged_images(void) {
+    RegisterChunk original;
+    build_chunk(&original);
+    uint8_t* image;
+    size_t size;
+    CHECK(register_chunk_serialize(&original, &image, &size));
+    register_chunk_free(&original);
+    RegisterChunk loaded;
+
+    // Truncated anywhere, including inside the header
+    size_t cuts[] = { 1, 16, 47, 48, size / 2, size - ORBC_SECTION_ALIGN, size - 1 };
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        CHECK(!register_chunk_deserialize(image, cuts[i], &loaded));
+    }
+    CHECK(!register_chunk_deserialize(image, 0, &loaded));
+
+    uint8_t* damaged = malloc(size + 1);
+    CHECK(damaged != NULL);
+    if (!damaged) {
+        free(image);
+        return;
+    }
+
+    // A section that does not start on ORBC_SECTION_ALIGN
+    memcpy(damaged, image, size);
+    damaged[FIRST_SECTION_OFFSET] += 4;
+    CHECK(!register_chunk_deserialize(damaged, size, &loaded));
+
+    // An image from another format version, or no image at all
+    uint32_t versions[] = { 1, ORBC_IMAGE_VERSION - 1, ORBC_IMAGE_VERSION + 1 };
+    for (size_t i = 0; i < sizeof(versions) / sizeof(versions[0]); i++) {
+        memcpy(damaged, image, size);
+        damaged[4] = (uint8_t)versions[i];
+        CHECK(!register_chunk_deserialize(damaged, size, &loaded));
+    }
+    memcpy(damaged, image, size);
+    damaged[0] ^= 0xFF;
+    CHECK(!register_chunk_deserialize(damaged, size, &loaded));
+
+    // The buffer itself need not be aligned, since the loader copies it
+    memcpy(damaged + 1, image, size);
+    bool unaligned = register_chunk_deserialize(damaged + 1, size, &loaded);
+    CHECK(unaligned);
+    if (unaligned) {
+        check_loaded(&loaded);
+        register_chunk_free(&loaded);
+    }
+
+    free(damaged);
+    free(image);
+}
+
+int main(void) {
+    RUN_TEST(serialize_round_trips);
+    RUN_TEST(mapped_file_runs_in_place);
+    RUN_TEST(deserialize_rejects_damaged_images);
+    return test_summary("test_image");
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_linker.c
+ * @brief Tests for the whole-program linker
+ *
+ * A module and a program are assembled by hand, linked, and the merged
+ * chunk is inspected instruction by instruction before it runs.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/memory.h"
+#include "../include/register_chunk.h"
+#include "../include/register_opcodes.h"
+#include "../include/register_vm.h"
+#include "../include/value.h"
+#include "test.h"
+
+#define EMIT(chunk, instruction) register_chunk_add_instruction(&(chunk), (instruction), 1, 1)
+
+// Global slots shared by both chunks
+enum { SLOT_F, SLOT_G, SLOT_FROM_PROGRAM, SLOT_FROM_F, SLOT_FROM_MODULE, SLOT_HI, SLOT_COUNT };
+
+static bool is_string(Value value, const char* chars) {
+    return IS_STRING(value) && AS_STRING(value)->length == (int)strlen(chars) &&
+           memcmp(AS_STRING(value)->chars, chars, strlen(chars)) == 0;
+}
+
+static uint32_t string_constant(RegisterChunk* chunk, const char* chars) {
+    return register_chunk_add_constant(chunk,
+        STRING_VAL(allocateString(chars, (int)strlen(chars))));
+}
+
+// Module "m": f() is called by the program, g() by nobody
+static void build_module(RegisterChunk* m) {
+    register_chunk_init(m, "m");
+    for (int i = 0; i < 2; i++) {
+        register_chunk_add_global(m, NIL_VAL);
+    }
+    uint32_t half = register_chunk_add_constant(m, F64_VAL(1.5));
+    uint32_t hi = string_constant(m, "hi");
+    uint32_t seven = register_chunk_add_constant(m, F64_VAL(7.0));
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 4));
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, half));            // f: 1
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 1, SLOT_FROM_F));
+    EMIT(*m, MAKE_INSTRUCTION(ROP_RET, 0, 0, 0));
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 7));                      // 4
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, seven));           // g: 5
+    EMIT(*m, MAKE_INSTRUCTION(ROP_RET, 0, 0, 0));
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 2, hi));              // 7
+    EMIT(*m, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 2, SLOT_FROM_MODULE));
+    EMIT(*m, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    register_chunk_add_function(m, "f", 1, 3, 0, VAL_NIL);
+    register_chunk_add_function(m, "g", 5, 6, 0, VAL_NIL);
+    m->functions[0].global_index = SLOT_F;
+    m->functions[1].global_index = SLOT_G;
+}
+
+// The program imports m and calls f() through its global slot
+static void build_program(RegisterChunk* p) {
+    register_chunk_init(p, "main");
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        register_chunk_add_global(p, NIL_VAL);
+    }
+    uint32_t name = string_constant(p, "m");
+    uint32_t hi = string_constant(p, "hi");
+    uint32_t half = register_chunk_add_constant(p, F64_VAL(1.5));
+    EMIT(*p, MAKE_IMM_INSTRUCTION(ROP_IMPORT, 0, name));
+    EMIT(*p, MAKE_IMM_INSTRUCTION(ROP_MODULE_CALL, 0, SLOT_F));
+    EMIT(*p, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 3, hi));
+    EMIT(*p, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 3, SLOT_HI));
+    EMIT(*p, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 4, half));
+    EMIT(*p, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 4, SLOT_FROM_PROGRAM));
+    EMIT(*p, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    register_chunk_add_import(p, "m", "f", SLOT_F, VAL_NIL);
+}
+
+static void count_opcode(const RegisterChunk* chunk, RegisterOpcode opcode, int* count) {
+    *count = 0;
+    for (uint32_t i = 0; i < chunk->code_count; i++) {
+        *count += GET_OPCODE(chunk->code[i]) == opcode;
+    }
+}
+
+static void link_merges_module_and_program(void) {
+    RegisterChunk m, p, linked;
+    build_module(&m);
+    build_program(&p);
+    RegisterChunk* units[] = { &m, &p };
+    char message[256];
+    bool ok = register_chunk_link(units, 2, &linked, message, sizeof(message));
+    CHECK(ok);
+    if (!ok) {
+        register_chunk_free(&m);
+        register_chunk_free(&p);
+        return;
+    }
+
+    // g(), the jump over it and the IMPORT are gone; m's HALT falls through
+    //   0 JMP 4   1-3 f   4 LOAD_CONST   5 STORE_GLOBAL   6 JMP 7
+    //   7 CALL 1   8-11 loads and stores   12 HALT
+    CHECK(linked.code_count == 13);
+    CHECK(linked.code[0] == MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 4));
+    CHECK(linked.code[6] == MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 7));
+    CHECK(linked.code[7] == MAKE_IMM_INSTRUCTION(ROP_CALL, 0, 1));
+    int jumps, module_calls, imports, halts;
+    count_opcode(&linked, ROP_JMP, &jumps);
+    count_opcode(&linked, ROP_MODULE_CALL, &module_calls);
+    count_opcode(&linked, ROP_IMPORT, &imports);
+    count_opcode(&linked, ROP_HALT, &halts);
+    CHECK(jumps == 2 && module_calls == 0 && imports == 0 && halts == 1);
+
+    CHECK(linked.function_count == 1);
+    uint16_t f = register_chunk_find_function(&linked, "f");
+    CHECK(f == 0 && linked.functions[0].start_address == 1 &&
+          linked.functions[0].end_address == 3);
+    CHECK(register_chunk_find_function(&linked, "g") == UINT16_MAX);
+    CHECK(IS_I32(linked.globals[SLOT_F]) && AS_I32(linked.globals[SLOT_F]) == 0);
+    CHECK(IS_NIL(linked.globals[SLOT_G]));
+
+    // Each chunk's 1.5 and "hi" share one entry; g's 7.0 and the module
+    // name are no longer loaded by anything
+    CHECK(linked.constant_count == 2);
+    CHECK(IS_F64(linked.constants[0]) && AS_F64(linked.constants[0]) == 1.5);
+    CHECK(is_string(linked.constants[1], "hi"));
+    CHECK(linked.code[1] == MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 1, 0));
+    CHECK(linked.code[4] == MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 2, 1));
+    CHECK(linked.code[8] == MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 3, 1));
+    CHECK(linked.code[10] == MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 4, 0));
+
+    RegisterVM vm;
+    CHECK(registervm_init(&vm, &linked));
+    CHECK(linked.is_verified);
+    CHECK(registervm_execute(&vm) == EXEC_OK);
+    CHECK(IS_F64(linked.globals[SLOT_FROM_F]) && AS_F64(linked.globals[SLOT_FROM_F]) == 1.5);
+    CHECK(is_string(linked.globals[SLOT_FROM_MODULE], "hi"));
+    CHECK(is_string(linked.globals[SLOT_HI], "hi"));
+    CHECK(IS_F64(linked.globals[SLOT_FROM_PROGRAM]) &&
+          AS_F64(linked.globals[SLOT_FROM_PROGRAM]) == 1.5);
+    registervm_free(&vm);
+
+    register_chunk_free(&linked);
+    register_chunk_free(&m);
+    register_chunk_free(&p);
+}
+
+// Code that finds its target at run time cannot be rewritten
+static void link_rejects_dynamic_instructions(void) {
+    RegisterOpcode dynamic[] = { ROP_MODULE_GET, ROP_JMP_REG, ROP_CALL_REG };
+    for (size_t i = 0; i < sizeof(dynamic) / sizeof(dynamic[0]); i++) {
+        RegisterChunk m, p, linked;
+        build_module(&m);
+        build_program(&p);
+        register_chunk_set_instruction(&p, 2, MAKE_INSTRUCTION(dynamic[i], 3, 1, 0));
+        RegisterChunk* units[] = { &m, &p };
+        char message[256];
+        CHECK(!register_chunk_link(units, 2, &linked, message, sizeof(message)));
+        CHECK(strstr(message, get_instruction_name(dynamic[i])) != NULL);
+        register_chunk_free(&m);
+        register_chunk_free(&p);
+    }
+}
+
+int main(void) {
+    RUN_TEST(link_merges_module_and_program);
+    RUN_TEST(link_rejects_dynamic_instructions);
+    return test_summary("test_linker");
+}
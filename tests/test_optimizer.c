@@ -0,0 +1,206 @@
+/**
+ * @file test_optimizer.c
+ * @brief Tests for the register bytecode optimizer
+ *
+ * Chunks are assembled by hand, optimized at one level, and the rewritten
+ * code and the metadata that points into it are checked before they run.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/register_chunk.h"
+#include "../include/register_opcodes.h"
+#include "../include/register_vm.h"
+#include "../include/value.h"
+#include "test.h"
+
+#define EMIT(chunk, instruction) register_chunk_add_instruction(&(chunk), (instruction), 1, 1)
+
+// Superinstruction fusion runs last and only changes opcode bytes
+static RegisterOpcode base_opcode(const RegisterChunk* chunk, uint32_t address) {
+    return get_base_opcode((RegisterOpcode)GET_OPCODE(chunk->code[address]));
+}
+
+static int count_opcode(const RegisterChunk* chunk, RegisterOpcode opcode) {
+    int count = 0;
+    for (uint32_t i = 0; i < chunk->code_count; i++) {
+        count += base_opcode(chunk, i) == opcode;
+    }
+    return count;
+}
+
+// Run the chunk and return global 0
+static Value run(RegisterChunk* chunk) {
+    Value result = NIL_VAL;
+    RegisterVM vm;
+    if (registervm_init(&vm, chunk)) {
+        if (registervm_execute(&vm) == EXEC_OK) {
+            result = chunk->globals[0];
+        }
+        registervm_free(&vm);
+    }
+    return result;
+}
+
+static void branches_fold_and_dead_blocks_vanish(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    register_chunk_add_global(&chunk, NIL_VAL);
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JZ, 0, 4));                    // always taken
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 7));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 1, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 3));              // 4
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 1, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    CHECK(register_chunk_optimize(&chunk, 2));
+
+    // The branch, the block it skipped and its dead condition are gone
+    CHECK(chunk.code_count == 3);
+    CHECK(count_opcode(&chunk, ROP_JZ) == 0 && count_opcode(&chunk, ROP_JMP) == 0);
+    CHECK(chunk.code[0] == MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 3));
+    CHECK(base_opcode(&chunk, 1) == ROP_STORE_GLOBAL && base_opcode(&chunk, 2) == ROP_HALT);
+    Value result = run(&chunk);
+    CHECK(IS_I32(result) && AS_I32(result) == 3);
+    register_chunk_free(&chunk);
+}
+
+// Address of the last backward branch, which closes the loop
+static uint32_t loop_tail(const RegisterChunk* chunk) {
+    uint32_t tail = UINT32_MAX;
+    for (uint32_t i = 0; i < chunk->code_count; i++) {
+        RegisterOpcode opcode = base_opcode(chunk, i);
+        if ((opcode == ROP_JNZ || opcode == ROP_JMP) && GET_IMM(chunk->code[i]) <= i) {
+            tail = i;
+        }
+    }
+    return tail;
+}
+
+static void invariants_leave_the_loop(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    register_chunk_add_global(&chunk, NIL_VAL);
+    register_chunk_add_global(&chunk, I32_VAL(6));
+    register_chunk_add_global(&chunk, I32_VAL(2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 0));              // i
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 0));              // sum
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 4, 5));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_GLOBAL, 2, 1));           // loop: 3
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_GLOBAL, 3, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_DIV_I32, 5, 2, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 1, 1, 5));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 0, 0, 6));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LT_I32, 7, 0, 4));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JNZ, 7, 3));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 1, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    CHECK(register_chunk_optimize(&chunk, 3));
+
+    uint32_t tail = loop_tail(&chunk);
+    CHECK(tail < chunk.code_count);
+    if (tail >= chunk.code_count) {
+        register_chunk_free(&chunk);
+        return;
+    }
+    uint32_t header = GET_IMM(chunk.code[tail]);
+
+    // The global loads and the step constant run once, ahead of the loop;
+    // the division could trap on a zero divisor, so it stays where it was
+    bool loads_hoisted = true;
+    bool division_inside = false;
+    for (uint32_t i = 0; i < chunk.code_count; i++) {
+        RegisterOpcode opcode = base_opcode(&chunk, i);
+        bool inside = i >= header && i <= tail;
+        if (opcode == ROP_LOAD_GLOBAL ||
+            chunk.code[i] == MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 6, 1)) {
+            loads_hoisted = loads_hoisted && !inside;
+        }
+        if (opcode == ROP_DIV_I32) {
+            division_inside = inside;
+        }
+    }
+    CHECK(loads_hoisted);
+    CHECK(division_inside);
+    CHECK(count_opcode(&chunk, ROP_LOAD_GLOBAL) == 2);
+
+    Value result = run(&chunk);
+    CHECK(IS_I32(result) && AS_I32(result) == 5 * (6 / 2));
+    register_chunk_free(&chunk);
+}
+
+// A jump chain through NOPs, with a line per instruction, a function and
+// its export
+static void build_jump_chain(RegisterChunk* chunk) {
+    static const uint32_t code[] = {
+        MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 3),
+        MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 1),
+        MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 0, 0),
+        MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 6),                            // 3
+        MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0),
+        MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0),
+        MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0),                             // 6
+        MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 9),                       // f: 7
+        MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 0, 0),
+        MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0),
+    };
+    register_chunk_init(chunk, "test");
+    register_chunk_enable_debug(chunk);
+    register_chunk_add_global(chunk, NIL_VAL);
+    for (uint32_t i = 0; i < sizeof(code) / sizeof(code[0]); i++) {
+        register_chunk_add_instruction(chunk, code[i], i + 1, 1);
+    }
+    register_chunk_add_function(chunk, "f", 7, 9, 0, VAL_NIL);
+    register_chunk_add_export(chunk, "f", 7, VAL_NIL, true);
+}
+
+static void jumps_skip_chains_and_nops(void) {
+    RegisterChunk chunk;
+    build_jump_chain(&chunk);
+
+    CHECK(register_chunk_optimize(&chunk, 1));
+
+    // Both jumps go straight to the load that was at 7, now at 5
+    CHECK(chunk.code_count == 8);
+    CHECK(count_opcode(&chunk, ROP_NOP) == 0);
+    CHECK(chunk.code[0] == MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 5));
+    CHECK(chunk.code[3] == MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 5));
+    CHECK(chunk.code[5] == MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 9));
+    Value result = run(&chunk);
+    CHECK(IS_I32(result) && AS_I32(result) == 9);
+    register_chunk_free(&chunk);
+}
+
+static void metadata_follows_stripped_nops(void) {
+    RegisterChunk chunk;
+    build_jump_chain(&chunk);
+
+    CHECK(register_chunk_optimize(&chunk, 1));
+
+    // Each instruction keeps the line it was written on
+    uint32_t lines[] = { 1, 2, 3, 4, 6, 8, 9, 10 };
+    CHECK(chunk.code_count == sizeof(lines) / sizeof(lines[0]));
+    for (uint32_t i = 0; i < chunk.code_count && i < sizeof(lines) / sizeof(lines[0]); i++) {
+        const SourceLocation* location = register_chunk_get_location(&chunk, i);
+        CHECK(location && location->line == lines[i]);
+    }
+
+    const FunctionInfo* f = register_chunk_get_function(&chunk, 0);
+    CHECK(f && f->start_address == 5 && f->end_address == 7);
+    const ExportEntry* export = register_chunk_find_export(&chunk, "f");
+    CHECK(export && export->address == 5);
+    register_chunk_free(&chunk);
+}
+
+int main(void) {
+    RUN_TEST(branches_fold_and_dead_blocks_vanish);
+    RUN_TEST(invariants_leave_the_loop);
+    RUN_TEST(jumps_skip_chains_and_nops);
+    RUN_TEST(metadata_follows_stripped_nops);
+    return test_summary("test_optimizer");
+}
@@ -0,0 +1,168 @@
+/**
+ * @file test_register_allocator.c
+ * @brief Tests for the register allocator
+ *
+ * Chunks over virtual registers are assembled by hand, allocated, and the
+ * rewritten operands are checked before the chunk runs.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/register_allocator.h"
+#include "../include/register_chunk.h"
+#include "../include/register_opcodes.h"
+#include "../include/register_vm.h"
+#include "../include/value.h"
+#include "test.h"
+
+#define EMIT(chunk, instruction) register_chunk_add_instruction(&(chunk), (instruction), 1, 1)
+
+static void build_chunk(RegisterChunk* chunk) {
+    register_chunk_init(chunk, "test");
+    register_chunk_add_global(chunk, NIL_VAL);
+}
+
+static bool allocates(RegisterChunk* chunk) {
+    uint16_t failed;
+    return register_allocate_chunk(chunk, &failed);
+}
+
+// Run the chunk and return global 0
+static Value run(RegisterChunk* chunk) {
+    Value result = NIL_VAL;
+    RegisterVM vm;
+    if (registervm_init(&vm, chunk)) {
+        if (registervm_execute(&vm) == EXEC_OK) {
+            result = chunk->globals[0];
+        }
+        registervm_free(&vm);
+    }
+    return result;
+}
+
+static void coalesced_moves_are_stripped(void) {
+    RegisterChunk chunk;
+    build_chunk(&chunk);
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 5));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_MOVE, 1, 0, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 2, 1, 1));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 2, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    CHECK(allocates(&chunk));
+    CHECK(chunk.code_count == 4);
+    CHECK(chunk.code[1] == MAKE_INSTRUCTION(ROP_ADD_I32, 0, 0, 0));
+    CHECK(chunk.max_registers == 1);
+    Value result = run(&chunk);
+    CHECK(IS_I32(result) && AS_I32(result) == 10);
+    register_chunk_free(&chunk);
+}
+
+static void dead_registers_are_reused(void) {
+    RegisterChunk chunk;
+    build_chunk(&chunk);
+    // Far more values than registers, but only one live at a time
+    for (int v = 0; v < 3 * REGISTER_COUNT; v++) {
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, v, v));
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, v, 0));
+    }
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    CHECK(allocates(&chunk));
+    CHECK(chunk.max_registers == 1);
+    Value result = run(&chunk);
+    CHECK(IS_I32(result) && AS_I32(result) == 3 * REGISTER_COUNT - 1);
+    register_chunk_free(&chunk);
+}
+
+// sub(a, b) is called through a window placed after the caller's v0
+static void parameters_and_windows(void) {
+    RegisterChunk chunk;
+    build_chunk(&chunk);
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SUB_I32, 2, 0, 1));               // sub: 1
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_RET_VAL, 2, 0, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 100));           // 3
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, WINDOW_REGISTER(0), 50));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, WINDOW_REGISTER(1), 8));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_CALL, WINDOW_REGISTER(0), 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 1, 0, WINDOW_REGISTER(0)));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 1, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    register_chunk_add_function(&chunk, "sub", 1, 2, 2, VAL_I32);
+
+    CHECK(register_function_fits(&chunk, 0));
+    CHECK(GET_DST(chunk.code[4]) == WINDOW_REGISTER(0));
+    CHECK(allocates(&chunk));
+
+    // The parameters keep R0 and R1; the result may reuse either
+    CHECK(GET_SRC1(chunk.code[1]) == 0 && GET_SRC2(chunk.code[1]) == 1);
+    CHECK(GET_DST(chunk.code[1]) == GET_DST(chunk.code[2]));
+    CHECK(chunk.functions[0].register_count == 2);
+
+    // v0 is live across the call, so the window starts at R1
+    CHECK(chunk.code[4] == MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 50));
+    CHECK(chunk.code[5] == MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 8));
+    CHECK(chunk.code[6] == MAKE_IMM_INSTRUCTION(ROP_CALL, 1, 1));
+    Value result = run(&chunk);
+    CHECK(IS_I32(result) && AS_I32(result) == 142);
+    register_chunk_free(&chunk);
+}
+
+// JMP, REGISTER_COUNT + 1 loads, REGISTER_COUNT adds, RET_VAL and HALT
+#define OVERFLOW_LENGTH (2 * REGISTER_COUNT + 4)
+
+// One more value live at once than there are registers
+static void build_overflowing_function(RegisterChunk* chunk) {
+    build_chunk(chunk);
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, OVERFLOW_LENGTH - 1));
+    for (int v = 0; v <= REGISTER_COUNT; v++) {
+        EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, v, v));
+    }
+    for (int v = 1; v <= REGISTER_COUNT; v++) {
+        EMIT(*chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 0, 0, v));
+    }
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_RET_VAL, 0, 0, 0));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    register_chunk_add_function(chunk, "big", 1, chunk->code_count - 2, 0, VAL_I32);
+}
+
+static void overflow_names_the_function(void) {
+    RegisterChunk chunk;
+    build_overflowing_function(&chunk);
+    uint32_t before[OVERFLOW_LENGTH];
+    CHECK(chunk.code_count == OVERFLOW_LENGTH);
+    memcpy(before, chunk.code, sizeof(before));
+
+    // The check alone leaves the code as it was
+    CHECK(!register_function_fits(&chunk, 0));
+    CHECK(memcmp(before, chunk.code, sizeof(before)) == 0);
+    CHECK(!register_function_fits(&chunk, 1));
+
+    uint16_t failed;
+    CHECK(!register_allocate_chunk(&chunk, &failed));
+    CHECK(failed == 0);
+    register_chunk_free(&chunk);
+}
+
+static void truncate_drops_functions(void) {
+    RegisterChunk chunk;
+    build_overflowing_function(&chunk);
+    register_chunk_enable_debug(&chunk);
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    register_chunk_truncate(&chunk, 1);
+    CHECK(chunk.code_count == 1 && chunk.function_count == 0);
+    CHECK(chunk.debug->location_count <= 1);
+    register_chunk_free(&chunk);
+}
+
+int main(void) {
+    RUN_TEST(coalesced_moves_are_stripped);
+    RUN_TEST(dead_registers_are_reused);
+    RUN_TEST(parameters_and_windows);
+    RUN_TEST(overflow_names_the_function);
+    RUN_TEST(truncate_drops_functions);
+    return test_summary("test_register_allocator");
+}
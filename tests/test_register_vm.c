@@ -0,0 +1,296 @@
+/**
+ * @file test_register_vm.c
+ * @brief Tests for the register chunk verifier and the dispatch loops
+ *
+ * Chunks are assembled by hand so each test controls exactly which
+ * operands the verifier sees.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/register_chunk.h"
+#include "../include/register_opcodes.h"
+#include "../include/register_vm.h"
+#include "../include/type.h"
+#include "../include/value.h"
+#include "test.h"
+
+#define EMIT(chunk, instruction) register_chunk_add_instruction(&(chunk), (instruction), 1, 1)
+
+static void verify_accepts_well_formed_code(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    register_chunk_add_global(&chunk, NIL_VAL);
+    uint32_t pi = register_chunk_add_constant(&chunk, F64_VAL(3.5));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 0, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 3, pi));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_F64, 4, 3, 3));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 0, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 7));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+static void verify_rejects_out_of_range_register(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_MOVE, TOTAL_REGISTER_COUNT, 1, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_MOVE, 0, TOTAL_REGISTER_COUNT + 4, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+
+    // Lane operands are bounded by the lane file, not the register file
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LANE_ADD_I64, LANE_REGISTER_COUNT, 0, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+static void verify_rejects_out_of_range_constant(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    register_chunk_add_constant(&chunk, I32_VAL(70000));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 0, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+static void verify_rejects_out_of_range_global(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    register_chunk_add_global(&chunk, NIL_VAL);
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_GLOBAL, 0, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+static void verify_rejects_out_of_range_jump(void) {
+    RegisterOpcode jumps[] = { ROP_JMP, ROP_JZ, ROP_JNZ, ROP_JLT, ROP_CALL };
+    for (size_t i = 0; i < sizeof(jumps) / sizeof(jumps[0]); i++) {
+        RegisterChunk chunk;
+        register_chunk_init(&chunk, "test");
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 1));
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(jumps[i], 0, 3));
+        EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+        CHECK(!register_chunk_verify(&chunk));
+        register_chunk_free(&chunk);
+    }
+}
+
+static void verify_rejects_mistyped_arithmetic(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    uint32_t half = register_chunk_add_constant(&chunk, F64_VAL(0.5));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 2, half));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 0, 1, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_F64, 0, 1, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+
+    // Globals may hold anything
+    register_chunk_init(&chunk, "test");
+    register_chunk_add_global(&chunk, I32_VAL(1));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_GLOBAL, 1, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 0, 1, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+static void verify_leaves_dynamic_jumps_unverified(void) {
+    RegisterOpcode jumps[] = { ROP_JMP_REG, ROP_CALL_REG };
+    for (size_t i = 0; i < sizeof(jumps) / sizeof(jumps[0]); i++) {
+        RegisterChunk chunk;
+        register_chunk_init(&chunk, "test");
+        EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 0, 2));
+        EMIT(chunk, MAKE_INSTRUCTION(jumps[i], 0, 0, 0));
+        EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+        CHECK(!register_chunk_verify(&chunk));
+
+        // The VM then runs the chunk with runtime checks
+        RegisterVM vm;
+        CHECK(registervm_init(&vm, &chunk));
+        CHECK(!chunk.is_verified);
+        registervm_free(&vm);
+        register_chunk_free(&chunk);
+    }
+}
+
+static void verify_forgets_register_types_across_call(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 3));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_CALL, 3, 5));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 0, 1, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_RET, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+
+    // The same code without the call verifies
+    register_chunk_set_instruction(&chunk, 2, MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0));
+    CHECK(register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+// Every opcode the code generator emits must be known to the verifier
+static void verify_accepts_generated_opcodes(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 7));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_NEW_ARRAY, 0, 1, 1));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 0));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 1));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ARRAY_SLICE, 4, 0, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_GENERIC_CAST, 5, 1, TYPE_I64));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_SUB_ANY, 6, 5, 5));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_PRINT, 0, 6, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_TRY_END, 0, 0, 0));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+static void disassembly_names_operands(void) {
+    char text[64];
+    disassemble_instruction(MAKE_INSTRUCTION(ROP_PRINT, 0, 3, 0), text, sizeof(text));
+    CHECK(strcmp(text, "PRINT R3, #0") == 0);
+    disassemble_instruction(MAKE_IMM_INSTRUCTION(ROP_TRY_BEGIN, 2, 9), text, sizeof(text));
+    CHECK(strcmp(text, "TRY_BEGIN G2, #9") == 0);
+    disassemble_instruction(MAKE_INSTRUCTION(ROP_ARRAY_SLICE, 1, 2, 3), text, sizeof(text));
+    CHECK(strcmp(text, "ARRAY_SLICE R1, R2, R3") == 0);
+}
+
+static void verify_rejects_superinstruction_without_partner(void) {
+    RegisterChunk chunk;
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 3));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_LT_I32_JZ, 0, 1, 2));
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_JZ, 0, 4));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+    CHECK(register_chunk_verify(&chunk));
+
+    register_chunk_set_instruction(&chunk, 3, MAKE_INSTRUCTION(ROP_NOP, 0, 0, 0));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+
+    // A superinstruction at the end of the code has no partner at all
+    register_chunk_init(&chunk, "test");
+    EMIT(chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 2));
+    EMIT(chunk, MAKE_INSTRUCTION(ROP_ADD_I32_JMP, 1, 1, 1));
+    CHECK(!register_chunk_verify(&chunk));
+    register_chunk_free(&chunk);
+}
+
+// Iterative fib(n) into global 0, n halves summed in f64 into global 1 and
+// the result of a call into global 2. Uses fused loop instructions and
+// verifies, so it can run on both dispatch loops.
+static void build_program(RegisterChunk* chunk, uint16_t n) {
+    register_chunk_init(chunk, "test");
+    for (int i = 0; i < 3; i++) {
+        register_chunk_add_global(chunk, NIL_VAL);
+    }
+    uint32_t zero = register_chunk_add_constant(chunk, F64_VAL(0.0));
+    uint32_t half = register_chunk_add_constant(chunk, F64_VAL(0.5));
+
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 1, 0));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 2, 1));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 0));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 4, n));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 5, 1));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_LT_I32, 6, 3, 4));            // 5
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_JZ, 6, 12));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_ADD_I32, 7, 1, 2));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_MOVE, 1, 2, 0));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_MOVE, 2, 7, 0));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_ADD_I32_JMP, 3, 3, 5));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 5));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 1, 0));     // 12
+
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 8, zero));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_CONST, 9, half));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 3, 0));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_LT_I32_JZ, 6, 3, 4));         // 16
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_JZ, 6, 21));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_ADD_F64, 8, 8, 9));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_ADD_I32_JMP, 3, 3, 5));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_JMP, 0, 16));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 8, 1));     // 21
+
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_LOAD_IMM, 10, 7));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_CALL, 10, 26));
+    EMIT(*chunk, MAKE_IMM_INSTRUCTION(ROP_STORE_GLOBAL, 10, 2));
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_HALT, 0, 0, 0));
+
+    // Callee: returns its argument
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_MOVE, 1, 0, 0));              // 26
+    EMIT(*chunk, MAKE_INSTRUCTION(ROP_RET_VAL, 1, 0, 0));
+}
+
+static void unchecked_dispatch_matches_checked(void) {
+    Value results[2][3];
+    for (int checked = 0; checked < 2; checked++) {
+        RegisterChunk chunk;
+        build_program(&chunk, 30);
+        RegisterVM vm;
+        CHECK(registervm_init(&vm, &chunk));
+        CHECK(chunk.is_verified);
+        if (checked) {
+            chunk.is_verified = false;
+        }
+        CHECK(registervm_execute(&vm) == EXEC_OK);
+        for (int i = 0; i < 3; i++) {
+            results[checked][i] = chunk.globals[i];
+        }
+        registervm_free(&vm);
+        register_chunk_free(&chunk);
+    }
+
+    CHECK(IS_I32(results[0][0]) && AS_I32(results[0][0]) == 832040);
+    CHECK(IS_F64(results[0][1]) && AS_F64(results[0][1]) == 15.0);
+    CHECK(IS_I32(results[0][2]) && AS_I32(results[0][2]) == 7);
+    for (int i = 0; i < 3; i++) {
+        CHECK(valuesEqual(results[0][i], results[1][i]));
+    }
+}
+
+int main(void) {
+    RUN_TEST(verify_accepts_well_formed_code);
+    RUN_TEST(verify_rejects_out_of_range_register);
+    RUN_TEST(verify_rejects_out_of_range_constant);
+    RUN_TEST(verify_rejects_out_of_range_global);
+    RUN_TEST(verify_rejects_out_of_range_jump);
+    RUN_TEST(verify_rejects_mistyped_arithmetic);
+    RUN_TEST(verify_leaves_dynamic_jumps_unverified);
+    RUN_TEST(verify_forgets_register_types_across_call);
+    RUN_TEST(verify_rejects_superinstruction_without_partner);
+    RUN_TEST(verify_accepts_generated_opcodes);
+    RUN_TEST(disassembly_names_operands);
+    RUN_TEST(unchecked_dispatch_matches_checked);
+    return test_summary("test_register_vm");
+}